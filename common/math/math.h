@@ -198,6 +198,38 @@ namespace embree
     return x | (y << 1) | (z << 2);
   }
 
+  /*! clears all but the highest set bit */
+  template<class T>
+    __forceinline T highestBit(T v)
+  {
+    for (size_t i=1; i<8*sizeof(T); i*=2) v |= v >> i;
+    return v ^ (v >> 1);
+  }
+
+  /*! bit interleave operation for 21 bits per dimension */
+  __forceinline uint64 bitInterleave64(uint64 x, uint64 y, uint64 z)
+  {
+    x = (x | (x << 32)) & 0x001F00000000FFFFull;
+    x = (x | (x << 16)) & 0x001F0000FF0000FFull;
+    x = (x | (x <<  8)) & 0x100F00F00F00F00Full;
+    x = (x | (x <<  4)) & 0x10C30C30C30C30C3ull;
+    x = (x | (x <<  2)) & 0x1249249249249249ull;
+
+    y = (y | (y << 32)) & 0x001F00000000FFFFull;
+    y = (y | (y << 16)) & 0x001F0000FF0000FFull;
+    y = (y | (y <<  8)) & 0x100F00F00F00F00Full;
+    y = (y | (y <<  4)) & 0x10C30C30C30C30C3ull;
+    y = (y | (y <<  2)) & 0x1249249249249249ull;
+
+    z = (z | (z << 32)) & 0x001F00000000FFFFull;
+    z = (z | (z << 16)) & 0x001F0000FF0000FFull;
+    z = (z | (z <<  8)) & 0x100F00F00F00F00Full;
+    z = (z | (z <<  4)) & 0x10C30C30C30C30C3ull;
+    z = (z | (z <<  2)) & 0x1249249249249249ull;
+
+    return x | (y << 1) | (z << 2);
+  }
+
 #if _WIN32
   __forceinline double drand48() {
     return double(rand())/double(RAND_MAX);
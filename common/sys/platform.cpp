@@ -50,7 +50,7 @@ namespace embree
   {
     size_t pageSize = 4096;
     if (bytesNew & (pageSize-1)) 
-      bytesNew = (bytesNew+pageSize) & (pageSize-1);
+      bytesNew = (bytesNew+pageSize) & ~(pageSize-1);
 
     VirtualFree((char*)ptr+bytesNew,bytesOld-bytesNew,MEM_DECOMMIT);
   }
@@ -60,6 +60,39 @@ namespace embree
     VirtualFree(ptr,0,MEM_RELEASE);
   }
 
+  void* os_reserve_huge(size_t bytes) {
+    return NULL; // large pages require a privilege and cannot be committed lazily
+  }
+
+  void os_advise_huge_pages(void* ptr, size_t bytes) {
+  }
+
+  void* os_map_file(const char* fileName, size_t& bytes)
+  {
+    HANDLE file = CreateFileA(fileName,GENERIC_READ,FILE_SHARE_READ,NULL,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
+    if (file == INVALID_HANDLE_VALUE) return NULL;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file,&size) || size.QuadPart == 0) { CloseHandle(file); return NULL; }
+    HANDLE mapping = CreateFileMappingA(file,NULL,PAGE_WRITECOPY,0,0,NULL);
+    CloseHandle(file);
+    if (mapping == NULL) return NULL;
+    void* ptr = MapViewOfFile(mapping,FILE_MAP_COPY,0,0,0);
+    CloseHandle(mapping);
+    bytes = (size_t) size.QuadPart;
+    return ptr;
+  }
+
+  void os_unmap_file(void* ptr, size_t bytes) {
+    if (bytes == 0) return;
+    UnmapViewOfFile(ptr);
+  }
+
+  void os_numa_interleave(void* ptr, size_t bytes) {
+  }
+
+  void os_numa_bind(void* ptr, size_t bytes, size_t node) {
+  }
+
   double getSeconds() {
     LARGE_INTEGER freq, val;
     QueryPerformanceFrequency(&freq);
@@ -79,6 +112,14 @@ namespace embree
 #include <sys/mman.h>
 #include <errno.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(__LINUX__)
+#include <sys/syscall.h>
+#include "sysinfo.h"
+#endif
 
 namespace embree
 {
@@ -124,9 +165,17 @@ namespace embree
     if (bytesOld > 16*4096) pageSize = 2*1024*1024;
 #endif
     if (bytesNew & (pageSize-1)) 
-      bytesNew = (bytesNew+pageSize) & (pageSize-1);
-
-    os_free((char*)ptr+bytesNew,bytesOld-bytesNew);
+      bytesNew = (bytesNew+pageSize) & ~(pageSize-1);
+    if (bytesNew >= bytesOld) return;
+
+    /* mappings with explicit huge pages can only be split at huge page
+     * boundaries, failing to shrink only wastes some memory */
+    if (munmap((char*)ptr+bytesNew,bytesOld-bytesNew) == -1 && errno == EINVAL) {
+      const size_t hugePageSize = 2*1024*1024;
+      bytesNew = (bytesNew+hugePageSize-1)&(-hugePageSize);
+      bytesOld = (bytesOld+hugePageSize-1)&(-hugePageSize);
+      if (bytesNew < bytesOld) munmap((char*)ptr+bytesNew,bytesOld-bytesNew);
+    }
   }
 
   void os_free(void* ptr, size_t bytes) 
@@ -141,11 +190,102 @@ namespace embree
       bytes = (bytes+4095)&(-4096);
     }
 #endif
-    if (munmap(ptr,bytes) == -1) {
-      throw std::bad_alloc();
+    if (munmap(ptr,bytes) == -1) 
+    {
+      /* mappings with explicit huge pages can only be unmapped in full huge pages */
+      const size_t hugePageSize = 2*1024*1024;
+      if (errno != EINVAL || munmap(ptr,(bytes+hugePageSize-1)&(-hugePageSize)) == -1)
+        throw std::bad_alloc();
     }
   }
 
+  void* os_reserve_huge(size_t bytes)
+  {
+#if defined(MAP_HUGETLB)
+    /* huge pages get reserved at mmap time, thus we fail here instead of at page fault time */
+    const size_t hugePageSize = 2*1024*1024;
+    bytes = (bytes+hugePageSize-1)&(-hugePageSize);
+    void* ptr = mmap(0, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON | MAP_HUGETLB, -1, 0);
+    if (ptr != MAP_FAILED) return ptr;
+#endif
+    return NULL;
+  }
+
+  void os_advise_huge_pages(void* ptr, size_t bytes)
+  {
+#if defined(MADV_HUGEPAGE)
+    /* only full huge pages inside the range can be backed */
+    const size_t hugePageSize = 2*1024*1024;
+    const size_t begin = ((size_t)ptr+hugePageSize-1) & (-hugePageSize);
+    const size_t end   = ((size_t)ptr+bytes) & (-hugePageSize);
+    if (begin >= end) return;
+    madvise((void*)begin,end-begin,MADV_HUGEPAGE);
+#endif
+  }
+
+  void* os_map_file(const char* fileName, size_t& bytes)
+  {
+    int fd = open(fileName,O_RDONLY);
+    if (fd == -1) return NULL;
+    struct stat st;
+    if (fstat(fd,&st) == -1 || st.st_size == 0) { close(fd); return NULL; }
+    void* ptr = mmap(0, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED) return NULL;
+    bytes = st.st_size;
+    return ptr;
+  }
+
+  void os_unmap_file(void* ptr, size_t bytes) 
+  {
+    if (bytes == 0) return;
+    munmap(ptr,bytes);
+  }
+
+#if defined(__LINUX__)
+
+  /*! memory policies of the mbind system call, we invoke the system
+   *  call directly to not depend on libnuma */
+  static const int MPOL_BIND_ = 2;
+  static const int MPOL_INTERLEAVE_ = 3;
+
+  static void os_numa_policy(void* ptr, size_t bytes, int mode, const unsigned long* mask, size_t maxNode)
+  {
+    /* only full pages inside the range are affected */
+    const size_t begin = ((size_t)ptr+4095) & (-4096);
+    const size_t end   = ((size_t)ptr+bytes) & (-4096);
+    if (begin >= end) return;
+    syscall(SYS_mbind,begin,end-begin,mode,mask,maxNode+1,0); // failure only affects performance
+  }
+
+  void os_numa_interleave(void* ptr, size_t bytes) 
+  {
+    unsigned long mask[16]; memset(mask,0,sizeof(mask));
+    size_t numNodes = getNumberOfNumaNodes();
+    if (numNodes > 8*sizeof(mask)) numNodes = 8*sizeof(mask);
+    for (size_t node=0; node<numNodes; node++)
+      mask[node/(8*sizeof(long))] |= 1UL << (node%(8*sizeof(long)));
+    os_numa_policy(ptr,bytes,MPOL_INTERLEAVE_,mask,8*sizeof(mask));
+  }
+
+  void os_numa_bind(void* ptr, size_t bytes, size_t node)
+  {
+    unsigned long mask[16]; memset(mask,0,sizeof(mask));
+    if (node >= 8*sizeof(mask)) return;
+    mask[node/(8*sizeof(long))] = 1UL << (node%(8*sizeof(long)));
+    os_numa_policy(ptr,bytes,MPOL_BIND_,mask,8*sizeof(mask));
+  }
+
+#else
+
+  void os_numa_interleave(void* ptr, size_t bytes) {
+  }
+
+  void os_numa_bind(void* ptr, size_t bytes, size_t node) {
+  }
+
+#endif
+
 #if defined(__MIC__)
 
   static double getFrequencyInMHz()
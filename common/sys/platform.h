@@ -297,6 +297,21 @@ namespace embree
   void  os_shrink (void* ptr, size_t bytesNew, size_t bytesOld);
   void  os_free   (void* ptr, size_t bytes);
 
+  /*! reserves memory backed by explicit 2MB huge pages, returns NULL if no huge pages are available */
+  void* os_reserve_huge(size_t bytes);
+
+  /*! asks the OS to back the range with transparent huge pages, failure only affects performance */
+  void  os_advise_huge_pages(void* ptr, size_t bytes);
+
+  /*! maps a file copy-on-write into memory, returns NULL if the file cannot be mapped */
+  void* os_map_file  (const char* fileName, size_t& bytes);
+  void  os_unmap_file(void* ptr, size_t bytes);
+
+  /*! sets the NUMA placement of pages that are not touched yet, the
+   *  pages get interleaved over all nodes or are bound to a single node */
+  void  os_numa_interleave(void* ptr, size_t bytes);
+  void  os_numa_bind      (void* ptr, size_t bytes, size_t node);
+
   /*! returns performance counter in seconds */
   double getSeconds();
 }
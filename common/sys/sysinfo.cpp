@@ -18,6 +18,9 @@
 #include "intrinsics.h"
 #include "stl/string.h"
 
+#include <vector>
+#include <algorithm>
+
 ////////////////////////////////////////////////////////////////////////////////
 /// All Platforms
 ////////////////////////////////////////////////////////////////////////////////
@@ -245,6 +248,26 @@ namespace embree
     if (features & CPU_FEATURE_KNC   ) str += "KNC ";
     return str;
   }
+
+  /*! sorts the logical threads by NUMA node */
+  static std::vector<size_t> sortLogicalThreadsByNumaNode()
+  {
+    std::vector<size_t> threads;
+    const size_t numNodes = getNumberOfNumaNodes();
+    const size_t numThreads = getNumberOfLogicalThreads();
+    for (size_t node=0; node<numNodes; node++)
+      for (size_t thread=0; thread<numThreads; thread++)
+        if (getNumaNodeOfLogicalThread(thread) == node) 
+          threads.push_back(thread);
+    return threads;
+  }
+
+  size_t getNumaAwareLogicalThread(size_t threadIndex)
+  {
+    static std::vector<size_t> threads = sortLogicalThreadsByNumaNode();
+    if (threads.size() == 0) return threadIndex;
+    return threads[threadIndex % threads.size()];
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -279,6 +302,24 @@ namespace embree
 #endif
   }
 
+  size_t getNumberOfNumaNodes() 
+  {
+    ULONG highestNode = 0;
+    if (!GetNumaHighestNodeNumber(&highestNode)) return 1;
+    return highestNode+1;
+  }
+
+  size_t getNumaNodeOfLogicalThread(size_t thread)
+  {
+    UCHAR node = 0;
+    if (thread >= 64 || !GetNumaProcessorNode((UCHAR)thread,&node) || node == 0xFF) return 0;
+    return node;
+  }
+
+  size_t getNumaNodeOfCurrentThread() {
+    return getNumaNodeOfLogicalThread(GetCurrentProcessorNumber());
+  }
+
   int getTerminalWidth() 
   {
     HANDLE handle = GetStdHandle(STD_OUTPUT_HANDLE);
@@ -298,6 +339,7 @@ namespace embree
 
 #include <stdio.h>
 #include <unistd.h>
+#include <sched.h>
 
 namespace embree
 {
@@ -309,6 +351,70 @@ namespace embree
     if (bytes != -1) buf[bytes] = '\0';
     return std::string(buf);
   }
+
+  /*! parses a list of ranges like 0-3,8-11 as found in /sys */
+  static bool readRangeList(const char* fileName, std::vector<size_t>& list)
+  {
+    FILE* file = fopen(fileName,"r");
+    if (!file) return false;
+    int begin = 0, end = 0;
+    while (fscanf(file,"%d",&begin) == 1) 
+    {
+      end = begin;
+      int c = fgetc(file);
+      if (c == '-') { if (fscanf(file,"%d",&end) != 1) break; c = fgetc(file); }
+      for (int i=begin; i<=end; i++) list.push_back(i);
+      if (c != ',') break;
+    }
+    fclose(file);
+    return true;
+  }
+
+  /*! NUMA node of each logical thread as reported by the kernel */
+  static std::vector<size_t> readNumaTopology()
+  {
+    std::vector<size_t> thread2node(getNumberOfLogicalThreads(),0);
+    std::vector<size_t> nodes;
+    if (!readRangeList("/sys/devices/system/node/online",nodes)) 
+      return thread2node;
+
+    for (size_t i=0; i<nodes.size(); i++) 
+    {
+      char fileName[256]; sprintf(fileName,"/sys/devices/system/node/node%d/cpulist",int(nodes[i]));
+      std::vector<size_t> threads; readRangeList(fileName,threads);
+      for (size_t j=0; j<threads.size(); j++)
+        if (threads[j] < thread2node.size()) thread2node[threads[j]] = nodes[i];
+    }
+    return thread2node;
+  }
+
+  static const std::vector<size_t>& getNumaTopology() {
+    static std::vector<size_t> thread2node = readNumaTopology();
+    return thread2node;
+  }
+
+  size_t getNumberOfNumaNodes() 
+  {
+    const std::vector<size_t>& thread2node = getNumaTopology();
+    size_t numNodes = 1;
+    for (size_t i=0; i<thread2node.size(); i++)
+      numNodes = std::max(numNodes,thread2node[i]+1);
+    return numNodes;
+  }
+
+  size_t getNumaNodeOfLogicalThread(size_t thread) 
+  {
+    const std::vector<size_t>& thread2node = getNumaTopology();
+    if (thread >= thread2node.size()) return 0;
+    return thread2node[thread];
+  }
+
+  size_t getNumaNodeOfCurrentThread() 
+  {
+    int thread = sched_getcpu();
+    if (thread < 0) return 0;
+    return getNumaNodeOfLogicalThread(thread);
+  }
 }
 
 #endif
@@ -330,6 +436,18 @@ namespace embree
     if (_NSGetExecutablePath(buf, &size) != 0) return std::string();
     return std::string(buf);
   }
+
+  size_t getNumberOfNumaNodes() {
+    return 1;
+  }
+
+  size_t getNumaNodeOfLogicalThread(size_t thread) {
+    return 0;
+  }
+
+  size_t getNumaNodeOfCurrentThread() {
+    return 0;
+  }
 }
 
 #endif
@@ -74,6 +74,19 @@ namespace embree
 
   /*! return the number of logical threads of the system */
   size_t getNumberOfLogicalThreads();
+
+  /*! return the number of NUMA nodes of the system */
+  size_t getNumberOfNumaNodes();
+
+  /*! returns the NUMA node a logical thread belongs to */
+  size_t getNumaNodeOfLogicalThread(size_t thread);
+
+  /*! returns the NUMA node the calling thread is currently running on */
+  size_t getNumaNodeOfCurrentThread();
+
+  /*! maps a thread index to a logical thread, such that consecutive
+   *  thread indices fill up one NUMA node before the next one is used */
+  size_t getNumaAwareLogicalThread(size_t threadIndex);
   
   /*! returns the size of the terminal window in characters */
   int getTerminalWidth();
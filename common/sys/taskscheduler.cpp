@@ -16,6 +16,7 @@
 
 #include "taskscheduler.h"
 #include "taskscheduler_sys.h"
+#include "taskscheduler_steal.h"
 #if defined(__MIC__)
 #include "taskscheduler_mic.h"
 #endif
@@ -41,7 +42,7 @@ namespace embree
   
   TaskScheduler* TaskScheduler::instance = NULL;
 
-  void TaskScheduler::create(size_t numThreads)
+  void TaskScheduler::create(size_t numThreads, TYPE type, bool spawnThreads)
   {
     if (instance)
       throw std::runtime_error("Embree threads already running.");
@@ -51,13 +52,18 @@ namespace embree
     instance = new TaskSchedulerMIC; 
     //instance = new TaskSchedulerSys; 
 #else
-    instance = new TaskSchedulerSys; 
+    switch (type) {
+    case DEFAULT      : instance = new TaskSchedulerSteal; break;
+    case GLOBAL_QUEUE : instance = new TaskSchedulerSys; break;
+    case WORK_STEALING: instance = new TaskSchedulerSteal; break;
+    default           : throw std::runtime_error("invalid task scheduler");
+    }
 #endif
 
 #if 1
-    instance->createThreads(numThreads);
+    instance->createThreads(numThreads,spawnThreads);
 #else
-    instance->createThreads(1);
+    instance->createThreads(1,spawnThreads);
     std::cout << "WARNING: Using only a single thread." << std::endl;
 #endif
   }
@@ -68,6 +74,19 @@ namespace embree
     return instance->numThreads;
   }
 
+  bool TaskScheduler::hasUserThreads() 
+  {
+    if (!instance) throw std::runtime_error("Embree tasks not running.");
+    return instance->userThreads;
+  }
+
+  void TaskScheduler::processTask(size_t threadIndex, size_t threadCount)
+  {
+    if (!instance) throw std::runtime_error("Embree tasks not running.");
+    if (threadIndex >= instance->numThreads) throw std::runtime_error("invalid thread index");
+    instance->work(threadIndex,threadCount,false);
+  }
+
   void TaskScheduler::addTask(ssize_t threadIndex, QUEUE queue, Task* task)
   {
     if (!instance) throw std::runtime_error("Embree tasks not running.");
@@ -125,11 +144,12 @@ namespace embree
   }
 
   TaskScheduler::TaskScheduler () 
-    : terminateThreads(false), numThreads(0), thread2event(NULL) {}
+    : terminateThreads(false), numThreads(0), userThreads(false), thread2event(NULL) {}
 
-  void TaskScheduler::createThreads(size_t numThreads_in)
+  void TaskScheduler::createThreads(size_t numThreads_in, bool spawnThreads)
   {
     numThreads = numThreads_in;
+    userThreads = !spawnThreads;
 #if defined(__MIC__)
     if (numThreads == 0) numThreads = getNumberOfLogicalThreads()-4;
 #else
@@ -142,9 +162,12 @@ namespace embree
 
     memset(thread2event,0,numThreads*sizeof(ThreadEvent));
 
-    /* generate all threads */
-    for (size_t t=0; t<numThreads; t++) {
-      threads.push_back(createThread((thread_func)threadFunction,new Thread(t,numThreads,this),4*1024*1024,t));
+    /* initialize scheduler specific per thread data */
+    init(numThreads);
+
+    /* generate all threads, threads with neighboring indices share a NUMA node */
+    for (size_t t=0; t<numThreads && spawnThreads; t++) {
+      threads.push_back(createThread((thread_func)threadFunction,new Thread(t,numThreads,this),4*1024*1024,getNumaAwareLogicalThread(t)));
     }
 
     //setAffinity(0);
@@ -37,6 +37,9 @@ namespace embree
     /*! Task queues */
     enum QUEUE { GLOBAL_FRONT, GLOBAL_BACK };
 
+    /*! Task scheduler implementations */
+    enum TYPE { DEFAULT, GLOBAL_QUEUE, WORK_STEALING };
+
 #define TASK_RUN_FUNCTION(Class,name)                                   \
     void name(size_t threadIndex, size_t threadCount, size_t taskIndex, size_t taskCount, TaskScheduler::Event* taskGroup); \
     static void _##name(void* This, size_t threadIndex, size_t threadCount, size_t taskIndex, size_t taskCount, TaskScheduler::Event* taskGroup) { \
@@ -140,12 +143,18 @@ namespace embree
     /*! single instance of task scheduler */
     static TaskScheduler* instance;
     
-    /*! creates the threads */
-    static void create(size_t numThreads = 0);
+    /*! creates the threads, if no threads get spawned the application has to provide them */
+    static void create(size_t numThreads = 0, TYPE type = DEFAULT, bool spawnThreads = true);
 
     /*! returns the number of threads used */
     static size_t getNumThreads();
 
+    /*! returns true if the worker threads are provided by the application */
+    static bool hasUserThreads();
+
+    /*! processes the next task as worker thread threadIndex, returns if no task is available */
+    static void processTask(size_t threadIndex, size_t threadCount);
+
     /*! add a task to the scheduler */
     static void addTask(ssize_t threadIndex, QUEUE queue, Task* task);
 
@@ -168,11 +177,14 @@ namespace embree
   protected:
 
     /*! creates all threads */
-    void createThreads(size_t numThreads);
+    void createThreads(size_t numThreads, bool spawnThreads);
 
     /*! thread function */
     static void threadFunction(void* thread);
 
+    /*! initializes per thread data before the threads get started */
+    virtual void init(size_t numThreads) {}
+
     /*! thread function */
     virtual void run(size_t threadIndex, size_t threadCount) = 0;
 
@@ -182,6 +194,11 @@ namespace embree
     /*! waits for an event out of a task */
     virtual void wait(size_t threadIndex, size_t threadCount, Event* event) = 0;
 
+    /*! processes next task */
+    virtual void work(size_t threadIndex, size_t threadCount, bool wait) { 
+      throw std::runtime_error("task scheduler does not support application threads"); 
+    }
+
     /*! sets the terminate thread variable */
     virtual void terminate() = 0;
 
@@ -193,6 +210,7 @@ namespace embree
     volatile bool terminateThreads;
     std::vector<thread_t> threads;
     size_t numThreads;
+    bool userThreads;
     struct __align(64) ThreadEvent { 
       Event* event; 
       char align[64-sizeof(Event*)];
@@ -0,0 +1,186 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "taskscheduler_steal.h"
+#include "tasklogger.h"
+
+namespace embree
+{
+  TaskSchedulerSteal::TaskSchedulerSteal()
+    : queues(NULL), numTasks(0), numSleeping(0) {}
+
+  TaskSchedulerSteal::~TaskSchedulerSteal() {
+    delete[] queues; queues = NULL;
+  }
+
+  void TaskSchedulerSteal::init(size_t numThreads)
+  {
+    delete[] queues;
+    queues = new TaskQueue[numThreads+1];
+  }
+
+  bool TaskSchedulerSteal::TaskQueue::take(bool steal, Task*& task, size_t& elt)
+  {
+    /* test without lock first */
+    if (end == begin) return false;
+
+    Lock<AtomicMutex> lock(mutex);
+    if (end == begin) return false;
+
+    /* owner works depth first, thieves take the oldest tasks */
+    size_t i = steal ? begin : end-1;
+    task = tasks[i&(tasks.size()-1)];
+    elt = --task->started;
+    if (elt == 0) {
+      if (steal) begin++;
+      else       end--;
+    }
+    return true;
+  }
+
+  bool TaskSchedulerSteal::take(size_t threadIndex, Task*& task, size_t& elt)
+  {
+    bool found = false;
+
+    /* first look into own deque */
+    if (threadIndex < numThreads)
+      found = queues[threadIndex].take(false,task,elt);
+
+    /* then into deque of tasks added by application threads */
+    if (!found)
+      found = queues[numThreads].take(false,task,elt);
+
+    /* steal from other threads */
+    for (size_t i=1; i<numThreads && !found; i++)
+      found = queues[(threadIndex+i)%numThreads].take(true,task,elt);
+
+    if (found && elt == 0) numTasks--;
+    return found;
+  }
+
+  void TaskSchedulerSteal::add(ssize_t threadIndex, QUEUE queue, Task* task)
+  {
+    if (task->event)
+      task->event->inc();
+
+    /* tasks of application threads go to the shared deque */
+    if (threadIndex < 0 || threadIndex >= (ssize_t)numThreads)
+      threadIndex = numThreads;
+
+    TaskQueue& q = queues[threadIndex];
+    q.mutex.lock();
+
+    /*! resize array if too small */
+    if (q.end-q.begin == q.tasks.size())
+    {
+      size_t s0 = 1*q.tasks.size();
+      size_t s1 = 2*q.tasks.size();
+      q.tasks.resize(s1);
+      for (size_t i=q.begin; i!=q.end; i++)
+        q.tasks[i&(s1-1)] = q.tasks[i&(s0-1)];
+    }
+
+    /*! insert task to correct end of deque */
+    switch (queue) {
+    case GLOBAL_FRONT: { size_t i = (--q.begin)&(q.tasks.size()-1); q.tasks[i] = task; break; }
+    case GLOBAL_BACK : { size_t i = (q.end++  )&(q.tasks.size()-1); q.tasks[i] = task; break; }
+    default          : q.mutex.unlock(); throw std::runtime_error("invalid task queue");
+    }
+    q.mutex.unlock();
+    numTasks++;
+
+    /*! wake up threads only if some are sleeping */
+    if (numSleeping) {
+      mutex.lock();
+      condition.broadcast();
+      mutex.unlock();
+    }
+  }
+
+  void TaskSchedulerSteal::wait(size_t threadIndex, size_t threadCount, Event* event)
+  {
+    event->dec();
+    while (!event->triggered()) {
+      work(threadIndex,threadCount,false);
+    }
+  }
+
+  void TaskSchedulerSteal::work(size_t threadIndex, size_t threadCount, bool wait)
+  {
+    Task* task = NULL;
+    size_t elt = 0;
+    size_t spins = 0;
+
+    /* find next task to process */
+    while (!take(threadIndex,task,elt))
+    {
+      /* terminate this thread */
+      if (terminateThreads)
+        throw TaskScheduler::Terminate();
+
+      if (!wait) return;
+
+      /* spin some time before going to sleep */
+      if (++spins < MAX_SPIN_ITERATIONS) {
+        _mm_pause();
+        continue;
+      }
+      spins = 0;
+
+      /* sleep until new tasks get available */
+      numSleeping++;
+      mutex.lock();
+      while (numTasks == 0 && !terminateThreads)
+        condition.wait(mutex);
+      mutex.unlock();
+      numSleeping--;
+    }
+
+    /* run the task */
+    TaskScheduler::Event* event = task->event;
+    thread2event[threadIndex].event = event;
+    if (task->run) {
+      size_t taskID = TaskLogger::beginTask(threadIndex,task->name,elt);
+      task->run(task->runData,threadIndex,threadCount,elt,task->elts,task->event);
+      TaskLogger::endTask(threadIndex,taskID);
+    }
+
+    /* complete the task */
+    if (--task->completed == 0) {
+      if (task->complete) {
+        size_t taskID = TaskLogger::beginTask(threadIndex,task->name,0);
+        task->complete(task->completeData,threadIndex,threadCount,task->event);
+        TaskLogger::endTask(threadIndex,taskID);
+      }
+      if (event) event->dec();
+    }
+  }
+
+  void TaskSchedulerSteal::run(size_t threadIndex, size_t threadCount)
+  {
+    while (true)
+      work(threadIndex,threadCount,true);
+  }
+
+  void TaskSchedulerSteal::terminate()
+  {
+    mutex.lock();
+    terminateThreads = true;
+    condition.broadcast();
+    mutex.unlock();
+  }
+}
+
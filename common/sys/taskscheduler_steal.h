@@ -0,0 +1,94 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef __EMBREE_TASKSCHEDULER_STEAL_H__
+#define __EMBREE_TASKSCHEDULER_STEAL_H__
+
+#include "taskscheduler.h"
+#include "sys/sync/mutex.h"
+#include "sys/sync/condition.h"
+
+namespace embree
+{
+  /*! Task scheduler with one task deque per thread. Threads push and
+   *  pop tasks at the end of their own deque and steal tasks from the
+   *  begin of the deques of other threads. Tasks added from outside the
+   *  worker threads go to an additional shared deque. */
+  class __hidden TaskSchedulerSteal : public TaskScheduler
+  {
+  public:
+
+    /*! number of spin iterations before an idle thread goes to sleep */
+    static const size_t MAX_SPIN_ITERATIONS = 1024;
+
+    /*! construction */
+    TaskSchedulerSteal();
+
+    /*! destruction */
+    ~TaskSchedulerSteal();
+
+  private:
+
+    /*! allocates one deque per thread */
+    void init(size_t numThreads);
+
+    /*! adds a task to the deque of the calling thread */
+    void add(ssize_t threadIndex, QUEUE queue, Task* task);
+
+    /*! waits for an event out of a task */
+    void wait(size_t threadIndex, size_t threadCount, Event* event);
+
+    /*! processes next task */
+    void work(size_t threadIndex, size_t threadCount, bool wait);
+
+    /*! thread function */
+    void run(size_t threadIndex, size_t threadCount);
+
+    /*! sets the terminate thread variable */
+    void terminate();
+
+  private:
+
+    /*! task deque of a single thread */
+    struct __align(64) TaskQueue
+    {
+      ALIGNED_STRUCT;
+
+      TaskQueue () : begin(0), end(0), tasks(1024) {}
+
+      /*! takes next work item from the deque, the owner takes from the end, thieves from the begin */
+      bool take(bool steal, Task*& task, size_t& elt);
+
+    public:
+      AtomicMutex mutex;        //!< only contended when other threads steal
+      volatile size_t begin,end; //!< current range of tasks
+      std::vector<Task*> tasks;  //!< ring buffer of tasks
+    };
+
+    /*! tries to get a work item from the own deque, the shared deque, or some other thread */
+    bool take(size_t threadIndex, Task*& task, size_t& elt);
+
+  private:
+    TaskQueue* queues;        //!< deques of all threads plus shared deque
+    AtomicCounter numTasks;   //!< number of tasks in all deques
+    AtomicCounter numSleeping; //!< number of threads waiting for tasks
+    MutexSys mutex;           //!< mutex to protect sleeping
+    ConditionSys condition;   //!< condition to signal new tasks to sleeping threads
+  };
+}
+
+#endif
+
@@ -56,6 +56,18 @@
   
   threads = num,       // sets the number of threads to use (default is to use all threads)
   verbose = num,       // sets verbosity level (default is 0)
+  numa = first_touch,  // places BVH memory on the NUMA node of the building thread (default)
+  numa = interleave,   // interleaves BVH memory over all NUMA nodes
+  numa_replicate = 1,  // copies static BVHs into the memory of each NUMA node
+  huge_pages = off,    // backs BVH memory with normal pages (default)
+  huge_pages = transparent, // backs BVH memory with transparent 2MB huge pages where the OS supports them
+  huge_pages = explicit,    // backs BVH memory with reserved 2MB huge pages, falls back to transparent huge pages
+  refit_rotate = 1.25, // rotates refitted BVHs once their SAH cost grew by this factor, 0 disables (default is 1.25)
+  refit_rebuild = 2.0, // rebuilds refitted BVHs once their SAH cost grew by this factor, 0 disables (default is 2.0)
+  morton64_threshold = num, // Morton builders use 64 bit codes for more than num primitives (default is 16777216)
+  hybrid_threshold = adaptive, // tunes the packet to single ray switch of hybrid traversal per scene and ray kind at runtime (default)
+  hybrid_threshold = fixed,    // switches from packet to single ray traversal at the fixed default number of active rays
+  hybrid_threshold = num,      // switches from packet to single ray traversal at num or less active rays, num is 0 to 8
 
   If Embree is started on an unsupported CPU, rtcInit will fail and
   set the RTC_UNSUPPORTED_CPU error code.
@@ -89,6 +101,25 @@ enum RTCError {
   currently stored error and clears the error flag again. */
 RTCORE_API RTCError rtcGetError();
 
+/*! \brief Type of memory monitor callback function. 
+
+  Gets invoked with the number of bytes a build is about to allocate
+  for an acceleration structure and its temporary build data, and
+  with the negative number of bytes when this memory gets released
+  again. Returning false vetoes the allocation, the vetoed
+  acceleration structure then stays empty and the commit reports
+  RTC_OUT_OF_MEMORY. Releases cannot be vetoed. The function may get
+  called from different threads. */
+typedef bool (*RTCMemoryMonitorFunc)(const ptrdiff_t bytes);
+
+/*! \brief Sets the memory monitor callback function.
+
+  Installs a function that gets informed about the memory allocated
+  by builds and can veto these allocations, e.g. to keep the memory
+  consumption inside some budget. Passing NULL removes the
+  callback. */
+RTCORE_API void rtcSetMemoryMonitorFunction(RTCMemoryMonitorFunc func);
+
 /*! \brief Implementation specific (do not call).
 
   This function is implementation specific and only for debugging
@@ -104,6 +104,69 @@ RTCORE_API unsigned rtcNewTriangleMesh (RTCScene scene,                    //!<
                                         size_t numTimeSteps = 1            //!< number of motion blur time steps
   );
 
+/*! \brief Triangles and vertices of one mesh created with rtcNewTriangleMeshes. */
+struct RTCMeshRange
+{
+  size_t firstTriangle;   //!< index of the first triangle of the mesh inside the index array
+  size_t numTriangles;    //!< number of triangles of the mesh
+  size_t firstVertex;     //!< index of the first vertex of the mesh inside the vertex array
+  size_t numVertices;     //!< number of vertices of the mesh
+};
+
+/*! \brief Creates many triangle meshes at once. All meshes share the
+  index array (indices) and vertex array (vertices) of the
+  application, which use the default layouts of rtcNewTriangleMesh
+  and have to stay valid as long as the meshes exist, like buffers
+  passed to rtcSetBuffer. Mesh i consists of the triangles and
+  vertices specified by ranges[i], its vertex indices are relative to
+  ranges[i].firstVertex. The geometry IDs of the meshes are written to
+  geomIDs. Compared to creating the meshes one by one, no buffers get
+  allocated, mapped, and copied. */
+RTCORE_API void rtcNewTriangleMeshes (RTCScene scene,                    //!< the scene the meshes belong to
+                                      RTCGeometryFlags flags,            //!< geometry flags of all meshes
+                                      size_t numMeshes,                  //!< number of meshes to create
+                                      const RTCMeshRange* ranges,        //!< triangle and vertex range of each mesh
+                                      void* indices,                     //!< shared index array
+                                      void* vertices,                    //!< shared vertex array
+                                      unsigned* geomIDs                  //!< returns the geometry ID of each mesh
+  );
+
+/*! \brief Creates a new quad mesh. The number of quads (numQuads),
+  number of vertices (numVertices), and number of time steps have to
+  get specified. Motion blurred quad meshes are not supported yet,
+  thus the number of time steps has to be 1, otherwise an
+  RTC_INVALID_OPERATION error is recorded. The index buffer
+  (RTC_INDEX_BUFFER) stores four 32 bit integer indices for each quad,
+  the vertex buffer (RTC_VERTEX_BUFFER) has the same layout as for
+  triangle meshes. Each quad (v0,v1,v2,v3) is intersected as the two
+  triangles (v0,v1,v3) and (v2,v3,v1) and the reported u and v
+  coordinates run from v0 to v1 and from v0 to v3, respectively.
+  Triangles can be specified by repeating the last vertex. */
+RTCORE_API unsigned rtcNewQuadMesh (RTCScene scene,                    //!< the scene the mesh belongs to
+                                    RTCGeometryFlags flags,            //!< geometry flags
+                                    size_t numQuads,                   //!< number of quads
+                                    size_t numVertices,                //!< number of vertices
+                                    size_t numTimeSteps = 1            //!< number of motion blur time steps
+  );
+
+/*! \brief Creates a new set of hair curves. The number of curves
+  (numCurves), number of vertices (numVertices), and number of time
+  steps (1 for normal curves, and 2 for linear motion blur), have to
+  get specified. Each curve is a cubic bezier curve of varying
+  radius. The index buffer (RTC_INDEX_BUFFER) stores a single 32 bit
+  integer index for each curve that points to the first of four
+  consecutive control points in the vertex buffer
+  (RTC_VERTEX_BUFFER). Each control point stores single precision
+  x,y,z coordinates and the radius r of the curve at that control
+  point. Motion blurred curves are currently not supported by the
+  default acceleration structures. */
+RTCORE_API unsigned rtcNewQuadraticBezierCurves (RTCScene scene,                    //!< the scene the curves belong to
+                                                 RTCGeometryFlags flags,            //!< geometry flags
+                                                 size_t numCurves,                  //!< number of curves
+                                                 size_t numVertices,                //!< number of vertices
+                                                 size_t numTimeSteps = 1            //!< number of motion blur time steps
+  );
+
 /*! \brief Sets 32 bit ray mask. */
 RTCORE_API void rtcSetMask (RTCScene scene, unsigned geomID, int mask);
 
@@ -149,6 +149,40 @@ public:
   int   instID[16];  //!< instance ID
 };
 
+/*! \brief Ray structure for streams of N rays stored as structure of
+ *  arrays. Each member points to an array of N elements. */
+struct RTCRayNp
+{
+  /* ray data */
+public:
+  float* orgx;  //!< x coordinates of ray origins
+  float* orgy;  //!< y coordinates of ray origins
+  float* orgz;  //!< z coordinates of ray origins
+  
+  float* dirx;  //!< x coordinates of ray directions
+  float* diry;  //!< y coordinates of ray directions
+  float* dirz;  //!< z coordinates of ray directions
+  
+  float* tnear; //!< Start of ray segments
+  float* tfar;  //!< End of ray segments (set to hit distance)
+
+  float* time;  //!< Time of the rays for motion blur
+  int*   mask;  //!< Used to mask out objects during traversal
+  
+  /* hit data */
+public:
+  float* Ngx;   //!< x coordinates of geometry normals
+  float* Ngy;   //!< y coordinates of geometry normals
+  float* Ngz;   //!< z coordinates of geometry normals
+  
+  float* u;     //!< Barycentric u coordinates of hits
+  float* v;     //!< Barycentric v coordinates of hits
+  
+  int*   geomID;  //!< geometry IDs
+  int*   primID;  //!< primitive IDs
+  int*   instID;  //!< instance IDs
+};
+
 /*! @} */
 
 #endif
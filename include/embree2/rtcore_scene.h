@@ -25,6 +25,10 @@ struct RTCRay;
 struct RTCRay4;
 struct RTCRay8;
 struct RTCRay16;
+struct RTCRayNp;
+
+/*! maximal number of rays of a packet passed to rtcIntersectPacket and rtcOccludedPacket */
+#define RTC_MAX_PACKET_SIZE 256
 
 /*! scene flags */
 enum RTCSceneFlags 
@@ -37,7 +41,7 @@ enum RTCSceneFlags
   RTC_SCENE_COMPACT    = (1 << 8),    //!< use memory conservative data structures
   RTC_SCENE_COHERENT   = (1 << 9),    //!< optimize data structures for coherent rays
   RTC_SCENE_INCOHERENT = (1 << 10),    //!< optimize data structures for in-coherent rays (enabled by default)
-  RTC_SCENE_HIGH_QUALITY = (1 << 11),  //!< create higher quality data structures
+  RTC_SCENE_HIGH_QUALITY = (1 << 11),  //!< create higher quality data structures, in dynamic scenes the BVH of dynamic geometry gets restructured after each build
 
   /* traversal algorithm flags */
   RTC_SCENE_ROBUST     = (1 << 16)     //!< use more robust traversal algorithms
@@ -52,6 +56,37 @@ enum RTCAlgorithmFlags
   RTC_INTERSECT16 = (1 << 3),   //!< enables the rtcIntersect16 and rtcOccluded16 functions for this scene
 };
 
+/*! traversal statistics modes */
+enum RTCStatisticsMode
+{
+  RTC_STATISTICS_DISABLED = 0,  //!< no statistics get collected (default)
+  RTC_STATISTICS_ENABLED  = 1,  //!< all ray queries get counted
+  RTC_STATISTICS_SAMPLED  = 2   //!< only a subset of the ray queries get counted and the counts get extrapolated
+};
+
+/*! traversal statistics of a scene */
+struct RTCStatistics
+{
+  size_t rays;         //!< number of traced rays
+  size_t nodes;        //!< number of traversed inner nodes, a node traversed by a ray packet counts once
+  size_t leaves;       //!< number of visited leaves, a leaf visited by a ray packet counts once
+  size_t primitives;   //!< number of intersected primitive blocks
+  size_t hits;         //!< number of rays that hit something
+  size_t filterCalls;  //!< number of invoked intersection filter functions
+  size_t instances;    //!< number of entered instances
+};
+
+/*! memory consumption of a scene or of one of its acceleration structures */
+struct RTCMemoryStatistics
+{
+  size_t nodes;          //!< bytes of inner nodes
+  size_t primitives;     //!< bytes of primitive leaves
+  size_t allocated;      //!< bytes allocated for nodes and leaves, including memory not used yet
+  size_t builderPeak;    //!< peak bytes of temporary memory used by the builds of this scene or structure
+  size_t sharedBuffers;  //!< bytes of geometry buffers shared with the application
+  size_t copiedBuffers;  //!< bytes of geometry buffers allocated by Embree
+};
+
 /*! \brief Defines an opaque scene type */
 typedef struct __RTCScene {}* RTCScene;
 
@@ -63,6 +98,71 @@ RTCORE_API RTCScene rtcNewScene (RTCSceneFlags flags, RTCAlgorithmFlags aflags);
  *  rays. */
 RTCORE_API void rtcCommit (RTCScene scene);
 
+/*! Commits the geometry of the scene using threads of the
+ *  application. This function has to get called concurrently by
+ *  threadCount application threads, each passing a different
+ *  threadIndex from 0 to threadCount-1. The calling threads process
+ *  the build tasks and all return once the scene is committed. Only
+ *  available if Embree got initialized with user_threads=N, where N
+ *  has to match threadCount. In this mode Embree does not create any
+ *  threads, and rtcCommit and rtcCommitAsync are not supported. */
+RTCORE_API void rtcCommitThread (RTCScene scene, unsigned int threadIndex, unsigned int threadCount);
+
+/*! Starts committing the geometry of the scene in the background and
+ *  returns immediately. For dynamic scenes the previously committed
+ *  version of the scene can still be traced while the new version
+ *  gets built. The geometry of the scene must not be modified until
+ *  the commit got finished with rtcCommitWait or rtcCommitPoll. */
+RTCORE_API void rtcCommitAsync (RTCScene scene);
+
+/*! Waits for a commit started with rtcCommitAsync. After this call
+ *  rays are traced against the new version of the scene. This
+ *  function must not be called while rays are traced. */
+RTCORE_API void rtcCommitWait (RTCScene scene);
+
+/*! Finishes a commit started with rtcCommitAsync if the build got
+ *  already completed and returns true in this case. Returns false if
+ *  the build is still running. Like rtcCommitWait, this function must
+ *  not be called while rays are traced. */
+RTCORE_API bool rtcCommitPoll (RTCScene scene);
+
+/*! Stores the acceleration structure of a committed static scene to
+ *  a file. Only scenes that contain just triangle meshes and use an
+ *  acceleration structure that does not reference the vertex arrays
+ *  can get stored, otherwise RTC_INVALID_OPERATION is reported. */
+RTCORE_API void rtcStoreScene (RTCScene scene, const char* filename);
+
+/*! Commits a static scene by memory mapping an acceleration structure
+ *  previously stored with rtcStoreScene instead of building it. The
+ *  scene has to contain the same geometry and has to be created with
+ *  the same flags as the stored scene, otherwise
+ *  RTC_INVALID_ARGUMENT is reported and the scene stays
+ *  uncommitted. */
+RTCORE_API void rtcLoadScene (RTCScene scene, const char* filename);
+
+/*! Enables or disables the collection of traversal statistics for
+ *  the scene. Each thread counts into its own counters, thus
+ *  statistics can get collected while rays are traced from multiple
+ *  threads. Rays that enter an instance get counted as rays of the
+ *  instanced scene, which collects its statistics separately. */
+RTCORE_API void rtcSetStatisticsMode (RTCScene scene, RTCStatisticsMode mode);
+
+/*! Returns the traversal statistics collected for the scene since
+ *  the last call to rtcClearStatistics. The counts are only
+ *  consistent when no rays are traced concurrently. */
+RTCORE_API void rtcGetStatistics (RTCScene scene, RTCStatistics* stats);
+
+/*! Resets the traversal statistics of the scene. */
+RTCORE_API void rtcClearStatistics (RTCScene scene);
+
+/*! Returns the memory consumption of a committed scene. The first
+ *  entry sums over the whole scene, the following entries break the
+ *  nodes, leaves, and build memory down for each acceleration
+ *  structure of the scene. Geometry buffers are only counted in the
+ *  first entry. At most maxStats entries get written to stats, the
+ *  number of available entries is returned. */
+RTCORE_API size_t rtcGetMemoryStatistics (RTCScene scene, RTCMemoryStatistics* stats, size_t maxStats);
+
 /*! Intersects a single ray with the scene. The ray has to be aligned
  *  to 16 bytes. This function can only be called for scenes with the
  *  RTC_INTERSECT1 flag set. */
@@ -113,6 +213,48 @@ RTCORE_API void rtcOccluded8 (const void* valid, RTCScene scene, RTCRay8& ray);
  *  instructions. */
 RTCORE_API void rtcOccluded16 (const void* valid, RTCScene scene, RTCRay16& ray);
 
+/*! Intersects a stream of N rays with the scene. The rays are stored
+ *  as an array of RTCRay structures that has to be aligned to 16
+ *  bytes. Internally the rays get sorted by direction octant and
+ *  origin and are regrouped into packets of the widest packet size
+ *  enabled for the scene; remaining rays are traced individually. The
+ *  rays can be arbitrarily incoherent. This function can be called
+ *  for scenes with any of the RTC_INTERSECT1, RTC_INTERSECT4, or
+ *  RTC_INTERSECT8 flags set. Scenes with only RTC_INTERSECT8 set
+ *  require a CPU with AVX, otherwise an RTC_INVALID_OPERATION error
+ *  is recorded and the rays are not traced. */
+RTCORE_API void rtcIntersectN (RTCScene scene, RTCRay* rays, size_t N);
+
+/*! Intersects a stream of N rays stored as structure of arrays with
+ *  the scene. Otherwise behaves like rtcIntersectN. */
+RTCORE_API void rtcIntersectNp (RTCScene scene, const RTCRayNp& rays, size_t N);
+
+/*! Tests if a stream of N rays is occluded by the scene. The rays are
+ *  stored as an array of RTCRay structures that has to be aligned to
+ *  16 bytes. Rays are regrouped into packets like for
+ *  rtcIntersectN. */
+RTCORE_API void rtcOccludedN (RTCScene scene, RTCRay* rays, size_t N);
+
+/*! Tests if a stream of N rays stored as structure of arrays is
+ *  occluded by the scene. Otherwise behaves like rtcOccludedN. */
+RTCORE_API void rtcOccludedNp (RTCScene scene, const RTCRayNp& rays, size_t N);
+
+/*! Intersects a large packet of N coherent rays stored as structure
+ *  of arrays with the scene, e.g. a tile of primary rays or the
+ *  shadow rays of a tile towards a point light. The packet gets
+ *  traversed as a whole, bounded by a frustum over all its rays,
+ *  which is fastest for packets of 64 to RTC_MAX_PACKET_SIZE rays
+ *  with similar origins and directions. Large packet traversal is
+ *  used for scenes with the RTC_INTERSECT8 flag set on CPUs that
+ *  support AVX, other scenes and packets of more than
+ *  RTC_MAX_PACKET_SIZE rays are traced like with rtcIntersectNp. */
+RTCORE_API void rtcIntersectPacket (RTCScene scene, const RTCRayNp& rays, size_t N);
+
+/*! Tests if a large packet of N coherent rays stored as structure of
+ *  arrays is occluded by the scene. Otherwise behaves like
+ *  rtcIntersectPacket. */
+RTCORE_API void rtcOccludedPacket (RTCScene scene, const RTCRayNp& rays, size_t N);
+
 /*! Deletes the scene. All contained geometry get also destroyed. */
 RTCORE_API void rtcDeleteScene (RTCScene scene);
 
@@ -25,6 +25,34 @@ namespace embree
   class Bounded : public RefCount {
   public:
     Bounded () : bounds(empty) {}
+
+    /*! stores the data structure into a stream, returns false if not supported */
+    virtual bool store(std::ostream& out) { return false; }
+
+    /*! initializes the data structure from a memory mapped file
+     *  instead of building it. The data starts at the specified
+     *  offset. Returns false if not supported, otherwise the object
+     *  takes ownership of the mapped memory. */
+    virtual bool load(void* file, size_t bytes, size_t offset) { return false; }
+
+    /*! creates a copy of the data structure in the memory of each
+     *  NUMA node, only supported for data structures that are not
+     *  modified anymore */
+    virtual void replicate() {}
+
+    /*! reorders the data structure in memory for cache efficient
+     *  traversal, only supported for data structures that are not
+     *  modified anymore */
+    virtual void layout() {}
+
+    /*! copies the data structure into a tightly sized memory region
+     *  and releases the memory it was built in, only supported for
+     *  data structures that are not modified anymore */
+    virtual void compact() {}
+
+    /*! adds the memory consumption of the data structure to the statistics */
+    virtual void memoryStatistics(RTCMemoryStatistics& stats) {}
+
   public:
     BBox3f bounds;
   };
@@ -72,6 +100,16 @@ namespace embree
     typedef void (*OccludedFunc16) (const void* valid, /*! pointer to valid mask */
                                     void* ptr,         /*!< pointer to user data */
                                     RTCRay16& ray      /*!< Ray packet to test occlusion. */);
+
+    /*! Type of intersect function pointer for large ray packets of up to RTC_MAX_PACKET_SIZE rays. */
+    typedef void (*IntersectFuncPacket)(void* ptr,           /*!< pointer to user data */
+                                        const RTCRayNp& rays, /*!< rays to intersect */
+                                        size_t N              /*!< number of rays */);
+
+    /*! Type of occlusion function pointer for large ray packets of up to RTC_MAX_PACKET_SIZE rays. */
+    typedef void (*OccludedFuncPacket) (void* ptr,           /*!< pointer to user data */
+                                        const RTCRayNp& rays, /*!< rays to test occlusion */
+                                        size_t N              /*!< number of rays */);
   
     struct Intersector1
     {
@@ -140,6 +178,23 @@ namespace embree
       IntersectFunc16 intersect;
       OccludedFunc16 occluded;
     };
+
+    struct IntersectorPacket 
+    {
+      IntersectorPacket (ErrorFunc error = NULL) 
+      : intersect((IntersectFuncPacket)error), occluded((OccludedFuncPacket)error), name(NULL) {}
+
+      IntersectorPacket (IntersectFuncPacket intersect, OccludedFuncPacket occluded, const char* name)
+      : intersect(intersect), occluded(occluded), name(name) {}
+
+      operator bool() const { return name; }
+      
+    public:
+      static const char* type;
+      const char* name;
+      IntersectFuncPacket intersect;
+      OccludedFuncPacket occluded;
+    };
   
   public:
 
@@ -179,6 +234,12 @@ namespace embree
       intersectors.intersector16.intersect(valid,intersectors.ptr,ray);
     }
 
+    /*! Intersects a large packet of N coherent rays with the scene. */
+    __forceinline void intersectPacket (const RTCRayNp& rays, size_t N) {
+      assert(intersectors.intersectorPacket.intersect);
+      intersectors.intersectorPacket.intersect(intersectors.ptr,rays,N);
+    }
+
     /*! Tests if single ray is occluded by the scene. */
     __forceinline void occluded (RTCRay& ray) {
       assert(intersectors.intersector1.occluded);
@@ -203,6 +264,12 @@ namespace embree
       intersectors.intersector16.occluded(valid,intersectors.ptr,ray);
     }
 
+    /*! Tests if a large packet of N coherent rays is occluded by the scene. */
+    __forceinline void occludedPacket (const RTCRayNp& rays, size_t N) {
+      assert(intersectors.intersectorPacket.occluded);
+      intersectors.intersectorPacket.occluded(intersectors.ptr,rays,N);
+    }
+
   public:
     struct Intersectors 
     {
@@ -227,6 +294,10 @@ namespace embree
           for (size_t i=0; i<ident; i++) std::cout << " ";
           std::cout << "intersector16 = " << intersector16.name << std::endl;
         }
+        if (intersectorPacket.name) {
+          for (size_t i=0; i<ident; i++) std::cout << " ";
+          std::cout << "intersectorPacket = " << intersectorPacket.name << std::endl;
+        }
       }
 
     public:
@@ -235,6 +306,7 @@ namespace embree
       Intersector4 intersector4;
       Intersector8 intersector8;
       Intersector16 intersector16;
+      IntersectorPacket intersectorPacket;
     } intersectors;
   };
 
@@ -257,6 +329,11 @@ namespace embree
   Accel::Intersector16 symbol((Accel::IntersectFunc16)intersector::intersect, \
                               (Accel::OccludedFunc16)intersector::occluded,\
                               TOSTRING(isa) "::" TOSTRING(symbol));
+
+#define DEFINE_INTERSECTOR_PACKET(symbol,intersector)                   \
+  Accel::IntersectorPacket symbol((Accel::IntersectFuncPacket)intersector::intersect, \
+                                  (Accel::OccludedFuncPacket)intersector::occluded, \
+                                  TOSTRING(isa) "::" TOSTRING(symbol));
 }
 
 #endif
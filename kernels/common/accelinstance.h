@@ -46,6 +46,33 @@ namespace embree
       bounds = accel->bounds;
     }
 
+    bool store(std::ostream& out) {
+      return accel->store(out);
+    }
+
+    void replicate() {
+      accel->replicate();
+    }
+
+    void layout() {
+      accel->layout();
+    }
+
+    void compact() {
+      accel->compact();
+    }
+
+    void memoryStatistics(RTCMemoryStatistics& stats) {
+      accel->memoryStatistics(stats);
+    }
+
+    bool load(void* file, size_t bytes, size_t offset) 
+    {
+      if (!accel->load(file,bytes,offset)) return false;
+      delete builder; builder = NULL; // no build required anymore
+      return true;
+    }
+
   private:
     Bounded* accel;
     Builder* builder;
@@ -116,6 +116,30 @@ namespace embree
       accels[i]->immutable();
   }
 
+  void AccelN::replicate()
+  {
+    for (size_t i=0; i<N; i++)
+      accels[i]->replicate();
+  }
+
+  void AccelN::layout()
+  {
+    for (size_t i=0; i<N; i++)
+      accels[i]->layout();
+  }
+
+  void AccelN::compact()
+  {
+    for (size_t i=0; i<N; i++)
+      accels[i]->compact();
+  }
+
+  void AccelN::memoryStatistics(RTCMemoryStatistics& stats)
+  {
+    for (size_t i=0; i<N; i++)
+      accels[i]->memoryStatistics(stats);
+  }
+
   void AccelN::build (size_t threadIndex, size_t threadCount) 
   {
     size_t validAccelIndex = 0;
@@ -140,6 +164,7 @@ namespace embree
       intersectors.intersector4 = Intersector4(&intersect4,&occluded4,"AccelN::intersector4");
       intersectors.intersector8 = Intersector8(&intersect8,&occluded8,"AccelN::intersector8");
       intersectors.intersector16= Intersector16(&intersect16,&occluded16,"AccelN::intersector16");
+      intersectors.intersectorPacket = Accel::IntersectorPacket();
     }
     
     /*! calculate bounds */
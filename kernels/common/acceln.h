@@ -45,6 +45,10 @@ namespace embree
   public:
     void print(size_t ident);
     void immutable();
+    void replicate();
+    void layout();
+    void compact();
+    void memoryStatistics(RTCMemoryStatistics& stats);
     void build (size_t threadIndex, size_t threadCount);
 
   public:
@@ -18,42 +18,179 @@
 
 namespace embree
 {
-  Alloc Alloc::global;
+  NumaPolicy g_numa_policy = NUMA_FIRST_TOUCH;
+  HugePages g_huge_pages = HUGE_PAGES_OFF;
+  RTCMemoryMonitorFunc g_memory_monitor = NULL;
+
+  bool memoryMonitor(ssize_t bytes)
+  {
+    RTCMemoryMonitorFunc monitor = g_memory_monitor;
+    if (monitor == NULL || bytes == 0) return true;
+    return monitor(bytes) || bytes < 0;
+  }
+
+  void* numa_reserve(size_t bytes)
+  {
+    /* small structures would waste most of an explicit huge page */
+    void* ptr = NULL;
+    if (g_huge_pages == HUGE_PAGES_EXPLICIT && bytes >= 2*1024*1024) 
+      ptr = os_reserve_huge(bytes);
+    if (ptr == NULL) {
+      ptr = os_reserve(bytes);
+      if (g_huge_pages != HUGE_PAGES_OFF) 
+        os_advise_huge_pages(ptr,bytes);
+    }
+    if (g_numa_policy == NUMA_INTERLEAVE) 
+      os_numa_interleave(ptr,bytes);
+    return ptr;
+  }
 
-  Alloc::Alloc () {
-    blocks.reserve(1024);
+  void numa_commit(void* ptr, size_t bytes)
+  {
+    os_commit(ptr,bytes);
+    if (g_numa_policy == NUMA_FIRST_TOUCH && getNumberOfNumaNodes() > 1) 
+      return; // fresh pages are zero already
+    memset(ptr,0,bytes);
   }
 
+  Alloc Alloc::global;
+
+  Alloc::Alloc () 
+    : head(0), numBlocks(0), numUsed(0), maxNumUsed(0), epoch(1) {}
+
   Alloc::~Alloc () {
   }
 
   size_t Alloc::size() const {
-    return size_t(blockSize)*blocks.size();
+    return size_t(blockSize)*size_t(numBlocks);
+  }
+
+  size_t Alloc::used() const {
+    return size_t(blockSize)*size_t(numUsed & ~clearing);
+  }
+
+  size_t Alloc::maxUsed() const {
+    return size_t(blockSize)*size_t(maxNumUsed);
+  }
+
+  Alloc::ThreadCache& Alloc::threadCache()
+  {
+    /* the cache gets invalid when the pool gets cleared */
+    static __thread ThreadCache cache = { NULL, 0, 0 };
+    if (unlikely(cache.pool != this || cache.epoch != epoch)) {
+      cache.pool = this;
+      cache.epoch = epoch;
+      cache.num = 0;
+    }
+    return cache;
+  }
+
+  atomic_t Alloc::enter()
+  {
+    while (true) 
+    {
+      const atomic_t used = atomic_add(&numUsed,1)+1;
+      if (likely(!(used & clearing))) return used;
+      atomic_add(&numUsed,-1);
+      while (numUsed & clearing) __pause();
+    }
   }
 
   void Alloc::clear()
   {
     Lock<MutexSys> lock(mutex);
-    for (size_t i=0; i<blocks.size(); i++)
-      alignedFree(blocks[i]);
-    blocks.clear();
+
+    /* closes the pool for malloc and free, fails if some blocks of the chunks are still in use */
+    if (atomic_cmpxchg(&numUsed,0,clearing) != 0) return; 
+    for (size_t i=0; i<chunks.size(); i++)
+      alignedFree(chunks[i]);
+    chunks.clear();
+    head = 0;
+    numBlocks = 0;
+    epoch++;
+    atomic_add(&numUsed,-clearing);
+  }
+
+  char* Alloc::allocChunk(size_t num)
+  {
+    char* chunk = (char*) alignedMalloc(num*blockSize,blockSize);
+    if (g_numa_policy == NUMA_INTERLEAVE) 
+      os_numa_interleave(chunk,num*blockSize);
+    chunks.push_back(chunk);
+    atomic_add(&numBlocks,num);
+    return chunk;
+  }
+
+  void* Alloc::grow()
+  {
+    Lock<MutexSys> lock(mutex);
+    if (head & ~tagMask) return NULL; // other thread grew the pool meanwhile
+    const size_t num = clamp(size_t(numBlocks),size_t(1),size_t(maxChunkBlocks));
+    char* chunk = allocChunk(num);
+    for (size_t i=1; i<num; i++)
+      push(chunk+i*blockSize);
+    return chunk;
+  }
+
+  void Alloc::reserve(size_t bytes)
+  {
+    enter();
+    {
+      Lock<MutexSys> lock(mutex);
+      const size_t need  = (bytes+blockSize-1)/blockSize;
+      const size_t avail = size_t(numBlocks)-min(size_t(numUsed-1),size_t(numBlocks));
+      if (need > avail) {
+        const size_t num = need-avail;
+        char* chunk = allocChunk(num);
+        for (size_t i=0; i<num; i++)
+          push(chunk+i*blockSize);
+      }
+    }
+    atomic_add(&numUsed,-1);
+  }
+
+  void Alloc::push(void* ptr)
+  {
+    while (true) 
+    {
+      const atomic_t h = head;
+      *(atomic_t*)ptr = h & ~tagMask;
+      const atomic_t nh = atomic_t(ptr) | ((h+1) & tagMask);
+      if (atomic_cmpxchg(&head,h,nh) == h) return;
+    }
   }
   
   void* Alloc::malloc() 
   {
-    Lock<MutexSys> lock(mutex);
-    if (blocks.size()) {
-      void* ptr = blocks.back();
-      blocks.pop_back();
-      return ptr;
+    /* track usage and high-water mark, the handed out block keeps the pool from getting cleared */
+    const atomic_t used = enter();
+    for (atomic_t m = maxNumUsed; used > m; m = maxNumUsed)
+      if (atomic_cmpxchg(&maxNumUsed,m,used) == m) break;
+
+    /* take block from the cache of the thread */
+    ThreadCache& cache = threadCache();
+    if (cache.num) return cache.blocks[--cache.num];
+
+    /* pop block from free stack, the tag protects against a block that got popped and pushed again in between */
+    while (true)
+    {
+      const atomic_t h = head;
+      char* ptr = (char*) (h & ~tagMask);
+      if (ptr == NULL) {
+        if (void* block = grow()) return block;
+        continue;
+      }
+      const atomic_t next = *(volatile atomic_t*)ptr;
+      const atomic_t nh = next | ((h+1) & tagMask);
+      if (atomic_cmpxchg(&head,h,nh) == h) return ptr;
     }
-    return alignedMalloc(blockSize,64);
   }
   
   void Alloc::free(void* ptr) 
   {
-    Lock<MutexSys> lock(mutex);
-    blocks.push_back(ptr);
+    ThreadCache& cache = threadCache();
+    if (cache.num < threadCacheBlocks) cache.blocks[cache.num++] = ptr;
+    else push(ptr);
+    atomic_add(&numUsed,-1);
   }
 }
-
@@ -21,15 +21,47 @@
 #include "sys/sync/mutex.h"
 #include "sys/taskscheduler.h"
 #include "math/math.h"
+#include "embree2/rtcore.h"
 
 #include <vector>
 
 namespace embree
 {
+  /*! NUMA placement policies for acceleration structure memory. With
+   *  first touch placement the pages land on the node of the builder
+   *  thread that writes them first, interleaving distributes them
+   *  round robin over all nodes. */
+  enum NumaPolicy { NUMA_FIRST_TOUCH, NUMA_INTERLEAVE };
+  extern NumaPolicy g_numa_policy;
+
+  /*! Page sizes for acceleration structure memory. Huge pages reduce
+   *  TLB misses of incoherent traversal in large scenes. Explicit huge
+   *  pages fall back to transparent huge pages, and these to normal
+   *  pages, when the OS cannot provide them. */
+  enum HugePages { HUGE_PAGES_OFF, HUGE_PAGES_TRANSPARENT, HUGE_PAGES_EXPLICIT };
+  extern HugePages g_huge_pages;
+
+  /*! Memory monitor callback of the application, NULL if none is set. */
+  extern RTCMemoryMonitorFunc g_memory_monitor;
+
+  /*! Reports allocations (positive) and releases (negative) of build
+   *  memory to the memory monitor. Returns false if the application
+   *  vetoes the allocation. */
+  bool memoryMonitor(ssize_t bytes);
+
+  /*! reserves address space for acceleration structure data */
+  void* numa_reserve(size_t bytes);
+
+  /*! commits the first bytes of a reserved region and prefaults them,
+   *  on NUMA systems first touch is left to the builder threads */
+  void numa_commit(void* ptr, size_t bytes);
+
   /*! Global memory pool. Node, triangle, and intermediary build data
       is allocated from this memory pool and returned to it. The pool
       does not return memory to the operating system unless the clear function
-      is called. */
+      is called. Free blocks are kept in a lock-free stack with a small
+      cache of blocks in front of it for each thread, only growing the
+      pool takes a lock. */
   class Alloc
   {
   public:
@@ -38,6 +70,15 @@ namespace embree
     //enum { blockSize = 512*4096 };
     enum { blockSize = 16*4096 };
     //enum { blockSize = 4*4096 };
+
+    /*! Maximal number of blocks allocated from the OS at once. The
+     *  pool grows geometrically up to this many blocks per chunk, thus
+     *  small scenes stay small and large builds rarely take the
+     *  lock. Builds that know their size reserve larger chunks. */
+    enum { maxChunkBlocks = 32 };
+
+    /*! Number of free blocks each thread keeps for itself. */
+    enum { threadCacheBlocks = 4 };
     
     /*! single allocator object */
     static Alloc global;
@@ -50,8 +91,18 @@ namespace embree
 
     /*! returns size of memory pool */
     size_t size() const;
+
+    /*! returns number of bytes currently handed out */
+    size_t used() const;
+
+    /*! returns high-water mark of bytes handed out */
+    size_t maxUsed() const;
+
+    /*! grows the pool in a single chunk such that the specified
+     *  number of bytes are available, used as size hint by builders */
+    void reserve(size_t bytes);
     
-    /*! frees all available memory */
+    /*! frees all available memory if no block is handed out */
     void clear();
     
     /*! allocates a memory block */
@@ -59,132 +110,125 @@ namespace embree
     
     /*! frees a memory block */
     void free(void* ptr);
+
+  private:
+
+    /*! Per thread cache of free blocks, only valid in the epoch it got filled in. */
+    struct ThreadCache
+    {
+      const Alloc* pool;                   //!< pool the blocks belong to
+      atomic_t epoch;                      //!< epoch of the pool the blocks belong to
+      size_t num;                          //!< number of cached blocks
+      void* blocks[threadCacheBlocks];     //!< cached blocks
+    };
+
+    /*! returns the block cache of the calling thread */
+    ThreadCache& threadCache();
+
+    /*! Announces an access to the blocks of the pool, waits while
+     *  the pool gets cleared. Balanced by a decrement of numUsed,
+     *  returns the incremented numUsed. */
+    atomic_t enter();
+
+    /*! allocates a new chunk of blocks from the OS, returns the first
+     *  block and pushes the others, returns NULL if the pool is not empty */
+    void* grow();
+
+    /*! allocates a chunk of the specified number of blocks from the OS */
+    char* allocChunk(size_t num);
+
+    /*! pushes a block onto the stack of free blocks */
+    void push(void* ptr);
+
+    /*! low bits of the stack head hold a tag to avoid the ABA problem */
+    static const size_t tagMask = size_t(blockSize)-1;
+
+    /*! set in numUsed while clear releases the chunks, keeps malloc and free out */
+    static const atomic_t clearing = atomic_t(1) << (8*sizeof(atomic_t)-2);
     
   private:
-    MutexSys mutex;                 //<! Mutex to protect access to blocks vector
-    std::vector<void*> blocks;      //<! list of available memory blocks
+    volatile atomic_t head;         //<! tagged pointer to first free block, blocks are linked through their first bytes
+    atomic_t numBlocks;             //<! number of blocks in the pool
+    volatile atomic_t numUsed;      //<! number of blocks handed out plus pending accesses
+    atomic_t maxNumUsed;            //<! high-water mark of numUsed
+    volatile atomic_t epoch;        //<! incremented by each clear, invalidates the thread caches
+    MutexSys mutex;                 //<! Mutex to protect growing of the pool
+    std::vector<void*> chunks;      //<! memory chunks allocated from the OS
   };
 
   /*! Base class for a each memory allocator. Allocates from blocks of the 
-    Alloc class and returns these blocks on destruction. */
+    Alloc class and returns these blocks on destruction. Each thread
+    fills its own block, thus allocations do not need any locking. */
   class AllocatorBase 
   {
+    ALIGNED_CLASS;
+
   public:
 
     /*! Default constructor. */
-    AllocatorBase () : ptr(NULL), cur(0), end(0) {
+    AllocatorBase () {
+      thread = new ThreadBlocks[getNumberOfLogicalThreads()];
     }
     
     /*! Returns all allocated blocks to Alloc class. */
     ~AllocatorBase () {
       clear();
+      delete[] thread; thread = NULL;
     }
 
     /*! clears the allocator */
     void clear () 
     {
-      for (size_t i=0; i<blocks.size(); i++) {
-        Alloc::global.free(blocks[i]); 
-      }
-      ptr = NULL;
-      cur = end = 0;
-      blocks.resize(0);
+      for (size_t i=0; i<getNumberOfLogicalThreads(); i++) 
+        thread[i].clear();
     }
 
     /*! returns number of bytes allocated */
-    size_t bytes () {
-      return blocks.size() * Alloc::blockSize;
-    }
-
-    /*! Allocates some number of bytes. */
-    void* malloc(size_t bytes) 
+    size_t bytes () const 
     {
-      Lock<MutexSys> lock(mutex);
-      cur += bytes;
-      if (cur <= end) return &ptr[cur - bytes];
-      ptr = (char*) Alloc::global.malloc();
-      blocks.push_back(ptr);
-      cur = 0;
-      end = Alloc::blockSize;
-      assert(bytes<=Alloc::blockSize);
-      cur += bytes;
-      return &ptr[cur - bytes];
-    }
-    
-  private:
-    MutexSys mutex;                  //!< mutex to protect access to this class
-    char*  ptr;                      //!< pointer to memory block
-    size_t cur;                      //!< Current location of the allocator.
-    size_t end;                      //!< End of the memory block.
-    std::vector<void*> blocks;       //!< available memory blocks
-  };
-
-  /*! This class implements an efficient multi-threaded memory
-   *  allocation scheme. The per thread allocator allocates from its
-   *  current memory block or requests a new block from the slower
-   *  global allocator when its block is full. */
-  class AllocatorPerThread : public AllocatorBase
-  {
-    ALIGNED_CLASS;
-
-     /*! Allocation block size. Number of bytes to request from the
-      *  base allocator when the memory block of a thread is empty. */
-    //enum { allocBlockSize = 4096*16 };
-    enum { allocBlockSize = 4*4096 };
-
-  public:
-
-    /*! Allocator default construction. */
-    AllocatorPerThread () {
-      thread = new ThreadAllocator[getNumberOfLogicalThreads()];
-    }
-
-    /*! Allocator destructor. */
-    ~AllocatorPerThread() {
-      delete[] thread; thread = NULL;
+      size_t blocks = 0;
+      for (size_t i=0; i<getNumberOfLogicalThreads(); i++) 
+        blocks += thread[i].blocks.size();
+      return blocks * Alloc::blockSize;
     }
 
-    /*! Aligned memory allocation */
+    /*! Allocates some number of aligned bytes from the block of the thread. */
     __forceinline void* malloc(size_t tinfo, size_t bytes, size_t align = 16) {
-      return thread[tinfo].malloc(bytes,align,this);
-    }
-
-    /*! clears the allocator */
-    void clear () 
-    {
-      AllocatorBase::clear();
-      for (size_t i=0; i<getNumberOfLogicalThreads(); i++) 
-        thread[i].clear();
+      return thread[tinfo].malloc(bytes,align);
     }
 
   private:
 
-     /*! Per thread structure holding the current memory block. */
-    struct __align(4096) ThreadAllocator 
+    /*! Per thread structure holding the current memory block. */
+    struct __align(64) ThreadBlocks
     {
-      ALIGNED_CLASS_(4096);
+      ALIGNED_CLASS_(64);
     public:
 
       /*! Default constructor. */
-      __forceinline ThreadAllocator () : ptr(NULL), cur(0), end(0) {}
+      __forceinline ThreadBlocks () : ptr(NULL), cur(0), end(0) {}
 
       /* Allocate aligned memory from the threads memory block. */
-      __forceinline void* malloc(size_t bytes, size_t align, AllocatorBase* alloc) 
+      __forceinline void* malloc(size_t bytes, size_t align) 
       {
         cur += (align - cur) & (align-1);
         cur += bytes;
-        if (cur <= end) return &ptr[cur - bytes];
-        ptr = (char*) alloc->malloc(allocBlockSize);
-        cur = 0;
-        end = allocBlockSize;
-        if (bytes > allocBlockSize) 
+        if (likely(cur <= end)) return &ptr[cur - bytes];
+        if (bytes > size_t(Alloc::blockSize)) 
           throw std::runtime_error("allocated block is too large");
-        cur += bytes;
-        return &ptr[cur - bytes];
+        ptr = (char*) Alloc::global.malloc();
+        blocks.push_back(ptr);
+        cur = bytes;
+        end = Alloc::blockSize;
+        return ptr;
       }
 
-      /*! clears the allocator */
-      void clear () {
+      /*! returns all blocks to the Alloc class */
+      void clear () 
+      {
+        for (size_t i=0; i<blocks.size(); i++) 
+          Alloc::global.free(blocks[i]); 
+        blocks.clear();
         ptr = NULL;
         cur = end = 0;
       }
@@ -193,10 +237,20 @@ namespace embree
       char*  ptr;      //!< pointer to memory block
       size_t cur;      //!< Current location of the allocator.
       size_t end;      //!< End of the memory block.
+      std::vector<void*> blocks; //!< blocks owned by this thread
     };
 
   private:
-    ThreadAllocator* thread;   //!< one allocator for each thread
+    ThreadBlocks* thread;   //!< one block list for each thread
+  };
+
+  /*! This class implements an efficient multi-threaded memory
+   *  allocation scheme. The per thread allocator allocates from its
+   *  current memory block or requests a new block from the lock-free
+   *  global allocator when its block is full. */
+  class AllocatorPerThread : public AllocatorBase
+  {
+    ALIGNED_CLASS;
   };
 
   /*! This class implements an efficient multi-threaded memory
@@ -245,6 +299,14 @@ namespace embree
 	thread[i].clear();
     }
 
+    /*! clears the allocator and releases all memory */
+    void reset ()
+    {
+      clear();
+      if (ptr) os_free(ptr,end); ptr = NULL;
+      end = 0; bytesAllocated = 0;
+    }
+
     /*! initializes the allocator */
     void init (size_t bytes) 
     {
@@ -253,7 +315,7 @@ namespace embree
       bytes = max(bytes,size_t(allocBlockSize*numThreads));
       if (bytes != size_t(end)) {
         if (ptr) os_free(ptr,end);
-        ptr = (char*) os_reserve(bytes);
+        ptr = (char*) numa_reserve(bytes);
         end = bytes;
       }
     }
@@ -268,9 +330,8 @@ namespace embree
       {
         bytesAllocated = bytesAllocate;
         if (ptr) os_free(ptr,end);
-        ptr = (char*) os_reserve(bytesReserved);
-        os_commit(ptr,bytesAllocated);
-        memset(ptr,0,bytesAllocated);
+        ptr = (char*) numa_reserve(bytesReserved);
+        numa_commit(ptr,bytesAllocated);
         end = bytesReserved;
       }
     }
@@ -396,11 +457,10 @@ namespace embree
 
       if (data) os_free(data,bytesReserved);
       
-      data = (char*) os_reserve(bytesReserve);
+      data = (char*) numa_reserve(bytesReserve);
       bytesReserved = bytesReserve;
       
-      os_commit(data,bytesAllocate);
-      memset(data,0,bytesAllocate);
+      numa_commit(data,bytesAllocate);
       bytesAllocated = bytesAllocate;
       
       next = 0;
@@ -433,6 +493,11 @@ namespace embree
       return data;
     }
 
+    /*! returns the number of bytes backed by memory */
+    __forceinline size_t bytesCommitted() const {
+      return max(size_t(next),bytesAllocated);
+    }
+
   public:
     atomic_t next;
     char* data;
@@ -60,6 +60,16 @@ namespace embree
       return mapped; 
     }
 
+    /*! returns the number of bytes of application memory the buffer references */
+    __forceinline size_t bytesShared() const {
+      return shared ? num*stride : 0;
+    }
+
+    /*! returns the number of bytes allocated for the buffer */
+    __forceinline size_t bytesCopied() const {
+      return !shared && ptr ? bytes : 0;
+    }
+
   protected:
     char* ptr;       //!< pointer to buffer data
     size_t bytes;    //!< size of buffer in bytes
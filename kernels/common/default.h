@@ -64,6 +64,12 @@ namespace embree
   extern std::string g_traverser;
   extern int g_scene_flags;
   extern size_t g_benchmark;
+  extern bool g_numa_replicate;
+  extern float g_refit_rotate;
+  extern float g_refit_rebuild;
+  extern size_t g_morton64_threshold;
+  extern bool g_hybrid_adaptive;
+  extern ssize_t g_hybrid_threshold;
 
   /*! records an error */
   void recordError(RTCError error);
@@ -25,7 +25,7 @@ namespace embree
   class Scene;
 
   /*! type of geometry */
-  enum GeometryTy { TRIANGLE_MESH, USER_GEOMETRY, QUADRATIC_BEZIER_CURVES, INSTANCES };
+  enum GeometryTy { TRIANGLE_MESH, USER_GEOMETRY, QUADRATIC_BEZIER_CURVES, INSTANCES, QUAD_MESH };
   
 #if defined(__SSE__)
   typedef void (*ISPCFilterFunc4)(void* ptr, RTCRay4& ray, __m128 valid);
@@ -94,6 +94,9 @@ namespace embree
     /*! Verify the geometry */
     virtual bool verify () { return true; }
 
+    /*! adds the bytes of the geometry buffers to the statistics */
+    virtual void memoryStatistics(RTCMemoryStatistics& stats) const {}
+
     /*! called if geometry is switching from disabled to enabled state */
     virtual void enabling() = 0;
 
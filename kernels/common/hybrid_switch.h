@@ -0,0 +1,118 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef __EMBREE_HYBRID_SWITCH_H__
+#define __EMBREE_HYBRID_SWITCH_H__
+
+#include "default.h"
+
+namespace embree
+{
+  /*! Runtime adaptive switch from packet to single ray traversal for
+   *  the hybrid traversal kernels. For each kernel a packet node test
+   *  costs about as much as 'cost' single ray node tests. If on
+   *  average only the fraction u of the rays that enter a subtree hit
+   *  its nodes, then single ray traversal of n rays is cheaper than
+   *  packet traversal if n*u < cost. The utilization u is measured for
+   *  some sampled packets of each ray kind and the threshold gets
+   *  derived from it. */
+  class HybridSwitch
+  {
+  public:
+
+    enum Kind { INTERSECT = 0, OCCLUDED = 1 };
+
+    /*! every that many packets get sampled */
+    static const size_t samplingRate = 64;
+
+    /*! statistics of the currently traversed packet */
+    struct Sample
+    {
+      __forceinline Sample (bool enabled)
+        : enabled(enabled), lanes(0), entered(0) {}
+
+      /*! counts a packet node test, the number of rays that hit the node, and the number of active rays when entering the subtree */
+      __forceinline void count(size_t hit, size_t active) {
+        lanes += hit; entered += active;
+      }
+
+    public:
+      bool enabled;   //!< true if the packet gets sampled
+      size_t lanes;   //!< number of rays that hit traversed nodes
+      size_t entered; //!< number of active rays of the subtree of each traversed node
+    };
+
+    /*! constructs a switch for packets of K rays that starts with a fixed threshold */
+    HybridSwitch (size_t K, size_t threshold) 
+      : K(K), initial(threshold) { reset(); }
+
+    /*! resets the switch to the initial threshold */
+    void reset()
+    {
+      for (size_t i=0; i<2; i++) {
+        kinds[i].utilization = 1.0f;
+        kinds[i].threshold = initial;
+      }
+    }
+
+    /*! returns the number of active rays at or below which the packet switches to single ray traversal */
+    __forceinline size_t threshold(Kind kind) const
+    {
+      if (likely(g_hybrid_adaptive)) return kinds[kind].threshold;
+      if (g_hybrid_threshold >= 0) return g_hybrid_threshold;
+      return initial;
+    }
+
+    /*! decides if the next packet gets sampled, sampled packets never switch to single ray traversal */
+    static __forceinline bool sample()
+    {
+      if (unlikely(!g_hybrid_adaptive)) return false;
+      static __thread size_t packets = 0; // per thread to not share a cache line between threads
+      return (packets++ % samplingRate) == 0;
+    }
+
+    /*! updates the threshold of some ray kind with the statistics of a sampled packet */
+    void update(Kind kind, const Sample& sample, float cost);
+
+    /*! returns the current utilization estimate of some ray kind */
+    float utilization(Kind kind) const { return kinds[kind].utilization; }
+
+  private:
+
+    /*! adaptive state of a single ray kind */
+    struct State
+    {
+      volatile float utilization;  //!< running estimate of the node utilization
+      volatile size_t threshold;   //!< current switch threshold
+    };
+
+    State kinds[2];  //!< states for intersection and occlusion rays
+    size_t K;        //!< number of rays per packet
+    size_t initial;  //!< threshold before the first sample
+  };
+
+  __forceinline void HybridSwitch::update(Kind kind, const Sample& sample, float cost)
+  {
+    if (sample.entered == 0) return;
+    State& state = kinds[kind];
+    const float u = float(sample.lanes)/float(sample.entered);
+    const float utilization = state.utilization + (u-state.utilization)/16.0f;
+    state.utilization = utilization;
+    state.threshold = min(K,size_t(ceilf(cost/max(utilization,1.0f/float(K+1))))-1);
+  }
+}
+
+#endif
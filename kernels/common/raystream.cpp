@@ -0,0 +1,285 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#include "raystream.h"
+#include "scene.h"
+
+namespace embree
+{
+  /*! accesses a stream of rays stored as array of RTCRay structures */
+  struct RayStreamAOS
+  {
+    __forceinline RayStreamAOS (RTCRay* rays) : rays(rays) {}
+
+    __forceinline void org(size_t i, float& x, float& y, float& z) const {
+      x = rays[i].org[0]; y = rays[i].org[1]; z = rays[i].org[2];
+    }
+
+    __forceinline void dir(size_t i, float& x, float& y, float& z) const {
+      x = rays[i].dir[0]; y = rays[i].dir[1]; z = rays[i].dir[2];
+    }
+
+    __forceinline void get(size_t i, RTCRay& ray) const { 
+      ray = rays[i]; 
+    }
+
+    __forceinline void set(size_t i, const RTCRay& ray, bool occluded) 
+    {
+      RTCRay& dst = rays[i];
+      dst.geomID = ray.geomID;
+      if (occluded) return;
+      dst.tfar = ray.tfar;
+      dst.Ng[0] = ray.Ng[0]; dst.Ng[1] = ray.Ng[1]; dst.Ng[2] = ray.Ng[2];
+      dst.u = ray.u; dst.v = ray.v;
+      dst.primID = ray.primID; dst.instID = ray.instID;
+    }
+
+  public:
+    RTCRay* rays;
+  };
+
+  /*! accesses a stream of rays stored as structure of arrays */
+  struct RayStreamSOA
+  {
+    __forceinline RayStreamSOA (const RTCRayNp& rays) : rays(rays) {}
+
+    __forceinline void org(size_t i, float& x, float& y, float& z) const {
+      x = rays.orgx[i]; y = rays.orgy[i]; z = rays.orgz[i];
+    }
+
+    __forceinline void dir(size_t i, float& x, float& y, float& z) const {
+      x = rays.dirx[i]; y = rays.diry[i]; z = rays.dirz[i];
+    }
+
+    __forceinline void get(size_t i, RTCRay& ray) const 
+    {
+      ray.org[0] = rays.orgx[i]; ray.org[1] = rays.orgy[i]; ray.org[2] = rays.orgz[i];
+      ray.dir[0] = rays.dirx[i]; ray.dir[1] = rays.diry[i]; ray.dir[2] = rays.dirz[i];
+      ray.tnear = rays.tnear[i]; ray.tfar = rays.tfar[i];
+      ray.time = rays.time[i]; ray.mask = rays.mask[i];
+      ray.Ng[0] = rays.Ngx[i]; ray.Ng[1] = rays.Ngy[i]; ray.Ng[2] = rays.Ngz[i];
+      ray.u = rays.u[i]; ray.v = rays.v[i];
+      ray.geomID = rays.geomID[i]; ray.primID = rays.primID[i]; ray.instID = rays.instID[i];
+    }
+
+    __forceinline void set(size_t i, const RTCRay& ray, bool occluded) 
+    {
+      rays.geomID[i] = ray.geomID;
+      if (occluded) return;
+      rays.tfar[i] = ray.tfar;
+      rays.Ngx[i] = ray.Ng[0]; rays.Ngy[i] = ray.Ng[1]; rays.Ngz[i] = ray.Ng[2];
+      rays.u[i] = ray.u; rays.v[i] = ray.v;
+      rays.primID[i] = ray.primID; rays.instID[i] = ray.instID;
+    }
+
+  public:
+    const RTCRayNp& rays;
+  };
+
+  /*! stores a single ray into some slot of a ray packet */
+  template<typename Packet>
+  __forceinline void setPacketRay(Packet& packet, size_t k, const RTCRay& ray)
+  {
+    packet.orgx[k] = ray.org[0]; packet.orgy[k] = ray.org[1]; packet.orgz[k] = ray.org[2];
+    packet.dirx[k] = ray.dir[0]; packet.diry[k] = ray.dir[1]; packet.dirz[k] = ray.dir[2];
+    packet.tnear[k] = ray.tnear; packet.tfar[k] = ray.tfar;
+    packet.time[k] = ray.time; packet.mask[k] = ray.mask;
+    packet.Ngx[k] = ray.Ng[0]; packet.Ngy[k] = ray.Ng[1]; packet.Ngz[k] = ray.Ng[2];
+    packet.u[k] = ray.u; packet.v[k] = ray.v;
+    packet.geomID[k] = ray.geomID; packet.primID[k] = ray.primID; packet.instID[k] = ray.instID;
+  }
+
+  /*! loads the hit data of some slot of a ray packet */
+  template<typename Packet>
+  __forceinline void getPacketHit(const Packet& packet, size_t k, RTCRay& ray)
+  {
+    ray.tfar = packet.tfar[k];
+    ray.Ng[0] = packet.Ngx[k]; ray.Ng[1] = packet.Ngy[k]; ray.Ng[2] = packet.Ngz[k];
+    ray.u = packet.u[k]; ray.v = packet.v[k];
+    ray.geomID = packet.geomID[k]; ray.primID = packet.primID[k]; ray.instID = packet.instID[k];
+  }
+
+  __forceinline void tracePacket(Scene* scene, const int* valid, RTCRay4& packet, bool occluded) {
+    if (occluded) scene->occluded4(valid,packet); else scene->intersect4(valid,packet);
+  }
+
+  __forceinline void tracePacket(Scene* scene, const int* valid, RTCRay8& packet, bool occluded) {
+    if (occluded) scene->occluded8(valid,packet); else scene->intersect8(valid,packet);
+  }
+
+  __forceinline void tracePacket(Scene* scene, const int* valid, RTCRay16& packet, bool occluded) {
+    if (occluded) scene->occluded16(valid,packet); else scene->intersect16(valid,packet);
+  }
+
+  /*! traces rays one by one */
+  template<typename Stream>
+  static void traceSingle(Scene* scene, Stream& stream, const unsigned* ids, size_t n, bool occluded)
+  {
+    for (size_t i=0; i<n; i++) 
+    {
+      RTCRay ray; stream.get(ids[i],ray);
+      STAT3(normal.travs,1,1,1);
+      if (occluded) scene->occluded(ray); else scene->intersect(ray);
+      stream.set(ids[i],ray,occluded);
+    }
+  }
+
+  /*! traces rays in packets of K rays, the last packet may be partially filled */
+  template<typename Packet, size_t K, typename Stream>
+  static void tracePackets(Scene* scene, Stream& stream, const unsigned* ids, size_t n, bool occluded)
+  {
+    for (size_t i=0; i<n; i+=K)
+    {
+      const size_t m = min(n-i,K);
+      __align(64) int valid[K];
+      Packet packet;
+      RTCRay ray;
+
+      /* unused slots get a copy of the last ray to keep the packet well defined */
+      for (size_t k=0; k<K; k++) {
+        valid[k] = k < m ? -1 : 0;
+        if (k < m) stream.get(ids[i+k],ray);
+        setPacketRay(packet,k,ray);
+      }
+      
+      STAT3(normal.travs,1,m,K);
+      tracePacket(scene,valid,packet,occluded);
+
+      for (size_t k=0; k<m; k++) {
+        getPacketHit(packet,k,ray);
+        stream.set(ids[i+k],ray,occluded);
+      }
+    }
+  }
+
+  /*! sorts a block of rays and traces them in full packets */
+  template<typename Packet, size_t K, typename Stream>
+  static void traceBlock(Scene* scene, Stream& stream, size_t begin, size_t end, bool occluded)
+  {
+    unsigned short keys[RayStream::BLOCK_SIZE];
+    unsigned ids[RayStream::BLOCK_SIZE];
+    unsigned leftover[RayStream::BLOCK_SIZE];
+    unsigned counts[RayStream::NUM_BUCKETS+1];
+    const size_t N = end-begin;
+
+    /* map origins into a grid of CELLS^3 cells inside the scene bounds */
+    const BBox3f& bounds = scene->bounds;
+    const float C = float(RayStream::CELLS);
+    float lower[3] = { 0.0f, 0.0f, 0.0f }, scale[3] = { 0.0f, 0.0f, 0.0f };
+    if (!bounds.empty()) {
+      for (size_t d=0; d<3; d++) {
+        lower[d] = bounds.lower[d];
+        const float size = bounds.upper[d]-bounds.lower[d];
+        scale[d] = size > 0.0f ? C/size : 0.0f;
+      }
+    }
+
+    /* calculate sort key from direction octant and origin cell */
+    for (size_t b=0; b<=RayStream::NUM_BUCKETS; b++) counts[b] = 0;
+    for (size_t i=0; i<N; i++) 
+    {
+      float org[3], dir[3];
+      stream.org(begin+i,org[0],org[1],org[2]);
+      stream.dir(begin+i,dir[0],dir[1],dir[2]);
+      unsigned key = 0;
+      for (size_t d=0; d<3; d++) {
+        const float c = max(0.0f,min((org[d]-lower[d])*scale[d],C-1.0f));
+        key = key*RayStream::CELLS + unsigned(c);
+      }
+      key |= ((dir[0] < 0.0f) | ((dir[1] < 0.0f) << 1) | ((dir[2] < 0.0f) << 2)) * RayStream::CELLS*RayStream::CELLS*RayStream::CELLS;
+      keys[i] = key;
+      counts[key+1]++;
+    }
+
+    /* counting sort of ray IDs */
+    for (size_t b=1; b<=RayStream::NUM_BUCKETS; b++) counts[b] += counts[b-1];
+    for (size_t i=0; i<N; i++) ids[counts[keys[i]]++] = begin+i;
+
+    /* trace full packets of each bucket, remember remaining rays */
+    size_t numLeftover = 0;
+    for (size_t b=0, i=0; b<RayStream::NUM_BUCKETS; b++) 
+    {
+      const size_t bucketEnd = counts[b];
+      const size_t numFull = ((bucketEnd-i)/K)*K;
+      tracePackets<Packet,K>(scene,stream,ids+i,numFull,occluded);
+      for (i+=numFull; i<bucketEnd; i++) leftover[numLeftover++] = ids[i];
+    }
+
+    /* remaining rays of neighboring buckets get packed together */
+    const size_t numFull = (numLeftover/K)*K;
+    tracePackets<Packet,K>(scene,stream,leftover,numFull,occluded);
+
+    /* stragglers are traced as single rays if possible */
+    const bool single = occluded ? scene->intersectors.intersector1.occluded : scene->intersectors.intersector1.intersect;
+    if (single) traceSingle(scene,stream,leftover+numFull,numLeftover-numFull,occluded);
+    else        tracePackets<Packet,K>(scene,stream,leftover+numFull,numLeftover-numFull,occluded);
+  }
+
+  /*! traces the stream block by block with the widest packets available */
+  template<typename Stream>
+  static void trace(Scene* scene, Stream& stream, size_t N, bool occluded)
+  {
+    const Accel::Intersectors& isecs = scene->intersectors;
+    
+#if defined(__MIC__)
+    if (occluded ? isecs.intersector16.occluded : isecs.intersector16.intersect) {
+      for (size_t i=0; i<N; i+=RayStream::BLOCK_SIZE)
+        traceBlock<RTCRay16,16>(scene,stream,i,min(N,i+RayStream::BLOCK_SIZE),occluded);
+      return;
+    }
+#else
+#if defined(__TARGET_AVX__) || defined(__TARGET_AVX2__)
+    if (has_feature(AVX) && (occluded ? isecs.intersector8.occluded : isecs.intersector8.intersect)) {
+      for (size_t i=0; i<N; i+=RayStream::BLOCK_SIZE)
+        traceBlock<RTCRay8,8>(scene,stream,i,min(N,i+RayStream::BLOCK_SIZE),occluded);
+      return;
+    }
+#endif
+    if (occluded ? isecs.intersector4.occluded : isecs.intersector4.intersect) {
+      for (size_t i=0; i<N; i+=RayStream::BLOCK_SIZE)
+        traceBlock<RTCRay4,4>(scene,stream,i,min(N,i+RayStream::BLOCK_SIZE),occluded);
+      return;
+    }
+#endif
+
+    /* no packet intersector enabled for this scene */
+    if (!(occluded ? isecs.intersector1.occluded : isecs.intersector1.intersect)) {
+      recordError(RTC_INVALID_OPERATION);
+      return;
+    }
+    for (size_t i=0; i<N; i++) {
+      const unsigned id = i;
+      traceSingle(scene,stream,&id,1,occluded);
+    }
+  }
+
+  void RayStream::intersect (Scene* scene, RTCRay* rays, size_t N) {
+    RayStreamAOS stream(rays); trace(scene,stream,N,false);
+  }
+
+  void RayStream::intersect (Scene* scene, const RTCRayNp& rays, size_t N) {
+    RayStreamSOA stream(rays); trace(scene,stream,N,false);
+  }
+
+  void RayStream::occluded (Scene* scene, RTCRay* rays, size_t N) {
+    RayStreamAOS stream(rays); trace(scene,stream,N,true);
+  }
+
+  void RayStream::occluded (Scene* scene, const RTCRayNp& rays, size_t N) {
+    RayStreamSOA stream(rays); trace(scene,stream,N,true);
+  }
+}
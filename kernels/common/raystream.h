@@ -0,0 +1,62 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#ifndef __EMBREE_RAYSTREAM_H__
+#define __EMBREE_RAYSTREAM_H__
+
+#include "common/default.h"
+#include "embree2/rtcore_ray.h"
+
+namespace embree
+{
+  class Scene;
+
+  /*! Traces streams of arbitrary many rays. The rays of a stream get
+   *  sorted by direction octant and origin cell inside the scene
+   *  bounds and are regrouped into full packets for the widest packet
+   *  intersector enabled for the scene. Rays that do not fill a
+   *  packet are traced with the single ray intersector. */
+  class RayStream
+  {
+  public:
+
+    /*! number of rays sorted together */
+    static const size_t BLOCK_SIZE = 1024;
+
+    /*! number of cells per dimension used to classify ray origins */
+    static const size_t CELLS = 4;
+
+    /*! number of sort buckets: 8 octants times CELLS^3 origin cells */
+    static const size_t NUM_BUCKETS = 8*CELLS*CELLS*CELLS;
+
+  public:
+
+    /*! intersects a stream of rays stored as array of structures */
+    static void intersect (Scene* scene, RTCRay* rays, size_t N);
+
+    /*! intersects a stream of rays stored as structure of arrays */
+    static void intersect (Scene* scene, const RTCRayNp& rays, size_t N);
+
+    /*! tests a stream of rays stored as array of structures for occlusion */
+    static void occluded (Scene* scene, RTCRay* rays, size_t N);
+
+    /*! tests a stream of rays stored as structure of arrays for occlusion */
+    static void occluded (Scene* scene, const RTCRayNp& rays, size_t N);
+  };
+}
+
+#endif
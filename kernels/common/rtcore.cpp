@@ -24,6 +24,7 @@
 #include "common/alloc.h"
 #include "embree2/rtcore.h"
 #include "common/scene.h"
+#include "common/raystream.h"
 #include "sys/taskscheduler.h"
 #include "sys/thread.h"
 
@@ -75,10 +76,18 @@ namespace embree
   std::string g_tri_accel = "default";    //!< triangle acceleration structure to use
   std::string g_builder = "default";      //!< builder to use
   std::string g_traverser = "default";    //!< traverser to use
+  std::string g_scheduler = "default";    //!< task scheduler to use
   int g_scene_flags = -1;       //!< scene flags to use
   size_t g_verbose = 0;                   //!< verbosity of output
   size_t g_numThreads = 0;                //!< number of threads to use in builders
+  bool g_userThreads = false;             //!< builder threads are provided by the application
   size_t g_benchmark = 0;
+  bool g_numa_replicate = false;          //!< replicate static BVHs on each NUMA node
+  float g_refit_rotate = 1.25f;           //!< rotate refitted BVHs whose SAH cost grew by this factor since the last build
+  float g_refit_rebuild = 2.0f;           //!< rebuild refitted BVHs whose SAH cost grew by this factor since the last build
+  size_t g_morton64_threshold = 16*1024*1024; //!< Morton builders use 64 bit codes above this number of primitives
+  bool g_hybrid_adaptive = true;          //!< adapt the packet to single ray switch threshold of the hybrid traversal at runtime
+  ssize_t g_hybrid_threshold = -1;        //!< fixed switch threshold of the hybrid traversal, the default of each kernel if negative
 
   /* error flag */
   static tls_t g_error = NULL;
@@ -102,6 +111,14 @@ namespace embree
     return atoi(str+begin);
   }
 
+  float parseFloat(const char* str, size_t& pos) 
+  {
+    skipSpace(str,pos);
+    size_t begin = pos;
+    while (isdigit(str[pos]) || str[pos] == '.') pos++;
+    return (float) atof(str+begin);
+  }
+
   std::string parseIdentifier(const char* str, size_t& pos) 
   {
     skipSpace(str,pos);
@@ -156,10 +173,20 @@ namespace embree
     g_tri_accel = "default";
     g_builder = "default";
     g_traverser = "default";
+    g_scheduler = "default";
     g_scene_flags = -1;
     g_verbose = 0;
     g_numThreads = 0;
+    g_userThreads = false;
     g_benchmark = 0;
+    g_numa_policy = NUMA_FIRST_TOUCH;
+    g_numa_replicate = false;
+    g_huge_pages = HUGE_PAGES_OFF;
+    g_refit_rotate = 1.25f;
+    g_refit_rebuild = 2.0f;
+    g_morton64_threshold = 16*1024*1024;
+    g_hybrid_adaptive = true;
+    g_hybrid_threshold = -1;
 
     if (cfg != NULL) 
     {
@@ -175,6 +202,11 @@ namespace embree
 	    FATAL("MIC supports only number of threads % 4 == 0, or threads == 1");
 #endif
         }
+        else if (tok == "user_threads") {
+          if (parseSymbol(cfg,'=',pos))
+            g_numThreads = parseInt(cfg,pos);
+          g_userThreads = true;
+        }
         else if (tok == "isa") {
           if (parseSymbol (cfg,'=',pos)) {
             std::string isa = parseIdentifier (cfg,pos);
@@ -209,6 +241,10 @@ namespace embree
           if (parseSymbol (cfg,'=',pos))
             g_traverser = parseIdentifier (cfg,pos);
         }
+        else if (tok == "scheduler") {
+          if (parseSymbol (cfg,'=',pos))
+            g_scheduler = parseIdentifier (cfg,pos);
+        }
         else if (tok == "verbose") {
           if (parseSymbol (cfg,'=',pos))
             g_verbose = parseInt (cfg,pos);
@@ -217,6 +253,52 @@ namespace embree
           if (parseSymbol (cfg,'=',pos))
             g_benchmark = parseInt (cfg,pos);
         }
+        else if (tok == "numa") {
+          if (parseSymbol (cfg,'=',pos)) {
+            std::string policy = parseIdentifier (cfg,pos);
+            if      (policy == "first_touch") g_numa_policy = NUMA_FIRST_TOUCH;
+            else if (policy == "interleave" ) g_numa_policy = NUMA_INTERLEAVE;
+            else throw std::runtime_error("unknown numa policy "+policy);
+          }
+        }
+        else if (tok == "numa_replicate") {
+          g_numa_replicate = true;
+          if (parseSymbol (cfg,'=',pos))
+            g_numa_replicate = parseInt (cfg,pos) != 0;
+        }
+        else if (tok == "huge_pages") {
+          if (parseSymbol (cfg,'=',pos)) {
+            std::string pages = parseIdentifier (cfg,pos);
+            if      (pages == "off"        ) g_huge_pages = HUGE_PAGES_OFF;
+            else if (pages == "transparent") g_huge_pages = HUGE_PAGES_TRANSPARENT;
+            else if (pages == "explicit"   ) g_huge_pages = HUGE_PAGES_EXPLICIT;
+            else throw std::runtime_error("unknown huge pages mode "+pages);
+          }
+        }
+        else if (tok == "refit_rotate") {
+          if (parseSymbol (cfg,'=',pos))
+            g_refit_rotate = parseFloat (cfg,pos);
+        }
+        else if (tok == "refit_rebuild") {
+          if (parseSymbol (cfg,'=',pos))
+            g_refit_rebuild = parseFloat (cfg,pos);
+        }
+        else if (tok == "morton64_threshold") {
+          if (parseSymbol (cfg,'=',pos))
+            g_morton64_threshold = parseInt (cfg,pos);
+        }
+        else if (tok == "hybrid_threshold") {
+          if (parseSymbol (cfg,'=',pos)) {
+            std::string threshold = parseIdentifier (cfg,pos);
+            const bool number = threshold.size() && threshold.size() <= 2 && threshold.find_first_not_of("0123456789") == std::string::npos;
+            if      (threshold == "adaptive") { g_hybrid_adaptive = true;  g_hybrid_threshold = -1; }
+            else if (threshold == "fixed"   ) { g_hybrid_adaptive = false; g_hybrid_threshold = -1; }
+            else if (number && atoi(threshold.c_str()) <= 8) { // at most the rays of the widest hybrid packet
+              g_hybrid_adaptive = false; g_hybrid_threshold = atoi(threshold.c_str());
+            }
+            else throw std::runtime_error("unknown hybrid threshold "+threshold);
+          }
+        }
         else if (tok == "flags") {
           g_scene_flags = 0;
           if (parseSymbol (cfg,'=',pos)) {
@@ -242,6 +324,7 @@ namespace embree
       std::cout << "  Compiler : " << getCompilerName() << std::endl;
       std::cout << "  Platform : " << getPlatformName() << std::endl;
       std::cout << "  CPU      : " << stringOfCPUFeatures(getCPUFeatures()) << std::endl;
+      std::cout << "  NUMA     : " << getNumberOfNumaNodes() << " node(s)" << std::endl;
     }
 
     /* CPU has to support at least SSE2 */
@@ -272,14 +355,22 @@ namespace embree
     {
       PRINT(cfg);
       PRINT(g_numThreads);
+      PRINT(g_userThreads);
       PRINT(g_verbose);
       PRINT(g_top_accel);
       PRINT(g_tri_accel);
       PRINT(g_builder);
       PRINT(g_traverser);
+      PRINT(g_scheduler);
     }
 
-    TaskScheduler::create(g_numThreads);
+    TaskScheduler::TYPE scheduler = TaskScheduler::DEFAULT;
+    if      (g_scheduler == "default") scheduler = TaskScheduler::DEFAULT;
+    else if (g_scheduler == "global" ) scheduler = TaskScheduler::GLOBAL_QUEUE;
+    else if (g_scheduler == "steal"  ) scheduler = TaskScheduler::WORK_STEALING;
+    else throw std::runtime_error("unknown task scheduler "+g_scheduler);
+
+    TaskScheduler::create(g_numThreads,scheduler,!g_userThreads);
 
     CATCH_END;
   }
@@ -295,6 +386,7 @@ namespace embree
     TaskScheduler::destroy();
     for (size_t i=0; i<g_errors.size(); i++)
       delete g_errors[i];
+    g_errors.clear();
     destroyTls(g_error);
     Alloc::global.clear();
     g_initialized = false;
@@ -345,6 +437,12 @@ namespace embree
     return error;
   }
 
+  RTCORE_API void rtcSetMemoryMonitorFunction(RTCMemoryMonitorFunc func) 
+  {
+    TRACE(rtcSetMemoryMonitorFunction);
+    g_memory_monitor = func;
+  }
+
   RTCORE_API void rtcDebug()
   {
     Lock<MutexSys> lock(g_mutex);
@@ -374,12 +472,115 @@ namespace embree
     ((Scene*)scene)->build();
     CATCH_END;
   }
+
+  RTCORE_API void rtcCommitThread (RTCScene scene, unsigned int threadIndex, unsigned int threadCount) 
+  {
+    CATCH_BEGIN;
+    TRACE(rtcCommitThread);
+    VERIFY_HANDLE(scene);
+    ((Scene*)scene)->buildThread(threadIndex,threadCount);
+    CATCH_END;
+  }
+
+  RTCORE_API void rtcCommitAsync (RTCScene scene) 
+  {
+    CATCH_BEGIN;
+    TRACE(rtcCommitAsync);
+    VERIFY_HANDLE(scene);
+    ((Scene*)scene)->buildAsync();
+    CATCH_END;
+  }
+
+  RTCORE_API void rtcCommitWait (RTCScene scene) 
+  {
+    CATCH_BEGIN;
+    TRACE(rtcCommitWait);
+    VERIFY_HANDLE(scene);
+    ((Scene*)scene)->waitBuild(true);
+    CATCH_END;
+  }
+
+  RTCORE_API bool rtcCommitPoll (RTCScene scene) 
+  {
+    CATCH_BEGIN;
+    TRACE(rtcCommitPoll);
+    VERIFY_HANDLE(scene);
+    return ((Scene*)scene)->waitBuild(false);
+    CATCH_END;
+    return false;
+  }
+
+  RTCORE_API void rtcStoreScene (RTCScene scene, const char* filename) 
+  {
+    CATCH_BEGIN;
+    TRACE(rtcStoreScene);
+    VERIFY_HANDLE(scene);
+    ((Scene*)scene)->store(filename);
+    CATCH_END;
+  }
+
+  RTCORE_API void rtcLoadScene (RTCScene scene, const char* filename) 
+  {
+    CATCH_BEGIN;
+    TRACE(rtcLoadScene);
+    VERIFY_HANDLE(scene);
+    ((Scene*)scene)->load(filename);
+    CATCH_END;
+  }
+  
+  RTCORE_API void rtcSetStatisticsMode (RTCScene scene, RTCStatisticsMode mode) 
+  {
+    CATCH_BEGIN;
+    TRACE(rtcSetStatisticsMode);
+    VERIFY_HANDLE(scene);
+    switch (mode) {
+    case RTC_STATISTICS_DISABLED: ((Scene*)scene)->statistics.setMode(SceneStat::DISABLED); break;
+    case RTC_STATISTICS_ENABLED : ((Scene*)scene)->statistics.setMode(SceneStat::ENABLED ); break;
+    case RTC_STATISTICS_SAMPLED : ((Scene*)scene)->statistics.setMode(SceneStat::SAMPLED ); break;
+    default: 
+      if (VERBOSE) std::cerr << "Embree: invalid statistics mode" << std::endl;
+      recordError(RTC_INVALID_ARGUMENT);
+    }
+    CATCH_END;
+  }
+
+  RTCORE_API void rtcGetStatistics (RTCScene scene, RTCStatistics* stats) 
+  {
+    CATCH_BEGIN;
+    TRACE(rtcGetStatistics);
+    VERIFY_HANDLE(scene);
+    VERIFY_HANDLE(stats);
+    ((Scene*)scene)->statistics.get(*stats);
+    CATCH_END;
+  }
+
+  RTCORE_API void rtcClearStatistics (RTCScene scene) 
+  {
+    CATCH_BEGIN;
+    TRACE(rtcClearStatistics);
+    VERIFY_HANDLE(scene);
+    ((Scene*)scene)->statistics.clear();
+    CATCH_END;
+  }
   
+  RTCORE_API size_t rtcGetMemoryStatistics (RTCScene scene, RTCMemoryStatistics* stats, size_t maxStats) 
+  {
+    CATCH_BEGIN;
+    TRACE(rtcGetMemoryStatistics);
+    VERIFY_HANDLE(scene);
+    if (maxStats) VERIFY_HANDLE(stats);
+    return ((Scene*)scene)->getMemoryStatistics(stats,stats ? maxStats : 0);
+    CATCH_END;
+    return 0;
+  }
+
   RTCORE_API void rtcIntersect (RTCScene scene, RTCRay& ray) 
   {
     TRACE(rtcIntersect);
     STAT3(normal.travs,1,1,1);
+    SceneStat::Counters* stats = ((Scene*)scene)->statistics.begin();
     ((Scene*)scene)->intersect(ray);
+    STAT_SCENE(stats,count(ray.geomID));
   }
   
   RTCORE_API void rtcIntersect4 (const void* valid, RTCScene scene, RTCRay4& ray) 
@@ -391,7 +592,9 @@ namespace embree
     TRACE(rtcIntersect4);
     STAT(size_t cnt=0; for (size_t i=0; i<4; i++) cnt += ((int*)valid)[i] == -1;);
     STAT3(normal.travs,1,cnt,4);
+    SceneStat::Counters* stats = ((Scene*)scene)->statistics.begin();
     ((Scene*)scene)->intersect4(valid,ray);
+    STAT_SCENE(stats,count(valid,ray.geomID,4));
 #endif
   }
   
@@ -404,7 +607,9 @@ namespace embree
 #else
     STAT(size_t cnt=0; for (size_t i=0; i<8; i++) cnt += ((int*)valid)[i] == -1;);
     STAT3(normal.travs,1,cnt,8);
+    SceneStat::Counters* stats = ((Scene*)scene)->statistics.begin();
     ((Scene*)scene)->intersect8(valid,ray);
+    STAT_SCENE(stats,count(valid,ray.geomID,8));
 #endif
   }
   
@@ -417,7 +622,9 @@ namespace embree
 #else
     STAT(size_t cnt=0; for (size_t i=0; i<16; i++) cnt += ((int*)valid)[i] == -1;);
     STAT3(normal.travs,1,cnt,16);
+    SceneStat::Counters* stats = ((Scene*)scene)->statistics.begin();
     ((Scene*)scene)->intersect16(valid,ray);
+    STAT_SCENE(stats,count(valid,ray.geomID,16));
 #endif
   }
   
@@ -425,7 +632,9 @@ namespace embree
   {
     TRACE(rtcOccluded);
     STAT3(shadow.travs,1,1,1);
+    SceneStat::Counters* stats = ((Scene*)scene)->statistics.begin();
     ((Scene*)scene)->occluded(ray);
+    STAT_SCENE(stats,count(ray.geomID));
   }
   
   RTCORE_API void rtcOccluded4 (const void* valid, RTCScene scene, RTCRay4& ray) 
@@ -437,7 +646,9 @@ namespace embree
 #else
     STAT(size_t cnt=0; for (size_t i=0; i<4; i++) cnt += ((int*)valid)[i] == -1;);
     STAT3(shadow.travs,1,cnt,4);
+    SceneStat::Counters* stats = ((Scene*)scene)->statistics.begin();
     ((Scene*)scene)->occluded4(valid,ray);
+    STAT_SCENE(stats,count(valid,ray.geomID,4));
 #endif
   }
   
@@ -450,7 +661,9 @@ namespace embree
 #else
     STAT(size_t cnt=0; for (size_t i=0; i<8; i++) cnt += ((int*)valid)[i] == -1;);
     STAT3(shadow.travs,1,cnt,8);
+    SceneStat::Counters* stats = ((Scene*)scene)->statistics.begin();
     ((Scene*)scene)->occluded8(valid,ray);
+    STAT_SCENE(stats,count(valid,ray.geomID,8));
 #endif
   }
   
@@ -463,10 +676,66 @@ namespace embree
 #else
     STAT(size_t cnt=0; for (size_t i=0; i<16; i++) cnt += ((int*)valid)[i] == -1;);
     STAT3(shadow.travs,1,cnt,16);
+    SceneStat::Counters* stats = ((Scene*)scene)->statistics.begin();
     ((Scene*)scene)->occluded16(valid,ray);
+    STAT_SCENE(stats,count(valid,ray.geomID,16));
 #endif
   }
   
+  RTCORE_API void rtcIntersectN (RTCScene scene, RTCRay* rays, size_t N) 
+  {
+    TRACE(rtcIntersectN);
+    SceneStat::Counters* stats = ((Scene*)scene)->statistics.begin();
+    RayStream::intersect((Scene*)scene,rays,N);
+    for (size_t i=0; i<N; i++) STAT_SCENE(stats,count(rays[i].geomID));
+  }
+
+  RTCORE_API void rtcIntersectNp (RTCScene scene, const RTCRayNp& rays, size_t N) 
+  {
+    TRACE(rtcIntersectNp);
+    SceneStat::Counters* stats = ((Scene*)scene)->statistics.begin();
+    RayStream::intersect((Scene*)scene,rays,N);
+    for (size_t i=0; i<N; i++) STAT_SCENE(stats,count(rays.geomID[i]));
+  }
+  
+  RTCORE_API void rtcOccludedN (RTCScene scene, RTCRay* rays, size_t N) 
+  {
+    TRACE(rtcOccludedN);
+    SceneStat::Counters* stats = ((Scene*)scene)->statistics.begin();
+    RayStream::occluded((Scene*)scene,rays,N);
+    for (size_t i=0; i<N; i++) STAT_SCENE(stats,count(rays[i].geomID));
+  }
+
+  RTCORE_API void rtcOccludedNp (RTCScene scene, const RTCRayNp& rays, size_t N) 
+  {
+    TRACE(rtcOccludedNp);
+    SceneStat::Counters* stats = ((Scene*)scene)->statistics.begin();
+    RayStream::occluded((Scene*)scene,rays,N);
+    for (size_t i=0; i<N; i++) STAT_SCENE(stats,count(rays.geomID[i]));
+  }
+
+  RTCORE_API void rtcIntersectPacket (RTCScene scene, const RTCRayNp& rays, size_t N) 
+  {
+    TRACE(rtcIntersectPacket);
+    SceneStat::Counters* stats = ((Scene*)scene)->statistics.begin();
+    if (N <= RTC_MAX_PACKET_SIZE && ((Scene*)scene)->intersectors.intersectorPacket) 
+      ((Scene*)scene)->intersectPacket(rays,N);
+    else
+      RayStream::intersect((Scene*)scene,rays,N);
+    for (size_t i=0; i<N; i++) STAT_SCENE(stats,count(rays.geomID[i]));
+  }
+
+  RTCORE_API void rtcOccludedPacket (RTCScene scene, const RTCRayNp& rays, size_t N) 
+  {
+    TRACE(rtcOccludedPacket);
+    SceneStat::Counters* stats = ((Scene*)scene)->statistics.begin();
+    if (N <= RTC_MAX_PACKET_SIZE && ((Scene*)scene)->intersectors.intersectorPacket) 
+      ((Scene*)scene)->occludedPacket(rays,N);
+    else
+      RayStream::occluded((Scene*)scene,rays,N);
+    for (size_t i=0; i<N; i++) STAT_SCENE(stats,count(rays.geomID[i]));
+  }
+  
   RTCORE_API void rtcDeleteScene (RTCScene scene) 
   {
     CATCH_BEGIN;
@@ -548,6 +817,29 @@ namespace embree
     return -1;
   }
 
+  RTCORE_API void rtcNewTriangleMeshes (RTCScene scene, RTCGeometryFlags flags, size_t numMeshes, const RTCMeshRange* ranges, void* indices, void* vertices, unsigned* geomIDs) 
+  {
+    CATCH_BEGIN;
+    TRACE(rtcNewTriangleMeshes);
+    VERIFY_HANDLE(scene);
+    if (numMeshes && (ranges == NULL || indices == NULL || vertices == NULL || geomIDs == NULL)) {
+      recordError(RTC_INVALID_ARGUMENT);
+      return;
+    }
+    ((Scene*)scene)->newTriangleMeshes(flags,numMeshes,ranges,indices,vertices,geomIDs);
+    CATCH_END;
+  }
+
+  RTCORE_API unsigned rtcNewQuadMesh (RTCScene scene, RTCGeometryFlags flags, size_t numQuads, size_t numVertices, size_t numTimeSteps) 
+  {
+    CATCH_BEGIN;
+    TRACE(rtcNewQuadMesh);
+    VERIFY_HANDLE(scene);
+    return ((Scene*)scene)->newQuadMesh(flags,numQuads,numVertices,numTimeSteps);
+    CATCH_END;
+    return -1;
+  }
+
   RTCORE_API unsigned rtcNewQuadraticBezierCurves (RTCScene scene, RTCGeometryFlags flags, size_t numCurves, size_t numVertices, size_t numTimeSteps) 
   {
     CATCH_BEGIN;
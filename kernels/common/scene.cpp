@@ -15,6 +15,7 @@
 // ======================================================================== //
 
 #include "scene.h"
+#include <fstream>
 
 #if !defined(__MIC__)
 #include "bvh4/twolevel_accel.h"
@@ -32,15 +33,23 @@
 namespace embree
 {
   Scene::Scene (RTCSceneFlags sflags, RTCAlgorithmFlags aflags)
-    : flags(sflags), aflags(aflags), numMappedBuffers(0), is_build(false), needTriangles(false), needVertices(false),
-      numTriangleMeshes(0), numTriangleMeshes2(0), numCurveSets(0), numCurveSets2(0), numUserGeometries(0),
-      flat_triangle_source_1(this,1), flat_triangle_source_2(this,2)
+    : flags(sflags), aflags(aflags), backAccels(NULL), activeAccels(&accels), buildAccels(&accels), buildEvent(NULL), buildDone(false), buildVetoed(false),
+      numMappedBuffers(0), is_build(false), needTriangles(false), needVertices(false),
+      numTriangleMeshes(0), numTriangleMeshes2(0), numQuadMeshes(0), numQuadMeshes2(0), numCurveSets(0), numCurveSets2(0), numUserGeometries(0),
+      flat_triangle_source_1(this,1), flat_triangle_source_2(this,2), flat_quad_source(this),
+      flat_curves_source(this,1), flat_curves_source_subdiv(this,4)
   {
     if (g_scene_flags != -1)
       flags = (RTCSceneFlags) g_scene_flags;
 
     geometries.reserve(128);
+    if (TaskScheduler::hasUserThreads())
+      commitBarrier.init(TaskScheduler::getNumThreads());
+    createAccels(accels);
+  }
 
+  void Scene::createAccels (AccelN& accels)
+  {
 #if defined(__MIC__)
 
     g_top_accel = g_tri_accel;
@@ -114,7 +123,7 @@ namespace embree
           break;
 
         case /*0b001*/ 1: accels.add(BVH4::BVH4Triangle4vObjectSplit(this)); break;
-        case /*0b010*/ 2: accels.add(BVH4::BVH4Triangle4iObjectSplit(this)); break;
+        case /*0b010*/ 2: accels.add(BVH4::BVH4Triangle4iCompressed(this)); break;
         case /*0b011*/ 3: accels.add(BVH4::BVH4Triangle4iObjectSplit(this)); break;
         case /*0b100*/ 4: 
           if (isHighQuality()) accels.add(BVH4::BVH4Triangle1SpatialSplit(this));
@@ -159,10 +168,20 @@ namespace embree
       else if (g_tri_accel == "bvh4.triangle1v")        accels.add(BVH4::BVH4Triangle1v(this));
       else if (g_tri_accel == "bvh4.triangle4v")        accels.add(BVH4::BVH4Triangle4v(this));
       else if (g_tri_accel == "bvh4.triangle4i")        accels.add(BVH4::BVH4Triangle4i(this));
+      else if (g_tri_accel == "bvh4.triangle4q")        accels.add(BVH4::BVH4Triangle4q(this));
+      else if (g_tri_accel == "bvh4.triangle4w")        accels.add(BVH4::BVH4Triangle4w(this));
+#if defined (__TARGET_AVX__)
+      else if (g_tri_accel == "bvh4.triangle8w")        accels.add(BVH4::BVH4Triangle8w(this));
+#endif
+      else if (g_tri_accel == "bvh4.triangle4.compressed")  accels.add(BVH4::BVH4Triangle4Compressed(this));
+      else if (g_tri_accel == "bvh4.triangle4i.compressed") accels.add(BVH4::BVH4Triangle4iCompressed(this));
+      else if (g_tri_accel == "bvh4.triangle4q.compressed") accels.add(BVH4::BVH4Triangle4qCompressed(this));
       else if (g_tri_accel == "bvh4i.triangle1")        accels.add(BVH4i::BVH4iTriangle1(this));
       else if (g_tri_accel == "bvh4i.triangle4")        accels.add(BVH4i::BVH4iTriangle4(this));
+      else if (g_tri_accel == "bvh4i.triangle4w")       accels.add(BVH4i::BVH4iTriangle4w(this));
 #if defined (__TARGET_AVX__)
       else if (g_tri_accel == "bvh4i.triangle8")        accels.add(BVH4i::BVH4iTriangle8(this));
+      else if (g_tri_accel == "bvh4i.triangle8w")       accels.add(BVH4i::BVH4iTriangle8w(this));
 #endif
       else if (g_tri_accel == "bvh4i.triangle1.v1")     accels.add(BVH4i::BVH4iTriangle1_v1(this));
       else if (g_tri_accel == "bvh4i.triangle1.v2")     accels.add(BVH4i::BVH4iTriangle1_v2(this));
@@ -178,13 +197,26 @@ namespace embree
     else {
       accels.add(new TwoLevelAccel(g_top_accel,this));
     }
+
+    /* create acceleration structure for quad meshes */
+    accels.add(BVH4::BVH4Quad4(this));
+
+    /* create acceleration structure for hair geometry */
+    accels.add(BVH4::BVH4Bezier1(this));
 #endif
   }
   
   Scene::~Scene () 
   {
+    /* wait for pending build */
+    if (buildEvent) {
+      buildEvent->sync();
+      delete buildEvent;
+    }
+
     for (size_t i=0; i<geometries.size(); i++)
       delete geometries[i];
+    delete backAccels;
   }
 
   unsigned Scene::newUserGeometry (size_t items) 
@@ -214,6 +246,50 @@ namespace embree
     return geom->id;
   }
 
+  void Scene::newTriangleMeshes (RTCGeometryFlags gflags, size_t numMeshes, const RTCMeshRange* ranges, void* indices, void* vertices, unsigned* geomIDs) 
+  {
+    for (size_t i=0; i<numMeshes; i++)
+      geomIDs[i] = RTC_INVALID_GEOMETRY_ID;
+
+    if (isStatic() && (gflags != RTC_GEOMETRY_STATIC)) {
+      recordError(RTC_INVALID_OPERATION);
+      return;
+    }
+
+    {
+      Lock<AtomicMutex> lock(geometriesMutex);
+      geometries.reserve(geometries.size()+numMeshes);
+    }
+
+    /* the meshes reference their part of the shared arrays */
+    typedef TriangleMeshScene::TriangleMesh::Triangle Triangle;
+    for (size_t i=0; i<numMeshes; i++) 
+    {
+      const RTCMeshRange& range = ranges[i];
+      TriangleMeshScene::TriangleMesh* mesh = new TriangleMeshScene::TriangleMesh(this,gflags,range.numTriangles,range.numVertices,1);
+      mesh->setBuffer(RTC_INDEX_BUFFER ,indices ,range.firstTriangle*sizeof(Triangle),sizeof(Triangle));
+      mesh->setBuffer(RTC_VERTEX_BUFFER,vertices,range.firstVertex*sizeof(Vec3fa),sizeof(Vec3fa));
+      geomIDs[i] = mesh->id;
+    }
+  }
+
+  unsigned Scene::newQuadMesh (RTCGeometryFlags gflags, size_t numQuads, size_t numVertices, size_t numTimeSteps) 
+  {
+    if (isStatic() && (gflags != RTC_GEOMETRY_STATIC)) {
+      recordError(RTC_INVALID_OPERATION);
+      return -1;
+    }
+
+    /* no acceleration structure supports motion blurred quads yet */
+    if (numTimeSteps != 1) {
+      recordError(RTC_INVALID_OPERATION);
+      return -1;
+    }
+    
+    Geometry* geom = new QuadMeshScene::QuadMesh(this,gflags,numQuads,numVertices,numTimeSteps);
+    return geom->id;
+  }
+
   unsigned Scene::newQuadraticBezierCurves (RTCGeometryFlags gflags, size_t numCurves, size_t numVertices, size_t numTimeSteps) 
   {
     if (isStatic() && (gflags != RTC_GEOMETRY_STATIC)) {
@@ -255,21 +331,79 @@ namespace embree
   }
 
   void Scene::build (size_t threadIndex, size_t threadCount) {
-    accels.build(threadIndex,threadCount);
+    buildAccels->build(threadIndex,threadCount);
   }
 
   void Scene::task_build(size_t threadIndex, size_t threadCount, TaskScheduler::Event* event) {
     build(threadIndex,threadCount);
+    buildDone = true;
   }
 
   void Scene::build () 
   {
     Lock<MutexSys> lock(mutex);
+    if (TaskScheduler::hasUserThreads()) {
+      recordError(RTC_INVALID_OPERATION);
+      return;
+    }
+    if (startBuild(false)) finishBuild();
+  }
+
+  void Scene::buildAsync () 
+  {
+    Lock<MutexSys> lock(mutex);
+    if (TaskScheduler::hasUserThreads()) {
+      recordError(RTC_INVALID_OPERATION);
+      return;
+    }
+    startBuild(true);
+  }
 
-    if ((isStatic() && isBuild()) || !ready()) {
+  void Scene::buildThread (size_t threadIndex, size_t threadCount) 
+  {
+    if (!TaskScheduler::hasUserThreads()) {
       recordError(RTC_INVALID_OPERATION);
       return;
     }
+    if (threadCount != TaskScheduler::getNumThreads() || threadIndex >= threadCount) {
+      recordError(RTC_INVALID_ARGUMENT);
+      return;
+    }
+
+    /* first thread spawns the build task */
+    if (threadIndex == 0) {
+      mutex.lock();
+      if (!startBuild(false)) buildDone = true;
+    }
+    commitBarrier.wait();
+
+    /* all threads work on the tasks of the build */
+    while (!buildDone)
+      TaskScheduler::processTask(threadIndex,threadCount);
+
+    /* first thread makes the new acceleration structures visible */
+    if (threadIndex == 0) {
+      if (buildEvent) finishBuild();
+      mutex.unlock();
+    }
+    commitBarrier.wait();
+  }
+
+  bool Scene::waitBuild (bool block) 
+  {
+    Lock<MutexSys> lock(mutex);
+    if (buildEvent == NULL) return true;
+    if (!block && !buildDone) return false;
+    finishBuild();
+    return true;
+  }
+
+  bool Scene::startBuild (bool async)
+  {
+    if ((isStatic() && isBuild()) || !ready() || buildEvent) {
+      recordError(RTC_INVALID_OPERATION);
+      return false;
+    }
 
     /* verify geometry in debug mode  */
 #if defined(DEBUG)
@@ -283,31 +417,87 @@ namespace embree
     }
 #endif
 
+    /* remember geometries modified by the application */
+    std::vector<size_t> modified;
+    for (size_t i=0; i<geometries.size(); i++)
+      if (geometries[i] && geometries[i]->isModified()) modified.push_back(i);
+
+    /* an asynchronous commit of a dynamic scene builds into a second
+     * set of acceleration structures, such that the previously
+     * committed version can still be traced during the build */
+    buildAccels = activeAccels;
+    if (isDynamic() && isBuild() && (async || backAccels)) 
+    {
+      const bool created = backAccels == NULL;
+      if (created) {
+        backAccels = new AccelN;
+        createAccels(*backAccels);
+      }
+      buildAccels = activeAccels == &accels ? backAccels : &accels;
+
+      /* the builders only rebuild modified geometries, thus also
+       * geometries modified for the build of the other acceleration
+       * structures have to get marked as modified again */
+      for (size_t i=0; i<geometries.size(); i++) 
+      {
+        Geometry* geom = geometries[i];
+        if (geom == NULL || geom->state != Geometry::ENABLED) continue;
+        if (created || std::find(modifiedGeometries.begin(),modifiedGeometries.end(),i) != modifiedGeometries.end())
+          geom->state = Geometry::MODIFIED;
+      }
+    }
+    modifiedGeometries = modified;
+
     /* spawn build task */
-    TaskScheduler::EventSync event;
-    new (&task) TaskScheduler::Task(&event,NULL,NULL,1,_task_build,this,"scene_build");
+    buildDone = false;
+    buildEvent = new TaskScheduler::EventSync;
+    new (&task) TaskScheduler::Task(buildEvent,NULL,NULL,1,_task_build,this,"scene_build");
     TaskScheduler::addTask(-1,TaskScheduler::GLOBAL_FRONT,&task);
-    event.sync();
+    return true;
+  }
+
+  void Scene::finishBuild ()
+  {
+    /* wait for build task */
+    buildEvent->sync();
+    delete buildEvent; buildEvent = NULL;
 
     /* make static geometry immutable */
     if (isStatic()) 
     {
-      accels.immutable();
+      buildAccels->immutable();
+      buildAccels->layout();
+      if (isCompact()) buildAccels->compact();
+      if (g_numa_replicate) buildAccels->replicate();
       for (size_t i=0; i<geometries.size(); i++)
         geometries[i]->immutable();
     }
 
-    /* delete geometry that is scheduled for delete */
+    /* delete geometry that is scheduled for delete, with double
+     * buffering both acceleration structures have to release the
+     * geometry first */
+    std::vector<Geometry*> erase;
     for (size_t i=0; i<geometries.size(); i++) 
     {
       Geometry* geom = geometries[i];
       if (geom == NULL || geom->state != Geometry::ERASING) continue;
-      remove(geom);
+      if (backAccels && std::find(pendingErase.begin(),pendingErase.end(),geom) == pendingErase.end()) 
+        erase.push_back(geom);
+      else
+        remove(geom);
+    }
+    pendingErase = erase;
+
+    /* the vetoed acceleration structures stayed empty */
+    if (buildVetoed) {
+      buildVetoed = false;
+      recordError(RTC_OUT_OF_MEMORY);
     }
 
     /* update bounds */
-    bounds = accels.bounds;
-    intersectors = accels.intersectors;
+    bounds = buildAccels->bounds;
+    intersectors = buildAccels->intersectors;
+    activeAccels = buildAccels;
     is_build = true;
 
     /* enable only algorithms choosen by application */
@@ -322,6 +512,7 @@ namespace embree
     if ((aflags & RTC_INTERSECT8) == 0) {
       intersectors.intersector8.intersect = NULL;
       intersectors.intersector8.occluded = NULL;
+      intersectors.intersectorPacket = Accel::IntersectorPacket();
     }
     if ((aflags & RTC_INTERSECT16) == 0) {
       intersectors.intersector16.intersect = NULL;
@@ -330,9 +521,155 @@ namespace embree
 
     if (g_verbose >= 2) {
       std::cout << "created scene intersector" << std::endl;
-      accels.print(2);
+      buildAccels->print(2);
       std::cout << "selected scene intersector" << std::endl;
       intersectors.print(2);
     }
   }
+
+  /*! Header of a stored scene. Used to verify that the scene a file
+   *  gets loaded into matches the stored scene. */
+  struct SceneFileHeader
+  {
+    char magic[8];            //!< identifies scene files
+    size_t version;           //!< version of the file format
+    size_t flags;             //!< scene flags
+    size_t aflags;            //!< algorithm flags
+    size_t numGeometries;     //!< number of geometries in the scene
+    size_t numTriangles;      //!< number of triangles of all enabled triangle meshes
+    char intersector[64];     //!< name of the single ray intersector of the stored acceleration structure
+  };
+
+  static const char sceneFileMagic[8] = "embree2";
+  static const size_t sceneFileVersion = 1;
+
+  static bool initFileHeader(Scene* scene, SceneFileHeader& header)
+  {
+    const char* name = scene->accels.accels[0]->intersectors.intersector1.name;
+    if (name == NULL || strlen(name) >= sizeof(header.intersector)) 
+      return false;
+
+    memset(&header,0,sizeof(header));
+    memcpy(header.magic,sceneFileMagic,sizeof(header.magic));
+    header.version = sceneFileVersion;
+    header.flags = scene->flags;
+    header.aflags = scene->aflags;
+    header.numGeometries = scene->size();
+    for (size_t i=0; i<scene->size(); i++) {
+      Scene::TriangleMesh* mesh = scene->getTriangleMeshSafe(i);
+      if (mesh && mesh->isEnabled() && mesh->numTimeSteps == 1)
+        header.numTriangles += mesh->numTriangles;
+    }
+    strcpy(header.intersector,name);
+    return true;
+  }
+
+  void Scene::store (const char* fileName)
+  {
+    Lock<MutexSys> lock(mutex);
+
+    /* only committed static scenes that contain just triangle meshes can get stored */
+    if (!isStatic() || !isBuild() || accels.N == 0 || 
+        numTriangleMeshes2 || numQuadMeshes || numQuadMeshes2 || numCurveSets || numCurveSets2 || numUserGeometries) {
+      recordError(RTC_INVALID_OPERATION);
+      return;
+    }
+
+    SceneFileHeader header;
+    if (!initFileHeader(this,header)) {
+      recordError(RTC_INVALID_OPERATION);
+      return;
+    }
+
+    if (fileName == NULL) {
+      recordError(RTC_INVALID_ARGUMENT);
+      return;
+    }
+    std::ofstream out(fileName,std::ios::out | std::ios::binary);
+    if (!out.is_open()) {
+      recordError(RTC_INVALID_ARGUMENT);
+      return;
+    }
+
+    out.write((char*)&header,sizeof(header));
+    if (!accels.accels[0]->store(out)) {
+      out.close();
+      ::remove(fileName);
+      recordError(RTC_INVALID_OPERATION);
+    }
+  }
+
+  void Scene::load (const char* fileName)
+  {
+    {
+      Lock<MutexSys> lock(mutex);
+
+      if (!isStatic() || isBuild() || buildEvent || !ready() || accels.N == 0) {
+        recordError(RTC_INVALID_OPERATION);
+        return;
+      }
+
+      if (fileName == NULL) {
+        recordError(RTC_INVALID_ARGUMENT);
+        return;
+      }
+      size_t bytes = 0;
+      void* file = os_map_file(fileName,bytes);
+      if (file == NULL) {
+        recordError(RTC_INVALID_ARGUMENT);
+        return;
+      }
+
+      /* the stored scene has to match this scene */
+      SceneFileHeader header;
+      const SceneFileHeader& stored = *(SceneFileHeader*)file;
+      bool valid = bytes >= sizeof(SceneFileHeader) && initFileHeader(this,header);
+      valid = valid && memcmp(&stored,&header,sizeof(header)) == 0;
+
+      /* the acceleration structure takes ownership of the mapped file */
+      valid = valid && accels.accels[0]->load(file,bytes,sizeof(SceneFileHeader));
+      if (!valid) {
+        os_unmap_file(file,bytes);
+        recordError(RTC_INVALID_ARGUMENT);
+        return;
+      }
+    }
+
+    /* finish commit of the scene without building the loaded acceleration structure */
+    build();
+  }
+
+  size_t Scene::getMemoryStatistics (RTCMemoryStatistics* stats, size_t maxStats)
+  {
+    Lock<MutexSys> lock(mutex);
+
+    /* the acceleration structures are modified by a pending asynchronous build */
+    if (buildEvent && buildAccels == activeAccels) {
+      recordError(RTC_INVALID_OPERATION);
+      return 0;
+    }
+
+    /* one entry for each acceleration structure */
+    const size_t numStats = activeAccels->N+1;
+    std::vector<RTCMemoryStatistics> accelStats(numStats);
+    memset(&accelStats[0],0,numStats*sizeof(RTCMemoryStatistics));
+    for (size_t i=0; i<activeAccels->N; i++)
+      activeAccels->accels[i]->memoryStatistics(accelStats[i+1]);
+
+    /* the total also counts the second set of a double buffered scene and the geometry buffers */
+    RTCMemoryStatistics& total = accelStats[0];
+    if (backAccels) {
+      accels.memoryStatistics(total);
+      backAccels->memoryStatistics(total);
+    }
+    else 
+      activeAccels->memoryStatistics(total);
+
+    for (size_t i=0; i<geometries.size(); i++)
+      if (geometries[i]) geometries[i]->memoryStatistics(total);
+
+    for (size_t i=0; i<min(numStats,maxStats); i++)
+      stats[i] = accelStats[i];
+    return numStats;
+  }
 }
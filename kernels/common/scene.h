@@ -20,12 +20,14 @@
 #include "common/default.h"
 
 #include "scene_triangle_mesh.h"
+#include "scene_quad_mesh.h"
 #include "scene_user_geometry.h"
 #include "scene_quadratic_bezier_curves.h"
 
 #include "common/acceln.h"
 #include "geometry.h"
 #include "common/buildsource.h"
+#include "sys/sync/barrier.h"
 
 namespace embree
 {
@@ -36,6 +38,8 @@ namespace embree
   public:
 
     typedef TriangleMeshScene::TriangleMesh TriangleMesh;
+    typedef QuadMeshScene::QuadMesh QuadMesh;
+    typedef QuadraticBezierCurvesScene::QuadraticBezierCurves QuadraticBezierCurves;
     
     /*! Scene construction */
     Scene (RTCSceneFlags flags, RTCAlgorithmFlags aflags);
@@ -52,6 +56,12 @@ namespace embree
     /*! Creates a new triangle mesh. */
     unsigned int newTriangleMesh (RTCGeometryFlags flags, size_t maxTriangles, size_t maxVertices, size_t numTimeSteps);
 
+    /*! Creates many triangle meshes that share the application's index and vertex arrays. */
+    void newTriangleMeshes (RTCGeometryFlags flags, size_t numMeshes, const RTCMeshRange* ranges, void* indices, void* vertices, unsigned* geomIDs);
+
+    /*! Creates a new quad mesh. */
+    unsigned int newQuadMesh (RTCGeometryFlags flags, size_t maxQuads, size_t maxVertices, size_t numTimeSteps);
+
     /*! Creates a new collection of quadratic bezier curves. */
     unsigned int newQuadraticBezierCurves (RTCGeometryFlags flags, size_t maxCurves, size_t maxVertices, size_t numTimeSteps);
 
@@ -60,6 +70,39 @@ namespace embree
 
     void build (size_t threadIndex, size_t threadCount);
 
+    /*! Starts building the acceleration structure in the background. */
+    void buildAsync ();
+
+    /*! Finishes a pending asynchronous build. Returns false if the
+     *  build is still running and blocking is disabled. */
+    bool waitBuild (bool block);
+
+    /*! Builds the acceleration structure using threads of the application. */
+    void buildThread (size_t threadIndex, size_t threadCount);
+
+  private:
+
+    /*! Creates all acceleration structures of the scene. */
+    void createAccels (AccelN& accels);
+
+    /*! Selects the acceleration structures to build and spawns the build task. */
+    bool startBuild (bool async);
+
+    /*! Waits for the build task and makes the new acceleration structures visible. */
+    void finishBuild ();
+
+  public:
+
+    /*! Stores the acceleration structure of a committed static scene to a file. */
+    void store (const char* fileName);
+
+    /*! Commits the scene by mapping a previously stored acceleration structure. */
+    void load (const char* fileName);
+
+    /*! Writes the memory consumption of the scene and of each of its
+     *  acceleration structures, returns the number of entries available. */
+    size_t getMemoryStatistics (RTCMemoryStatistics* stats, size_t maxStats);
+
     /*! build task */
     TASK_COMPLETE_FUNCTION(Scene,task_build);
     TaskScheduler::Task task;
@@ -105,6 +148,32 @@ namespace embree
       if (geometries[i]->type != TRIANGLE_MESH) return NULL;
       else return (TriangleMesh*) geometries[i]; 
     }
+    /* get quad mesh by ID */
+    __forceinline QuadMesh* getQuadMesh(size_t i) { 
+      assert(i < geometries.size()); 
+      assert(geometries[i]);
+      assert(geometries[i]->type == QUAD_MESH);
+      return (QuadMesh*) geometries[i]; 
+    }
+    __forceinline const QuadMesh* getQuadMesh(size_t i) const { 
+      assert(i < geometries.size()); 
+      assert(geometries[i]);
+      assert(geometries[i]->type == QUAD_MESH);
+      return (QuadMesh*) geometries[i]; 
+    }
+    /* get bezier curve set by ID */
+    __forceinline QuadraticBezierCurves* getQuadraticBezierCurves(size_t i) { 
+      assert(i < geometries.size()); 
+      assert(geometries[i]);
+      assert(geometries[i]->type == QUADRATIC_BEZIER_CURVES);
+      return (QuadraticBezierCurves*) geometries[i]; 
+    }
+    __forceinline const QuadraticBezierCurves* getQuadraticBezierCurves(size_t i) const { 
+      assert(i < geometries.size()); 
+      assert(geometries[i]);
+      assert(geometries[i]->type == QUADRATIC_BEZIER_CURVES);
+      return (QuadraticBezierCurves*) geometries[i]; 
+    }
     __forceinline UserGeometryScene::Base* getUserGeometrySafe(size_t i) { 
       assert(i < geometries.size()); 
       if (geometries[i] == NULL) return NULL;
@@ -203,6 +272,112 @@ namespace embree
       size_t numTimeSteps;
     };
 
+
+    /*! Build source for all quads of the scene. */
+    struct FlatQuadMeshAccelBuildSource : public BuildSource
+    {
+      FlatQuadMeshAccelBuildSource (Scene* scene)
+        : scene(scene) {}
+
+      bool isEmpty () const { 
+        return scene->numQuadMeshes == 0;
+      }
+      
+      size_t groups () const { 
+        return scene->geometries.size();
+      }
+      
+      size_t prims (size_t group, size_t* numVertices) const 
+      {
+        if (scene->get(group) == NULL || scene->get(group)->type != QUAD_MESH) return 0;
+        QuadMesh* mesh = scene->getQuadMesh(group);
+        if (mesh == NULL || !mesh->isEnabled() || mesh->numTimeSteps != 1) return 0;
+        if (numVertices) *numVertices = mesh->numVertices;
+        return mesh->numQuads;
+      }
+
+      const BBox3f bounds(size_t group, size_t prim) const 
+      {
+        assert(scene->get(group) != NULL);
+        assert(scene->get(group)->type == QUAD_MESH);
+
+        const QuadMesh* mesh = scene->getQuadMesh(group);
+        if (mesh == NULL) return empty;
+        return mesh->bounds(prim);
+      }
+
+      void bounds(size_t group, size_t begin, size_t end, BBox3f* bounds_o) const 
+      {
+        assert(scene->get(group) != NULL);
+        assert(scene->get(group)->type == QUAD_MESH);
+
+        const QuadMesh* mesh = scene->getQuadMesh(group);
+        if (mesh == NULL) { 
+          for (size_t i=0; i<end-begin; i++)
+            bounds_o[i] = empty;
+        } else {
+          for (size_t i=begin; i<end; i++)
+            bounds_o[i-begin] = mesh->bounds(i);
+        }
+      }
+
+    public:
+      Scene* scene;
+    };
+
+    /*! Build source for all curves of the scene. Each curve can get
+     *  subdivided into multiple segments to obtain tighter bounds. */
+    struct FlatBezierCurvesAccelBuildSource : public BuildSource
+    {
+      FlatBezierCurvesAccelBuildSource (Scene* scene, size_t numSegments = 1)
+        : scene(scene), numSegments(numSegments) {}
+
+      bool isEmpty () const { 
+        return scene->numCurveSets == 0;
+      }
+      
+      size_t groups () const { 
+        return scene->geometries.size();
+      }
+      
+      size_t prims (size_t group, size_t* numVertices) const 
+      {
+        if (scene->get(group) == NULL || scene->get(group)->type != QUADRATIC_BEZIER_CURVES) return 0;
+        QuadraticBezierCurves* curves = scene->getQuadraticBezierCurves(group);
+        if (curves == NULL || !curves->isEnabled() || curves->numTimeSteps != 1) return 0;
+        if (numVertices) *numVertices = curves->numVertices;
+        return numSegments*curves->numCurves;
+      }
+
+      const BBox3f bounds(size_t group, size_t prim) const 
+      {
+        assert(scene->get(group) != NULL);
+        assert(scene->get(group)->type == QUADRATIC_BEZIER_CURVES);
+
+        const QuadraticBezierCurves* curves = scene->getQuadraticBezierCurves(group);
+        if (curves == NULL) return empty;
+        return curves->bounds(prim/numSegments,prim%numSegments,numSegments);
+      }
+
+      void bounds(size_t group, size_t begin, size_t end, BBox3f* bounds_o) const 
+      {
+        assert(scene->get(group) != NULL);
+        assert(scene->get(group)->type == QUADRATIC_BEZIER_CURVES);
+
+        const QuadraticBezierCurves* curves = scene->getQuadraticBezierCurves(group);
+        if (curves == NULL) { 
+          for (size_t i=0; i<end-begin; i++)
+            bounds_o[i] = empty;
+        } else {
+          for (size_t i=begin; i<end; i++)
+            bounds_o[i-begin] = curves->bounds(i/numSegments,i%numSegments,numSegments);
+        }
+      }
+
+    public:
+      Scene* scene;
+      size_t numSegments;
+    };
     
   public:
     std::vector<int> usedIDs;
@@ -210,7 +385,17 @@ namespace embree
     
   public:
     AccelN accels;
+    AccelN* backAccels;                //!< second set of acceleration structures for double buffered builds
+    AccelN* activeAccels;              //!< acceleration structures currently used for tracing rays
+    AccelN* buildAccels;               //!< acceleration structures the build task is working on
+    TaskScheduler::EventSync* buildEvent; //!< event of pending build task
+    volatile bool buildDone;           //!< set once the build task finished
+    volatile bool buildVetoed;         //!< set if the memory monitor vetoed some allocation of the build
+    std::vector<size_t> modifiedGeometries; //!< geometries modified for the last build
+    std::vector<Geometry*> pendingErase; //!< erased geometries still referenced by the other acceleration structures
+    BarrierSys commitBarrier;          //!< synchronizes application threads joining the build
     atomic_t numMappedBuffers;         //!< number of mapped buffers
+    SceneStat statistics;              //!< runtime traversal statistics
     RTCSceneFlags flags;
     RTCAlgorithmFlags aflags;
     bool needTriangles;
@@ -222,6 +407,8 @@ namespace embree
   public:
     atomic_t numTriangleMeshes;        //!< number of enabled triangle meshes
     atomic_t numTriangleMeshes2;       //!< number of enabled motion blur triangle meshes
+    atomic_t numQuadMeshes;            //!< number of enabled quad meshes
+    atomic_t numQuadMeshes2;           //!< number of enabled motion blur quad meshes
     atomic_t numCurveSets;             //!< number of enabled curve sets
     atomic_t numCurveSets2;            //!< number of enabled motion blur curve sets
     atomic_t numUserGeometries;        //!< number of enabled user geometries
@@ -229,6 +416,9 @@ namespace embree
   public:
     FlatTriangleAccelBuildSource flat_triangle_source_1;
     FlatTriangleAccelBuildSource flat_triangle_source_2;
+    FlatQuadMeshAccelBuildSource flat_quad_source;
+    FlatBezierCurvesAccelBuildSource flat_curves_source;
+    FlatBezierCurvesAccelBuildSource flat_curves_source_subdiv;
   };
 
   typedef Builder* (*TriangleMeshBuilderFunc)(void* accel, TriangleMeshScene::TriangleMesh* mesh, const size_t minLeafSize, const size_t maxLeafSize);
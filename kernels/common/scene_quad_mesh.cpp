@@ -0,0 +1,209 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "scene_quad_mesh.h"
+#include "scene.h"
+
+namespace embree
+{
+  QuadMeshScene::QuadMesh::QuadMesh (Scene* parent, RTCGeometryFlags flags, size_t numQuads, size_t numVertices, size_t numTimeSteps)
+    : Geometry(parent,QUAD_MESH,numQuads,flags), 
+      mask(-1), built(false), numTimeSteps(numTimeSteps),
+      numQuads(numQuads), needQuads(false),
+      numVertices(numVertices), needVertices(false)
+  {
+    quads.init(numQuads,sizeof(Quad));
+    for (size_t i=0; i<numTimeSteps; i++) {
+      vertices[i].init(numVertices,sizeof(Vec3fa));
+    }
+    enabling();
+  }
+  
+  void QuadMeshScene::QuadMesh::enabling() 
+  { 
+    if (numTimeSteps == 1) atomic_add(&parent->numQuadMeshes ,1); 
+    else                   atomic_add(&parent->numQuadMeshes2,1); 
+  }
+  
+  void QuadMeshScene::QuadMesh::disabling() 
+  { 
+    if (numTimeSteps == 1) atomic_add(&parent->numQuadMeshes ,-1); 
+    else                   atomic_add(&parent->numQuadMeshes2,-1); 
+  }
+
+  void QuadMeshScene::QuadMesh::setMask (unsigned mask) 
+  {
+    if (parent->isStatic() && parent->isBuild()) {
+      recordError(RTC_INVALID_OPERATION);
+      return;
+    }
+    this->mask = mask; 
+  }
+
+  void QuadMeshScene::QuadMesh::enable () 
+  {
+    if (parent->isStatic() || anyMappedBuffers()) {
+      recordError(RTC_INVALID_OPERATION);
+      return;
+    }
+    Geometry::enable();
+  }
+
+  void QuadMeshScene::QuadMesh::update () 
+  {
+    if (parent->isStatic() || anyMappedBuffers()) {
+      recordError(RTC_INVALID_OPERATION);
+      return;
+    }
+    Geometry::update();
+  }
+
+  void QuadMeshScene::QuadMesh::disable () 
+  {
+    if (parent->isStatic() || anyMappedBuffers()) {
+      recordError(RTC_INVALID_OPERATION);
+      return;
+    }
+    Geometry::disable();
+  }
+
+  void QuadMeshScene::QuadMesh::erase () 
+  {
+    if (parent->isStatic() || anyMappedBuffers()) {
+      recordError(RTC_INVALID_OPERATION);
+      return;
+    }
+    Geometry::erase();
+  }
+
+  void QuadMeshScene::QuadMesh::setBuffer(RTCBufferType type, void* ptr, size_t offset, size_t stride) 
+  { 
+    if (parent->isStatic() && parent->isBuild()) {
+      recordError(RTC_INVALID_OPERATION);
+      return;
+    }
+
+    /* verify that all accesses are 4 bytes aligned */
+    if (((size_t(ptr) + offset) & 0x3) || (stride & 0x3)) {
+      recordError(RTC_INVALID_OPERATION);
+      return;
+    }
+
+    /* verify that all vertex accesses are 16 bytes aligned */
+#if defined(__MIC__)
+    if (type == RTC_VERTEX_BUFFER0 || type == RTC_VERTEX_BUFFER1) {
+      if (((size_t(ptr) + offset) & 0xF) || (stride & 0xF)) {
+        recordError(RTC_INVALID_OPERATION);
+        return;
+      }
+    }
+#endif
+
+    switch (type) {
+    case RTC_INDEX_BUFFER  : 
+      quads.set(ptr,offset,stride); 
+      break;
+    case RTC_VERTEX_BUFFER0: 
+      vertices[0].set(ptr,offset,stride); 
+      if (numVertices) {
+        /* test if array is properly padded */
+        volatile int w = *((int*)&vertices[0][numVertices-1]+3); // FIXME: is failing hard avoidable?
+      }
+      break;
+    case RTC_VERTEX_BUFFER1: 
+      vertices[1].set(ptr,offset,stride); 
+      if (numVertices) {
+        /* test if array is properly padded */
+        volatile int w = *((int*)&vertices[1][numVertices-1]+3); // FIXME: is failing hard avoidable?
+      }
+      break;
+    default: 
+      recordError(RTC_INVALID_ARGUMENT); break;
+    }
+  }
+
+  void* QuadMeshScene::QuadMesh::map(RTCBufferType type) 
+  {
+    if (parent->isStatic() && parent->isBuild()) {
+      recordError(RTC_INVALID_OPERATION);
+      return NULL;
+    }
+
+    switch (type) {
+    case RTC_INDEX_BUFFER  : return quads      .map(parent->numMappedBuffers);
+    case RTC_VERTEX_BUFFER0: return vertices[0].map(parent->numMappedBuffers);
+    case RTC_VERTEX_BUFFER1: return vertices[1].map(parent->numMappedBuffers);
+    default: 
+      recordError(RTC_INVALID_ARGUMENT); 
+      return NULL;
+    }
+  }
+
+  void QuadMeshScene::QuadMesh::unmap(RTCBufferType type) 
+  {
+    if (parent->isStatic() && parent->isBuild()) {
+      recordError(RTC_INVALID_OPERATION);
+      return;
+    }
+
+    switch (type) {
+    case RTC_INDEX_BUFFER  : quads      .unmap(parent->numMappedBuffers); break;
+    case RTC_VERTEX_BUFFER0: vertices[0].unmap(parent->numMappedBuffers); break;
+    case RTC_VERTEX_BUFFER1: vertices[1].unmap(parent->numMappedBuffers); break;
+    default                : recordError(RTC_INVALID_ARGUMENT); break;
+    }
+  }
+
+  void QuadMeshScene::QuadMesh::setUserData (void* ptr, bool ispc) {
+    userPtr = ptr;
+  }
+
+  void QuadMeshScene::QuadMesh::immutable () 
+  {
+    built = true;
+    bool freeQuads     = !needQuads;
+    bool freeVertices  = !(needVertices  || parent->needVertices);
+    if (freeQuads    ) quads.free();
+    if (freeVertices ) vertices[0].free();
+    if (freeVertices ) vertices[1].free();
+  }
+
+  void QuadMeshScene::QuadMesh::memoryStatistics(RTCMemoryStatistics& stats) const
+  {
+    stats.sharedBuffers += quads.bytesShared() + vertices[0].bytesShared() + vertices[1].bytesShared();
+    stats.copiedBuffers += quads.bytesCopied() + vertices[0].bytesCopied() + vertices[1].bytesCopied();
+  }
+
+  bool QuadMeshScene::QuadMesh::verify () 
+  {
+    float range = sqrtf(0.5f*FLT_MAX);
+    for (size_t i=0; i<numQuads; i++) {
+      if (quads[i].v[0] >= numVertices) return false;
+      if (quads[i].v[1] >= numVertices) return false;
+      if (quads[i].v[2] >= numVertices) return false;
+      if (quads[i].v[3] >= numVertices) return false;
+    }
+    for (size_t j=0; j<numTimeSteps; j++) {
+      BufferT<Vec3fa>& verts = vertices[j];
+      for (size_t i=0; i<numVertices; i++) {
+        if (verts[i].x < -range || verts[i].x > range) return false;
+        if (verts[i].y < -range || verts[i].y > range) return false;
+        if (verts[i].z < -range || verts[i].z > range) return false;
+      }
+    }
+    return true;
+  }
+}
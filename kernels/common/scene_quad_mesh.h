@@ -0,0 +1,126 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef __EMBREE_QUAD_MESH_SCENE_H__
+#define __EMBREE_QUAD_MESH_SCENE_H__
+
+#include "common/default.h"
+#include "common/geometry.h"
+#include "common/buildsource.h"
+#include "common/buffer.h"
+
+namespace embree
+{
+  namespace QuadMeshScene
+  {
+
+    /*! Quad Mesh */
+    struct QuadMesh : public Geometry, public BuildSource
+    {
+      struct Quad {
+        unsigned int v[4];
+      };
+
+    public:
+      QuadMesh (Scene* parent, RTCGeometryFlags flags, size_t numQuads, size_t numVertices, size_t numTimeSteps); 
+      
+    public:
+      void setMask (unsigned mask);
+      void enable ();
+      void update ();
+      void disable ();
+      void erase ();
+      void immutable ();
+      bool verify ();
+      void memoryStatistics(RTCMemoryStatistics& stats) const;
+      void setBuffer(RTCBufferType type, void* ptr, size_t offset, size_t stride);
+      void* map(RTCBufferType type);
+      void unmap(RTCBufferType type);
+      void setUserData (void* ptr, bool ispc);
+
+      void enabling();
+      void disabling();
+
+    public:
+
+      bool isEmpty () const { 
+        return numQuads == 0;
+      }
+      
+      size_t groups () const { 
+        return 1;
+      }
+      
+      size_t prims (size_t group, size_t* pnumVertices) const {
+        if (pnumVertices) *pnumVertices = numVertices*numTimeSteps;
+        return numQuads;
+      }
+
+      const BBox3f bounds(size_t group, size_t prim) const {
+        return bounds(prim);
+      }
+
+      void bounds(size_t group, size_t begin, size_t end, BBox3f* bounds_o) const 
+      {
+        BBox3f b = empty;
+        for (size_t i=begin; i<end; i++) b.extend(bounds(i));
+        *bounds_o = b;
+      }
+
+    public:
+
+      __forceinline const Quad& quad(size_t i) const {
+        assert(i < numQuads);
+        return quads[i];
+      }
+
+      __forceinline const Vec3fa& vertex(size_t i, size_t j = 0) const {
+        assert(i < numVertices);
+        assert(j < 2);
+        return vertices[j][i];
+      }
+
+      __forceinline BBox3f bounds(size_t index) const 
+      {
+        const Quad& q = quad(index);
+        const Vec3fa& v0 = vertex(q.v[0]);
+        const Vec3fa& v1 = vertex(q.v[1]);
+        const Vec3fa& v2 = vertex(q.v[2]);
+        const Vec3fa& v3 = vertex(q.v[3]);
+        return BBox3f( min(min(v0,v1),min(v2,v3)), max(max(v0,v1),max(v2,v3)) );
+      }
+
+      __forceinline bool anyMappedBuffers() const {
+        return quads.isMapped() || vertices[0].isMapped() || vertices[1].isMapped();
+      }
+
+    public:
+      unsigned mask;                    //!< for masking out geometry
+      bool built;                       //!< geometry got built
+      unsigned char numTimeSteps;       //!< number of time steps (1 or 2)
+
+      BufferT<Quad> quads;              //!< array of quads
+      bool needQuads;                   //!< set if quad array required by acceleration structure
+      size_t numQuads;                  //!< number of quads
+
+      BufferT<Vec3fa> vertices[2];      //!< vertex array
+      bool needVertices;                //!< set if vertex array required by acceleration structure
+      size_t numVertices;               //!< number of vertices
+    };
+  }
+}
+
+#endif
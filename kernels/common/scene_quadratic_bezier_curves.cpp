@@ -177,6 +177,12 @@ namespace embree
     if (freeVertices ) vertices[1].free();
   }
 
+  void QuadraticBezierCurvesScene::QuadraticBezierCurves::memoryStatistics(RTCMemoryStatistics& stats) const
+  {
+    stats.sharedBuffers += curves.bytesShared() + vertices[0].bytesShared() + vertices[1].bytesShared();
+    stats.copiedBuffers += curves.bytesCopied() + vertices[0].bytesCopied() + vertices[1].bytesCopied();
+  }
+
   bool QuadraticBezierCurvesScene::QuadraticBezierCurves::verify () 
   {
     float range = sqrtf(0.5f*FLT_MAX);
@@ -44,6 +44,7 @@ namespace embree
       void erase ();
       void immutable ();
       bool verify ();
+      void memoryStatistics(RTCMemoryStatistics& stats) const;
       void setBuffer(RTCBufferType type, void* ptr, size_t offset, size_t stride);
       void* map(RTCBufferType type);
       void unmap(RTCBufferType type);
@@ -104,6 +105,38 @@ namespace embree
         return enlarge(b,Vec3fa(max(r0,r1,r2,r3)));
       }
 
+      /*! calculates the control points of the part [t0,t1] of the
+       *  curve, the radii are stored in the w components */
+      __forceinline void segment(size_t i, float t0, float t1, Vec3fa& p0_o, Vec3fa& p1_o, Vec3fa& p2_o, Vec3fa& p3_o) const
+      {
+        const int index = curve(i);
+        Vec3fa p0 = vertex(index+0);
+        Vec3fa p1 = vertex(index+1);
+        Vec3fa p2 = vertex(index+2);
+        Vec3fa p3 = vertex(index+3);
+
+        /* keep the part [0,t1] */
+        Vec3fa p01  = (1.0f-t1)*p0 + t1*p1, p12 = (1.0f-t1)*p1 + t1*p2, p23 = (1.0f-t1)*p2 + t1*p3;
+        Vec3fa p012 = (1.0f-t1)*p01 + t1*p12, p123 = (1.0f-t1)*p12 + t1*p23;
+        p1 = p01; p2 = p012; p3 = (1.0f-t1)*p012 + t1*p123;
+
+        /* of this keep the part [t0/t1,1] */
+        const float s = t1 > 0.0f ? t0/t1 : 0.0f;
+        p01  = (1.0f-s)*p0 + s*p1; p12 = (1.0f-s)*p1 + s*p2; p23 = (1.0f-s)*p2 + s*p3;
+        p012 = (1.0f-s)*p01 + s*p12; p123 = (1.0f-s)*p12 + s*p23;
+        p0_o = (1.0f-s)*p012 + s*p123; p1_o = p123; p2_o = p23; p3_o = p3;
+      }
+
+      /*! calculates the bounds of one of numSegments equally sized parts of the curve */
+      __forceinline BBox3f bounds(size_t i, size_t seg, size_t numSegments) const 
+      {
+        if (numSegments == 1) return bounds(i);
+        Vec3fa p0,p1,p2,p3;
+        segment(i,float(seg+0)/float(numSegments),float(seg+1)/float(numSegments),p0,p1,p2,p3);
+        const BBox3f b = merge(BBox3f(p0),BBox3f(p1),BBox3f(p2),BBox3f(p3));
+        return enlarge(b,Vec3fa(max(p0.w,p1.w,p2.w,p3.w)));
+      }
+
       __forceinline bool anyMappedBuffers() const {
         return curves.isMapped() || vertices[0].isMapped() || vertices[1].isMapped();
       }
@@ -190,6 +190,12 @@ namespace embree
     if (freeVertices ) vertices[1].free();
   }
 
+  void TriangleMeshScene::TriangleMesh::memoryStatistics(RTCMemoryStatistics& stats) const
+  {
+    stats.sharedBuffers += triangles.bytesShared() + vertices[0].bytesShared() + vertices[1].bytesShared();
+    stats.copiedBuffers += triangles.bytesCopied() + vertices[0].bytesCopied() + vertices[1].bytesCopied();
+  }
+
   bool TriangleMeshScene::TriangleMesh::verify () 
   {
     float range = sqrtf(0.5f*FLT_MAX);
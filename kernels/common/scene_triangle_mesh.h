@@ -45,6 +45,7 @@ namespace embree
       void erase ();
       void immutable ();
       bool verify ();
+      void memoryStatistics(RTCMemoryStatistics& stats) const;
       void setBuffer(RTCBufferType type, void* ptr, size_t offset, size_t stride);
       void* map(RTCBufferType type);
       void unmap(RTCBufferType type);
@@ -15,6 +15,7 @@
 // ======================================================================== //
 
 #include "stat.h"
+#include "sys/thread.h"
 
 namespace embree
 {
@@ -97,4 +98,90 @@ namespace embree
     }
     cout << std::endl;
   }
+
+  SceneStat SceneStat::disabled;
+  AtomicMutex SceneStat::sharedMutex;
+
+  /*! every thread that counts gets its own slot of counters */
+  static tls_t g_statSlot = createTls();
+  static atomic_t g_numStatSlots = 0;
+
+  SceneStat::SceneStat () 
+    : mode(DISABLED), counters(NULL) {}
+
+  SceneStat::~SceneStat () {
+    alignedFree(counters); counters = NULL;
+  }
+
+  void SceneStat::setMode(Mode mode) 
+  {
+    if (mode != DISABLED && counters == NULL) {
+      counters = (Counters*) alignedMalloc(maxThreads*sizeof(Counters),sizeof(Counters));
+      clear();
+    }
+    this->mode = mode;
+  }
+
+  void SceneStat::clear() 
+  {
+    if (counters == NULL) return;
+    memset(counters,0,maxThreads*sizeof(Counters));
+    counters[maxThreads-1].shared = true;
+  }
+
+  void SceneStat::get(RTCStatistics& stats) const
+  {
+    memset(&stats,0,sizeof(RTCStatistics));
+    if (counters == NULL) return;
+
+    for (size_t i=0; i<maxThreads; i++) {
+      stats.rays        += counters[i].rays;
+      stats.nodes       += counters[i].nodes;
+      stats.leaves      += counters[i].leaves;
+      stats.primitives  += counters[i].prims;
+      stats.hits        += counters[i].hits;
+      stats.filterCalls += counters[i].filters;
+      stats.instances   += counters[i].instances;
+    }
+
+    /* extrapolate sampled counts */
+    if (mode == SAMPLED) {
+      stats.rays        *= samplingRate;
+      stats.nodes       *= samplingRate;
+      stats.leaves      *= samplingRate;
+      stats.primitives  *= samplingRate;
+      stats.hits        *= samplingRate;
+      stats.filterCalls *= samplingRate;
+      stats.instances   *= samplingRate;
+    }
+  }
+
+  /*! returns the counters of the slot assigned to the calling thread */
+  __forceinline SceneStat::Counters* slotCounters(SceneStat::Counters* counters)
+  {
+    size_t slot = (size_t) getTls(g_statSlot);
+    if (slot == 0) {
+      slot = min(size_t(atomic_add(&g_numStatSlots,1)),SceneStat::maxThreads-1)+1;
+      setTls(g_statSlot,(void*)slot);
+    }
+    return &counters[slot-1];
+  }
+
+  SceneStat::Counters* SceneStat::beginQuery()
+  {
+    Counters* c = slotCounters(counters);
+    if (mode == SAMPLED) {
+      if (likely(!c->shared)) c->sampled = (c->queries++ % samplingRate) == 0;
+      else { Lock<AtomicMutex> lock(sharedMutex); c->sampled = (c->queries++ % samplingRate) == 0; }
+      if (!c->sampled) return NULL;
+    }
+    return c;
+  }
+
+  SceneStat::Counters* SceneStat::threadCounters()
+  {
+    Counters* c = slotCounters(counters);
+    if (mode == SAMPLED && !c->sampled) return NULL;
+    return c;
+  }
 }
@@ -31,6 +31,15 @@
 #define STAT3(s,x,y,z)
 #endif
 
+/* Makro to count into the runtime statistics of a scene, the slot
+ * shared by the threads beyond SceneStat::maxThreads gets locked */
+#define STAT_SCENE(stats,x) {                                           \
+    if (unlikely(stats != NULL)) {                                      \
+      if (likely(!stats->shared)) stats->x;                             \
+      else { Lock<AtomicMutex> lock(SceneStat::sharedMutex); stats->x; } \
+    }                                                                   \
+  }
+
 namespace embree
 {
   /*! Gathers ray tracing statistics. */
@@ -89,6 +98,89 @@ namespace embree
   private:
     static Stat instance;
   };
+
+  /*! Traversal statistics of a scene that can get enabled at
+   *  runtime. Each thread counts into its own cache line, thus no
+   *  atomic operations are required. Once maxThreads-1 threads got a
+   *  slot, all further threads share the last slot and count under a
+   *  lock. In sampling mode only every samplingRate-th query of a
+   *  thread gets counted. */
+  class SceneStat
+  {
+  public:
+
+    enum Mode { DISABLED = 0, ENABLED = 1, SAMPLED = 2 };
+
+    /*! maximal number of slots of counters, including the shared one */
+    static const size_t maxThreads = 256;
+
+    /*! every that many queries get counted in sampling mode */
+    static const size_t samplingRate = 64;
+
+    /*! counters of a single thread */
+    struct __align(64) Counters 
+    {
+      /*! counts a single ray */
+      __forceinline void count(const int geomID) {
+        rays++; hits += geomID != -1;
+      }
+
+      /*! counts the valid rays of a packet */
+      __forceinline void count(const void* valid, const int* geomID, const size_t N) {
+        for (size_t i=0; i<N; i++)
+          if (((const int*)valid)[i] == -1) count(geomID[i]);
+      }
+
+      size_t rays;      //!< number of counted rays
+      size_t nodes;     //!< number of traversed inner nodes
+      size_t leaves;    //!< number of visited leaves
+      size_t prims;     //!< number of intersected primitive blocks
+      size_t hits;      //!< number of rays that hit something
+      size_t filters;   //!< number of filter function invocations
+      size_t instances; //!< number of entered instances
+      size_t queries;   //!< number of started queries, used for sampling
+      size_t sampled;   //!< true if the current query gets counted
+      size_t shared;    //!< true for the slot shared by several threads
+    };
+
+    SceneStat ();
+    ~SceneStat ();
+
+    /*! sets the statistics mode */
+    void setMode(Mode mode);
+
+    /*! resets all counters */
+    void clear();
+
+    /*! sums up the counters of all threads */
+    void get(RTCStatistics& stats) const;
+
+    /*! starts a new query and returns the counters of the calling
+     *  thread or NULL if the query should not get counted */
+    __forceinline Counters* begin() {
+      if (likely(mode == DISABLED)) return NULL;
+      return beginQuery();
+    }
+
+    /*! returns the counters of the calling thread or NULL if the
+     *  current query should not get counted */
+    __forceinline Counters* thread() {
+      if (likely(mode == DISABLED)) return NULL;
+      return threadCounters();
+    }
+
+  private:
+    Counters* beginQuery();
+    Counters* threadCounters();
+
+  private:
+    volatile Mode mode;
+    Counters* counters;   //!< counters of all threads
+
+  public:
+    static SceneStat disabled; //!< for data structures that do not belong to a scene
+    static AtomicMutex sharedMutex; //!< protects the shared slots of all scenes
+  };
 }
 
 #endif
@@ -39,7 +39,7 @@ namespace embree
         if (ptr) return new (ptr) atomic_set<PrimRefBlock>::item();
         
         /* if this failed again we have to allocate more memory */
-        ptr = (atomic_set<PrimRefBlock>::item*) alloc->malloc(sizeof(atomic_set<PrimRefBlock>::item));
+        ptr = (atomic_set<PrimRefBlock>::item*) alloc->malloc(thread,sizeof(atomic_set<PrimRefBlock>::item));
         
         /* return first block */
         return new (ptr) atomic_set<PrimRefBlock>::item();
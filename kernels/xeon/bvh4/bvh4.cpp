@@ -22,6 +22,11 @@
 #include "geometry/triangle1v.h"
 #include "geometry/triangle4v.h"
 #include "geometry/triangle4i.h"
+#include "geometry/triangle4q.h"
+#include "geometry/triangle4w.h"
+#include "geometry/triangle8w.h"
+#include "geometry/quad4.h"
+#include "geometry/bezier1.h"
 
 #include "common/accelinstance.h"
 
@@ -33,7 +38,15 @@ namespace embree
   DECLARE_SYMBOL(Accel::Intersector1,BVH4Triangle1vIntersector1Pluecker);
   DECLARE_SYMBOL(Accel::Intersector1,BVH4Triangle4vIntersector1Pluecker);
   DECLARE_SYMBOL(Accel::Intersector1,BVH4Triangle4iIntersector1Pluecker);
+  DECLARE_SYMBOL(Accel::Intersector1,BVH4Triangle4wIntersector1Woop);
+  DECLARE_SYMBOL(Accel::Intersector1,BVH4Triangle8wIntersector1Woop);
+  DECLARE_SYMBOL(Accel::Intersector1,BVH4Triangle4qIntersector1Moeller);
+  DECLARE_SYMBOL(Accel::Intersector1,BVH4Quad4Intersector1Moeller);
+  DECLARE_SYMBOL(Accel::Intersector1,BVH4Bezier1Intersector1);
   DECLARE_SYMBOL(Accel::Intersector1,BVH4VirtualIntersector1);
+  DECLARE_SYMBOL(Accel::Intersector1,BVH4Triangle4Intersector1MoellerCompressed);
+  DECLARE_SYMBOL(Accel::Intersector1,BVH4Triangle4iIntersector1PlueckerCompressed);
+  DECLARE_SYMBOL(Accel::Intersector1,BVH4Triangle4qIntersector1MoellerCompressed);
 
   DECLARE_SYMBOL(Accel::Intersector4,BVH4Triangle1Intersector4ChunkMoeller);
   DECLARE_SYMBOL(Accel::Intersector4,BVH4Triangle4Intersector4ChunkMoeller);
@@ -44,7 +57,17 @@ namespace embree
   DECLARE_SYMBOL(Accel::Intersector4,BVH4Triangle4vIntersector4ChunkPluecker);
   DECLARE_SYMBOL(Accel::Intersector4,BVH4Triangle4vIntersector4HybridPluecker);
   DECLARE_SYMBOL(Accel::Intersector4,BVH4Triangle4iIntersector4ChunkPluecker);
+  DECLARE_SYMBOL(Accel::Intersector4,BVH4Triangle4wIntersector4ChunkWoop);
+  DECLARE_SYMBOL(Accel::Intersector4,BVH4Triangle8wIntersector4ChunkWoop);
+  DECLARE_SYMBOL(Accel::Intersector4,BVH4Triangle4wIntersector4HybridWoop);
+  DECLARE_SYMBOL(Accel::Intersector4,BVH4Triangle8wIntersector4HybridWoop);
+  DECLARE_SYMBOL(Accel::Intersector4,BVH4Triangle4qIntersector4HybridMoeller);
+  DECLARE_SYMBOL(Accel::Intersector4,BVH4Quad4Intersector4HybridMoeller);
+  DECLARE_SYMBOL(Accel::Intersector4,BVH4Bezier1Intersector4Hybrid);
   DECLARE_SYMBOL(Accel::Intersector4,BVH4VirtualIntersector4Chunk);
+  DECLARE_SYMBOL(Accel::Intersector4,BVH4Triangle4Intersector4HybridMoellerCompressed);
+  DECLARE_SYMBOL(Accel::Intersector4,BVH4Triangle4iIntersector4ChunkPlueckerCompressed);
+  DECLARE_SYMBOL(Accel::Intersector4,BVH4Triangle4qIntersector4HybridMoellerCompressed);
 
   DECLARE_SYMBOL(Accel::Intersector8,BVH4Triangle1Intersector8ChunkMoeller);
   DECLARE_SYMBOL(Accel::Intersector8,BVH4Triangle4Intersector8ChunkMoeller);
@@ -55,7 +78,24 @@ namespace embree
   DECLARE_SYMBOL(Accel::Intersector8,BVH4Triangle4vIntersector8ChunkPluecker);
   DECLARE_SYMBOL(Accel::Intersector8,BVH4Triangle4vIntersector8HybridPluecker);
   DECLARE_SYMBOL(Accel::Intersector8,BVH4Triangle4iIntersector8ChunkPluecker);
+  DECLARE_SYMBOL(Accel::Intersector8,BVH4Triangle4wIntersector8ChunkWoop);
+  DECLARE_SYMBOL(Accel::Intersector8,BVH4Triangle8wIntersector8ChunkWoop);
+  DECLARE_SYMBOL(Accel::Intersector8,BVH4Triangle4wIntersector8HybridWoop);
+  DECLARE_SYMBOL(Accel::Intersector8,BVH4Triangle8wIntersector8HybridWoop);
+  DECLARE_SYMBOL(Accel::Intersector8,BVH4Triangle4qIntersector8HybridMoeller);
+  DECLARE_SYMBOL(Accel::Intersector8,BVH4Quad4Intersector8HybridMoeller);
+  DECLARE_SYMBOL(Accel::Intersector8,BVH4Bezier1Intersector8Hybrid);
   DECLARE_SYMBOL(Accel::Intersector8,BVH4VirtualIntersector8Chunk);
+  DECLARE_SYMBOL(Accel::Intersector8,BVH4Triangle4Intersector8HybridMoellerCompressed);
+  DECLARE_SYMBOL(Accel::Intersector8,BVH4Triangle4iIntersector8ChunkPlueckerCompressed);
+  DECLARE_SYMBOL(Accel::Intersector8,BVH4Triangle4qIntersector8HybridMoellerCompressed);
+
+  DECLARE_SYMBOL(Accel::IntersectorPacket,BVH4Triangle1IntersectorPacketMoeller);
+  DECLARE_SYMBOL(Accel::IntersectorPacket,BVH4Triangle4IntersectorPacketMoeller);
+  DECLARE_SYMBOL(Accel::IntersectorPacket,BVH4Triangle8IntersectorPacketMoeller);
+  DECLARE_SYMBOL(Accel::IntersectorPacket,BVH4Triangle4vIntersectorPacketPluecker);
+  DECLARE_SYMBOL(Accel::IntersectorPacket,BVH4Triangle4wIntersectorPacketWoop);
+  DECLARE_SYMBOL(Accel::IntersectorPacket,BVH4Triangle8wIntersectorPacketWoop);
 
   DECLARE_TOPLEVEL_BUILDER(BVH4BuilderTopLevelFast);
 
@@ -73,6 +113,7 @@ namespace embree
   Builder* BVH4BuilderSpatialSplit1 (void* bvh, BuildSource* source, void* geometry, const size_t minLeafSize, const size_t maxLeafSize);
   Builder* BVH4BuilderSpatialSplit4 (void* bvh, BuildSource* source, void* geometry, const size_t minLeafSize, const size_t maxLeafSize);
   Builder* BVH4BuilderSpatialSplit8 (void* bvh, BuildSource* source, void* geometry, const size_t minLeafSize, const size_t maxLeafSize);
+  Builder* BVH4BuilderCompress (void* bvh, Builder* builder);
   
   void BVH4Register () 
   {
@@ -95,7 +136,15 @@ namespace embree
     SELECT_SYMBOL_DEFAULT_SSE41_AVX     (features,BVH4Triangle1vIntersector1Pluecker);
     SELECT_SYMBOL_DEFAULT_SSE41_AVX     (features,BVH4Triangle4vIntersector1Pluecker);
     SELECT_SYMBOL_DEFAULT_SSE41_AVX     (features,BVH4Triangle4iIntersector1Pluecker);
+    SELECT_SYMBOL_DEFAULT_SSE41_AVX_AVX2(features,BVH4Triangle4wIntersector1Woop);
+    SELECT_SYMBOL_AVX_AVX2              (features,BVH4Triangle8wIntersector1Woop);
+    SELECT_SYMBOL_DEFAULT_SSE41_AVX_AVX2(features,BVH4Triangle4qIntersector1Moeller);
+    SELECT_SYMBOL_DEFAULT_SSE41_AVX_AVX2(features,BVH4Quad4Intersector1Moeller);
+    SELECT_SYMBOL_DEFAULT_SSE41_AVX_AVX2(features,BVH4Bezier1Intersector1);
     SELECT_SYMBOL_DEFAULT_SSE41_AVX_AVX2(features,BVH4VirtualIntersector1);
+    SELECT_SYMBOL_DEFAULT_SSE41_AVX_AVX2(features,BVH4Triangle4Intersector1MoellerCompressed);
+    SELECT_SYMBOL_DEFAULT_SSE41_AVX     (features,BVH4Triangle4iIntersector1PlueckerCompressed);
+    SELECT_SYMBOL_DEFAULT_SSE41_AVX_AVX2(features,BVH4Triangle4qIntersector1MoellerCompressed);
 
     /* select intersectors4 */
     SELECT_SYMBOL_DEFAULT_SSE41_AVX_AVX2(features,BVH4Triangle1Intersector4ChunkMoeller);
@@ -107,7 +156,17 @@ namespace embree
     SELECT_SYMBOL_DEFAULT_SSE41_AVX     (features,BVH4Triangle4vIntersector4ChunkPluecker);
     SELECT_SYMBOL_DEFAULT_SSE41_AVX     (features,BVH4Triangle4vIntersector4HybridPluecker);
     SELECT_SYMBOL_DEFAULT_SSE41_AVX     (features,BVH4Triangle4iIntersector4ChunkPluecker);
+    SELECT_SYMBOL_DEFAULT_SSE41_AVX_AVX2(features,BVH4Triangle4wIntersector4ChunkWoop);
+    SELECT_SYMBOL_AVX_AVX2              (features,BVH4Triangle8wIntersector4ChunkWoop);
+    SELECT_SYMBOL_DEFAULT_SSE41_AVX_AVX2(features,BVH4Triangle4wIntersector4HybridWoop);
+    SELECT_SYMBOL_AVX_AVX2              (features,BVH4Triangle8wIntersector4HybridWoop);
+    SELECT_SYMBOL_DEFAULT_SSE41_AVX_AVX2(features,BVH4Triangle4qIntersector4HybridMoeller);
+    SELECT_SYMBOL_DEFAULT_SSE41_AVX_AVX2(features,BVH4Quad4Intersector4HybridMoeller);
+    SELECT_SYMBOL_DEFAULT_SSE41_AVX_AVX2(features,BVH4Bezier1Intersector4Hybrid);
     SELECT_SYMBOL_DEFAULT_SSE41_AVX_AVX2(features,BVH4VirtualIntersector4Chunk);
+    SELECT_SYMBOL_DEFAULT_SSE41_AVX_AVX2(features,BVH4Triangle4Intersector4HybridMoellerCompressed);
+    SELECT_SYMBOL_DEFAULT_SSE41_AVX     (features,BVH4Triangle4iIntersector4ChunkPlueckerCompressed);
+    SELECT_SYMBOL_DEFAULT_SSE41_AVX_AVX2(features,BVH4Triangle4qIntersector4HybridMoellerCompressed);
 
     /* select intersectors8 */
     SELECT_SYMBOL_AVX_AVX2(features,BVH4Triangle1Intersector8ChunkMoeller);
@@ -119,13 +178,32 @@ namespace embree
     SELECT_SYMBOL_AVX     (features,BVH4Triangle4vIntersector8ChunkPluecker);
     SELECT_SYMBOL_AVX     (features,BVH4Triangle4vIntersector8HybridPluecker);
     SELECT_SYMBOL_AVX     (features,BVH4Triangle4iIntersector8ChunkPluecker);
+    SELECT_SYMBOL_AVX_AVX2(features,BVH4Triangle4wIntersector8ChunkWoop);
+    SELECT_SYMBOL_AVX_AVX2(features,BVH4Triangle8wIntersector8ChunkWoop);
+    SELECT_SYMBOL_AVX_AVX2(features,BVH4Triangle4wIntersector8HybridWoop);
+    SELECT_SYMBOL_AVX_AVX2(features,BVH4Triangle8wIntersector8HybridWoop);
+    SELECT_SYMBOL_AVX_AVX2(features,BVH4Triangle4qIntersector8HybridMoeller);
+    SELECT_SYMBOL_AVX_AVX2(features,BVH4Quad4Intersector8HybridMoeller);
+    SELECT_SYMBOL_AVX_AVX2(features,BVH4Bezier1Intersector8Hybrid);
     SELECT_SYMBOL_AVX_AVX2(features,BVH4VirtualIntersector8Chunk);
+    SELECT_SYMBOL_AVX_AVX2(features,BVH4Triangle4Intersector8HybridMoellerCompressed);
+    SELECT_SYMBOL_AVX     (features,BVH4Triangle4iIntersector8ChunkPlueckerCompressed);
+    SELECT_SYMBOL_AVX_AVX2(features,BVH4Triangle4qIntersector8HybridMoellerCompressed);
+
+    SELECT_SYMBOL_AVX_AVX2(features,BVH4Triangle1IntersectorPacketMoeller);
+    SELECT_SYMBOL_AVX_AVX2(features,BVH4Triangle4IntersectorPacketMoeller);
+    SELECT_SYMBOL_AVX_AVX2(features,BVH4Triangle8IntersectorPacketMoeller);
+    SELECT_SYMBOL_AVX     (features,BVH4Triangle4vIntersectorPacketPluecker);
+    SELECT_SYMBOL_AVX_AVX2(features,BVH4Triangle4wIntersectorPacketWoop);
+    SELECT_SYMBOL_AVX_AVX2(features,BVH4Triangle8wIntersectorPacketWoop);
   }
 
   BVH4::BVH4 (const PrimitiveType& primTy, void* geometry)
-  : primTy(primTy), geometry(geometry), root(emptyNode),
+  : primTy(primTy), geometry(geometry), 
+    stat(geometry ? &((Scene*)geometry)->statistics : &SceneStat::disabled), hybrid4(4,3), hybrid8(8,6), root(emptyNode),
     numPrimitives(0), numVertices(0),
-    nodes(NULL), bytesNodes(0), primitives(NULL), bytesPrimitives(0) 
+    nodes(NULL), bytesNodes(0), primitives(NULL), bytesPrimitives(0), bytesCommitted(0), bytesBuilder(0), bytesMonitored(0),
+    mappedFile(NULL), bytesMappedFile(0), compressed(false), compactedTree(NULL), bytesCompactedTree(0)
   {
     alloc = new LinearAllocatorPerThread;
   }
@@ -133,7 +211,12 @@ namespace embree
   BVH4::~BVH4 () {
     if (nodes) os_free(nodes, bytesNodes);
     if (primitives) os_free(primitives, bytesPrimitives);
+    if (mappedFile) os_unmap_file(mappedFile, bytesMappedFile);
+    if (compactedTree) os_free(compactedTree, bytesCompactedTree);
+    for (size_t i=0; i<replicas.size(); i++) 
+      if (replicas[i].ptr) os_free(replicas[i].ptr, replicas[i].bytes);
     for (size_t i=0; i<objects.size(); i++) delete objects[i];
+    memoryMonitor(-ssize_t(bytesMonitored));
   }
   
   Accel::Intersectors BVH4Triangle1Intersectors(BVH4* bvh)
@@ -144,6 +227,7 @@ namespace embree
     intersectors.intersector4 = BVH4Triangle1Intersector4ChunkMoeller;
     intersectors.intersector8 = BVH4Triangle1Intersector8ChunkMoeller;
     intersectors.intersector16 = NULL;
+    intersectors.intersectorPacket = BVH4Triangle1IntersectorPacketMoeller;
     return intersectors;
   }
 
@@ -155,6 +239,7 @@ namespace embree
     intersectors.intersector4 = BVH4Triangle4Intersector4ChunkMoeller;
     intersectors.intersector8 = BVH4Triangle4Intersector8ChunkMoeller;
     intersectors.intersector16 = NULL;
+    intersectors.intersectorPacket = BVH4Triangle4IntersectorPacketMoeller;
     return intersectors;
   }
 
@@ -166,6 +251,7 @@ namespace embree
     intersectors.intersector4 = BVH4Triangle4Intersector4HybridMoeller;
     intersectors.intersector8 = BVH4Triangle4Intersector8HybridMoeller;
     intersectors.intersector16 = NULL;
+    intersectors.intersectorPacket = BVH4Triangle4IntersectorPacketMoeller;
     return intersectors;
   }
 
@@ -177,6 +263,7 @@ namespace embree
     intersectors.intersector4 = BVH4Triangle8Intersector4ChunkMoeller;
     intersectors.intersector8 = BVH4Triangle8Intersector8ChunkMoeller;
     intersectors.intersector16 = NULL;
+    intersectors.intersectorPacket = BVH4Triangle8IntersectorPacketMoeller;
     return intersectors;
   }
 
@@ -188,6 +275,55 @@ namespace embree
     intersectors.intersector4 = BVH4Triangle8Intersector4HybridMoeller;
     intersectors.intersector8 = BVH4Triangle8Intersector8HybridMoeller;
     intersectors.intersector16 = NULL;
+    intersectors.intersectorPacket = BVH4Triangle8IntersectorPacketMoeller;
+    return intersectors;
+  }
+
+  Accel::Intersectors BVH4Triangle4wIntersectorsChunk(BVH4* bvh)
+  {
+    Accel::Intersectors intersectors;
+    intersectors.ptr = bvh;
+    intersectors.intersector1 = BVH4Triangle4wIntersector1Woop;
+    intersectors.intersector4 = BVH4Triangle4wIntersector4ChunkWoop;
+    intersectors.intersector8 = BVH4Triangle4wIntersector8ChunkWoop;
+    intersectors.intersector16 = NULL;
+    intersectors.intersectorPacket = BVH4Triangle4wIntersectorPacketWoop;
+    return intersectors;
+  }
+
+  Accel::Intersectors BVH4Triangle4wIntersectorsHybrid(BVH4* bvh)
+  {
+    Accel::Intersectors intersectors;
+    intersectors.ptr = bvh;
+    intersectors.intersector1 = BVH4Triangle4wIntersector1Woop;
+    intersectors.intersector4 = BVH4Triangle4wIntersector4HybridWoop;
+    intersectors.intersector8 = BVH4Triangle4wIntersector8HybridWoop;
+    intersectors.intersector16 = NULL;
+    intersectors.intersectorPacket = BVH4Triangle4wIntersectorPacketWoop;
+    return intersectors;
+  }
+
+  Accel::Intersectors BVH4Triangle8wIntersectorsChunk(BVH4* bvh)
+  {
+    Accel::Intersectors intersectors;
+    intersectors.ptr = bvh;
+    intersectors.intersector1 = BVH4Triangle8wIntersector1Woop;
+    intersectors.intersector4 = BVH4Triangle8wIntersector4ChunkWoop;
+    intersectors.intersector8 = BVH4Triangle8wIntersector8ChunkWoop;
+    intersectors.intersector16 = NULL;
+    intersectors.intersectorPacket = BVH4Triangle8wIntersectorPacketWoop;
+    return intersectors;
+  }
+
+  Accel::Intersectors BVH4Triangle8wIntersectorsHybrid(BVH4* bvh)
+  {
+    Accel::Intersectors intersectors;
+    intersectors.ptr = bvh;
+    intersectors.intersector1 = BVH4Triangle8wIntersector1Woop;
+    intersectors.intersector4 = BVH4Triangle8wIntersector4HybridWoop;
+    intersectors.intersector8 = BVH4Triangle8wIntersector8HybridWoop;
+    intersectors.intersector16 = NULL;
+    intersectors.intersectorPacket = BVH4Triangle8wIntersectorPacketWoop;
     return intersectors;
   }
 
@@ -210,6 +346,7 @@ namespace embree
     intersectors.intersector4 = BVH4Triangle4vIntersector4ChunkPluecker;
     intersectors.intersector8 = BVH4Triangle4vIntersector8HybridPluecker;
     intersectors.intersector16 = NULL;
+    intersectors.intersectorPacket = BVH4Triangle4vIntersectorPacketPluecker;
     return intersectors;
   }
 
@@ -221,6 +358,7 @@ namespace embree
     intersectors.intersector4 = BVH4Triangle4vIntersector4HybridPluecker;
     intersectors.intersector8 = BVH4Triangle4vIntersector8HybridPluecker;
     intersectors.intersector16 = NULL;
+    intersectors.intersectorPacket = BVH4Triangle4vIntersectorPacketPluecker;
     return intersectors;
   }
 
@@ -235,6 +373,72 @@ namespace embree
     return intersectors;
   }
 
+  Accel::Intersectors BVH4Triangle4qIntersectors(BVH4* bvh)
+  {
+    Accel::Intersectors intersectors;
+    intersectors.ptr = bvh;
+    intersectors.intersector1 = BVH4Triangle4qIntersector1Moeller;
+    intersectors.intersector4 = BVH4Triangle4qIntersector4HybridMoeller;
+    intersectors.intersector8 = BVH4Triangle4qIntersector8HybridMoeller;
+    intersectors.intersector16 = NULL;
+    return intersectors;
+  }
+
+  Accel::Intersectors BVH4Quad4Intersectors(BVH4* bvh)
+  {
+    Accel::Intersectors intersectors;
+    intersectors.ptr = bvh;
+    intersectors.intersector1 = BVH4Quad4Intersector1Moeller;
+    intersectors.intersector4 = BVH4Quad4Intersector4HybridMoeller;
+    intersectors.intersector8 = BVH4Quad4Intersector8HybridMoeller;
+    intersectors.intersector16 = NULL;
+    return intersectors;
+  }
+
+  Accel::Intersectors BVH4Bezier1Intersectors(BVH4* bvh)
+  {
+    Accel::Intersectors intersectors;
+    intersectors.ptr = bvh;
+    intersectors.intersector1 = BVH4Bezier1Intersector1;
+    intersectors.intersector4 = BVH4Bezier1Intersector4Hybrid;
+    intersectors.intersector8 = BVH4Bezier1Intersector8Hybrid;
+    intersectors.intersector16 = NULL;
+    return intersectors;
+  }
+
+  Accel::Intersectors BVH4Triangle4IntersectorsCompressed(BVH4* bvh)
+  {
+    Accel::Intersectors intersectors;
+    intersectors.ptr = bvh;
+    intersectors.intersector1 = BVH4Triangle4Intersector1MoellerCompressed;
+    intersectors.intersector4 = BVH4Triangle4Intersector4HybridMoellerCompressed;
+    intersectors.intersector8 = BVH4Triangle4Intersector8HybridMoellerCompressed;
+    intersectors.intersector16 = NULL;
+    return intersectors;
+  }
+
+  Accel::Intersectors BVH4Triangle4iIntersectorsCompressed(BVH4* bvh)
+  {
+    Accel::Intersectors intersectors;
+    intersectors.ptr = bvh;
+    intersectors.intersector1 = BVH4Triangle4iIntersector1PlueckerCompressed;
+    intersectors.intersector4 = BVH4Triangle4iIntersector4ChunkPlueckerCompressed;
+    intersectors.intersector8 = BVH4Triangle4iIntersector8ChunkPlueckerCompressed;
+    intersectors.intersector16 = NULL;
+    return intersectors;
+  }
+
+  Accel::Intersectors BVH4Triangle4qIntersectorsCompressed(BVH4* bvh)
+  {
+    Accel::Intersectors intersectors;
+    intersectors.ptr = bvh;
+    intersectors.intersector1 = BVH4Triangle4qIntersector1MoellerCompressed;
+    intersectors.intersector4 = BVH4Triangle4qIntersector4HybridMoellerCompressed;
+    intersectors.intersector8 = BVH4Triangle4qIntersector8HybridMoellerCompressed;
+    intersectors.intersector16 = NULL;
+    return intersectors;
+  }
+
   Accel* BVH4::BVH4Triangle1(Scene* scene)
   { 
     BVH4* accel = new BVH4(SceneTriangle1::type,scene);
@@ -296,6 +500,47 @@ namespace embree
   }
 #endif
 
+  Accel* BVH4::BVH4Triangle4w(Scene* scene)
+  {
+    BVH4* accel = new BVH4(SceneTriangle4w::type,scene);
+
+    Accel::Intersectors intersectors;
+    if      (g_traverser == "default") intersectors = BVH4Triangle4wIntersectorsHybrid(accel);
+    else if (g_traverser == "chunk"  ) intersectors = BVH4Triangle4wIntersectorsChunk(accel);
+    else if (g_traverser == "hybrid" ) intersectors = BVH4Triangle4wIntersectorsHybrid(accel);
+    else throw std::runtime_error("unknown traverser "+g_traverser+" for BVH4<Triangle4w>");
+
+    Builder* builder = NULL;
+    if      (g_builder == "default"     ) builder = BVH4BuilderObjectSplit4(accel,&scene->flat_triangle_source_1,scene,1,inf);
+    else if (g_builder == "spatialsplit") builder = BVH4BuilderSpatialSplit4(accel,&scene->flat_triangle_source_1,scene,1,inf);
+    else if (g_builder == "objectsplit" ) builder = BVH4BuilderObjectSplit4(accel,&scene->flat_triangle_source_1,scene,1,inf);
+    else throw std::runtime_error("unknown builder "+g_builder+" for BVH4<Triangle4w>");
+
+    return new AccelInstance(accel,builder,intersectors);
+  }
+
+#if defined (__TARGET_AVX__)
+
+  Accel* BVH4::BVH4Triangle8w(Scene* scene)
+  {
+    BVH4* accel = new BVH4(SceneTriangle8w::type,scene);
+
+    Accel::Intersectors intersectors;
+    if      (g_traverser == "default") intersectors = BVH4Triangle8wIntersectorsHybrid(accel);
+    else if (g_traverser == "chunk"  ) intersectors = BVH4Triangle8wIntersectorsChunk(accel);
+    else if (g_traverser == "hybrid" ) intersectors = BVH4Triangle8wIntersectorsHybrid(accel);
+    else throw std::runtime_error("unknown traverser "+g_traverser+" for BVH4<Triangle8w>");
+
+    Builder* builder = NULL;
+    if      (g_builder == "default"     ) builder = BVH4BuilderObjectSplit8(accel,&scene->flat_triangle_source_1,scene,1,inf);
+    else if (g_builder == "spatialsplit") builder = BVH4BuilderSpatialSplit8(accel,&scene->flat_triangle_source_1,scene,1,inf);
+    else if (g_builder == "objectsplit" ) builder = BVH4BuilderObjectSplit8(accel,&scene->flat_triangle_source_1,scene,1,inf);
+    else throw std::runtime_error("unknown builder "+g_builder+" for BVH4<Triangle8w>");
+
+    return new AccelInstance(accel,builder,intersectors);
+  }
+#endif
+
   Accel* BVH4::BVH4Triangle1v(Scene* scene)
   {
     BVH4* accel = new BVH4(SceneTriangle1v::type,scene);
@@ -348,6 +593,88 @@ namespace embree
     return new AccelInstance(accel,builder,intersectors);
   }
 
+  Accel* BVH4::BVH4Triangle4Compressed(Scene* scene)
+  {
+    BVH4* accel = new BVH4(SceneTriangle4::type,scene);
+    Accel::Intersectors intersectors = BVH4Triangle4IntersectorsCompressed(accel);
+
+    Builder* builder = NULL;
+    if      (g_builder == "default"     ) builder = BVH4BuilderObjectSplit4(accel,&scene->flat_triangle_source_1,scene,1,inf);
+    else if (g_builder == "spatialsplit") builder = BVH4BuilderSpatialSplit4(accel,&scene->flat_triangle_source_1,scene,1,inf);
+    else if (g_builder == "objectsplit" ) builder = BVH4BuilderObjectSplit4(accel,&scene->flat_triangle_source_1,scene,1,inf);
+    else throw std::runtime_error("unknown builder "+g_builder+" for BVH4<Triangle4> compressed");
+
+    return new AccelInstance(accel,BVH4BuilderCompress(accel,builder),intersectors);
+  }
+
+  Accel* BVH4::BVH4Triangle4iCompressed(Scene* scene)
+  {
+    BVH4* accel = new BVH4(Triangle4iType::type,scene);
+    Accel::Intersectors intersectors = BVH4Triangle4iIntersectorsCompressed(accel);
+
+    Builder* builder = NULL;
+    if      (g_builder == "default"     ) builder = BVH4BuilderObjectSplit4(accel,&scene->flat_triangle_source_1,scene,1,inf);
+    else if (g_builder == "spatialsplit") builder = BVH4BuilderSpatialSplit4(accel,&scene->flat_triangle_source_1,scene,1,inf);
+    else if (g_builder == "objectsplit" ) builder = BVH4BuilderObjectSplit4(accel,&scene->flat_triangle_source_1,scene,1,inf);
+    else throw std::runtime_error("unknown builder "+g_builder+" for BVH4<Triangle4i> compressed");
+
+    scene->needVertices = true;
+    return new AccelInstance(accel,BVH4BuilderCompress(accel,builder),intersectors);
+  }
+
+  Accel* BVH4::BVH4Triangle4q(Scene* scene)
+  {
+    BVH4* accel = new BVH4(SceneTriangle4q::type,scene);
+    Accel::Intersectors intersectors = BVH4Triangle4qIntersectors(accel);
+
+    Builder* builder = NULL;
+    if      (g_builder == "default"     ) builder = BVH4BuilderObjectSplit4(accel,&scene->flat_triangle_source_1,scene,1,inf);
+    else if (g_builder == "spatialsplit") builder = BVH4BuilderSpatialSplit4(accel,&scene->flat_triangle_source_1,scene,1,inf);
+    else if (g_builder == "objectsplit" ) builder = BVH4BuilderObjectSplit4(accel,&scene->flat_triangle_source_1,scene,1,inf);
+    else throw std::runtime_error("unknown builder "+g_builder+" for BVH4<Triangle4q>");
+
+    return new AccelInstance(accel,builder,intersectors);
+  }
+
+  Accel* BVH4::BVH4Triangle4qCompressed(Scene* scene)
+  {
+    BVH4* accel = new BVH4(SceneTriangle4q::type,scene);
+    Accel::Intersectors intersectors = BVH4Triangle4qIntersectorsCompressed(accel);
+
+    Builder* builder = NULL;
+    if      (g_builder == "default"     ) builder = BVH4BuilderObjectSplit4(accel,&scene->flat_triangle_source_1,scene,1,inf);
+    else if (g_builder == "spatialsplit") builder = BVH4BuilderSpatialSplit4(accel,&scene->flat_triangle_source_1,scene,1,inf);
+    else if (g_builder == "objectsplit" ) builder = BVH4BuilderObjectSplit4(accel,&scene->flat_triangle_source_1,scene,1,inf);
+    else throw std::runtime_error("unknown builder "+g_builder+" for BVH4<Triangle4q> compressed");
+
+    return new AccelInstance(accel,BVH4BuilderCompress(accel,builder),intersectors);
+  }
+
+  Accel* BVH4::BVH4Quad4(Scene* scene)
+  {
+    BVH4* accel = new BVH4(SceneQuad4::type,scene);
+    Accel::Intersectors intersectors = BVH4Quad4Intersectors(accel);
+
+    /* every scene creates this accel, thus the builder setting for
+     * triangles falls back to the only builder supporting quads */
+    Builder* builder = BVH4BuilderObjectSplit4(accel,&scene->flat_quad_source,scene,1,inf);
+    return new AccelInstance(accel,builder,intersectors);
+  }
+
+  Accel* BVH4::BVH4Bezier1(Scene* scene)
+  {
+    /* in high quality mode each curve is split into multiple segments to get tighter bounds */
+    const bool subdiv = scene->isHighQuality();
+    BVH4* accel = new BVH4(subdiv ? SceneBezier1::type_subdiv : SceneBezier1::type,scene);
+    Accel::Intersectors intersectors = BVH4Bezier1Intersectors(accel);
+    BuildSource* source = subdiv ? (BuildSource*) &scene->flat_curves_source_subdiv : (BuildSource*) &scene->flat_curves_source;
+
+    /* every scene creates this accel, thus the builder setting for
+     * triangles falls back to the only builder supporting curves */
+    Builder* builder = BVH4BuilderObjectSplit1(accel,source,scene,1,inf);
+    return new AccelInstance(accel,builder,intersectors);
+  }
+
   void createTriangleMeshTriangle1Morton(TriangleMeshScene::TriangleMesh* mesh, BVH4*& accel, Builder*& builder)
   {
     if (mesh->numTimeSteps != 1) throw std::runtime_error("internal error");
@@ -564,7 +891,7 @@ namespace embree
     return new AccelInstance(accel,builder,intersectors);
   }
 
-  void BVH4::init(size_t numPrimitives)
+  void BVH4::estimateBytes(size_t numPrimitives, size_t& bytesAllocated, size_t& bytesReserved) const
   {
     /* allocate as much memory as likely needed and reserve conservative amounts of memory */
     size_t blockSize = LinearAllocatorPerThread::allocBlockSize;
@@ -580,15 +907,65 @@ namespace embree
     size_t numReservedPrimitives = 1.5*numAllocatedPrimitives;
 #endif
     
-    size_t bytesAllocated = numAllocatedNodes * sizeof(BVH4::Node) + numAllocatedPrimitives * primTy.bytes;
-    size_t bytesReserved  = numReservedNodes * sizeof(BVH4::Node) + numReservedPrimitives * primTy.bytes;
-    bytesReserved         = (bytesReserved+blockSize-1)/blockSize*blockSize;
+    bytesAllocated = numAllocatedNodes * sizeof(BVH4::Node) + numAllocatedPrimitives * primTy.bytes;
+    bytesReserved  = numReservedNodes * sizeof(BVH4::Node) + numReservedPrimitives * primTy.bytes;
+    bytesReserved  = (bytesReserved+blockSize-1)/blockSize*blockSize;
+  }
+
+  void BVH4::init(size_t numPrimitives)
+  {
+    size_t bytesAllocated, bytesReserved;
+    estimateBytes(numPrimitives,bytesAllocated,bytesReserved);
+
+    /* copies of the previous tree are outdated */
+    for (size_t i=0; i<replicas.size(); i++) 
+      if (replicas[i].ptr) os_free(replicas[i].ptr, replicas[i].bytes);
+    replicas.clear();
+
+    if (compactedTree) os_free(compactedTree, bytesCompactedTree);
+    compactedTree = NULL; bytesCompactedTree = 0;
 
     root = emptyNode;
     //alloc->init(numNodes*sizeof(BVH4::Node) + numPrimitives*primTy.bytes);
     alloc->init(bytesAllocated,bytesReserved);
   }
 
+  bool BVH4::monitorMemory(size_t bytes)
+  {
+    if (memoryMonitor(ssize_t(bytes)-ssize_t(bytesMonitored))) {
+      bytesMonitored = bytes;
+      return true;
+    }
+    
+    root = emptyNode;
+    bounds = empty;
+    numPrimitives = numVertices = 0;
+    if (geometry) ((Scene*)geometry)->buildVetoed = true;
+    return false;
+  }
+
+  void BVH4::memoryStatistics(RTCMemoryStatistics& stats)
+  {
+    countBytes(stats.nodes,stats.primitives);
+
+    /* the arrays of the fast builders are mostly reserved address space */
+    size_t bytes = bytesAllocated()-numVertices*sizeof(Vec3fa);
+    if (!mappedFile && (nodes || primitives)) bytes -= bytesNodes+bytesPrimitives-bytesCommitted;
+    stats.allocated += bytes;
+    stats.builderPeak = max(stats.builderPeak,bytesBuilder);
+
+    /* the toplevel tree links the object trees in, thus their nodes
+     * and leaves got already counted */
+    for (size_t i=0; i<objects.size(); i++) 
+    {
+      if (objects[i] == NULL) continue;
+      RTCMemoryStatistics objectStats; memset(&objectStats,0,sizeof(objectStats));
+      objects[i]->memoryStatistics(objectStats);
+      stats.allocated += objectStats.allocated;
+      stats.builderPeak = max(stats.builderPeak,objectStats.builderPeak);
+    }
+  }
+
   void BVH4::clearBarrier(NodeRef& node)
   {
     if (node.isBarrier())
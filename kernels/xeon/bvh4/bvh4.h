@@ -21,6 +21,7 @@
 #include "common/alloc.h"
 #include "common/accel.h"
 #include "common/scene.h"
+#include "common/hybrid_switch.h"
 #include "geometry/primitive.h"
 
 namespace embree
@@ -155,6 +156,17 @@ namespace embree
       __forceinline       NodeRef& child(size_t i)       { assert(i<4); return children[i]; }
       __forceinline const NodeRef& child(size_t i) const { assert(i<4); return children[i]; }
 
+      /*! Returns one bounding plane of all 4 children, ofs is the byte offset of the plane inside the node. */
+      __forceinline ssef plane(size_t ofs) const { return load4f((const char*)this+ofs); }
+
+      /*! Returns the bounding planes of child i. */
+      __forceinline float lowerX(size_t i) const { return lower_x[i]; }
+      __forceinline float upperX(size_t i) const { return upper_x[i]; }
+      __forceinline float lowerY(size_t i) const { return lower_y[i]; }
+      __forceinline float upperY(size_t i) const { return upper_y[i]; }
+      __forceinline float lowerZ(size_t i) const { return lower_z[i]; }
+      __forceinline float upperZ(size_t i) const { return upper_z[i]; }
+
     public:
       ssef lower_x;           //!< X dimension of lower bounds of all 4 children.
       ssef upper_x;           //!< X dimension of upper bounds of all 4 children.
@@ -165,6 +177,119 @@ namespace embree
       NodeRef children[4];    //!< Pointer to the 4 children (can be a node or leaf)
     };
 
+    /*! Compressed BVH4 Node. The bounds of the children are quantized
+     *  to 8 bits relative to the bounding box of the node, which
+     *  reduces the node size from 128 to 80 bytes. The quantized bounds
+     *  are always conservative, thus traversal finds the same hits as
+     *  with uncompressed nodes. The planes are stored in the same order
+     *  as in the uncompressed node, such that the traversal kernels
+     *  can address them with the same offsets. */
+    struct CompressedNode
+    {
+      /*! Quantizes the bounds of an uncompressed node. */
+      void set(const Node& node)
+      {
+        const BBox3f bounds = node.bounds();
+        for (size_t dim=0; dim<3; dim++) 
+        {
+          /* enlarge bounds slightly to stay conservative if the dequantization is evaluated with FMA */
+          const float lower = bounds.lower[dim] - 4.0f*float(ulp)*abs(bounds.lower[dim]);
+          const float upper = bounds.upper[dim] + 4.0f*float(ulp)*abs(bounds.upper[dim]);
+          start[dim] = lower;
+          scale[dim] = max((upper-lower)*(1.0f/255.0f),max(float(ulp)*abs(lower),float(FLT_MIN)));
+          while (start[dim]+scale[dim]*255.0f < upper) scale[dim] *= 1.0f+float(ulp);
+        }
+
+        for (size_t i=0; i<4; i++) 
+        {
+          children[i] = node.child(i);
+
+          /* empty children get an empty interval */
+          if (children[i] == emptyNode) {
+            for (size_t p=0; p<6; p++) q[4*p+i] = (p%2) ? 0 : 255;
+            continue;
+          }
+          const BBox3f b = node.bounds(i);
+          for (size_t dim=0; dim<3; dim++) {
+            const float lower = b.lower[dim] - 4.0f*float(ulp)*abs(b.lower[dim]);
+            const float upper = b.upper[dim] + 4.0f*float(ulp)*abs(b.upper[dim]);
+            q[4*(2*dim+0)+i] = quantizeLower(dim,lower);
+            q[4*(2*dim+1)+i] = quantizeUpper(dim,upper);
+          }
+        }
+      }
+
+      /*! Returns bounds of node. */
+      __forceinline BBox3f bounds() const {
+        BBox3f b = empty;
+        for (size_t i=0; i<4; i++) 
+          if (children[i] != emptyNode) b.extend(bounds(i));
+        return b;
+      }
+
+      /*! Returns the conservative bounds of specified child */
+      __forceinline BBox3f bounds(size_t i) const 
+      {
+        assert(i < 4);
+        const Vec3fa lower(lowerX(i),lowerY(i),lowerZ(i));
+        const Vec3fa upper(upperX(i),upperY(i),upperZ(i));
+        return BBox3f(lower,upper);
+      }
+
+      /*! Returns reference to specified child */
+      __forceinline       NodeRef& child(size_t i)       { assert(i<4); return children[i]; }
+      __forceinline const NodeRef& child(size_t i) const { assert(i<4); return children[i]; }
+
+      /*! Returns one bounding plane of all 4 children, ofs is the byte offset of the plane inside an uncompressed node. */
+      __forceinline ssef plane(size_t ofs) const 
+      {
+        const size_t p = ofs/sizeof(ssef), dim = p/2;
+        const __m128i b = _mm_cvtsi32_si128(*(const int*)&q[4*p]);
+#if defined(__SSE4_1__)
+        const ssef v = ssef(_mm_cvtepu8_epi32(b));
+#else
+        const __m128i z = _mm_setzero_si128();
+        const ssef v = ssef(_mm_unpacklo_epi16(_mm_unpacklo_epi8(b,z),z));
+#endif
+        return ssef(start[dim]) + ssef(scale[dim])*v;
+      }
+
+      /*! Returns the bounding planes of child i. */
+      __forceinline float lowerX(size_t i) const { return dequantize(0,q[ 0+i]); }
+      __forceinline float upperX(size_t i) const { return dequantize(0,q[ 4+i]); }
+      __forceinline float lowerY(size_t i) const { return dequantize(1,q[ 8+i]); }
+      __forceinline float upperY(size_t i) const { return dequantize(1,q[12+i]); }
+      __forceinline float lowerZ(size_t i) const { return dequantize(2,q[16+i]); }
+      __forceinline float upperZ(size_t i) const { return dequantize(2,q[20+i]); }
+
+    private:
+
+      /*! Dequantizes a single plane */
+      __forceinline float dequantize(size_t dim, unsigned char v) const {
+        return start[dim] + scale[dim]*float(v);
+      }
+
+      /*! Finds largest quantized value below the specified lower bound */
+      __forceinline unsigned char quantizeLower(size_t dim, float lower) const {
+        int v = clamp(int(floorf((lower-start[dim])/scale[dim])),0,255);
+        while (v > 0 && dequantize(dim,v) > lower) v--;
+        return v;
+      }
+
+      /*! Finds smallest quantized value above the specified upper bound */
+      __forceinline unsigned char quantizeUpper(size_t dim, float upper) const {
+        int v = clamp(int(ceilf((upper-start[dim])/scale[dim])),0,255);
+        while (v < 255 && dequantize(dim,v) < upper) v++;
+        return v;
+      }
+
+    public:
+      float start[3];          //!< Lower bounds of the node
+      float scale[3];          //!< Size of one quantization step in each dimension
+      unsigned char q[24];     //!< Quantized planes of all 4 children, ordered as lower_x, upper_x, lower_y, upper_y, lower_z, upper_z
+      NodeRef children[4];     //!< Pointer to the 4 children (can be a node or leaf)
+    };
+
     /*! swap the children of two nodes */
     __forceinline static void swap(Node* a, size_t i, Node* b, size_t j)
     {
@@ -213,6 +338,14 @@ namespace embree
     static Accel* BVH4Triangle1v(Scene* scene);
     static Accel* BVH4Triangle4v(Scene* scene);
     static Accel* BVH4Triangle4i(Scene* scene);
+    static Accel* BVH4Triangle4w(Scene* scene);
+    static Accel* BVH4Triangle8w(Scene* scene);
+    static Accel* BVH4Triangle4Compressed(Scene* scene);
+    static Accel* BVH4Triangle4iCompressed(Scene* scene);
+    static Accel* BVH4Triangle4q(Scene* scene);
+    static Accel* BVH4Triangle4qCompressed(Scene* scene);
+    static Accel* BVH4Quad4(Scene* scene);
+    static Accel* BVH4Bezier1(Scene* scene);
     
     static Accel* BVH4BVH4Triangle1Morton(Scene* scene);
     static Accel* BVH4BVH4Triangle1ObjectSplit(Scene* scene);
@@ -239,9 +372,45 @@ namespace embree
     /*! initializes the acceleration structure */
     void init (size_t numPrimitives = 0);
 
+    /*! estimates the bytes to allocate and to reserve for a BVH over some number of primitives */
+    void estimateBytes (size_t numPrimitives, size_t& bytesAllocated, size_t& bytesReserved) const;
+
     /*! Clears the barrier bits of a subtree. */
     void clearBarrier(NodeRef& node);
 
+    /*! stores the BVH into a relocatable stream */
+    bool store(std::ostream& out);
+
+    /*! initializes the BVH from a memory mapped file */
+    bool load(void* file, size_t bytes, size_t offset);
+
+    /*! creates a copy of the tree in the memory of each NUMA node */
+    void replicate();
+
+    /*! reorders the nodes in depth first order for cache efficient traversal */
+    void layout();
+
+    /*! copies the tree into a tightly sized memory region and releases the build memory */
+    void compact();
+
+    /*! adds the bytes of all nodes and leaves reachable from the root to the counters */
+    void countBytes(size_t& bytesNodes, size_t& bytesLeaves) const;
+
+    /*! adds the memory consumption of the BVH to the statistics */
+    void memoryStatistics(RTCMemoryStatistics& stats);
+
+    /*! Reports the bytes a build of this BVH is going to use to the
+     *  memory monitor. On a veto the BVH is reset to an empty tree,
+     *  the scene reports an out of memory error after the build, and
+     *  false is returned such that the builder can stop. */
+    bool monitorMemory(size_t bytes);
+
+    /*! returns the root of the tree copy closest to the calling thread */
+    __forceinline NodeRef getRoot() const {
+      if (likely(replicas.size() == 0)) return root;
+      return replicas[getNumaNodeOfCurrentThread()].root;
+    }
+
     Ref<LinearAllocatorPerThread> alloc;
 
     __forceinline Node* allocNode(size_t thread) {
@@ -268,15 +437,26 @@ namespace embree
     /*! calculates the amount of bytes allocated */
     size_t bytesAllocated() 
     {
-      if (nodes || primitives)
-        return bytesNodes+bytesPrimitives+numVertices*sizeof(Vec3fa);
+      size_t bytesReplicas = 0;
+      for (size_t i=0; i<replicas.size(); i++) 
+        bytesReplicas += replicas[i].bytes;
+
+      if (mappedFile)
+        return bytesMappedFile+bytesReplicas;
+      else if (compactedTree)
+        return bytesCompactedTree+numVertices*sizeof(Vec3fa)+bytesReplicas;
+      else if (nodes || primitives)
+        return bytesNodes+bytesPrimitives+numVertices*sizeof(Vec3fa)+bytesReplicas;
       else
-        return alloc->bytes()+numVertices*sizeof(Vec3fa);
+        return alloc->bytes()+numVertices*sizeof(Vec3fa)+bytesReplicas;
     }
 
   public:
     const PrimitiveType& primTy;       //!< primitive type stored in the BVH
     void* geometry;                    //!< pointer to additional data for primitive intersector
+    SceneStat* stat;                   //!< runtime traversal statistics of the scene
+    HybridSwitch hybrid4;              //!< packet to single ray switch of the hybrid traversal of 4 rays
+    HybridSwitch hybrid8;              //!< packet to single ray switch of the hybrid traversal of 8 rays
     NodeRef root;                      //!< Root node
     size_t numPrimitives;
     size_t numVertices;
@@ -287,7 +467,32 @@ namespace embree
     size_t bytesNodes;
     void* primitives;
     size_t bytesPrimitives;
+    size_t bytesCommitted;             //!< bytes of the node and primitive arrays backed by memory
     std::vector<BVH4*> objects;
+    size_t bytesBuilder;               //!< temporary memory held by the builder, peak of its builds
+    size_t bytesMonitored;             //!< bytes reported to the memory monitor
+
+    /*! memory mapped file the BVH got loaded from */
+  public:
+    void* mappedFile;
+    size_t bytesMappedFile;
+    bool compressed;                   //!< true if the nodes are of type CompressedNode
+
+    /*! tightly sized copy of the tree the build memory got released for */
+  public:
+    void* compactedTree;
+    size_t bytesCompactedTree;
+
+    /*! copies of the tree for each NUMA node */
+  public:
+    struct Replica 
+    {
+      Replica () : root(emptyNode), ptr(NULL), bytes(0) {}
+      NodeRef root;                    //!< root of the copy
+      void* ptr;                       //!< memory of the copy
+      size_t bytes;                    //!< size of the copy
+    };
+    std::vector<Replica> replicas;
   };
 
   typedef void (*createTriangleMeshAccelTy)(TriangleMeshScene::TriangleMesh* mesh, BVH4*& accel, Builder*& builder);
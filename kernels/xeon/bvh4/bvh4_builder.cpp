@@ -37,12 +37,22 @@ namespace embree
     if (source->isEmpty()) 
       return;
 #else
+    /* the primitive references are only needed during the build */
     size_t numPrimitives = source->size();
+    size_t bytesAllocated, bytesReserved;
+    bvh->estimateBytes(numPrimitives,bytesAllocated,bytesReserved);
+    if (!bvh->monitorMemory(bytesAllocated+numPrimitives*sizeof(PrimRef)))
+      return;
     bvh->init(numPrimitives);
     if (source->isEmpty()) 
       return;
 #endif
 
+    /* grow the pool at once for the primitive references the builder does not hold yet */
+    const size_t bytesPrimRefs = numPrimitives*sizeof(PrimRef);
+    if (bytesPrimRefs > alloc.bytes()) 
+      Alloc::global.reserve(bytesPrimRefs-alloc.bytes());
+
     if (g_verbose >= 2) 
       std::cout << "building BVH4<" << bvh->primTy.name << "> with " << Heuristic::name() << " SAH builder ... " << std::flush;
 
@@ -68,7 +78,12 @@ namespace embree
     bvh->bounds = initStage.pinfo.geomBounds;
     initStage.pinfo.clear();
 
-    /* free all temporary blocks */
+    /* the builder keeps its blocks of primitive references until it
+       gets destroyed, thus they count the peak of its own builds only */
+    bvh->bytesBuilder = alloc.bytes();
+    bvh->monitorMemory(bytesAllocated);
+
+    /* free the unused blocks of the pool */
     Alloc::global.clear();
 
     if (g_verbose >= 2 || g_benchmark) 
@@ -77,6 +92,7 @@ namespace embree
     if (g_verbose >= 2) {
       std::cout << "[DONE]" << std::endl;
       std::cout << "  dt = " << 1000.0f*(t1-t0) << "ms, perf = " << 1E-6*double(source->size())/(t1-t0) << " Mprim/s" << std::endl;
+      std::cout << "  temporary memory = " << 1E-6*double(alloc.bytes()) << " MB, pool peak = " << 1E-6*double(Alloc::global.maxUsed()) << " MB" << std::endl;
       std::cout << BVH4Statistics(bvh).str();
     }
 
@@ -63,10 +63,12 @@ namespace embree
     BVH4BuilderFast::~BVH4BuilderFast () 
     {
       if (prims) os_free(prims,bytesPrims); prims = NULL;
+      bvh->monitorMemory(bvh->bytesMonitored-bytesPrims);
       nodeAllocator.shrink(); 
       primAllocator.shrink();
       bvh->bytesNodes = nodeAllocator.bytesReserved;
       bvh->bytesPrimitives = primAllocator.bytesReserved;
+      bvh->bytesCommitted = nodeAllocator.bytesCommitted() + primAllocator.bytesCommitted();
     }
     
     void BVH4BuilderFast::build(size_t threadIndex, size_t threadCount) 
@@ -75,7 +77,8 @@ namespace embree
         std::cout << "building BVH4 with " << TOSTRING(isa) "::BVH4BuilderFast ... " << std::flush;
       
       /* do some global inits first */
-      init(threadIndex,threadCount);
+      if (!init(threadIndex,threadCount))
+        return;
       
 #if defined(PROFILE)
       
@@ -144,9 +147,10 @@ namespace embree
         std::cout << BVH4Statistics(bvh).str();
       }
 #endif
+      bvh->bytesCommitted = nodeAllocator.bytesCommitted() + primAllocator.bytesCommitted();
     }
     
-    void BVH4BuilderFast::init(size_t threadIndex, size_t threadCount)
+    bool BVH4BuilderFast::init(size_t threadIndex, size_t threadCount)
     {
       //bvh->clear();
       bvh->init(0); // FIXME
@@ -173,6 +177,12 @@ namespace embree
       bvh->numPrimitives = numPrimitives;
       if (primTy.needVertices) bvh->numVertices = numVertices;
       else                     bvh->numVertices = 0;
+
+      /* scenes without triangles need no build */
+      if (numPrimitives == 0) {
+        bvh->bounds = empty;
+        return false;
+      }
             
       if (numPrimitivesOld != numPrimitives)
       {
@@ -206,6 +216,13 @@ namespace embree
         bytesReservedNodes      = Allocator::blockSize*(blocksReservedNodes      + additionalBlocks);
         bytesReservedPrimitives = Allocator::blockSize*(blocksReservedPrimitives + additionalBlocks);
         
+        /* stop if the application does not grant the memory */
+        if (!bvh->monitorMemory(bytesPrims+bytesAllocatedNodes+bytesAllocatedPrimitives)) {
+          prims = NULL; bytesPrims = 0; numPrimitives = 0;
+          return false;
+        }
+        bvh->bytesBuilder = bytesPrims;
+
         /* allocated memory for primrefs, nodes, and primitives */
         prims = (PrimRef* ) os_malloc(bytesPrims);  memset(prims,0,bytesPrims);
         nodeAllocator.init(bytesAllocatedNodes,bytesReservedNodes);
@@ -216,6 +233,7 @@ namespace embree
         bvh->primitives = primAllocator.data; 
         bvh->bytesPrimitives = primAllocator.bytesReserved;
       }
+      return true;
     }
     
     // =======================================================================================================
@@ -66,8 +66,8 @@ namespace embree
       /*! Destructor */
       ~BVH4BuilderFast ();
 
-      /* initializes the builder */
-      void init(size_t threadIndex, size_t threadCount);
+      /* initializes the builder, returns false if the memory monitor vetoed the build */
+      bool init(size_t threadIndex, size_t threadCount);
       
       /* build function */
       void build(size_t threadIndex, size_t threadCount);
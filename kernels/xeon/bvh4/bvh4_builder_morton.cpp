@@ -17,6 +17,7 @@
 #include "bvh4.h"
 #include "bvh4_builder_morton.h"
 #include "bvh4_statistics.h"
+#include "bvh4_restructure.h"
 
 #include "geometry/triangle1.h"
 #include "geometry/triangle4.h"
@@ -43,10 +44,13 @@ namespace embree
     
     BVH4BuilderMorton::BVH4BuilderMorton (BVH4* bvh, BuildSource* source, Scene* scene, TriangleMeshScene::TriangleMesh* mesh, const size_t minLeafSize, const size_t maxLeafSize)
     : bvh(bvh), source(source), scene(scene), mesh(mesh), topLevelItemThreshold(0), encodeShift(0), encodeMask(0),
-      morton(NULL), bytesMorton(0), numGroups(0), numPrimitives(0), numAllocatedPrimitives(0), numAllocatedNodes(0)
+      morton(NULL), bytesMorton(0), useMorton64(false), restructure(false), numGroups(0), numPrimitives(0), numAllocatedPrimitives(0), numAllocatedNodes(0)
     {
       needAllThreads = true;
       if (mesh) needAllThreads = mesh->numTriangles > 50000;
+
+      /* high quality scenes get their treelets restructured after the build */
+      restructure = scene && scene->isHighQuality();
       
       if (&bvh->primTy == &SceneTriangle1::type) {
         createSmallLeaf = createTriangle1Leaf;
@@ -87,10 +91,12 @@ namespace embree
     BVH4BuilderMorton::~BVH4BuilderMorton () 
     {
       if (morton) os_free(morton,bytesMorton);
+      bvh->monitorMemory(bvh->bytesMonitored-bytesMorton);
       nodeAllocator.shrink(); 
       primAllocator.shrink();
       bvh->bytesNodes = nodeAllocator.bytesReserved;
       bvh->bytesPrimitives = primAllocator.bytesReserved;
+      bvh->bytesCommitted = nodeAllocator.bytesCommitted() + primAllocator.bytesCommitted();
     }
     
     void BVH4BuilderMorton::build(size_t threadIndex, size_t threadCount) 
@@ -99,7 +105,8 @@ namespace embree
         std::cout << "building BVH4 with " << TOSTRING(isa) << "::BVH4BuilderMorton ... " << std::flush;
       
       /* do some global inits first */
-      init(threadIndex,threadCount);
+      if (!init(threadIndex,threadCount))
+        return;
       
 #if defined(PROFILE)
       
@@ -145,9 +152,10 @@ namespace embree
         std::cout << BVH4Statistics(bvh).str();
       }
 #endif
+      bvh->bytesCommitted = nodeAllocator.bytesCommitted() + primAllocator.bytesCommitted();
     }
     
-    void BVH4BuilderMorton::init(size_t threadIndex, size_t threadCount)
+    bool BVH4BuilderMorton::init(size_t threadIndex, size_t threadCount)
     {
       //bvh->clear();
       bvh->init(numPrimitives);
@@ -175,6 +183,12 @@ namespace embree
       bvh->numPrimitives = numPrimitives;
       if (bvh->primTy.needVertices) bvh->numVertices = numVertices;
       else                          bvh->numVertices = 0;
+
+      /* scenes without triangles need no build */
+      if (numPrimitives == 0) {
+        bvh->bounds = empty;
+        return false;
+      }
       
       size_t maxPrimsPerGroup = 0;
       if (mesh) 
@@ -204,8 +218,12 @@ namespace embree
         numPrimitives = mesh->numTriangles;
       }
       
+      /* switch to 64 bit morton codes for large scenes */
+      const bool useMorton64Old = useMorton64;
+      useMorton64 = numPrimitives > g_morton64_threshold;
+
       /* preallocate arrays */
-      if (numPrimitivesOld != numPrimitives)
+      if (numPrimitivesOld != numPrimitives || useMorton64Old != useMorton64)
       {
         /* free previously allocated memory */
         if (morton) os_free(morton,bytesMorton);
@@ -225,7 +243,8 @@ namespace embree
         size_t numReservedNodes = 1.5*numAllocatedNodes;
         size_t numReservedPrimitives = 1.5*numAllocatedPrimitives;
 #endif
-        bytesMorton = ((numPrimitives+7)&(-8)) * sizeof(MortonID32Bit);
+        const size_t bytesMortonID = useMorton64 ? sizeof(MortonID64Bit) : sizeof(MortonID32Bit);
+        bytesMorton = ((numPrimitives+7)&(-8)) * bytesMortonID;
         size_t bytesAllocatedNodes      = numAllocatedNodes * sizeof(BVH4::Node);
         size_t bytesAllocatedPrimitives = numAllocatedPrimitives * bvh->primTy.bytes;
         size_t bytesReservedNodes       = numReservedNodes * sizeof(BVH4::Node);
@@ -237,6 +256,13 @@ namespace embree
         bytesAllocatedNodes = max(bytesAllocatedNodes,bytesMorton); 
         bytesReservedNodes  = max(bytesReservedNodes,bytesMorton); 
 
+        /* stop if the application does not grant the memory */
+        if (!bvh->monitorMemory(bytesMorton+bytesAllocatedNodes+bytesAllocatedPrimitives)) {
+          morton = NULL; bytesMorton = 0; numPrimitives = 0;
+          return false;
+        }
+        bvh->bytesBuilder = bytesMorton;
+
         /* allocated memory for primrefs, nodes, and primitives */
         morton = (MortonID32Bit* ) os_malloc(bytesMorton); memset(morton,0,bytesMorton);
         nodeAllocator.init(bytesAllocatedNodes,bytesReservedNodes);
@@ -247,6 +273,7 @@ namespace embree
         bvh->primitives = primAllocator.data; 
         bvh->bytesPrimitives = primAllocator.bytesReserved;
       }
+      return true;
     }
     
     // =======================================================================================================
@@ -399,17 +426,57 @@ namespace embree
       }
     }
     
+    void BVH4BuilderMorton::computeMortonCodes(const size_t startID, const size_t endID, 
+                                               const size_t startGroup, const size_t startOffset, 
+                                               MortonID64Bit* __restrict__ const dest)
+    {
+      /* compute mapping from world space into 3D grid */
+      const ssef base     = (ssef)global_bounds.centroid2.lower;
+      const ssef diagonal = (ssef)global_bounds.centroid2.upper - (ssef)global_bounds.centroid2.lower;
+      const ssef scale    = select(diagonal != 0, rcp(diagonal) * ssef(LATTICE_SIZE_PER_DIM_64 * 0.99f),ssef(0.0f));
+      
+      size_t currentID = startID;
+      size_t offset = startOffset;
+      
+      for (size_t group = startGroup; group<numGroups; group++) 
+      {       
+        Geometry* geom = scene->get(group);
+        if (!geom || geom->type != TRIANGLE_MESH) continue;
+        TriangleMeshScene::TriangleMesh* mesh = (TriangleMeshScene::TriangleMesh*) geom;
+        if (mesh->numTimeSteps != 1) continue;
+        const size_t numTriangles = min(mesh->numTriangles-offset,endID-currentID);
+        
+        for (size_t i=0; i<numTriangles; i++, currentID++)	  
+        {
+          const BBox3f b = mesh->bounds(offset+i);
+          const ssef lower = (ssef)b.lower;
+          const ssef upper = (ssef)b.upper;
+          const ssef centroid = lower+upper;
+          const ssei binID = ssei((centroid-base)*scale);
+          dest[currentID].code  = bitInterleave64(extract<0>(binID),extract<1>(binID),extract<2>(binID));
+          dest[currentID].index = (group << encodeShift) | (offset+i);
+        }
+        offset = 0;
+        if (currentID == endID) break;
+      }
+    }
+    
     void BVH4BuilderMorton::computeMortonCodes(const size_t threadID, const size_t numThreads)
     {      
       const size_t startID = (threadID+0)*numPrimitives/numThreads;
       const size_t endID   = (threadID+1)*numPrimitives/numThreads;
       
       /* store the morton codes temporarily in 'node' memory */
-      MortonID32Bit* __restrict__ const dest = (MortonID32Bit*)nodeAllocator.data; 
-      computeMortonCodes(startID,endID,g_state->startGroup[threadID],g_state->startGroupOffset[threadID],dest);
+      if (useMorton64) {
+        MortonID64Bit* __restrict__ const dest = (MortonID64Bit*)nodeAllocator.data; 
+        computeMortonCodes(startID,endID,g_state->startGroup[threadID],g_state->startGroupOffset[threadID],dest);
+      } else {
+        MortonID32Bit* __restrict__ const dest = (MortonID32Bit*)nodeAllocator.data; 
+        computeMortonCodes(startID,endID,g_state->startGroup[threadID],g_state->startGroupOffset[threadID],dest);
+      }
     }
     
-    void BVH4BuilderMorton::recreateMortonCodes(SmallBuildRecord& current) const
+    void BVH4BuilderMorton::recreateMortonCodes(MortonID32Bit* __restrict__ const morton, SmallBuildRecord& current) const
     {
       assert(current.size() > 4);
       Centroid_Scene_AABB global_bounds;
@@ -446,12 +513,58 @@ namespace embree
       }
       quicksort_insertionsort_ascending<MortonID32Bit,512>(morton,current.begin,current.end-1); 
       
+#if defined(DEBUG)
+      for (size_t i=current.begin; i<current.end-1; i++)
+        assert(morton[i].code <= morton[i+1].code);
+#endif	    
+    }
+    
+    void BVH4BuilderMorton::recreateMortonCodes(MortonID64Bit* __restrict__ const morton, SmallBuildRecord& current) const
+    {
+      assert(current.size() > 4);
+      Centroid_Scene_AABB global_bounds;
+      global_bounds.reset();
+      
+      for (size_t i=current.begin; i<current.end; i++)
+      {
+        const size_t index  = morton[i].index;
+        const size_t primID = index & encodeMask; 
+        const size_t geomID = index >> encodeShift; 
+        global_bounds.extend(scene->getTriangleMesh(geomID)->bounds(primID));
+      }
+      
+      /* compute mapping from world space into 3D grid */
+      const ssef base     = (ssef)global_bounds.centroid2.lower;
+      const ssef diagonal = (ssef)global_bounds.centroid2.upper - (ssef)global_bounds.centroid2.lower;
+      const ssef scale    = select(diagonal != 0,rcp(diagonal) * ssef(LATTICE_SIZE_PER_DIM_64 * 0.99f),ssef(0.0f));
+      
+      for (size_t i=current.begin; i<current.end; i++)
+      {
+        const size_t index  = morton[i].index;
+        const size_t primID = index & encodeMask; 
+        const size_t geomID = index >> encodeShift; 
+        const BBox3f b = scene->getTriangleMesh(geomID)->bounds(primID);
+        const ssef lower = (ssef)b.lower;
+        const ssef upper = (ssef)b.upper;
+        const ssef centroid = lower+upper;
+        const ssei binID = ssei((centroid-base)*scale);
+        morton[i].code = bitInterleave64(extract<0>(binID),extract<1>(binID),extract<2>(binID));
+      }
+      quicksort_insertionsort_ascending<MortonID64Bit,512>(morton,current.begin,current.end-1); 
+      
 #if defined(DEBUG)
       for (size_t i=current.begin; i<current.end-1; i++)
         assert(morton[i].code <= morton[i+1].code);
 #endif	    
     }
     
+    void BVH4BuilderMorton::radixsort(const size_t threadID, const size_t numThreads)
+    {
+      if (useMorton64) radixsort<MortonID64Bit>(threadID,numThreads);
+      else             radixsort<MortonID32Bit>(threadID,numThreads);
+    }
+
+    template<typename MortonID>
     void BVH4BuilderMorton::radixsort(const size_t threadID, const size_t numThreads)
     {
       //size_t taskID = TaskLogger::beginTask(threadID,"BVH4BuilderMorton::radixsort",0);
@@ -459,21 +572,26 @@ namespace embree
       const size_t startID = (threadID+0)*numPrimitives/numThreads;
       const size_t endID   = (threadID+1)*numPrimitives/numThreads;
       
-      MortonID32Bit* __restrict__ mortonID[2];
-      mortonID[0] = (MortonID32Bit*) morton; 
-      //mortonID[1] = (MortonID32Bit*) node;
-      mortonID[1] = (MortonID32Bit*) nodeAllocator.data;
+      MortonID* __restrict__ mortonID[2];
+      mortonID[0] = (MortonID*) morton; 
+      //mortonID[1] = (MortonID*) node;
+      mortonID[1] = (MortonID*) nodeAllocator.data;
       MortonBuilderState::ThreadRadixCountTy* radixCount = g_state->radixCount;
+
+      /* an odd number of passes leaves the sorted codes in the morton array */
+      static const size_t RADIX_BUCKETS = (size_t)1 << MortonID::RADIX_BITS;
+      static const size_t RADIX_BUCKETS_MASK = RADIX_BUCKETS-1;
+      assert(MortonID::RADIX_PASSES % 2 == 1);
+      assert(RADIX_BUCKETS <= BVH4BuilderMorton::RADIX_BUCKETS);
       
-      /* we need 3 iterations to process all 32 bits */
-      for (size_t b=0; b<3; b++)
+      for (size_t b=0; b<MortonID::RADIX_PASSES; b++)
       {
-        const MortonID32Bit* __restrict src = (MortonID32Bit*) &mortonID[((b+1)%2)][0];
-        MortonID32Bit*       __restrict dst = (MortonID32Bit*) &mortonID[((b+0)%2)][0];
+        const MortonID* __restrict src = (MortonID*) &mortonID[((b+1)%2)][0];
+        MortonID*       __restrict dst = (MortonID*) &mortonID[((b+0)%2)][0];
         
         /* shift and mask to extract some number of bits */
         const unsigned int mask = RADIX_BUCKETS_MASK;
-        const unsigned int shift = b * RADIX_BITS;
+        const unsigned int shift = b * MortonID::RADIX_BITS;
         
         /* count how many items go into the buckets */
         for (size_t i=0; i<RADIX_BUCKETS; i++)
@@ -510,7 +628,7 @@ namespace embree
           const size_t index = src[i].get(shift, mask);
           dst[offset[index]++] = src[i];
         }
-        if (b < 2) scheduler.syncThreads(threadID,numThreads);
+        if (b < MortonID::RADIX_PASSES-1) scheduler.syncThreads(threadID,numThreads);
       }
 
       //TaskLogger::endTask(threadID,taskID);
@@ -527,6 +645,8 @@ namespace embree
         
         //size_t id = TaskLogger::beginTask(threadID,"BVH4BuilderMorton::subtree",0);
         recurse(g_state->buildRecords[taskID],nodeAlloc,leafAlloc,RECURSE,threadID);
+        if (restructure) 
+          BVH4Restructure::restructure(bvh,*g_state->buildRecords[taskID].parent,g_state->buildRecords[taskID].depth);
         g_state->buildRecords[taskID].parent->setBarrier();
         g_state->workStack.push(g_state->buildRecords[taskID]);
         //TaskLogger::endTask(threadID,id);
@@ -551,7 +671,7 @@ namespace embree
       
       for (size_t i=0; i<items; i++) 
       {	
-        const size_t index = This->morton[start+i].index;
+        const size_t index = This->mortonIndex(start+i);
         const size_t primID = index & This->encodeMask; 
         const size_t geomID = index >> This->encodeShift; 
         const TriangleMeshScene::TriangleMesh* __restrict__ const mesh = This->scene->getTriangleMesh(geomID);
@@ -593,7 +713,7 @@ namespace embree
       
       for (size_t i=0; i<items; i++)
       {
-        const size_t index = This->morton[start+i].index;
+        const size_t index = This->mortonIndex(start+i);
         const size_t primID = index & This->encodeMask; 
         const size_t geomID = index >> This->encodeShift; 
         const TriangleMeshScene::TriangleMesh* __restrict__ const mesh = This->scene->getTriangleMesh(geomID);
@@ -629,7 +749,7 @@ namespace embree
       
       for (size_t i=0; i<items; i++) 
       {	
-        const size_t index = This->morton[start+i].index;
+        const size_t index = This->mortonIndex(start+i);
         const size_t primID = index & This->encodeMask; 
         const size_t geomID = index >> This->encodeShift; 
         const TriangleMeshScene::TriangleMesh* __restrict__ const mesh = This->scene->getTriangleMesh(geomID);
@@ -670,7 +790,7 @@ namespace embree
       
       for (size_t i=0; i<items; i++)
       {
-        const size_t index = This->morton[start+i].index;
+        const size_t index = This->mortonIndex(start+i);
         const size_t primID = index & This->encodeMask; 
         const size_t geomID = index >> This->encodeShift; 
         const TriangleMeshScene::TriangleMesh* __restrict__ const mesh = This->scene->getTriangleMesh(geomID);
@@ -743,20 +863,23 @@ namespace embree
                                                 SmallBuildRecord& left,
                                                 SmallBuildRecord& right) const
     {
-      const unsigned int code_start = morton[current.begin].code;
-      const unsigned int code_end   = morton[current.end-1].code;
-      unsigned int bitpos = clz(code_start^code_end);
-      
+      if (useMorton64) split((MortonID64Bit*)morton,current,left,right);
+      else             split(morton,current,left,right);
+    }
+
+    template<typename MortonID>
+    __forceinline void BVH4BuilderMorton::split(MortonID* __restrict__ const morton,
+                                                SmallBuildRecord& current,
+                                                SmallBuildRecord& left,
+                                                SmallBuildRecord& right) const
+    {
       /* if all items mapped to same morton code, then create new morton codes for the items */
-      if (unlikely(bitpos == 32)) 
+      if (unlikely(morton[current.begin].code == morton[current.end-1].code)) 
       {
-        recreateMortonCodes(current);
-        const unsigned int code_start = morton[current.begin].code;
-        const unsigned int code_end   = morton[current.end-1].code;
-        bitpos = clz(code_start^code_end);
+        recreateMortonCodes(morton,current);
         
         /* if the morton code is still the same, goto fall back split */
-        if (unlikely(bitpos == 32)) 
+        if (unlikely(morton[current.begin].code == morton[current.end-1].code)) 
         {
           size_t center = (current.begin + current.end)/2; 
           left.init(current.begin,center);
@@ -766,16 +889,14 @@ namespace embree
       }
       
       /* split the items at the topmost different morton code bit */
-      const unsigned int bitpos_diff = 31-bitpos;
-      const unsigned int bitmask = 1 << bitpos_diff;
+      const typename MortonID::Code bitmask = highestBit(morton[current.begin].code ^ morton[current.end-1].code);
       
       /* find location where bit differs using binary search */
       size_t begin = current.begin;
       size_t end   = current.end;
       while (begin + 1 != end) {
         const size_t mid = (begin+end)/2;
-        const unsigned bit = morton[mid].code & bitmask;
-        if (bit == 0) begin = mid; else end = mid;
+        if ((morton[mid].code & bitmask) == 0) begin = mid; else end = mid;
       }
       size_t center = end;
 #if defined(DEBUG)      
@@ -969,18 +1090,22 @@ namespace embree
       global_bounds = computeBounds();
       bvh->bounds = global_bounds.geometry;
 
-      /* compute morton codes */
-      if (mesh)
-        computeMortonCodes(0,numPrimitives,mesh->id,0,morton);
-      else
-        computeMortonCodes(0,numPrimitives,0,0,morton);
-
-      /* sort morton codes */
-      std::sort(&morton[0],&morton[numPrimitives]); // FIMXE: use radix sort
+      /* compute and sort morton codes */
+      const size_t startGroup = mesh ? mesh->id : 0;
+      if (useMorton64) {
+        MortonID64Bit* const morton64 = (MortonID64Bit*) morton;
+        computeMortonCodes(0,numPrimitives,startGroup,0,morton64);
+        std::sort(&morton64[0],&morton64[numPrimitives]);
+      } else {
+        computeMortonCodes(0,numPrimitives,startGroup,0,morton);
+        std::sort(&morton[0],&morton[numPrimitives]); // FIMXE: use radix sort
+      }
       
 #if defined(DEBUG)
       for (size_t i=1; i<numPrimitives; i++)
-        assert(morton[i-1].code <= morton[i].code);
+        assert(useMorton64 || morton[i-1].code <= morton[i].code);
+      for (size_t i=1; i<numPrimitives; i++)
+        assert(!useMorton64 || ((MortonID64Bit*)morton)[i-1].code <= ((MortonID64Bit*)morton)[i].code);
 #endif	    
       
       SmallBuildRecord br;
@@ -994,6 +1119,10 @@ namespace embree
       __align(64) Allocator nodeAlloc(nodeAllocator);
       __align(64) Allocator leafAlloc(primAllocator);
       recurse(br,nodeAlloc,leafAlloc,RECURSE,threadIndex);	    
+
+      /* optimize SAH cost of tree */
+      if (restructure) 
+        BVH4Restructure::restructure(bvh,bvh->root);
             
       /* stop measurement */
       if (g_verbose >= 2) dt = getSeconds()-t0;
@@ -1026,10 +1155,16 @@ namespace embree
       scheduler.dispatchTask( task_computeMortonCodes, this, threadIndex, threadCount );   
       
       /* padding */
-      MortonID32Bit* __restrict__ const dest = (MortonID32Bit*) nodeAllocator.data;
       for (size_t i=numPrimitives; i<( (numPrimitives+7)&(-8) ); i++) {
-        dest[i].code  = 0xffffffff; 
-        dest[i].index = 0;
+        if (useMorton64) {
+          MortonID64Bit* __restrict__ const dest = (MortonID64Bit*) nodeAllocator.data;
+          dest[i].code  = 0xffffffffffffffffull; 
+          dest[i].index = 0;
+        } else {
+          MortonID32Bit* __restrict__ const dest = (MortonID32Bit*) nodeAllocator.data;
+          dest[i].code  = 0xffffffff; 
+          dest[i].index = 0;
+        }
       }
       
       /* sort morton codes */
@@ -1037,7 +1172,9 @@ namespace embree
 
 #if defined(DEBUG)
       for (size_t i=1; i<numPrimitives; i++)
-        assert(morton[i-1].code <= morton[i].code);
+        assert(useMorton64 || morton[i-1].code <= morton[i].code);
+      for (size_t i=1; i<numPrimitives; i++)
+        assert(!useMorton64 || ((MortonID64Bit*)morton)[i-1].code <= ((MortonID64Bit*)morton)[i].code);
 #endif	    
       
       /* build and extract top-level tree */
@@ -1065,6 +1202,15 @@ namespace embree
       
       /* refit toplevel part of tree */
       refit_toplevel(bvh->root);
+
+      /* optimize SAH cost of toplevel part of tree, the sub-trees are already restructured */
+      if (restructure) 
+      {
+        for (size_t i=0; i<g_state->numBuildRecords; i++)
+          g_state->buildRecords[i].parent->setBarrier();
+        BVH4Restructure::restructure(bvh,bvh->root);
+        bvh->clearBarrier(bvh->root);
+      }
       
       /* end task */
       scheduler.releaseThreads(threadCount);
@@ -41,8 +41,10 @@ namespace embree
       static const size_t MORTON_LEAF_THRESHOLD = 4;
       static const size_t LATTICE_BITS_PER_DIM = 10;
       static const size_t LATTICE_SIZE_PER_DIM = size_t(1) << LATTICE_BITS_PER_DIM;
+      static const size_t LATTICE_BITS_PER_DIM_64 = 21;
+      static const size_t LATTICE_SIZE_PER_DIM_64 = size_t(1) << LATTICE_BITS_PER_DIM_64;
       
-      static const size_t RADIX_BITS = 11;
+      static const size_t RADIX_BITS = 13; //!< widest radix sort digit of all morton code types
       static const size_t RADIX_BUCKETS = (1 << RADIX_BITS);
       static const size_t RADIX_BUCKETS_MASK = (RADIX_BUCKETS-1);
 
@@ -74,6 +76,11 @@ namespace embree
 
       struct __align(8) MortonID32Bit
       {
+        /*! the 30 bit codes get sorted in 3 passes of 11 bits */
+        static const size_t RADIX_BITS = 11;
+        static const size_t RADIX_PASSES = 3;
+        typedef unsigned int Code;
+
         union {
           struct {
             unsigned int code;
@@ -99,6 +106,33 @@ namespace embree
         __forceinline bool operator>(const MortonID32Bit &m) const { return code > m.code; } 
       };
 
+      /*! Morton code with 21 bits per dimension, used for large scenes
+       *  where 10 bits per dimension map too many primitives to the
+       *  same code. */
+      struct __align(16) MortonID64Bit
+      {
+        /*! the 63 bit codes get sorted in 5 passes of 13 bits */
+        static const size_t RADIX_BITS = 13;
+        static const size_t RADIX_PASSES = 5;
+        typedef uint64 Code;
+
+        uint64 code;
+        unsigned int index;
+        unsigned int pad;
+        
+        __forceinline unsigned int get(const unsigned int shift, const unsigned and_mask) const {
+          return (unsigned int)(code >> shift) & and_mask;
+        }
+        
+        __forceinline friend std::ostream &operator<<(std::ostream &o, const MortonID64Bit& mc) {
+          o << "index " << mc.index << " code = " << mc.code;
+          return o;
+        }
+        
+        __forceinline bool operator<(const MortonID64Bit &m) const { return code < m.code; } 
+        __forceinline bool operator>(const MortonID64Bit &m) const { return code > m.code; } 
+      };
+
       struct MortonBuilderState
       {
         ALIGNED_CLASS;
@@ -143,8 +177,8 @@ namespace embree
       /* build function */
       void build(size_t threadIndex, size_t threadCount);
       
-      /*! initialized the builder */
-      void init(size_t threadIndex, size_t threadCount);
+      /*! initialized the builder, returns false if the memory monitor vetoed the build */
+      bool init(size_t threadIndex, size_t threadCount);
       
       /*! precalculate some per thread data */
       void initThreadState(const size_t threadID, const size_t numThreads);
@@ -158,6 +192,14 @@ namespace embree
                               const size_t startGroup, const size_t startOffset, 
                               MortonID32Bit* __restrict__ const dest);
 
+      void computeMortonCodes(const size_t startID, const size_t endID, 
+                              const size_t startGroup, const size_t startOffset, 
+                              MortonID64Bit* __restrict__ const dest);
+
+      /*! sorts the morton codes with a parallel radix sort */
+      template<typename MortonID>
+        void radixsort(const size_t threadID, const size_t numThreads);
+
       /*! main build task */
       TASK_RUN_FUNCTION(BVH4BuilderMorton,build_parallel_morton);
       TaskScheduler::Task task;
@@ -192,6 +234,9 @@ namespace embree
       
       /*! split a build record into two */
       void split(SmallBuildRecord& current, SmallBuildRecord& left, SmallBuildRecord& right) const;
+
+      template<typename MortonID>
+        void split(MortonID* __restrict__ const morton, SmallBuildRecord& current, SmallBuildRecord& left, SmallBuildRecord& right) const;
       
       /*! main recursive build function */
       BBox3f recurse(SmallBuildRecord& current, 
@@ -212,7 +257,14 @@ namespace embree
       BBox3f refit(NodeRef& index) const;
       
       /*! recreates morton codes when reaching a region where all codes are identical */
-      void recreateMortonCodes(SmallBuildRecord& current) const;
+      void recreateMortonCodes(MortonID32Bit* __restrict__ const morton, SmallBuildRecord& current) const;
+      void recreateMortonCodes(MortonID64Bit* __restrict__ const morton, SmallBuildRecord& current) const;
+
+      /*! returns the primitive index of the i'th sorted morton code */
+      __forceinline unsigned int mortonIndex(const size_t i) const {
+        if (useMorton64) return ((MortonID64Bit*)morton)[i].index;
+        else             return morton[i].index;
+      }
       
     public:
       BVH4* bvh;               //!< Output BVH
@@ -227,8 +279,10 @@ namespace embree
       static std::auto_ptr<MortonBuilderState> g_state;
             
     protected:
-      MortonID32Bit* __restrict__ morton;
+      MortonID32Bit* __restrict__ morton;  //!< morton codes, MortonID64Bit array if useMorton64 is set
       size_t bytesMorton;
+      bool useMorton64;                    //!< large scenes use 64 bit morton codes
+      bool restructure;                    //!< restructures treelets after the build to lower the SAH cost
       
     public:
       size_t numGroups;
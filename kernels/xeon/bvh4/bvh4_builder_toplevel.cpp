@@ -16,6 +16,7 @@
 
 #include "bvh4_builder_toplevel.h"
 #include "bvh4_statistics.h"
+#include "bvh4_rotate.h"
 
 #include "geometry/triangle1.h"
 #include "geometry/triangle4.h"
@@ -31,11 +32,15 @@ namespace embree
 #define BUILD_RECORD_SPLIT_THRESHOLD 512
 #define THRESHOLD_FOR_SUBTREE_RECURSION 128
 #define MIN_OPEN_SIZE 2000
+#define MIN_INCREMENTAL_OBJECTS 1024
+#define MAX_ROTATE_NODES 64
+#define MIN_BATCH_PRIMITIVES 4096
 
     std::auto_ptr<BVH4BuilderTopLevel::GlobalState> BVH4BuilderTopLevel::g_state(NULL);
 
     BVH4BuilderTopLevel::BVH4BuilderTopLevel (BVH4* bvh, Scene* scene, const createTriangleMeshAccelTy createTriangleMeshAccel) 
-      : bvh(bvh), objects(bvh->objects), scene(scene), createTriangleMeshAccel(createTriangleMeshAccel) {}
+      : bvh(bvh), objects(bvh->objects), scene(scene), createTriangleMeshAccel(createTriangleMeshAccel), 
+        incremental(false), numUpdates(0) {}
     
     BVH4BuilderTopLevel::~BVH4BuilderTopLevel ()
     {
@@ -79,17 +84,32 @@ namespace embree
       
       refs.resize(N);
       nextRef = 0;
+      changed.clear();
+      changed.resize(N,0);
       
-      /* sequential create of acceleration structures */
+      /* sequential create of acceleration structures, consecutive
+       * small objects are grouped into one build task */
+      batches.clear();
+      size_t batchPrimitives = MIN_BATCH_PRIMITIVES;
       for (size_t i=0; i<N; i++) 
+      {
         create_object(i);
+        if (batchPrimitives >= MIN_BATCH_PRIMITIVES) {
+          batches.push_back(i);
+          batchPrimitives = 0;
+        }
+        TriangleMeshScene::TriangleMesh* mesh = scene->getTriangleMeshSafe(i);
+        if (mesh && mesh->isModified()) batchPrimitives += mesh->numTriangles;
+        else                            batchPrimitives++;
+      }
+      batches.push_back(N);
       
       /* reset bounds of each thread */
       for (size_t i=0; i<threadCount; i++)
         g_state->thread_bounds[i].reset();
       
       /* parallel build of acceleration structures */
-      if (N) TaskScheduler::executeTask(threadIndex,threadCount,_task_build_parallel,this,N,"toplevel_build_parallel");
+      if (N) TaskScheduler::executeTask(threadIndex,threadCount,_task_build_parallel,this,batches.size()-1,"toplevel_build_parallel");
       //for (size_t i=0; i<N; i++) g_state->thread_bounds[threadIndex].extend(build(threadIndex,threadCount,i));
       
       /* perform builds that need all threads */
@@ -99,11 +119,20 @@ namespace embree
       
       allThreadBuilds.clear();
       
-      /* build toplevel BVH */
-      build_toplevel(threadIndex,threadCount);
+      /* scenes with many objects update the toplevel BVH
+       * incrementally if only few objects changed, the leaves of
+       * such BVHs reference the object roots and are never opened */
+      if (N < MIN_INCREMENTAL_OBJECTS) {
+        incremental = false;
+        build_toplevel(threadIndex,threadCount,true);
+      }
+      else if (!update_toplevel(threadIndex,threadCount)) {
+        build_toplevel(threadIndex,threadCount,false);
+        record_toplevel();
+      }
     }
     
-    void BVH4BuilderTopLevel::build_toplevel(size_t threadIndex, size_t threadCount)
+    void BVH4BuilderTopLevel::build_toplevel(size_t threadIndex, size_t threadCount, bool open)
     {
       /* calculate scene bounds */
       Centroid_Scene_AABB bounds; bounds.reset();
@@ -127,13 +156,17 @@ namespace embree
       open_sequential();
       refs1.resize(refs.size());
 #else
-      global_dest = refs.size();
-      size_t M = max(size_t(2*global_dest),size_t(MIN_OPEN_SIZE));
-      refs .resize(M);
-      refs1.resize(M);
-      barrier.init(threadCount);
-      TaskScheduler::executeTask(threadIndex,threadCount,_task_open_parallel,this,threadCount,"toplevel_open_parallel");
-      refs.resize(global_dest);
+      if (open) {
+        global_dest = refs.size();
+        size_t M = max(size_t(2*global_dest),size_t(MIN_OPEN_SIZE));
+        refs .resize(M);
+        refs1.resize(M);
+        barrier.init(threadCount);
+        TaskScheduler::executeTask(threadIndex,threadCount,_task_open_parallel,this,threadCount,"toplevel_open_parallel");
+        refs.resize(global_dest);
+      } 
+      else
+        refs1.resize(refs.size());
 #endif
       bvh->init(refs.size());
 
@@ -213,6 +246,7 @@ namespace embree
       if (mesh->isModified()) {
         builder->build(threadIndex,threadCount);
         mesh->state = Geometry::ENABLED;
+        changed[objectID] = 1;
       }
       
       /* create build primitive */
@@ -225,17 +259,261 @@ namespace embree
                                                   size_t taskIndex, size_t taskCount,
                                                   TaskScheduler::Event* event_i)
     {
-      /* ignore meshes that need all threads */
-      size_t objectID = taskIndex;
-      if (builders[objectID] && builders[objectID]->needAllThreads) 
-        return;
-      
-      /* build all other meshes */
-      BBox3f bounds = build(threadIndex,threadCount,objectID);
-      if (!bounds.empty()) 
-        g_state->thread_bounds[threadIndex].extend(bounds);
+      for (size_t objectID=batches[taskIndex]; objectID<batches[taskIndex+1]; objectID++)
+      {
+        /* ignore meshes that need all threads */
+        if (builders[objectID] && builders[objectID]->needAllThreads) 
+          continue;
+      
+        /* build all other meshes */
+        BBox3f bounds = build(threadIndex,threadCount,objectID);
+        if (!bounds.empty()) 
+          g_state->thread_bounds[threadIndex].extend(bounds);
+      }
     }
     
+    bool BVH4BuilderTopLevel::update_toplevel(size_t threadIndex, size_t threadCount)
+    {
+      if (!incremental) return false;
+      incremental = false;
+
+      /* find all objects whose reference in the toplevel BVH changed */
+      size_t N = scene->size();
+      size_t M = max(N,objectRefs.size());
+      objectRefs .resize(M,NodeRef(BVH4::emptyNode));
+      objectSlots.resize(M);
+      
+      std::vector<size_t> updates;
+      for (size_t i=0; i<M; i++) 
+      {
+        NodeRef ref = BVH4::emptyNode;
+        TriangleMeshScene::TriangleMesh* mesh = i < N ? scene->getTriangleMeshSafe(i) : NULL;
+        if (mesh && mesh->isEnabled() && mesh->numTimeSteps == 1 && !objects[i]->bounds.empty())
+          ref = objects[i]->root;
+        if (ref != objectRefs[i] || (i < N && changed[i])) 
+          updates.push_back(i);
+      }
+
+      /* rebuild if too many objects changed */
+      numUpdates += updates.size();
+      if (4*updates.size() > N || numUpdates > N) 
+        return false;
+
+      double t0 = 0.0;
+      if (g_verbose >= 2) {
+        std::cout << "updating BVH4<" << bvh->primTy.name << "> with toplevel SAH builder ... " << std::flush;
+        t0 = getSeconds();
+      }
+
+      /* remove all changed objects */
+      for (size_t i=0; i<updates.size(); i++) 
+        if (objectRefs[updates[i]] != BVH4::emptyNode) 
+          remove(updates[i]);
+
+      /* reinsert all changed objects and perform tree rotations close to the inserted objects */
+      for (size_t i=0; i<updates.size(); i++) 
+      {
+        const size_t objectID = updates[i];
+        TriangleMeshScene::TriangleMesh* mesh = objectID < N ? scene->getTriangleMeshSafe(objectID) : NULL;
+        if (mesh == NULL || !mesh->isEnabled() || mesh->numTimeSteps != 1 || objects[objectID]->bounds.empty()) 
+          continue;
+
+        if (!insert(objectID,objects[objectID]->root,objects[objectID]->bounds,threadIndex))
+          return false;
+
+        Node* node = objectSlots[objectID].node;
+        Node* parent = nodeSlots[node].node;
+        if (parent && count_nodes(parent,MAX_ROTATE_NODES) < MAX_ROTATE_NODES) rotate(parent);
+        else if (count_nodes(node,MAX_ROTATE_NODES) < MAX_ROTATE_NODES) rotate(node);
+      }
+      
+      bvh->bounds = bvh->root.node()->bounds();
+      incremental = true;
+
+      if (g_verbose >= 2) {
+        double t1 = getSeconds();
+        std::cout << "[DONE]" << std::endl;
+        std::cout << "  dt = " << 1000.0f*(t1-t0) << "ms, " << updates.size() << " objects updated" << std::endl;
+        std::cout << BVH4Statistics(bvh).str();
+      }
+      return true;
+    }
+
+    void BVH4BuilderTopLevel::record_toplevel()
+    {
+      incremental = false;
+      numUpdates = 0;
+      objectRefs.clear();
+      objectSlots.clear();
+      refObjects.clear();
+      nodeSlots.clear();
+
+      /* remember the roots of all objects that are part of the toplevel BVH */
+      size_t N = scene->size();
+      objectRefs .resize(N,NodeRef(BVH4::emptyNode));
+      objectSlots.resize(N);
+      for (size_t i=0; i<N; i++) 
+      {
+        TriangleMeshScene::TriangleMesh* mesh = scene->getTriangleMeshSafe(i);
+        if (mesh == NULL || !mesh->isEnabled() || mesh->numTimeSteps != 1 || objects[i]->bounds.empty()) 
+          continue;
+        objectRefs[i] = objects[i]->root;
+        refObjects[objects[i]->root] = i;
+      }
+
+      /* incremental updates require a toplevel node at the root */
+      if (refObjects.empty() || !bvh->root.isNode() || refObjects.find(bvh->root) != refObjects.end())
+        return;
+
+      Node* root = bvh->root.node();
+      nodeSlots[root] = Slot();
+      record_children(root,true);
+      incremental = true;
+    }
+
+    void BVH4BuilderTopLevel::record_children(Node* node, bool recursive)
+    {
+      for (size_t i=0; i<4; i++) 
+      {
+        NodeRef child = node->child(i);
+        if (child == BVH4::emptyNode) continue;
+        
+        std::map<size_t,size_t>::iterator obj = refObjects.find(child);
+        if (obj != refObjects.end()) {
+          objectSlots[obj->second] = Slot(node,i);
+          continue;
+        }
+        if (!child.isNode()) continue;
+        nodeSlots[child.node()] = Slot(node,i);
+        if (recursive) record_children(child.node(),true);
+      }
+    }
+
+    bool BVH4BuilderTopLevel::insert(size_t objectID, NodeRef ref, const BBox3f& bounds, size_t threadIndex)
+    {
+      Node* node = bvh->root.node();
+      for (size_t depth=1; ; depth++)
+      {
+        /* fill empty slot of node */
+        for (size_t i=0; i<4; i++) {
+          if (node->child(i) != BVH4::emptyNode) continue;
+          node->set(i,bounds,ref);
+          objectRefs [objectID] = ref;
+          objectSlots[objectID] = Slot(node,i);
+          refObjects[ref] = objectID;
+          refit(node);
+          return true;
+        }
+
+        /* find child whose area increases least */
+        size_t best = 0; 
+        float bestCost = inf, bestArea = inf;
+        for (size_t i=0; i<4; i++) {
+          const float A = area(node->bounds(i));
+          const float cost = area(merge(node->bounds(i),bounds))-A;
+          if (cost < bestCost || (cost == bestCost && A < bestArea)) {
+            best = i; bestCost = cost; bestArea = A;
+          }
+        }
+
+        /* descend into toplevel nodes */
+        NodeRef child = node->child(best);
+        if (child.isNode() && nodeSlots.find(child.node()) != nodeSlots.end()) {
+          node = child.node();
+          continue;
+        }
+
+        /* pair object with the object stored in the slot */
+        if (depth+1 > BVH4::maxBuildDepth) 
+          return false;
+
+        Node* pair = bvh->allocNode(threadIndex);
+        pair->set(0,node->bounds(best),child);
+        pair->set(1,bounds,ref);
+        node->set(best,pair->bounds(),bvh->encodeNode(pair));
+        nodeSlots[pair] = Slot(node,best);
+        objectSlots[refObjects[child]] = Slot(pair,0);
+        objectRefs [objectID] = ref;
+        objectSlots[objectID] = Slot(pair,1);
+        refObjects[ref] = objectID;
+        refit(node);
+        return true;
+      }
+    }
+
+    void BVH4BuilderTopLevel::remove(size_t objectID)
+    {
+      Slot slot = objectSlots[objectID];
+      refObjects.erase(objectRefs[objectID]);
+      objectRefs [objectID] = BVH4::emptyNode;
+      objectSlots[objectID] = Slot();
+
+      /* clear slot and remove nodes that got empty */
+      Node* node = slot.node;
+      node->set(slot.index,empty,BVH4::emptyNode);
+      while (node != bvh->root.node() && node->bounds().empty()) 
+      {
+        /* object roots with empty bounds are never inserted, thus nodes with empty bounds have no children */
+        Slot parent = nodeSlots[node];
+        nodeSlots.erase(node);
+        parent.node->set(parent.index,empty,BVH4::emptyNode);
+        node = parent.node;
+      }
+      BVH4::compact(node);
+      record_children(node,false);
+      refit(node);
+    }
+
+    void BVH4BuilderTopLevel::refit(Node* node)
+    {
+      while (true) {
+        Slot slot = nodeSlots[node];
+        if (slot.node == NULL) break;
+        slot.node->set(slot.index,node->bounds());
+        node = slot.node;
+      }
+    }
+
+    size_t BVH4BuilderTopLevel::depth(Node* node)
+    {
+      size_t d = 1;
+      for (Node* n = nodeSlots[node].node; n; n = nodeSlots[n].node) d++;
+      return d;
+    }
+
+    size_t BVH4BuilderTopLevel::count_nodes(Node* node, size_t maxNodes)
+    {
+      size_t num = 1;
+      for (size_t i=0; i<4 && num < maxNodes; i++) {
+        NodeRef child = node->child(i);
+        if (child.isNode() && nodeSlots.find(child.node()) != nodeSlots.end())
+          num += count_nodes(child.node(),maxNodes-num);
+      }
+      return num;
+    }
+
+    void BVH4BuilderTopLevel::mark_barriers(Node* node)
+    {
+      for (size_t i=0; i<4; i++) 
+      {
+        NodeRef& child = node->child(i);
+        if (!child.isNode()) continue;
+        if (nodeSlots.find(child.node()) != nodeSlots.end()) mark_barriers(child.node());
+        else child.setBarrier();
+      }
+    }
+
+    void BVH4BuilderTopLevel::rotate(Node* node)
+    {
+      /* the rotations must not enter the object BVHs, thus we mark
+       * the object roots as barriers during the rotation */
+      NodeRef ref = bvh->encodeNode(node);
+      mark_barriers(node);
+      BVH4Rotate::rotate(bvh,ref,depth(node));
+      bvh->clearBarrier(ref);
+      record_children(node,true);
+    }
+
     void BVH4BuilderTopLevel::open_sequential()
     {
       size_t N = max(2*refs.size(),size_t(MIN_OPEN_SIZE));
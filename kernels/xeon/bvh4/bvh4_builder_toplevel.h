@@ -76,7 +76,19 @@ namespace embree
       /*! builder entry point */
       void build(size_t threadIndex, size_t threadCount);
       
-      void build_toplevel(size_t threadIndex, size_t threadCount);
+      void build_toplevel(size_t threadIndex, size_t threadCount, bool open);
+      
+      /*! incremental update of the toplevel BVH, returns false if a full rebuild is required */
+      bool update_toplevel(size_t threadIndex, size_t threadCount);
+      void record_toplevel();
+      void record_children(Node* node, bool recursive);
+      bool insert(size_t objectID, NodeRef ref, const BBox3f& bounds, size_t threadIndex);
+      void remove(size_t objectID);
+      void refit(Node* node);
+      void rotate(Node* node);
+      void mark_barriers(Node* node);
+      size_t depth(Node* node);
+      size_t count_nodes(Node* node, size_t maxNodes);
       
       /*! parallel rebuild of geometry */
       TASK_RUN_FUNCTION(BVH4BuilderTopLevel,task_create_parallel);
@@ -104,6 +116,7 @@ namespace embree
       std::vector<BVH4*>& objects;
       std::vector<Builder*> builders;
       std::vector<size_t> allThreadBuilds;    
+      std::vector<size_t> batches;            //!< first object of each build task, followed by the number of objects
       
     public:
       Scene* scene;
@@ -113,6 +126,24 @@ namespace embree
       /*! build mode */
       enum { RECURSE = 1, BUILD_TOP_LEVEL = 3 };
       
+      /*! location of a reference inside the toplevel BVH */
+      struct Slot 
+      {
+        Slot () : node(NULL), index(0) {}
+        Slot (Node* node, size_t index) : node(node), index(index) {}
+        Node* node;     //!< node that stores the reference, NULL for the root
+        size_t index;   //!< child slot inside the node
+      };
+
+      /*! state for incremental updates of the toplevel BVH */
+      bool incremental;                     //!< true if the toplevel BVH can get updated incrementally
+      size_t numUpdates;                    //!< number of objects updated since last full build
+      std::vector<char> changed;            //!< objects rebuilt during the current build
+      std::vector<NodeRef> objectRefs;      //!< root of each object as referenced by the toplevel BVH
+      std::vector<Slot> objectSlots;        //!< location of each object inside the toplevel BVH
+      std::map<size_t,size_t> refObjects;   //!< maps object roots to object IDs
+      std::map<Node*,Slot> nodeSlots;       //!< location of each toplevel node inside its parent
+      
       TaskScheduler::Task task;
       vector_t<BuildRef> refs;
       vector_t<BuildRef> refs1;
@@ -0,0 +1,116 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#include "bvh4_compress.h"
+
+namespace embree
+{
+  BVH4Compress::BVH4Compress (BVH4* bvh, Builder* builder)
+    : builder(builder), bvh(bvh) 
+  {
+    needAllThreads = builder->needAllThreads;
+    bvh->compressed = true;
+  }
+
+  BVH4Compress::~BVH4Compress () {
+    delete builder;
+  }
+
+  void BVH4Compress::build(size_t threadIndex, size_t threadCount) 
+  {
+    /* free compressed nodes of previous build */
+    if (bvh->nodes) os_free(bvh->nodes,bvh->bytesNodes);
+    bvh->nodes = NULL; bvh->bytesNodes = 0;
+
+    /* build uncompressed BVH */
+    builder->build(threadIndex,threadCount);
+    const size_t bytesUncompressed = bvh->alloc->bytes();
+
+    double t0 = 0.0;
+    if (g_verbose >= 2) {
+      std::cout << "compressing BVH4 <" << bvh->primTy.name << "> ... " << std::flush;
+      t0 = getSeconds();
+    }
+
+    /* copy tree into a single memory block */
+    size_t bytesNodes = 0, bytesLeaves = 0;
+    count(bvh->root,bytesNodes,bytesLeaves);
+    const size_t bytes = max(bytesNodes+bytesLeaves,size_t(1));
+    char* ptr = (char*) os_malloc(bytes);
+    char* dst = ptr;
+    bvh->root = compress(bvh->root,dst);
+    assert(dst == ptr+bytesNodes+bytesLeaves);
+    bvh->nodes = ptr;
+    bvh->bytesNodes = bytes;
+
+    /* release memory of uncompressed BVH */
+    bvh->alloc->reset();
+
+    if (g_verbose >= 2) {
+      double t1 = getSeconds();
+      std::cout << "[DONE]" << std::endl;
+      std::cout << "  dt = " << 1000.0f*(t1-t0) << "ms" << std::endl;
+      std::cout << "  uncompressed = " << bytesUncompressed/1E6 << " MB, " 
+                << "compressed = " << bytes/1E6 << " MB "
+                << "(nodes = " << bytesNodes/1E6 << " MB, leaves = " << bytesLeaves/1E6 << " MB)" << std::endl;
+    }
+  }
+
+  void BVH4Compress::count(NodeRef ref, size_t& bytesNodes, size_t& bytesLeaves)
+  {
+    if (ref == BVH4::emptyNode) 
+      return;
+
+    if (ref.isLeaf()) {
+      size_t num; ref.leaf(num);
+      bytesLeaves += num*bvh->primTy.bytes;
+      return;
+    }
+
+    const Node* node = ref.node();
+    bytesNodes += sizeof(CompressedNode);
+    for (size_t i=0; i<BVH4::N; i++)
+      count(node->child(i),bytesNodes,bytesLeaves);
+  }
+
+  BVH4::NodeRef BVH4Compress::compress(NodeRef ref, char*& dst)
+  {
+    if (ref == BVH4::emptyNode) 
+      return ref;
+
+    if (ref.isLeaf()) {
+      size_t num; char* prims = ref.leaf(num);
+      const size_t bytes = num*bvh->primTy.bytes;
+      memcpy(dst,prims,bytes);
+      NodeRef leaf = bvh->encodeLeaf(dst,num);
+      dst += bytes;
+      return leaf;
+    }
+
+    const Node* node = ref.node();
+    CompressedNode* cnode = (CompressedNode*) dst;
+    dst += sizeof(CompressedNode);
+    cnode->set(*node);
+    for (size_t i=0; i<BVH4::N; i++)
+      cnode->child(i) = compress(node->child(i),dst);
+    return NodeRef((size_t)cnode);
+  }
+
+  Builder* BVH4BuilderCompress (void* accel, Builder* builder) {
+    return new BVH4Compress((BVH4*)accel,builder);
+  }
+}
@@ -0,0 +1,64 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#ifndef __EMBREE_BVH4_COMPRESS_H__
+#define __EMBREE_BVH4_COMPRESS_H__
+
+#include "bvh4.h"
+
+namespace embree
+{
+  /*! Builder that converts the BVH4 created by some other builder into
+   *  a BVH4 with compressed nodes. The compressed tree is stored in a
+   *  single memory block in depth first order, and the memory of the
+   *  original build is released afterwards. */
+  class BVH4Compress : public Builder
+  {
+    ALIGNED_CLASS;
+  public:
+
+    /*! Type shortcuts */
+    typedef BVH4::Node           Node;
+    typedef BVH4::CompressedNode CompressedNode;
+    typedef BVH4::NodeRef        NodeRef;
+
+  public:
+
+    /*! Constructor. */
+    BVH4Compress (BVH4* bvh, Builder* builder);
+
+    /*! Destructor. */
+    ~BVH4Compress();
+
+    /*! builds the BVH with the wrapped builder and compresses it */
+    void build(size_t threadIndex, size_t threadCount);
+
+  private:
+
+    /*! counts the bytes required to store the compressed subtree */
+    void count(NodeRef ref, size_t& bytesNodes, size_t& bytesLeaves);
+
+    /*! copies the subtree into the compressed memory block */
+    NodeRef compress(NodeRef ref, char*& dst);
+
+  public:
+    Builder* builder;     //!< builder for the uncompressed BVH
+    BVH4* bvh;            //!< BVH to compress
+  };
+}
+
+#endif
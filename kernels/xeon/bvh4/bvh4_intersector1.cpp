@@ -18,27 +18,35 @@
 
 #include "geometry/triangle1_intersector1_moeller.h"
 #include "geometry/triangle4_intersector1_moeller.h"
+#include "geometry/triangle4w_intersector1_woop.h"
 #if defined(__AVX__)
 #include "geometry/triangle8_intersector1_moeller.h"
+#include "geometry/triangle8w_intersector1_woop.h"
 #endif
 #include "geometry/triangle1v_intersector1_pluecker.h"
 #include "geometry/triangle4v_intersector1_pluecker.h"
 #include "geometry/triangle4i_intersector1.h"
+#include "geometry/triangle4q_intersector1_moeller.h"
+#include "geometry/quad4_intersector1_moeller.h"
+#include "geometry/bezier1_intersector1.h"
 #include "geometry/virtual_accel_intersector1.h"
 
 namespace embree
 { 
   namespace isa
   {
-    template<typename PrimitiveIntersector>
-    void BVH4Intersector1<PrimitiveIntersector>::intersect(const BVH4* bvh, Ray& ray)
+    template<typename PrimitiveIntersector, typename NodeTy>
+    void BVH4Intersector1<PrimitiveIntersector,NodeTy>::intersect(const BVH4* bvh, Ray& ray)
     {
       /*! stack state */
       StackItemInt32<NodeRef> stack[stackSize];  //!< stack of nodes 
       StackItemInt32<NodeRef>* stackPtr = stack+1;        //!< current stack pointer
       StackItemInt32<NodeRef>* stackEnd = stack+stackSize;
-      stack[0].ptr = bvh->root;
+      stack[0].ptr = bvh->getRoot();
       stack[0].dist = neg_inf;
+
+      /*! runtime statistics */
+      SceneStat::Counters* stats = bvh->stat->thread();
       
       /*! offsets to select the side that becomes the lower or upper bound */
       const size_t nearX = ray.dir.x >= 0.0f ? 0*sizeof(ssef) : 1*sizeof(ssef);
@@ -89,24 +97,25 @@ namespace embree
           /*! stop if we found a leaf */
           if (unlikely(cur.isLeaf())) break;
           STAT3(normal.trav_nodes,1,1,1);
+          STAT_SCENE(stats,nodes++);
           
           /*! single ray intersection with 4 boxes */
-          const Node* node = cur.node();
+          const Node* node = (const Node*) cur.node();
           const size_t farX  = nearX ^ 16, farY  = nearY ^ 16, farZ  = nearZ ^ 16;
 #if defined (__AVX2__)
-          const ssef tNearX = msub(load4f((const char*)node+nearX), rdir.x, org_rdir.x);
-          const ssef tNearY = msub(load4f((const char*)node+nearY), rdir.y, org_rdir.y);
-          const ssef tNearZ = msub(load4f((const char*)node+nearZ), rdir.z, org_rdir.z);
-          const ssef tFarX  = msub(load4f((const char*)node+farX ), rdir.x, org_rdir.x);
-          const ssef tFarY  = msub(load4f((const char*)node+farY ), rdir.y, org_rdir.y);
-          const ssef tFarZ  = msub(load4f((const char*)node+farZ ), rdir.z, org_rdir.z);
+          const ssef tNearX = msub(node->plane(nearX), rdir.x, org_rdir.x);
+          const ssef tNearY = msub(node->plane(nearY), rdir.y, org_rdir.y);
+          const ssef tNearZ = msub(node->plane(nearZ), rdir.z, org_rdir.z);
+          const ssef tFarX  = msub(node->plane(farX ), rdir.x, org_rdir.x);
+          const ssef tFarY  = msub(node->plane(farY ), rdir.y, org_rdir.y);
+          const ssef tFarZ  = msub(node->plane(farZ ), rdir.z, org_rdir.z);
 #else
-          const ssef tNearX = (norg.x + load4f((const char*)node+nearX)) * rdir.x;
-          const ssef tNearY = (norg.y + load4f((const char*)node+nearY)) * rdir.y;
-          const ssef tNearZ = (norg.z + load4f((const char*)node+nearZ)) * rdir.z;
-          const ssef tFarX  = (norg.x + load4f((const char*)node+farX )) * rdir.x;
-          const ssef tFarY  = (norg.y + load4f((const char*)node+farY )) * rdir.y;
-          const ssef tFarZ  = (norg.z + load4f((const char*)node+farZ )) * rdir.z;
+          const ssef tNearX = (norg.x + node->plane(nearX)) * rdir.x;
+          const ssef tNearY = (norg.y + node->plane(nearY)) * rdir.y;
+          const ssef tNearZ = (norg.z + node->plane(nearZ)) * rdir.z;
+          const ssef tFarX  = (norg.x + node->plane(farX )) * rdir.x;
+          const ssef tFarY  = (norg.y + node->plane(farY )) * rdir.y;
+          const ssef tFarZ  = (norg.z + node->plane(farZ )) * rdir.z;
 #endif
 
 #if defined(__SSE4_1__)
@@ -175,19 +184,24 @@ namespace embree
         /*! this is a leaf node */
         STAT3(normal.trav_leaves,1,1,1);
         size_t num; Primitive* prim = (Primitive*) cur.leaf(num);
+        STAT_SCENE(stats,leaves++);
+        STAT_SCENE(stats,prims += num);
         PrimitiveIntersector::intersect(ray,prim,num,bvh->geometry);
         ray_far = ray.tfar;
       }
     }
     
-    template<typename PrimitiveIntersector>
-    void BVH4Intersector1<PrimitiveIntersector>::occluded(const BVH4* bvh, Ray& ray)
+    template<typename PrimitiveIntersector, typename NodeTy>
+    void BVH4Intersector1<PrimitiveIntersector,NodeTy>::occluded(const BVH4* bvh, Ray& ray)
     {
       /*! stack state */
       NodeRef stack[stackSize];  //!< stack of nodes that still need to get traversed
       NodeRef* stackPtr = stack+1;        //!< current stack pointer
       NodeRef* stackEnd = stack+stackSize;
-      stack[0] = bvh->root;
+      stack[0] = bvh->getRoot();
+
+      /*! runtime statistics */
+      SceneStat::Counters* stats = bvh->stat->thread();
       
       /*! offsets to select the side that becomes the lower or upper bound */
       const size_t nearX = ray.dir.x >= 0 ? 0*sizeof(ssef) : 1*sizeof(ssef);
@@ -234,24 +248,25 @@ namespace embree
           /*! stop if we found a leaf */
           if (unlikely(cur.isLeaf())) break;
           STAT3(shadow.trav_nodes,1,1,1);
+          STAT_SCENE(stats,nodes++);
           
           /*! single ray intersection with 4 boxes */
-          const Node* node = cur.node();
+          const Node* node = (const Node*) cur.node();
           const size_t farX  = nearX ^ 16, farY  = nearY ^ 16, farZ  = nearZ ^ 16;
 #if defined (__AVX2__)
-          const ssef tNearX = msub(load4f((const char*)node+nearX), rdir.x, org_rdir.x);
-          const ssef tNearY = msub(load4f((const char*)node+nearY), rdir.y, org_rdir.y);
-          const ssef tNearZ = msub(load4f((const char*)node+nearZ), rdir.z, org_rdir.z);
-          const ssef tFarX  = msub(load4f((const char*)node+farX ), rdir.x, org_rdir.x);
-          const ssef tFarY  = msub(load4f((const char*)node+farY ), rdir.y, org_rdir.y);
-          const ssef tFarZ  = msub(load4f((const char*)node+farZ ), rdir.z, org_rdir.z);
+          const ssef tNearX = msub(node->plane(nearX), rdir.x, org_rdir.x);
+          const ssef tNearY = msub(node->plane(nearY), rdir.y, org_rdir.y);
+          const ssef tNearZ = msub(node->plane(nearZ), rdir.z, org_rdir.z);
+          const ssef tFarX  = msub(node->plane(farX ), rdir.x, org_rdir.x);
+          const ssef tFarY  = msub(node->plane(farY ), rdir.y, org_rdir.y);
+          const ssef tFarZ  = msub(node->plane(farZ ), rdir.z, org_rdir.z);
 #else
-          const ssef tNearX = (norg.x + load4f((const char*)node+nearX)) * rdir.x;
-          const ssef tNearY = (norg.y + load4f((const char*)node+nearY)) * rdir.y;
-          const ssef tNearZ = (norg.z + load4f((const char*)node+nearZ)) * rdir.z;
-          const ssef tFarX  = (norg.x + load4f((const char*)node+farX )) * rdir.x;
-          const ssef tFarY  = (norg.y + load4f((const char*)node+farY )) * rdir.y;
-          const ssef tFarZ  = (norg.z + load4f((const char*)node+farZ )) * rdir.z;
+          const ssef tNearX = (norg.x + node->plane(nearX)) * rdir.x;
+          const ssef tNearY = (norg.y + node->plane(nearY)) * rdir.y;
+          const ssef tNearZ = (norg.z + node->plane(nearZ)) * rdir.z;
+          const ssef tFarX  = (norg.x + node->plane(farX )) * rdir.x;
+          const ssef tFarY  = (norg.y + node->plane(farY )) * rdir.y;
+          const ssef tFarZ  = (norg.z + node->plane(farZ )) * rdir.z;
 #endif
           
 #if defined(__SSE4_1__)
@@ -310,6 +325,8 @@ namespace embree
         /*! this is a leaf node */
         STAT3(shadow.trav_leaves,1,1,1);
         size_t num; Primitive* prim = (Primitive*) cur.leaf(num);
+        STAT_SCENE(stats,leaves++);
+        STAT_SCENE(stats,prims += num);
         if (PrimitiveIntersector::occluded(ray,prim,num,bvh->geometry)) {
           ray.geomID = 0;
           break;
@@ -322,10 +339,22 @@ namespace embree
     DEFINE_INTERSECTOR1(BVH4Triangle4Intersector1Moeller,BVH4Intersector1<Triangle4Intersector1MoellerTrumbore>);
 #if defined(__AVX__)
     DEFINE_INTERSECTOR1(BVH4Triangle8Intersector1Moeller,BVH4Intersector1<Triangle8Intersector1MoellerTrumbore>);
+    DEFINE_INTERSECTOR1(BVH4Triangle8wIntersector1Woop,BVH4Intersector1<Triangle8wIntersector1Woop>);
 #endif
+    DEFINE_INTERSECTOR1(BVH4Triangle4wIntersector1Woop,BVH4Intersector1<Triangle4wIntersector1Woop>);
     DEFINE_INTERSECTOR1(BVH4Triangle1vIntersector1Pluecker,BVH4Intersector1<Triangle1vIntersector1Pluecker>);
     DEFINE_INTERSECTOR1(BVH4Triangle4vIntersector1Pluecker,BVH4Intersector1<Triangle4vIntersector1Pluecker>);
     DEFINE_INTERSECTOR1(BVH4Triangle4iIntersector1Pluecker,BVH4Intersector1<Triangle4iIntersector1Pluecker>);
+    DEFINE_INTERSECTOR1(BVH4Triangle4qIntersector1Moeller,BVH4Intersector1<Triangle4qIntersector1MoellerTrumbore>);
+    DEFINE_INTERSECTOR1(BVH4Quad4Intersector1Moeller,BVH4Intersector1<Quad4Intersector1MoellerTrumbore>);
+    DEFINE_INTERSECTOR1(BVH4Bezier1Intersector1,BVH4Intersector1<Bezier1Intersector1>);
     DEFINE_INTERSECTOR1(BVH4VirtualIntersector1,BVH4Intersector1<VirtualAccelIntersector1>);
+
+    typedef BVH4Intersector1<Triangle4Intersector1MoellerTrumbore,BVH4::CompressedNode> BVH4Triangle4Intersector1MoellerCompressedT;
+    DEFINE_INTERSECTOR1(BVH4Triangle4Intersector1MoellerCompressed,BVH4Triangle4Intersector1MoellerCompressedT);
+    typedef BVH4Intersector1<Triangle4iIntersector1Pluecker,BVH4::CompressedNode> BVH4Triangle4iIntersector1PlueckerCompressedT;
+    DEFINE_INTERSECTOR1(BVH4Triangle4iIntersector1PlueckerCompressed,BVH4Triangle4iIntersector1PlueckerCompressedT);
+    typedef BVH4Intersector1<Triangle4qIntersector1MoellerTrumbore,BVH4::CompressedNode> BVH4Triangle4qIntersector1MoellerCompressedT;
+    DEFINE_INTERSECTOR1(BVH4Triangle4qIntersector1MoellerCompressed,BVH4Triangle4qIntersector1MoellerCompressedT);
   }
 }
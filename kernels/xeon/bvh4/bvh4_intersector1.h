@@ -25,14 +25,15 @@ namespace embree
 {
   namespace isa
   {
-    /*! BVH4 single ray traversal implementation. */
-    template<typename PrimitiveIntersector>
+    /*! BVH4 single ray traversal implementation. The node type can be
+     *  either the default BVH4::Node or the BVH4::CompressedNode. */
+    template<typename PrimitiveIntersector, typename NodeTy = BVH4::Node>
       class BVH4Intersector1 
     {
       /* shortcuts for frequently used types */
       typedef typename PrimitiveIntersector::Primitive Primitive;
       typedef typename BVH4::NodeRef NodeRef;
-      typedef typename BVH4::Node Node;
+      typedef NodeTy Node;
       typedef StackItemT<size_t> StackItem;
       static const size_t stackSize = 1+3*BVH4::maxDepth;
       
@@ -18,8 +18,10 @@
 
 #include "geometry/triangle1_intersector4_moeller.h"
 #include "geometry/triangle4_intersector4_moeller.h"
+#include "geometry/triangle4w_intersector4_woop.h"
 #if defined (__AVX__)
 #include "geometry/triangle8_intersector4_moeller.h"
+#include "geometry/triangle8w_intersector4_woop.h"
 #endif
 #include "geometry/triangle1v_intersector4_pluecker.h"
 #include "geometry/triangle4v_intersector4_pluecker.h"
@@ -30,8 +32,8 @@ namespace embree
 {
   namespace isa
   {
-    template<typename PrimitiveIntersector4>
-    void BVH4Intersector4Chunk<PrimitiveIntersector4>::intersect(sseb* valid_i, BVH4* bvh, Ray4& ray)
+    template<typename PrimitiveIntersector4, typename NodeTy>
+    void BVH4Intersector4Chunk<PrimitiveIntersector4,NodeTy>::intersect(sseb* valid_i, BVH4* bvh, Ray4& ray)
     {
       /* load ray */
       const sseb valid0 = *valid_i;
@@ -41,12 +43,15 @@ namespace embree
       ssef ray_tfar  = select(valid0,ray.tfar ,ssef(neg_inf));
       const ssef inf = ssef(pos_inf);
       
+      /* runtime statistics */
+      SceneStat::Counters* stats = bvh->stat->thread();
+
       /* allocate stack and push root node */
       ssef    stack_near[stackSize];
       NodeRef stack_node[stackSize];
       stack_node[0] = BVH4::invalidNode;
       stack_near[0] = inf;
-      stack_node[1] = bvh->root;
+      stack_node[1] = bvh->getRoot();
       stack_near[1] = ray_tnear; 
       NodeRef* stackEnd = stack_node+stackSize;
       NodeRef* __restrict__ sptr_node = stack_node + 2;
@@ -77,7 +82,8 @@ namespace embree
           
           const sseb valid_node = ray_tfar > curDist;
           STAT3(normal.trav_nodes,1,popcnt(valid_node),4);
-          const Node* __restrict__ const node = curNode.node();
+          STAT_SCENE(stats,nodes++);
+          const Node* __restrict__ const node = (const Node*) curNode.node();
           
           /* pop of next node */
           assert(sptr_node > stack_node);
@@ -93,19 +99,19 @@ namespace embree
             if (unlikely(child == BVH4::emptyNode)) break;
             
 #if defined(__AVX2__)
-            const ssef lclipMinX = msub(node->lower_x[i],rdir.x,org_rdir.x);
-            const ssef lclipMinY = msub(node->lower_y[i],rdir.y,org_rdir.y);
-            const ssef lclipMinZ = msub(node->lower_z[i],rdir.z,org_rdir.z);
-            const ssef lclipMaxX = msub(node->upper_x[i],rdir.x,org_rdir.x);
-            const ssef lclipMaxY = msub(node->upper_y[i],rdir.y,org_rdir.y);
-            const ssef lclipMaxZ = msub(node->upper_z[i],rdir.z,org_rdir.z);
+            const ssef lclipMinX = msub(node->lowerX(i),rdir.x,org_rdir.x);
+            const ssef lclipMinY = msub(node->lowerY(i),rdir.y,org_rdir.y);
+            const ssef lclipMinZ = msub(node->lowerZ(i),rdir.z,org_rdir.z);
+            const ssef lclipMaxX = msub(node->upperX(i),rdir.x,org_rdir.x);
+            const ssef lclipMaxY = msub(node->upperY(i),rdir.y,org_rdir.y);
+            const ssef lclipMaxZ = msub(node->upperZ(i),rdir.z,org_rdir.z);
 #else
-            const ssef lclipMinX = (node->lower_x[i] - org.x) * rdir.x;
-            const ssef lclipMinY = (node->lower_y[i] - org.y) * rdir.y;
-            const ssef lclipMinZ = (node->lower_z[i] - org.z) * rdir.z;
-            const ssef lclipMaxX = (node->upper_x[i] - org.x) * rdir.x;
-            const ssef lclipMaxY = (node->upper_y[i] - org.y) * rdir.y;
-            const ssef lclipMaxZ = (node->upper_z[i] - org.z) * rdir.z;
+            const ssef lclipMinX = (node->lowerX(i) - org.x) * rdir.x;
+            const ssef lclipMinY = (node->lowerY(i) - org.y) * rdir.y;
+            const ssef lclipMinZ = (node->lowerZ(i) - org.z) * rdir.z;
+            const ssef lclipMaxX = (node->upperX(i) - org.x) * rdir.x;
+            const ssef lclipMaxY = (node->upperY(i) - org.y) * rdir.y;
+            const ssef lclipMaxZ = (node->upperZ(i) - org.z) * rdir.z;
 #endif
 
 #if defined(__SSE4_1__)
@@ -157,14 +163,16 @@ namespace embree
         const sseb valid_leaf = ray_tfar > curDist;
         STAT3(normal.trav_leaves,1,popcnt(valid_leaf),4);
         size_t items; const Primitive* prim = (Primitive*) curNode.leaf(items);
+        STAT_SCENE(stats,leaves++);
+        STAT_SCENE(stats,prims += items);
         PrimitiveIntersector4::intersect(valid_leaf,ray,prim,items,bvh->geometry);
         ray_tfar = select(valid_leaf,ray.tfar,ray_tfar);
       }
       AVX_ZERO_UPPER();
     }
     
-    template<typename PrimitiveIntersector4>
-    void BVH4Intersector4Chunk<PrimitiveIntersector4>::occluded(sseb* valid_i, BVH4* bvh, Ray4& ray)
+    template<typename PrimitiveIntersector4, typename NodeTy>
+    void BVH4Intersector4Chunk<PrimitiveIntersector4,NodeTy>::occluded(sseb* valid_i, BVH4* bvh, Ray4& ray)
     {
       /* load ray */
       const sseb valid = *valid_i;
@@ -175,12 +183,15 @@ namespace embree
       ssef ray_tfar  = select(valid,ray.tfar ,ssef(neg_inf));
       const ssef inf = ssef(pos_inf);
       
+      /* runtime statistics */
+      SceneStat::Counters* stats = bvh->stat->thread();
+
       /* allocate stack and push root node */
       ssef    stack_near[stackSize];
       NodeRef stack_node[stackSize];
       stack_node[0] = BVH4::invalidNode;
       stack_near[0] = inf;
-      stack_node[1] = bvh->root;
+      stack_node[1] = bvh->getRoot();
       stack_near[1] = ray_tnear; 
       NodeRef* stackEnd = stack_node+stackSize;
       NodeRef* __restrict__ sptr_node = stack_node + 2;
@@ -211,7 +222,8 @@ namespace embree
           
           const sseb valid_node = ray_tfar > curDist;
           STAT3(shadow.trav_nodes,1,popcnt(valid_node),4);
-          const Node* __restrict__ const node = curNode.node();
+          STAT_SCENE(stats,nodes++);
+          const Node* __restrict__ const node = (const Node*) curNode.node();
           
           /* pop of next node */
           assert(sptr_node > stack_node);
@@ -227,19 +239,19 @@ namespace embree
             if (unlikely(child == BVH4::emptyNode)) break;
             
 #if defined(__AVX2__)
-            const ssef lclipMinX = msub(node->lower_x[i],rdir.x,org_rdir.x);
-            const ssef lclipMinY = msub(node->lower_y[i],rdir.y,org_rdir.y);
-            const ssef lclipMinZ = msub(node->lower_z[i],rdir.z,org_rdir.z);
-            const ssef lclipMaxX = msub(node->upper_x[i],rdir.x,org_rdir.x);
-            const ssef lclipMaxY = msub(node->upper_y[i],rdir.y,org_rdir.y);
-            const ssef lclipMaxZ = msub(node->upper_z[i],rdir.z,org_rdir.z);
+            const ssef lclipMinX = msub(node->lowerX(i),rdir.x,org_rdir.x);
+            const ssef lclipMinY = msub(node->lowerY(i),rdir.y,org_rdir.y);
+            const ssef lclipMinZ = msub(node->lowerZ(i),rdir.z,org_rdir.z);
+            const ssef lclipMaxX = msub(node->upperX(i),rdir.x,org_rdir.x);
+            const ssef lclipMaxY = msub(node->upperY(i),rdir.y,org_rdir.y);
+            const ssef lclipMaxZ = msub(node->upperZ(i),rdir.z,org_rdir.z);
 #else
-            const ssef lclipMinX = (node->lower_x[i] - org.x) * rdir.x;
-            const ssef lclipMinY = (node->lower_y[i] - org.y) * rdir.y;
-            const ssef lclipMinZ = (node->lower_z[i] - org.z) * rdir.z;
-            const ssef lclipMaxX = (node->upper_x[i] - org.x) * rdir.x;
-            const ssef lclipMaxY = (node->upper_y[i] - org.y) * rdir.y;
-            const ssef lclipMaxZ = (node->upper_z[i] - org.z) * rdir.z;
+            const ssef lclipMinX = (node->lowerX(i) - org.x) * rdir.x;
+            const ssef lclipMinY = (node->lowerY(i) - org.y) * rdir.y;
+            const ssef lclipMinZ = (node->lowerZ(i) - org.z) * rdir.z;
+            const ssef lclipMaxX = (node->upperX(i) - org.x) * rdir.x;
+            const ssef lclipMaxY = (node->upperY(i) - org.y) * rdir.y;
+            const ssef lclipMaxZ = (node->upperZ(i) - org.z) * rdir.z;
 #endif
 
 #if defined(__SSE4_1__)
@@ -290,6 +302,8 @@ namespace embree
         const sseb valid_leaf = ray_tfar > curDist;
         STAT3(shadow.trav_leaves,1,popcnt(valid_leaf),4);
         size_t items; const Primitive* prim = (Primitive*) curNode.leaf(items);
+        STAT_SCENE(stats,leaves++);
+        STAT_SCENE(stats,prims += items);
         terminated |= PrimitiveIntersector4::occluded(!terminated,ray,prim,items,bvh->geometry);
         if (all(terminated)) break;
         ray_tfar = select(terminated,ssef(neg_inf),ray_tfar);
@@ -302,10 +316,15 @@ namespace embree
     DEFINE_INTERSECTOR4(BVH4Triangle4Intersector4ChunkMoeller, BVH4Intersector4Chunk<Triangle4Intersector4MoellerTrumbore>);
 #if defined (__AVX__)
     DEFINE_INTERSECTOR4(BVH4Triangle8Intersector4ChunkMoeller, BVH4Intersector4Chunk<Triangle8Intersector4MoellerTrumbore>);
+    DEFINE_INTERSECTOR4(BVH4Triangle8wIntersector4ChunkWoop, BVH4Intersector4Chunk<Triangle8wIntersector4Woop>);
 #endif
+    DEFINE_INTERSECTOR4(BVH4Triangle4wIntersector4ChunkWoop, BVH4Intersector4Chunk<Triangle4wIntersector4Woop>);
     DEFINE_INTERSECTOR4(BVH4Triangle1vIntersector4ChunkPluecker, BVH4Intersector4Chunk<Triangle1vIntersector4Pluecker>);
     DEFINE_INTERSECTOR4(BVH4Triangle4vIntersector4ChunkPluecker, BVH4Intersector4Chunk<Triangle4vIntersector4Pluecker>);
     DEFINE_INTERSECTOR4(BVH4Triangle4iIntersector4ChunkPluecker, BVH4Intersector4Chunk<Triangle4iIntersector4Pluecker>);
     DEFINE_INTERSECTOR4(BVH4VirtualIntersector4Chunk, BVH4Intersector4Chunk<VirtualAccelIntersector4>);
+
+    typedef BVH4Intersector4Chunk<Triangle4iIntersector4Pluecker,BVH4::CompressedNode> BVH4Triangle4iIntersector4ChunkPlueckerCompressedT;
+    DEFINE_INTERSECTOR4(BVH4Triangle4iIntersector4ChunkPlueckerCompressed, BVH4Triangle4iIntersector4ChunkPlueckerCompressedT);
   }
 }
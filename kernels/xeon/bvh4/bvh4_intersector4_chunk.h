@@ -25,13 +25,13 @@ namespace embree
   namespace isa 
   {
     /*! BVH4 packet traversal implementation. */
-    template<typename PrimitiveIntersector>
+    template<typename PrimitiveIntersector, typename NodeTy = BVH4::Node>
       class BVH4Intersector4Chunk
     {
       /* shortcuts for frequently used types */
       typedef typename PrimitiveIntersector::Primitive Primitive;
       typedef typename BVH4::NodeRef NodeRef;
-      typedef typename BVH4::Node Node;
+      typedef NodeTy Node;
       static const size_t stackSize = 4*BVH4::maxDepth+1;
       
     public:
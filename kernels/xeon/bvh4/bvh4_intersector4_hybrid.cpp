@@ -17,21 +17,27 @@
 #include "bvh4_intersector4_hybrid.h"
 
 #include "geometry/triangle4_intersector4_moeller.h"
+#include "geometry/triangle4w_intersector4_woop.h"
 #if defined (__AVX__)
 #include "geometry/triangle8_intersector4_moeller.h"
+#include "geometry/triangle8w_intersector4_woop.h"
 #endif
 #include "geometry/triangle4v_intersector4_pluecker.h"
+#include "geometry/triangle4q_intersector4_moeller.h"
+#include "geometry/quad4_intersector4_moeller.h"
+#include "geometry/bezier1_intersector4.h"
 
-#define SWITCH_THRESHOLD 3
+/*! cost of a packet node test relative to a single ray node test */
+#define SWITCH_COST 3.5f
 
 namespace embree
 {
   namespace isa
   {
-    template<typename PrimitiveIntersector4>
-    __forceinline void BVH4Intersector4Hybrid<PrimitiveIntersector4>::intersect1(const BVH4* bvh, NodeRef root, size_t k, Ray4& ray, 
+    template<typename PrimitiveIntersector4, typename NodeTy>
+    __forceinline void BVH4Intersector4Hybrid<PrimitiveIntersector4,NodeTy>::intersect1(const BVH4* bvh, NodeRef root, size_t k, Ray4& ray, 
                                                                                  const sse3f& ray_org, const sse3f& ray_dir, const sse3f& ray_rdir, 
-                                                                                 const ssef& ray_tnear, const ssef& ray_tfar)
+                                                                                 const ssef& ray_tnear, const ssef& ray_tfar, SceneStat::Counters* stats)
     {
       /*! stack state */
       StackItem stack[stackSizeSingle];  //!< stack of nodes 
@@ -69,24 +75,25 @@ namespace embree
           /*! stop if we found a leaf */
           if (unlikely(cur.isLeaf())) break;
           STAT3(normal.trav_nodes,1,1,1);
+          STAT_SCENE(stats,nodes++);
           
           /*! single ray intersection with 4 boxes */
-          const Node* node = cur.node();
+          const Node* node = (const Node*) cur.node();
           const size_t farX  = nearX ^ 16, farY  = nearY ^ 16, farZ  = nearZ ^ 16;
 #if defined (__AVX2__)
-          const ssef tNearX = msub(load4f((const char*)node+nearX), rdir.x, org_rdir.x);
-          const ssef tNearY = msub(load4f((const char*)node+nearY), rdir.y, org_rdir.y);
-          const ssef tNearZ = msub(load4f((const char*)node+nearZ), rdir.z, org_rdir.z);
-          const ssef tFarX  = msub(load4f((const char*)node+farX ), rdir.x, org_rdir.x);
-          const ssef tFarY  = msub(load4f((const char*)node+farY ), rdir.y, org_rdir.y);
-          const ssef tFarZ  = msub(load4f((const char*)node+farZ ), rdir.z, org_rdir.z);
+          const ssef tNearX = msub(node->plane(nearX), rdir.x, org_rdir.x);
+          const ssef tNearY = msub(node->plane(nearY), rdir.y, org_rdir.y);
+          const ssef tNearZ = msub(node->plane(nearZ), rdir.z, org_rdir.z);
+          const ssef tFarX  = msub(node->plane(farX ), rdir.x, org_rdir.x);
+          const ssef tFarY  = msub(node->plane(farY ), rdir.y, org_rdir.y);
+          const ssef tFarZ  = msub(node->plane(farZ ), rdir.z, org_rdir.z);
 #else
-          const ssef tNearX = (norg.x + load4f((const char*)node+nearX)) * rdir.x;
-          const ssef tNearY = (norg.y + load4f((const char*)node+nearY)) * rdir.y;
-          const ssef tNearZ = (norg.z + load4f((const char*)node+nearZ)) * rdir.z;
-          const ssef tFarX  = (norg.x + load4f((const char*)node+farX )) * rdir.x;
-          const ssef tFarY  = (norg.y + load4f((const char*)node+farY )) * rdir.y;
-          const ssef tFarZ  = (norg.z + load4f((const char*)node+farZ )) * rdir.z;
+          const ssef tNearX = (norg.x + node->plane(nearX)) * rdir.x;
+          const ssef tNearY = (norg.y + node->plane(nearY)) * rdir.y;
+          const ssef tNearZ = (norg.z + node->plane(nearZ)) * rdir.z;
+          const ssef tFarX  = (norg.x + node->plane(farX )) * rdir.x;
+          const ssef tFarY  = (norg.y + node->plane(farY )) * rdir.y;
+          const ssef tFarZ  = (norg.z + node->plane(farZ )) * rdir.z;
 #endif
 
 #if defined(__SSE4_1__)
@@ -155,13 +162,15 @@ namespace embree
         /*! this is a leaf node */
         STAT3(normal.trav_leaves,1,1,1);
         size_t num; Primitive* prim = (Primitive*) cur.leaf(num);
+        STAT_SCENE(stats,leaves++);
+        STAT_SCENE(stats,prims += num);
         PrimitiveIntersector4::intersect(ray,k,prim,num,bvh->geometry);
         rayFar = ray.tfar[k];
       }
     }
     
-    template<typename PrimitiveIntersector4>
-    void BVH4Intersector4Hybrid<PrimitiveIntersector4>::intersect(sseb* valid_i, BVH4* bvh, Ray4& ray)
+    template<typename PrimitiveIntersector4, typename NodeTy>
+    void BVH4Intersector4Hybrid<PrimitiveIntersector4,NodeTy>::intersect(sseb* valid_i, BVH4* bvh, Ray4& ray)
     {
       /* load ray */
       const sseb valid0 = *valid_i;
@@ -180,12 +189,20 @@ namespace embree
       ray_tfar  = select(valid0,ray_tfar ,ssef(neg_inf));
       const ssef inf = ssef(pos_inf);
       
+      /* runtime statistics */
+      SceneStat::Counters* stats = bvh->stat->thread();
+
+      /* some packets measure the node utilization for the adaptive switch to single ray traversal */
+      HybridSwitch::Sample sample(HybridSwitch::sample());
+      const size_t threshold = sample.enabled ? 0 : bvh->hybrid4.threshold(HybridSwitch::INTERSECT);
+      size_t numActive = 4;
+
       /* allocate stack and push root node */
       ssef    stack_near[stackSizeChunk]; 
       NodeRef stack_node[stackSizeChunk];
       stack_node[0] = BVH4::invalidNode;
       stack_near[0] = inf;
-      stack_node[1] = bvh->root;
+      stack_node[1] = bvh->getRoot();
       stack_near[1] = ray_tnear; 
       NodeRef* stackEnd = stack_node+stackSizeChunk;
       NodeRef* __restrict__ sptr_node = stack_node + 2;
@@ -212,9 +229,10 @@ namespace embree
         /* switch to single ray traversal */
 #if !defined(__WIN32__) || defined(__X86_64__)
         size_t bits = movemask(active);
-        if (unlikely(__popcnt(bits) <= SWITCH_THRESHOLD)) {
+        numActive = __popcnt(bits);
+        if (unlikely(numActive <= threshold)) {
           for (size_t i=__bsf(bits); bits!=0; bits=__btc(bits,i), i=__bsf(bits)) {
-            intersect1(bvh,curNode,i,ray,ray_org,ray_dir,rdir,ray_tnear,ray_tfar);
+            intersect1(bvh,curNode,i,ray,ray_org,ray_dir,rdir,ray_tnear,ray_tfar,stats);
           }
           ray_tfar = ray.tfar;
           continue;
@@ -229,7 +247,9 @@ namespace embree
           
           const sseb valid_node = ray_tfar > curDist;
           STAT3(normal.trav_nodes,1,popcnt(valid_node),4);
-          const Node* __restrict__ const node = curNode.node();
+          STAT_SCENE(stats,nodes++);
+          if (unlikely(sample.enabled)) sample.count(popcnt(valid_node),numActive);
+          const Node* __restrict__ const node = (const Node*) curNode.node();
           
           /* pop of next node */
           assert(sptr_node > stack_node);
@@ -245,19 +265,19 @@ namespace embree
             if (unlikely(child == BVH4::emptyNode)) break;
             
 #if defined(__AVX2__)
-            const ssef lclipMinX = msub(node->lower_x[i],rdir.x,org_rdir.x);
-            const ssef lclipMinY = msub(node->lower_y[i],rdir.y,org_rdir.y);
-            const ssef lclipMinZ = msub(node->lower_z[i],rdir.z,org_rdir.z);
-            const ssef lclipMaxX = msub(node->upper_x[i],rdir.x,org_rdir.x);
-            const ssef lclipMaxY = msub(node->upper_y[i],rdir.y,org_rdir.y);
-            const ssef lclipMaxZ = msub(node->upper_z[i],rdir.z,org_rdir.z);
+            const ssef lclipMinX = msub(node->lowerX(i),rdir.x,org_rdir.x);
+            const ssef lclipMinY = msub(node->lowerY(i),rdir.y,org_rdir.y);
+            const ssef lclipMinZ = msub(node->lowerZ(i),rdir.z,org_rdir.z);
+            const ssef lclipMaxX = msub(node->upperX(i),rdir.x,org_rdir.x);
+            const ssef lclipMaxY = msub(node->upperY(i),rdir.y,org_rdir.y);
+            const ssef lclipMaxZ = msub(node->upperZ(i),rdir.z,org_rdir.z);
 #else
-            const ssef lclipMinX = (node->lower_x[i] - org.x) * rdir.x;
-            const ssef lclipMinY = (node->lower_y[i] - org.y) * rdir.y;
-            const ssef lclipMinZ = (node->lower_z[i] - org.z) * rdir.z;
-            const ssef lclipMaxX = (node->upper_x[i] - org.x) * rdir.x;
-            const ssef lclipMaxY = (node->upper_y[i] - org.y) * rdir.y;
-            const ssef lclipMaxZ = (node->upper_z[i] - org.z) * rdir.z;
+            const ssef lclipMinX = (node->lowerX(i) - org.x) * rdir.x;
+            const ssef lclipMinY = (node->lowerY(i) - org.y) * rdir.y;
+            const ssef lclipMinZ = (node->lowerZ(i) - org.z) * rdir.z;
+            const ssef lclipMaxX = (node->upperX(i) - org.x) * rdir.x;
+            const ssef lclipMaxY = (node->upperY(i) - org.y) * rdir.y;
+            const ssef lclipMaxZ = (node->upperZ(i) - org.z) * rdir.z;
 #endif
     
 #if defined(__SSE4_1__)
@@ -309,16 +329,19 @@ namespace embree
         const sseb valid_leaf = ray_tfar > curDist;
         STAT3(normal.trav_leaves,1,popcnt(valid_leaf),4);
         size_t items; const Primitive* prim = (Primitive*) curNode.leaf(items);
+        STAT_SCENE(stats,leaves++);
+        STAT_SCENE(stats,prims += items);
         PrimitiveIntersector4::intersect(valid_leaf,ray,prim,items,bvh->geometry);
         ray_tfar = select(valid_leaf,ray.tfar,ray_tfar);
       }
+      if (unlikely(sample.enabled)) bvh->hybrid4.update(HybridSwitch::INTERSECT,sample,SWITCH_COST);
       AVX_ZERO_UPPER();
     }
 
-    template<typename PrimitiveIntersector4>
-    __forceinline bool BVH4Intersector4Hybrid<PrimitiveIntersector4>::occluded1(const BVH4* bvh, NodeRef root, size_t k, Ray4& ray, 
+    template<typename PrimitiveIntersector4, typename NodeTy>
+    __forceinline bool BVH4Intersector4Hybrid<PrimitiveIntersector4,NodeTy>::occluded1(const BVH4* bvh, NodeRef root, size_t k, Ray4& ray, 
                                                                                 const sse3f& ray_org, const sse3f& ray_dir, const sse3f& ray_rdir, 
-                                                                                const ssef& ray_tnear, const ssef& ray_tfar)
+                                                                                const ssef& ray_tnear, const ssef& ray_tfar, SceneStat::Counters* stats)
     {
       /*! stack state */
       NodeRef stack[stackSizeSingle];  //!< stack of nodes that still need to get traversed
@@ -351,24 +374,25 @@ namespace embree
           /*! stop if we found a leaf */
           if (unlikely(cur.isLeaf())) break;
           STAT3(shadow.trav_nodes,1,1,1);
+          STAT_SCENE(stats,nodes++);
           
           /*! single ray intersection with 4 boxes */
-          const Node* node = cur.node();
+          const Node* node = (const Node*) cur.node();
           const size_t farX  = nearX ^ 16, farY  = nearY ^ 16, farZ  = nearZ ^ 16;
 #if defined (__AVX2__)
-          const ssef tNearX = msub(load4f((const char*)node+nearX), rdir.x, org_rdir.x);
-          const ssef tNearY = msub(load4f((const char*)node+nearY), rdir.y, org_rdir.y);
-          const ssef tNearZ = msub(load4f((const char*)node+nearZ), rdir.z, org_rdir.z);
-          const ssef tFarX  = msub(load4f((const char*)node+farX ), rdir.x, org_rdir.x);
-          const ssef tFarY  = msub(load4f((const char*)node+farY ), rdir.y, org_rdir.y);
-          const ssef tFarZ  = msub(load4f((const char*)node+farZ ), rdir.z, org_rdir.z);
+          const ssef tNearX = msub(node->plane(nearX), rdir.x, org_rdir.x);
+          const ssef tNearY = msub(node->plane(nearY), rdir.y, org_rdir.y);
+          const ssef tNearZ = msub(node->plane(nearZ), rdir.z, org_rdir.z);
+          const ssef tFarX  = msub(node->plane(farX ), rdir.x, org_rdir.x);
+          const ssef tFarY  = msub(node->plane(farY ), rdir.y, org_rdir.y);
+          const ssef tFarZ  = msub(node->plane(farZ ), rdir.z, org_rdir.z);
 #else
-          const ssef tNearX = (norg.x + load4f((const char*)node+nearX)) * rdir.x;
-          const ssef tNearY = (norg.y + load4f((const char*)node+nearY)) * rdir.y;
-          const ssef tNearZ = (norg.z + load4f((const char*)node+nearZ)) * rdir.z;
-          const ssef tFarX  = (norg.x + load4f((const char*)node+farX )) * rdir.x;
-          const ssef tFarY  = (norg.y + load4f((const char*)node+farY )) * rdir.y;
-          const ssef tFarZ  = (norg.z + load4f((const char*)node+farZ )) * rdir.z;
+          const ssef tNearX = (norg.x + node->plane(nearX)) * rdir.x;
+          const ssef tNearY = (norg.y + node->plane(nearY)) * rdir.y;
+          const ssef tNearZ = (norg.z + node->plane(nearZ)) * rdir.z;
+          const ssef tFarX  = (norg.x + node->plane(farX )) * rdir.x;
+          const ssef tFarY  = (norg.y + node->plane(farY )) * rdir.y;
+          const ssef tFarZ  = (norg.z + node->plane(farZ )) * rdir.z;
 #endif
           
 #if defined(__SSE4_1__)
@@ -427,6 +451,8 @@ namespace embree
         /*! this is a leaf node */
         STAT3(shadow.trav_leaves,1,1,1);
         size_t num; Primitive* prim = (Primitive*) cur.leaf(num);
+        STAT_SCENE(stats,leaves++);
+        STAT_SCENE(stats,prims += num);
         if (PrimitiveIntersector4::occluded(ray,k,prim,num,bvh->geometry)) {
           ray.geomID[k] = 0;
           return true;
@@ -435,8 +461,8 @@ namespace embree
       return false;
     }
     
-    template<typename PrimitiveIntersector4>
-    void BVH4Intersector4Hybrid<PrimitiveIntersector4>::occluded(sseb* valid_i, BVH4* bvh, Ray4& ray)
+    template<typename PrimitiveIntersector4, typename NodeTy>
+    void BVH4Intersector4Hybrid<PrimitiveIntersector4,NodeTy>::occluded(sseb* valid_i, BVH4* bvh, Ray4& ray)
     {
       /* load ray */
       const sseb valid = *valid_i;
@@ -456,12 +482,20 @@ namespace embree
       ray_tfar  = select(valid,ray_tfar ,ssef(neg_inf));
       const ssef inf = ssef(pos_inf);
       
+      /* runtime statistics */
+      SceneStat::Counters* stats = bvh->stat->thread();
+
+      /* some packets measure the node utilization for the adaptive switch to single ray traversal */
+      HybridSwitch::Sample sample(HybridSwitch::sample());
+      const size_t threshold = sample.enabled ? 0 : bvh->hybrid4.threshold(HybridSwitch::OCCLUDED);
+      size_t numActive = 4;
+
       /* allocate stack and push root node */
       ssef    stack_near[stackSizeChunk];
       NodeRef stack_node[stackSizeChunk];
       stack_node[0] = BVH4::invalidNode;
       stack_near[0] = inf;
-      stack_node[1] = bvh->root;
+      stack_node[1] = bvh->getRoot();
       stack_near[1] = ray_tnear; 
       NodeRef* stackEnd = stack_node+stackSizeChunk;
       NodeRef* __restrict__ sptr_node = stack_node + 2;
@@ -488,9 +522,10 @@ namespace embree
         /* switch to single ray traversal */
 #if !defined(__WIN32__) || defined(__X86_64__)
         size_t bits = movemask(active);
-        if (unlikely(__popcnt(bits) <= SWITCH_THRESHOLD)) {
+        numActive = __popcnt(bits);
+        if (unlikely(numActive <= threshold)) {
           for (size_t i=__bsf(bits); bits!=0; bits=__btc(bits,i), i=__bsf(bits)) {
-            if (occluded1(bvh,curNode,i,ray,ray_org,ray_dir,rdir,ray_tnear,ray_tfar))
+            if (occluded1(bvh,curNode,i,ray,ray_org,ray_dir,rdir,ray_tnear,ray_tfar,stats))
               terminated[i] = -1;
           }
           if (all(terminated)) break;
@@ -507,7 +542,9 @@ namespace embree
           
           const sseb valid_node = ray_tfar > curDist;
           STAT3(shadow.trav_nodes,1,popcnt(valid_node),4);
-          const Node* __restrict__ const node = curNode.node();
+          STAT_SCENE(stats,nodes++);
+          if (unlikely(sample.enabled)) sample.count(popcnt(valid_node),numActive);
+          const Node* __restrict__ const node = (const Node*) curNode.node();
           
           /* pop of next node */
           assert(sptr_node > stack_node);
@@ -523,19 +560,19 @@ namespace embree
             if (unlikely(child == BVH4::emptyNode)) break;
             
 #if defined(__AVX2__)
-            const ssef lclipMinX = msub(node->lower_x[i],rdir.x,org_rdir.x);
-            const ssef lclipMinY = msub(node->lower_y[i],rdir.y,org_rdir.y);
-            const ssef lclipMinZ = msub(node->lower_z[i],rdir.z,org_rdir.z);
-            const ssef lclipMaxX = msub(node->upper_x[i],rdir.x,org_rdir.x);
-            const ssef lclipMaxY = msub(node->upper_y[i],rdir.y,org_rdir.y);
-            const ssef lclipMaxZ = msub(node->upper_z[i],rdir.z,org_rdir.z);
+            const ssef lclipMinX = msub(node->lowerX(i),rdir.x,org_rdir.x);
+            const ssef lclipMinY = msub(node->lowerY(i),rdir.y,org_rdir.y);
+            const ssef lclipMinZ = msub(node->lowerZ(i),rdir.z,org_rdir.z);
+            const ssef lclipMaxX = msub(node->upperX(i),rdir.x,org_rdir.x);
+            const ssef lclipMaxY = msub(node->upperY(i),rdir.y,org_rdir.y);
+            const ssef lclipMaxZ = msub(node->upperZ(i),rdir.z,org_rdir.z);
 #else
-            const ssef lclipMinX = (node->lower_x[i] - org.x) * rdir.x;
-            const ssef lclipMinY = (node->lower_y[i] - org.y) * rdir.y;
-            const ssef lclipMinZ = (node->lower_z[i] - org.z) * rdir.z;
-            const ssef lclipMaxX = (node->upper_x[i] - org.x) * rdir.x;
-            const ssef lclipMaxY = (node->upper_y[i] - org.y) * rdir.y;
-            const ssef lclipMaxZ = (node->upper_z[i] - org.z) * rdir.z;
+            const ssef lclipMinX = (node->lowerX(i) - org.x) * rdir.x;
+            const ssef lclipMinY = (node->lowerY(i) - org.y) * rdir.y;
+            const ssef lclipMinZ = (node->lowerZ(i) - org.z) * rdir.z;
+            const ssef lclipMaxX = (node->upperX(i) - org.x) * rdir.x;
+            const ssef lclipMaxY = (node->upperY(i) - org.y) * rdir.y;
+            const ssef lclipMaxZ = (node->upperZ(i) - org.z) * rdir.z;
 #endif
     
 #if defined(__SSE4_1__)
@@ -586,18 +623,31 @@ namespace embree
         const sseb valid_leaf = ray_tfar > curDist;
         STAT3(shadow.trav_leaves,1,popcnt(valid_leaf),4);
         size_t items; const Primitive* prim = (Primitive*) curNode.leaf(items);
+        STAT_SCENE(stats,leaves++);
+        STAT_SCENE(stats,prims += items);
         terminated |= PrimitiveIntersector4::occluded(!terminated,ray,prim,items,bvh->geometry);
         if (all(terminated)) break;
         ray_tfar = select(terminated,ssef(neg_inf),ray_tfar);
       }
       store4i(valid & terminated,&ray.geomID,0);
+      if (unlikely(sample.enabled)) bvh->hybrid4.update(HybridSwitch::OCCLUDED,sample,SWITCH_COST);
       AVX_ZERO_UPPER();
     }
     
     DEFINE_INTERSECTOR4(BVH4Triangle4Intersector4HybridMoeller, BVH4Intersector4Hybrid<Triangle4Intersector4MoellerTrumbore>);
 #if defined (__AVX__)
     DEFINE_INTERSECTOR4(BVH4Triangle8Intersector4HybridMoeller, BVH4Intersector4Hybrid<Triangle8Intersector4MoellerTrumbore>);
+    DEFINE_INTERSECTOR4(BVH4Triangle8wIntersector4HybridWoop, BVH4Intersector4Hybrid<Triangle8wIntersector4Woop>);
 #endif
+    DEFINE_INTERSECTOR4(BVH4Triangle4wIntersector4HybridWoop, BVH4Intersector4Hybrid<Triangle4wIntersector4Woop>);
     DEFINE_INTERSECTOR4(BVH4Triangle4vIntersector4HybridPluecker, BVH4Intersector4Hybrid<Triangle4vIntersector4Pluecker>);
+    DEFINE_INTERSECTOR4(BVH4Triangle4qIntersector4HybridMoeller, BVH4Intersector4Hybrid<Triangle4qIntersector4MoellerTrumbore>);
+    DEFINE_INTERSECTOR4(BVH4Quad4Intersector4HybridMoeller, BVH4Intersector4Hybrid<Quad4Intersector4MoellerTrumbore>);
+    DEFINE_INTERSECTOR4(BVH4Bezier1Intersector4Hybrid, BVH4Intersector4Hybrid<Bezier1Intersector4>);
+
+    typedef BVH4Intersector4Hybrid<Triangle4Intersector4MoellerTrumbore,BVH4::CompressedNode> BVH4Triangle4Intersector4HybridMoellerCompressedT;
+    DEFINE_INTERSECTOR4(BVH4Triangle4Intersector4HybridMoellerCompressed, BVH4Triangle4Intersector4HybridMoellerCompressedT);
+    typedef BVH4Intersector4Hybrid<Triangle4qIntersector4MoellerTrumbore,BVH4::CompressedNode> BVH4Triangle4qIntersector4HybridMoellerCompressedT;
+    DEFINE_INTERSECTOR4(BVH4Triangle4qIntersector4HybridMoellerCompressed, BVH4Triangle4qIntersector4HybridMoellerCompressedT);
   }
 }
@@ -19,6 +19,8 @@
 #include "geometry/triangle1_intersector8_moeller.h"
 #include "geometry/triangle4_intersector8_moeller.h"
 #include "geometry/triangle8_intersector8_moeller.h"
+#include "geometry/triangle4w_intersector8_woop.h"
+#include "geometry/triangle8w_intersector8_woop.h"
 #include "geometry/triangle1v_intersector8_pluecker.h"
 #include "geometry/triangle4v_intersector8_pluecker.h"
 #include "geometry/triangle4i_intersector8.h"
@@ -28,8 +30,8 @@ namespace embree
 {
   namespace isa
   {
-    template<typename PrimitiveIntersector8>
-    void BVH4Intersector8Chunk<PrimitiveIntersector8>::intersect(avxb* valid_i, BVH4* bvh, Ray8& ray)
+    template<typename PrimitiveIntersector8, typename NodeTy>
+    void BVH4Intersector8Chunk<PrimitiveIntersector8,NodeTy>::intersect(avxb* valid_i, BVH4* bvh, Ray8& ray)
     {
       /* load ray */
       const avxb valid0 = *valid_i;
@@ -39,12 +41,15 @@ namespace embree
       avxf ray_tfar  = select(valid0,ray.tfar ,neg_inf);
       const avxf inf = avxf(pos_inf);
       
+      /* runtime statistics */
+      SceneStat::Counters* stats = bvh->stat->thread();
+
       /* allocate stack and push root node */
       avxf    stack_near[stackSize];
       NodeRef stack_node[stackSize];
       stack_node[0] = BVH4::invalidNode;
       stack_near[0] = inf;
-      stack_node[1] = bvh->root;
+      stack_node[1] = bvh->getRoot();
       stack_near[1] = ray_tnear; 
       NodeRef* stackEnd = stack_node+stackSize;
       NodeRef* __restrict__ sptr_node = stack_node + 2;
@@ -75,7 +80,8 @@ namespace embree
           
           const avxb valid_node = ray_tfar > curDist;
           STAT3(normal.trav_nodes,1,popcnt(valid_node),8);
-          const Node* __restrict__ const node = curNode.node();
+          STAT_SCENE(stats,nodes++);
+          const Node* __restrict__ const node = (const Node*) curNode.node();
           
           /* pop of next node */
           assert(sptr_node > stack_node);
@@ -91,22 +97,22 @@ namespace embree
             if (unlikely(child == BVH4::emptyNode)) break;
             
 #if defined(__AVX2__)
-            const avxf lclipMinX = msub(node->lower_x[i],rdir.x,org_rdir.x);
-            const avxf lclipMinY = msub(node->lower_y[i],rdir.y,org_rdir.y);
-            const avxf lclipMinZ = msub(node->lower_z[i],rdir.z,org_rdir.z);
-            const avxf lclipMaxX = msub(node->upper_x[i],rdir.x,org_rdir.x);
-            const avxf lclipMaxY = msub(node->upper_y[i],rdir.y,org_rdir.y);
-            const avxf lclipMaxZ = msub(node->upper_z[i],rdir.z,org_rdir.z);
+            const avxf lclipMinX = msub(node->lowerX(i),rdir.x,org_rdir.x);
+            const avxf lclipMinY = msub(node->lowerY(i),rdir.y,org_rdir.y);
+            const avxf lclipMinZ = msub(node->lowerZ(i),rdir.z,org_rdir.z);
+            const avxf lclipMaxX = msub(node->upperX(i),rdir.x,org_rdir.x);
+            const avxf lclipMaxY = msub(node->upperY(i),rdir.y,org_rdir.y);
+            const avxf lclipMaxZ = msub(node->upperZ(i),rdir.z,org_rdir.z);
             const avxf lnearP = maxi(maxi(mini(lclipMinX, lclipMaxX), mini(lclipMinY, lclipMaxY)), mini(lclipMinZ, lclipMaxZ));
             const avxf lfarP  = mini(mini(maxi(lclipMinX, lclipMaxX), maxi(lclipMinY, lclipMaxY)), maxi(lclipMinZ, lclipMaxZ));
             const avxb lhit   = maxi(lnearP,ray_tnear) <= mini(lfarP,ray_tfar);      
 #else
-            const avxf lclipMinX = (node->lower_x[i] - org.x) * rdir.x;
-            const avxf lclipMinY = (node->lower_y[i] - org.y) * rdir.y;
-            const avxf lclipMinZ = (node->lower_z[i] - org.z) * rdir.z;
-            const avxf lclipMaxX = (node->upper_x[i] - org.x) * rdir.x;
-            const avxf lclipMaxY = (node->upper_y[i] - org.y) * rdir.y;
-            const avxf lclipMaxZ = (node->upper_z[i] - org.z) * rdir.z;
+            const avxf lclipMinX = (node->lowerX(i) - org.x) * rdir.x;
+            const avxf lclipMinY = (node->lowerY(i) - org.y) * rdir.y;
+            const avxf lclipMinZ = (node->lowerZ(i) - org.z) * rdir.z;
+            const avxf lclipMaxX = (node->upperX(i) - org.x) * rdir.x;
+            const avxf lclipMaxY = (node->upperY(i) - org.y) * rdir.y;
+            const avxf lclipMaxZ = (node->upperZ(i) - org.z) * rdir.z;
             const avxf lnearP = max(max(min(lclipMinX, lclipMaxX), min(lclipMinY, lclipMaxY)), min(lclipMinZ, lclipMaxZ));
             const avxf lfarP  = min(min(max(lclipMinX, lclipMaxX), max(lclipMinY, lclipMaxY)), max(lclipMinZ, lclipMaxZ));
             const avxb lhit   = max(lnearP,ray_tnear) <= min(lfarP,ray_tfar);      
@@ -150,14 +156,16 @@ namespace embree
         const avxb valid_leaf = ray_tfar > curDist;
         STAT3(normal.trav_leaves,1,popcnt(valid_leaf),8);
         size_t items; const Primitive* prim = (Primitive*) curNode.leaf(items);
+        STAT_SCENE(stats,leaves++);
+        STAT_SCENE(stats,prims += items);
         PrimitiveIntersector8::intersect(valid_leaf,ray,prim,items,bvh->geometry);
         ray_tfar = select(valid_leaf,ray.tfar,ray_tfar);
       }
       AVX_ZERO_UPPER();
     }
     
-    template<typename PrimitiveIntersector8>
-    void BVH4Intersector8Chunk<PrimitiveIntersector8>::occluded(avxb* valid_i, BVH4* bvh, Ray8& ray)
+    template<typename PrimitiveIntersector8, typename NodeTy>
+    void BVH4Intersector8Chunk<PrimitiveIntersector8,NodeTy>::occluded(avxb* valid_i, BVH4* bvh, Ray8& ray)
     {
       /* load ray */
       const avxb valid = *valid_i;
@@ -168,12 +176,15 @@ namespace embree
       avxf ray_tfar  = select(valid,ray.tfar ,neg_inf);
       const avxf inf = avxf(pos_inf);
       
+      /* runtime statistics */
+      SceneStat::Counters* stats = bvh->stat->thread();
+
       /* allocate stack and push root node */
       avxf    stack_near[stackSize];
       NodeRef stack_node[stackSize];
       stack_node[0] = BVH4::invalidNode;
       stack_near[0] = inf;
-      stack_node[1] = bvh->root;
+      stack_node[1] = bvh->getRoot();
       stack_near[1] = ray_tnear; 
       NodeRef* stackEnd = stack_node+stackSize;
       NodeRef* __restrict__ sptr_node = stack_node + 2;
@@ -204,7 +215,8 @@ namespace embree
           
           const avxb valid_node = ray_tfar > curDist;
           STAT3(shadow.trav_nodes,1,popcnt(valid_node),8);
-          const Node* __restrict__ const node = curNode.node();
+          STAT_SCENE(stats,nodes++);
+          const Node* __restrict__ const node = (const Node*) curNode.node();
           
           /* pop of next node */
           assert(sptr_node > stack_node);
@@ -220,22 +232,22 @@ namespace embree
             if (unlikely(child == BVH4::emptyNode)) break;
             
 #if defined(__AVX2__)
-            const avxf lclipMinX = msub(node->lower_x[i],rdir.x,org_rdir.x);
-            const avxf lclipMinY = msub(node->lower_y[i],rdir.y,org_rdir.y);
-            const avxf lclipMinZ = msub(node->lower_z[i],rdir.z,org_rdir.z);
-            const avxf lclipMaxX = msub(node->upper_x[i],rdir.x,org_rdir.x);
-            const avxf lclipMaxY = msub(node->upper_y[i],rdir.y,org_rdir.y);
-            const avxf lclipMaxZ = msub(node->upper_z[i],rdir.z,org_rdir.z);
+            const avxf lclipMinX = msub(node->lowerX(i),rdir.x,org_rdir.x);
+            const avxf lclipMinY = msub(node->lowerY(i),rdir.y,org_rdir.y);
+            const avxf lclipMinZ = msub(node->lowerZ(i),rdir.z,org_rdir.z);
+            const avxf lclipMaxX = msub(node->upperX(i),rdir.x,org_rdir.x);
+            const avxf lclipMaxY = msub(node->upperY(i),rdir.y,org_rdir.y);
+            const avxf lclipMaxZ = msub(node->upperZ(i),rdir.z,org_rdir.z);
             const avxf lnearP = maxi(maxi(mini(lclipMinX, lclipMaxX), mini(lclipMinY, lclipMaxY)), mini(lclipMinZ, lclipMaxZ));
             const avxf lfarP  = mini(mini(maxi(lclipMinX, lclipMaxX), maxi(lclipMinY, lclipMaxY)), maxi(lclipMinZ, lclipMaxZ));
             const avxb lhit   = maxi(lnearP,ray_tnear) <= mini(lfarP,ray_tfar);      
 #else
-            const avxf lclipMinX = (node->lower_x[i] - org.x) * rdir.x;
-            const avxf lclipMinY = (node->lower_y[i] - org.y) * rdir.y;
-            const avxf lclipMinZ = (node->lower_z[i] - org.z) * rdir.z;
-            const avxf lclipMaxX = (node->upper_x[i] - org.x) * rdir.x;
-            const avxf lclipMaxY = (node->upper_y[i] - org.y) * rdir.y;
-            const avxf lclipMaxZ = (node->upper_z[i] - org.z) * rdir.z;
+            const avxf lclipMinX = (node->lowerX(i) - org.x) * rdir.x;
+            const avxf lclipMinY = (node->lowerY(i) - org.y) * rdir.y;
+            const avxf lclipMinZ = (node->lowerZ(i) - org.z) * rdir.z;
+            const avxf lclipMaxX = (node->upperX(i) - org.x) * rdir.x;
+            const avxf lclipMaxY = (node->upperY(i) - org.y) * rdir.y;
+            const avxf lclipMaxZ = (node->upperZ(i) - org.z) * rdir.z;
             const avxf lnearP = max(max(min(lclipMinX, lclipMaxX), min(lclipMinY, lclipMaxY)), min(lclipMinZ, lclipMaxZ));
             const avxf lfarP  = min(min(max(lclipMinX, lclipMaxX), max(lclipMinY, lclipMaxY)), max(lclipMinZ, lclipMaxZ));
             const avxb lhit   = max(lnearP,ray_tnear) <= min(lfarP,ray_tfar);      
@@ -279,6 +291,8 @@ namespace embree
         const avxb valid_leaf = ray_tfar > curDist;
         STAT3(shadow.trav_leaves,1,popcnt(valid_leaf),8);
         size_t items; const Primitive* prim = (Primitive*) curNode.leaf(items);
+        STAT_SCENE(stats,leaves++);
+        STAT_SCENE(stats,prims += items);
         terminated |= valid_leaf & PrimitiveIntersector8::occluded(valid_leaf,ray,prim,items,bvh->geometry);
         if (all(terminated)) break;
         ray_tfar = select(terminated,neg_inf,ray_tfar);
@@ -290,9 +304,14 @@ namespace embree
     DEFINE_INTERSECTOR8(BVH4Triangle1Intersector8ChunkMoeller, BVH4Intersector8Chunk<Triangle1Intersector8MoellerTrumbore>);
     DEFINE_INTERSECTOR8(BVH4Triangle4Intersector8ChunkMoeller, BVH4Intersector8Chunk<Triangle4Intersector8MoellerTrumbore>);
     DEFINE_INTERSECTOR8(BVH4Triangle8Intersector8ChunkMoeller, BVH4Intersector8Chunk<Triangle8Intersector8MoellerTrumbore>);
+    DEFINE_INTERSECTOR8(BVH4Triangle4wIntersector8ChunkWoop, BVH4Intersector8Chunk<Triangle4wIntersector8Woop>);
+    DEFINE_INTERSECTOR8(BVH4Triangle8wIntersector8ChunkWoop, BVH4Intersector8Chunk<Triangle8wIntersector8Woop>);
     DEFINE_INTERSECTOR8(BVH4Triangle1vIntersector8ChunkPluecker, BVH4Intersector8Chunk<Triangle1vIntersector8Pluecker>);
     DEFINE_INTERSECTOR8(BVH4Triangle4vIntersector8ChunkPluecker, BVH4Intersector8Chunk<Triangle4vIntersector8Pluecker>);
     DEFINE_INTERSECTOR8(BVH4Triangle4iIntersector8ChunkPluecker, BVH4Intersector8Chunk<Triangle4iIntersector8Pluecker>);
     DEFINE_INTERSECTOR8(BVH4VirtualIntersector8Chunk, BVH4Intersector8Chunk<VirtualAccelIntersector8>);
+
+    typedef BVH4Intersector8Chunk<Triangle4iIntersector8Pluecker,BVH4::CompressedNode> BVH4Triangle4iIntersector8ChunkPlueckerCompressedT;
+    DEFINE_INTERSECTOR8(BVH4Triangle4iIntersector8ChunkPlueckerCompressed, BVH4Triangle4iIntersector8ChunkPlueckerCompressedT);
   }
 }
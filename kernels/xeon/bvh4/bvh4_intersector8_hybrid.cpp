@@ -18,17 +18,23 @@
 
 #include "geometry/triangle4_intersector8_moeller.h"
 #include "geometry/triangle8_intersector8_moeller.h"
+#include "geometry/triangle4w_intersector8_woop.h"
+#include "geometry/triangle8w_intersector8_woop.h"
 #include "geometry/triangle4v_intersector8_pluecker.h"
+#include "geometry/triangle4q_intersector8_moeller.h"
+#include "geometry/quad4_intersector8_moeller.h"
+#include "geometry/bezier1_intersector8.h"
 
-#define SWITCH_THRESHOLD 6
+/*! cost of a packet node test relative to a single ray node test */
+#define SWITCH_COST 5.5f
 #define ENABLE_PREFETCHING
 
 namespace embree
 {
   namespace isa
   {
-    template<typename PrimitiveIntersector8>
-    __forceinline void BVH4Intersector8Hybrid<PrimitiveIntersector8>::intersect1(const BVH4* bvh, NodeRef root, const size_t k, Ray8& ray,const avx3f &ray_org, const avx3f &ray_dir, const avx3f &ray_rdir, const avxf &ray_tnear, const avxf &ray_tfar, const avx3i& nearXYZ)
+    template<typename PrimitiveIntersector8, typename NodeTy>
+    __forceinline void BVH4Intersector8Hybrid<PrimitiveIntersector8,NodeTy>::intersect1(const BVH4* bvh, NodeRef root, const size_t k, Ray8& ray,const avx3f &ray_org, const avx3f &ray_dir, const avx3f &ray_rdir, const avxf &ray_tnear, const avxf &ray_tfar, const avx3i& nearXYZ, SceneStat::Counters* stats)
     {
       /*! stack state */
       StackItemInt32<NodeRef> stack[stackSizeSingle];  //!< stack of nodes 
@@ -66,24 +72,25 @@ namespace embree
           /*! stop if we found a leaf */
           if (unlikely(cur.isLeaf())) break;
           STAT3(normal.trav_nodes,1,1,1);
+          STAT_SCENE(stats,nodes++);
           
           /*! single ray intersection with 4 boxes */
-          const Node* node = cur.node();
+          const Node* node = (const Node*) cur.node();
           const size_t farX  = nearX ^ 16, farY  = nearY ^ 16, farZ  = nearZ ^ 16;
 #if defined (__AVX2__)
-          const ssef tNearX = msub(load4f((const char*)node+nearX), rdir.x, org_rdir.x);
-          const ssef tNearY = msub(load4f((const char*)node+nearY), rdir.y, org_rdir.y);
-          const ssef tNearZ = msub(load4f((const char*)node+nearZ), rdir.z, org_rdir.z);
-          const ssef tFarX  = msub(load4f((const char*)node+farX ), rdir.x, org_rdir.x);
-          const ssef tFarY  = msub(load4f((const char*)node+farY ), rdir.y, org_rdir.y);
-          const ssef tFarZ  = msub(load4f((const char*)node+farZ ), rdir.z, org_rdir.z);
+          const ssef tNearX = msub(node->plane(nearX), rdir.x, org_rdir.x);
+          const ssef tNearY = msub(node->plane(nearY), rdir.y, org_rdir.y);
+          const ssef tNearZ = msub(node->plane(nearZ), rdir.z, org_rdir.z);
+          const ssef tFarX  = msub(node->plane(farX ), rdir.x, org_rdir.x);
+          const ssef tFarY  = msub(node->plane(farY ), rdir.y, org_rdir.y);
+          const ssef tFarZ  = msub(node->plane(farZ ), rdir.z, org_rdir.z);
 #else
-          const ssef tNearX = (load4f((const char*)node+nearX) - org.x) * rdir.x;
-          const ssef tNearY = (load4f((const char*)node+nearY) - org.y) * rdir.y;
-          const ssef tNearZ = (load4f((const char*)node+nearZ) - org.z) * rdir.z;
-          const ssef tFarX  = (load4f((const char*)node+farX ) - org.x) * rdir.x;
-          const ssef tFarY  = (load4f((const char*)node+farY ) - org.y) * rdir.y;
-          const ssef tFarZ  = (load4f((const char*)node+farZ ) - org.z) * rdir.z;
+          const ssef tNearX = (node->plane(nearX) - org.x) * rdir.x;
+          const ssef tNearY = (node->plane(nearY) - org.y) * rdir.y;
+          const ssef tNearZ = (node->plane(nearZ) - org.z) * rdir.z;
+          const ssef tFarX  = (node->plane(farX ) - org.x) * rdir.x;
+          const ssef tFarY  = (node->plane(farY ) - org.y) * rdir.y;
+          const ssef tFarZ  = (node->plane(farZ ) - org.z) * rdir.z;
 #endif
 
 #if defined(__SSE4_1__)
@@ -162,14 +169,16 @@ namespace embree
         /*! this is a leaf node */
         STAT3(normal.trav_leaves,1,1,1);
         size_t num; Primitive* prim = (Primitive*) cur.leaf(num);
+        STAT_SCENE(stats,leaves++);
+        STAT_SCENE(stats,prims += num);
         PrimitiveIntersector8::intersect(ray,k,prim,num,bvh->geometry);
         rayFar = ray.tfar[k];
       }
       AVX_ZERO_UPPER();
     }
     
-    template<typename PrimitiveIntersector8>
-    void BVH4Intersector8Hybrid<PrimitiveIntersector8>::intersect(avxb* valid_i, BVH4* bvh, Ray8& ray)
+    template<typename PrimitiveIntersector8, typename NodeTy>
+    void BVH4Intersector8Hybrid<PrimitiveIntersector8,NodeTy>::intersect(avxb* valid_i, BVH4* bvh, Ray8& ray)
     {
       /* load ray */
       const avxb valid0 = *valid_i;
@@ -195,12 +204,20 @@ namespace embree
       nearXYZ.y = select(rdir.y >= 0.0f,avxi(2*(int)sizeof(ssef)),avxi(3*(int)sizeof(ssef)));
       nearXYZ.z = select(rdir.z >= 0.0f,avxi(4*(int)sizeof(ssef)),avxi(5*(int)sizeof(ssef)));
 
+      /* runtime statistics */
+      SceneStat::Counters* stats = bvh->stat->thread();
+
+      /* some packets measure the node utilization for the adaptive switch to single ray traversal */
+      HybridSwitch::Sample sample(HybridSwitch::sample());
+      const size_t threshold = sample.enabled ? 0 : bvh->hybrid8.threshold(HybridSwitch::INTERSECT);
+      size_t numActive = 8;
+
       /* allocate stack and push root node */
       avxf    stack_near[stackSizeChunk];
       NodeRef stack_node[stackSizeChunk];
       stack_node[0] = BVH4::invalidNode;
       stack_near[0] = inf;
-      stack_node[1] = bvh->root;
+      stack_node[1] = bvh->getRoot();
       stack_near[1] = ray_tnear; 
       NodeRef* stackEnd = stack_node+stackSizeChunk;
       NodeRef* __restrict__ sptr_node = stack_node + 2;
@@ -227,9 +244,10 @@ namespace embree
         /* switch to single ray traversal */
 #if !defined(__WIN32__) || defined(__X86_64__)
         size_t bits = movemask(active);
-        if (unlikely(__popcnt(bits) <= SWITCH_THRESHOLD)) {
+        numActive = __popcnt(bits);
+        if (unlikely(numActive <= threshold)) {
           for (size_t i=__bsf(bits); bits!=0; bits=__btc(bits,i), i=__bsf(bits)) {
-            intersect1(bvh,curNode,i,ray,ray_org,ray_dir,rdir,ray_tnear,ray_tfar,nearXYZ);
+            intersect1(bvh,curNode,i,ray,ray_org,ray_dir,rdir,ray_tnear,ray_tfar,nearXYZ,stats);
           }
           ray_tfar = ray.tfar;
           continue;
@@ -244,7 +262,9 @@ namespace embree
           
           const avxb valid_node = ray_tfar > curDist;
           STAT3(normal.trav_nodes,1,popcnt(valid_node),8);
-          const Node* __restrict__ const node = curNode.node();
+          STAT_SCENE(stats,nodes++);
+          if (unlikely(sample.enabled)) sample.count(popcnt(valid_node),numActive);
+          const Node* __restrict__ const node = (const Node*) curNode.node();
           
           /* pop of next node */
           assert(sptr_node > stack_node);
@@ -259,22 +279,22 @@ namespace embree
             if (unlikely(child == BVH4::emptyNode)) break;
             
 #if defined(__AVX2__)
-            const avxf lclipMinX = msub(node->lower_x[i],rdir.x,org_rdir.x);
-            const avxf lclipMinY = msub(node->lower_y[i],rdir.y,org_rdir.y);
-            const avxf lclipMinZ = msub(node->lower_z[i],rdir.z,org_rdir.z);
-            const avxf lclipMaxX = msub(node->upper_x[i],rdir.x,org_rdir.x);
-            const avxf lclipMaxY = msub(node->upper_y[i],rdir.y,org_rdir.y);
-            const avxf lclipMaxZ = msub(node->upper_z[i],rdir.z,org_rdir.z);
+            const avxf lclipMinX = msub(node->lowerX(i),rdir.x,org_rdir.x);
+            const avxf lclipMinY = msub(node->lowerY(i),rdir.y,org_rdir.y);
+            const avxf lclipMinZ = msub(node->lowerZ(i),rdir.z,org_rdir.z);
+            const avxf lclipMaxX = msub(node->upperX(i),rdir.x,org_rdir.x);
+            const avxf lclipMaxY = msub(node->upperY(i),rdir.y,org_rdir.y);
+            const avxf lclipMaxZ = msub(node->upperZ(i),rdir.z,org_rdir.z);
             const avxf lnearP = maxi(maxi(mini(lclipMinX, lclipMaxX), mini(lclipMinY, lclipMaxY)), mini(lclipMinZ, lclipMaxZ));
             const avxf lfarP  = mini(mini(maxi(lclipMinX, lclipMaxX), maxi(lclipMinY, lclipMaxY)), maxi(lclipMinZ, lclipMaxZ));
             const avxb lhit   = maxi(lnearP,ray_tnear) <= mini(lfarP,ray_tfar);      
 #else
-            const avxf lclipMinX = (node->lower_x[i] - org.x) * rdir.x;
-            const avxf lclipMinY = (node->lower_y[i] - org.y) * rdir.y;
-            const avxf lclipMinZ = (node->lower_z[i] - org.z) * rdir.z;
-            const avxf lclipMaxX = (node->upper_x[i] - org.x) * rdir.x;
-            const avxf lclipMaxY = (node->upper_y[i] - org.y) * rdir.y;
-            const avxf lclipMaxZ = (node->upper_z[i] - org.z) * rdir.z;
+            const avxf lclipMinX = (node->lowerX(i) - org.x) * rdir.x;
+            const avxf lclipMinY = (node->lowerY(i) - org.y) * rdir.y;
+            const avxf lclipMinZ = (node->lowerZ(i) - org.z) * rdir.z;
+            const avxf lclipMaxX = (node->upperX(i) - org.x) * rdir.x;
+            const avxf lclipMaxY = (node->upperY(i) - org.y) * rdir.y;
+            const avxf lclipMaxZ = (node->upperZ(i) - org.z) * rdir.z;
             const avxf lnearP = max(max(min(lclipMinX, lclipMaxX), min(lclipMinY, lclipMaxY)), min(lclipMinZ, lclipMaxZ));
             const avxf lfarP  = min(min(max(lclipMinX, lclipMaxX), max(lclipMinY, lclipMaxY)), max(lclipMinZ, lclipMaxZ));
             const avxb lhit   = max(lnearP,ray_tnear) <= min(lfarP,ray_tfar);      
@@ -321,14 +341,17 @@ namespace embree
         const avxb valid_leaf = ray_tfar > curDist;
         STAT3(normal.trav_leaves,1,popcnt(valid_leaf),8);
         size_t items; const Primitive* prim = (Primitive*) curNode.leaf(items);
+        STAT_SCENE(stats,leaves++);
+        STAT_SCENE(stats,prims += items);
         PrimitiveIntersector8::intersect(valid_leaf,ray,prim,items,bvh->geometry);
         ray_tfar = select(valid_leaf,ray.tfar,ray_tfar);
       }
+      if (unlikely(sample.enabled)) bvh->hybrid8.update(HybridSwitch::INTERSECT,sample,SWITCH_COST);
       AVX_ZERO_UPPER();
     }
 
-    template<typename PrimitiveIntersector8>
-    __forceinline bool BVH4Intersector8Hybrid<PrimitiveIntersector8>::occluded1(const BVH4* bvh, NodeRef root, const size_t k, Ray8& ray,const avx3f &ray_org, const avx3f &ray_dir, const avx3f &ray_rdir, const avxf &ray_tnear, const avxf &ray_tfar, const avx3i& nearXYZ)
+    template<typename PrimitiveIntersector8, typename NodeTy>
+    __forceinline bool BVH4Intersector8Hybrid<PrimitiveIntersector8,NodeTy>::occluded1(const BVH4* bvh, NodeRef root, const size_t k, Ray8& ray,const avx3f &ray_org, const avx3f &ray_dir, const avx3f &ray_rdir, const avxf &ray_tnear, const avxf &ray_tfar, const avx3i& nearXYZ, SceneStat::Counters* stats)
     {
       /*! stack state */
       NodeRef stack[stackSizeSingle];  //!< stack of nodes that still need to get traversed
@@ -361,24 +384,25 @@ namespace embree
           /*! stop if we found a leaf */
           if (unlikely(cur.isLeaf())) break;
           STAT3(shadow.trav_nodes,1,1,1);
+          STAT_SCENE(stats,nodes++);
           
           /*! single ray intersection with 4 boxes */
-          const Node* node = cur.node();
+          const Node* node = (const Node*) cur.node();
           const size_t farX  = nearX ^ 16, farY  = nearY ^ 16, farZ  = nearZ ^ 16;
 #if defined (__AVX2__)
-          const ssef tNearX = msub(load4f((const char*)node+nearX), rdir.x, org_rdir.x);
-          const ssef tNearY = msub(load4f((const char*)node+nearY), rdir.y, org_rdir.y);
-          const ssef tNearZ = msub(load4f((const char*)node+nearZ), rdir.z, org_rdir.z);
-          const ssef tFarX  = msub(load4f((const char*)node+farX ), rdir.x, org_rdir.x);
-          const ssef tFarY  = msub(load4f((const char*)node+farY ), rdir.y, org_rdir.y);
-          const ssef tFarZ  = msub(load4f((const char*)node+farZ ), rdir.z, org_rdir.z);
+          const ssef tNearX = msub(node->plane(nearX), rdir.x, org_rdir.x);
+          const ssef tNearY = msub(node->plane(nearY), rdir.y, org_rdir.y);
+          const ssef tNearZ = msub(node->plane(nearZ), rdir.z, org_rdir.z);
+          const ssef tFarX  = msub(node->plane(farX ), rdir.x, org_rdir.x);
+          const ssef tFarY  = msub(node->plane(farY ), rdir.y, org_rdir.y);
+          const ssef tFarZ  = msub(node->plane(farZ ), rdir.z, org_rdir.z);
 #else
-          const ssef tNearX = (norg.x + load4f((const char*)node+nearX)) * rdir.x;
-          const ssef tNearY = (norg.y + load4f((const char*)node+nearY)) * rdir.y;
-          const ssef tNearZ = (norg.z + load4f((const char*)node+nearZ)) * rdir.z;
-          const ssef tFarX  = (norg.x + load4f((const char*)node+farX )) * rdir.x;
-          const ssef tFarY  = (norg.y + load4f((const char*)node+farY )) * rdir.y;
-          const ssef tFarZ  = (norg.z + load4f((const char*)node+farZ )) * rdir.z;
+          const ssef tNearX = (norg.x + node->plane(nearX)) * rdir.x;
+          const ssef tNearY = (norg.y + node->plane(nearY)) * rdir.y;
+          const ssef tNearZ = (norg.z + node->plane(nearZ)) * rdir.z;
+          const ssef tFarX  = (norg.x + node->plane(farX )) * rdir.x;
+          const ssef tFarY  = (norg.y + node->plane(farY )) * rdir.y;
+          const ssef tFarZ  = (norg.z + node->plane(farZ )) * rdir.z;
 #endif
           
 #if defined(__SSE4_1__)
@@ -448,6 +472,8 @@ namespace embree
         /*! this is a leaf node */
         STAT3(shadow.trav_leaves,1,1,1);
         size_t num; Primitive* prim = (Primitive*) cur.leaf(num);
+        STAT_SCENE(stats,leaves++);
+        STAT_SCENE(stats,prims += num);
         if (PrimitiveIntersector8::occluded(ray,k,prim,num,bvh->geometry)) {
           ray.geomID[k] = 0;
           return true;
@@ -456,8 +482,8 @@ namespace embree
       return false;
     }
     
-    template<typename PrimitiveIntersector8>
-    void BVH4Intersector8Hybrid<PrimitiveIntersector8>::occluded(avxb* valid_i, BVH4* bvh, Ray8& ray)
+    template<typename PrimitiveIntersector8, typename NodeTy>
+    void BVH4Intersector8Hybrid<PrimitiveIntersector8,NodeTy>::occluded(avxb* valid_i, BVH4* bvh, Ray8& ray)
     {
       /* load ray */
       const avxb valid = *valid_i;
@@ -483,12 +509,20 @@ namespace embree
       nearXYZ.y = select(rdir.y >= 0.0f,avxi(2*(int)sizeof(ssef)),avxi(3*(int)sizeof(ssef)));
       nearXYZ.z = select(rdir.z >= 0.0f,avxi(4*(int)sizeof(ssef)),avxi(5*(int)sizeof(ssef)));
 
+      /* runtime statistics */
+      SceneStat::Counters* stats = bvh->stat->thread();
+
+      /* some packets measure the node utilization for the adaptive switch to single ray traversal */
+      HybridSwitch::Sample sample(HybridSwitch::sample());
+      const size_t threshold = sample.enabled ? 0 : bvh->hybrid8.threshold(HybridSwitch::OCCLUDED);
+      size_t numActive = 8;
+
       /* allocate stack and push root node */
       avxf    stack_near[stackSizeChunk];
       NodeRef stack_node[stackSizeChunk];
       stack_node[0] = BVH4::invalidNode;
       stack_near[0] = inf;
-      stack_node[1] = bvh->root;
+      stack_node[1] = bvh->getRoot();
       stack_near[1] = ray_tnear; 
       NodeRef* stackEnd = stack_node+stackSizeChunk;
       NodeRef* __restrict__ sptr_node = stack_node + 2;
@@ -515,9 +549,10 @@ namespace embree
         /* switch to single ray traversal */
 #if !defined(__WIN32__) || defined(__X86_64__)
         size_t bits = movemask(active);
-        if (unlikely(__popcnt(bits) <= SWITCH_THRESHOLD)) {
+        numActive = __popcnt(bits);
+        if (unlikely(numActive <= threshold)) {
           for (size_t i=__bsf(bits); bits!=0; bits=__btc(bits,i), i=__bsf(bits)) {
-            if (occluded1(bvh,curNode,i,ray,ray_org,ray_dir,rdir,ray_tnear,ray_tfar,nearXYZ))
+            if (occluded1(bvh,curNode,i,ray,ray_org,ray_dir,rdir,ray_tnear,ray_tfar,nearXYZ,stats))
               terminated[i] = -1;
           }
           if (all(terminated)) break;
@@ -534,7 +569,9 @@ namespace embree
           
           const avxb valid_node = ray_tfar > curDist;
           STAT3(shadow.trav_nodes,1,popcnt(valid_node),8);
-          const Node* __restrict__ const node = curNode.node();
+          STAT_SCENE(stats,nodes++);
+          if (unlikely(sample.enabled)) sample.count(popcnt(valid_node),numActive);
+          const Node* __restrict__ const node = (const Node*) curNode.node();
           
           /* pop of next node */
           assert(sptr_node > stack_node);
@@ -549,22 +586,22 @@ namespace embree
             if (unlikely(child == BVH4::emptyNode)) break;
             
 #if defined(__AVX2__)
-            const avxf lclipMinX = msub(node->lower_x[i],rdir.x,org_rdir.x);
-            const avxf lclipMinY = msub(node->lower_y[i],rdir.y,org_rdir.y);
-            const avxf lclipMinZ = msub(node->lower_z[i],rdir.z,org_rdir.z);
-            const avxf lclipMaxX = msub(node->upper_x[i],rdir.x,org_rdir.x);
-            const avxf lclipMaxY = msub(node->upper_y[i],rdir.y,org_rdir.y);
-            const avxf lclipMaxZ = msub(node->upper_z[i],rdir.z,org_rdir.z);
+            const avxf lclipMinX = msub(node->lowerX(i),rdir.x,org_rdir.x);
+            const avxf lclipMinY = msub(node->lowerY(i),rdir.y,org_rdir.y);
+            const avxf lclipMinZ = msub(node->lowerZ(i),rdir.z,org_rdir.z);
+            const avxf lclipMaxX = msub(node->upperX(i),rdir.x,org_rdir.x);
+            const avxf lclipMaxY = msub(node->upperY(i),rdir.y,org_rdir.y);
+            const avxf lclipMaxZ = msub(node->upperZ(i),rdir.z,org_rdir.z);
             const avxf lnearP = maxi(maxi(mini(lclipMinX, lclipMaxX), mini(lclipMinY, lclipMaxY)), mini(lclipMinZ, lclipMaxZ));
             const avxf lfarP  = mini(mini(maxi(lclipMinX, lclipMaxX), maxi(lclipMinY, lclipMaxY)), maxi(lclipMinZ, lclipMaxZ));
             const avxb lhit   = maxi(lnearP,ray_tnear) <= mini(lfarP,ray_tfar);      
 #else
-            const avxf lclipMinX = (node->lower_x[i] - org.x) * rdir.x;
-            const avxf lclipMinY = (node->lower_y[i] - org.y) * rdir.y;
-            const avxf lclipMinZ = (node->lower_z[i] - org.z) * rdir.z;
-            const avxf lclipMaxX = (node->upper_x[i] - org.x) * rdir.x;
-            const avxf lclipMaxY = (node->upper_y[i] - org.y) * rdir.y;
-            const avxf lclipMaxZ = (node->upper_z[i] - org.z) * rdir.z;
+            const avxf lclipMinX = (node->lowerX(i) - org.x) * rdir.x;
+            const avxf lclipMinY = (node->lowerY(i) - org.y) * rdir.y;
+            const avxf lclipMinZ = (node->lowerZ(i) - org.z) * rdir.z;
+            const avxf lclipMaxX = (node->upperX(i) - org.x) * rdir.x;
+            const avxf lclipMaxY = (node->upperY(i) - org.y) * rdir.y;
+            const avxf lclipMaxZ = (node->upperZ(i) - org.z) * rdir.z;
             const avxf lnearP = max(max(min(lclipMinX, lclipMaxX), min(lclipMinY, lclipMaxY)), min(lclipMinZ, lclipMaxZ));
             const avxf lfarP  = min(min(max(lclipMinX, lclipMaxX), max(lclipMinY, lclipMaxY)), max(lclipMinZ, lclipMaxZ));
             const avxb lhit   = max(lnearP,ray_tnear) <= min(lfarP,ray_tfar);      
@@ -612,17 +649,30 @@ namespace embree
         const avxb valid_leaf = ray_tfar > curDist;
         STAT3(shadow.trav_leaves,1,popcnt(valid_leaf),8);
         size_t items; const Primitive* prim = (Primitive*) curNode.leaf(items);
+        STAT_SCENE(stats,leaves++);
+        STAT_SCENE(stats,prims += items);
         terminated |= PrimitiveIntersector8::occluded(!terminated,ray,prim,items,bvh->geometry);
         if (all(terminated)) break;
         ray_tfar = select(terminated,avxf(neg_inf),ray_tfar);
       }
       store8i(valid & terminated,&ray.geomID,0);
+      if (unlikely(sample.enabled)) bvh->hybrid8.update(HybridSwitch::OCCLUDED,sample,SWITCH_COST);
       AVX_ZERO_UPPER();
     }
     
     DEFINE_INTERSECTOR8(BVH4Triangle4Intersector8HybridMoeller, BVH4Intersector8Hybrid<Triangle4Intersector8MoellerTrumbore>);
     DEFINE_INTERSECTOR8(BVH4Triangle8Intersector8HybridMoeller, BVH4Intersector8Hybrid<Triangle8Intersector8MoellerTrumbore>);
+    DEFINE_INTERSECTOR8(BVH4Triangle4wIntersector8HybridWoop, BVH4Intersector8Hybrid<Triangle4wIntersector8Woop>);
+    DEFINE_INTERSECTOR8(BVH4Triangle8wIntersector8HybridWoop, BVH4Intersector8Hybrid<Triangle8wIntersector8Woop>);
     DEFINE_INTERSECTOR8(BVH4Triangle4vIntersector8HybridPluecker, BVH4Intersector8Hybrid<Triangle4vIntersector8Pluecker>);
+    DEFINE_INTERSECTOR8(BVH4Triangle4qIntersector8HybridMoeller, BVH4Intersector8Hybrid<Triangle4qIntersector8MoellerTrumbore>);
+    DEFINE_INTERSECTOR8(BVH4Quad4Intersector8HybridMoeller, BVH4Intersector8Hybrid<Quad4Intersector8MoellerTrumbore>);
+    DEFINE_INTERSECTOR8(BVH4Bezier1Intersector8Hybrid, BVH4Intersector8Hybrid<Bezier1Intersector8>);
+
+    typedef BVH4Intersector8Hybrid<Triangle4Intersector8MoellerTrumbore,BVH4::CompressedNode> BVH4Triangle4Intersector8HybridMoellerCompressedT;
+    DEFINE_INTERSECTOR8(BVH4Triangle4Intersector8HybridMoellerCompressed, BVH4Triangle4Intersector8HybridMoellerCompressedT);
+    typedef BVH4Intersector8Hybrid<Triangle4qIntersector8MoellerTrumbore,BVH4::CompressedNode> BVH4Triangle4qIntersector8HybridMoellerCompressedT;
+    DEFINE_INTERSECTOR8(BVH4Triangle4qIntersector8HybridMoellerCompressed, BVH4Triangle4qIntersector8HybridMoellerCompressedT);
 
   }
 }
@@ -26,20 +26,20 @@ namespace embree
   namespace isa 
   {
     /*! BVH4 Traverser. Hybrid Packet traversal implementation for a Quad BVH. */
-    template<typename PrimitiveIntersector8>
+    template<typename PrimitiveIntersector8, typename NodeTy = BVH4::Node>
       class BVH4Intersector8Hybrid 
     {
       /* shortcuts for frequently used types */
       typedef typename PrimitiveIntersector8::Primitive Primitive;
       typedef typename BVH4::NodeRef NodeRef;
-      typedef typename BVH4::Node Node;
+      typedef NodeTy Node;
       typedef StackItemT<NodeRef> StackItem;
       static const size_t stackSizeSingle = 1+3*BVH4::maxDepth;
       static const size_t stackSizeChunk = 4*BVH4::maxDepth+1;
 
     public:
-      static void intersect1(const BVH4* bvh, NodeRef root, const size_t k, Ray8& ray, const avx3f &ray_org, const avx3f &ray_dir, const avx3f &ray_rdir, const avxf &ray_tnear, const avxf &ray_tfar, const avx3i& nearXYZ);
-      static bool occluded1 (const BVH4* bvh, NodeRef root, const size_t k, Ray8& ray, const avx3f &ray_org, const avx3f &ray_dir, const avx3f &ray_rdir, const avxf &ray_tnear, const avxf &ray_tfar, const avx3i& nearXYZ);
+      static void intersect1(const BVH4* bvh, NodeRef root, const size_t k, Ray8& ray, const avx3f &ray_org, const avx3f &ray_dir, const avx3f &ray_rdir, const avxf &ray_tnear, const avxf &ray_tfar, const avx3i& nearXYZ, SceneStat::Counters* stats);
+      static bool occluded1 (const BVH4* bvh, NodeRef root, const size_t k, Ray8& ray, const avx3f &ray_org, const avx3f &ray_dir, const avx3f &ray_rdir, const avxf &ray_tnear, const avxf &ray_tfar, const avx3i& nearXYZ, SceneStat::Counters* stats);
 
       static void intersect(avxb* valid, BVH4* bvh, Ray8& ray);
       static void occluded (avxb* valid, BVH4* bvh, Ray8& ray);
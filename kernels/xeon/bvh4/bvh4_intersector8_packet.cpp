@@ -0,0 +1,320 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "bvh4_intersector8_packet.h"
+
+#include "geometry/triangle1_intersector8_moeller.h"
+#include "geometry/triangle4_intersector8_moeller.h"
+#include "geometry/triangle8_intersector8_moeller.h"
+#include "geometry/triangle4w_intersector8_woop.h"
+#include "geometry/triangle8w_intersector8_woop.h"
+#include "geometry/triangle4v_intersector8_pluecker.h"
+
+namespace embree
+{
+  namespace isa
+  {
+    template<typename PrimitiveIntersector8>
+    __forceinline size_t BVH4Intersector8Packet<PrimitiveIntersector8>::load(Packet& packet, const RTCRayNp& rays, size_t N)
+    {
+      size_t octants = 0;
+      packet.numGroups = (N+7)/8;
+      for (size_t g=0; g<packet.numGroups; g++)
+      {
+        Ray8& ray = packet.rays[g];
+        avxb valid;
+        for (size_t k=0; k<8; k++)
+        {
+          const size_t i = 8*g+k;
+          valid[k] = i < N ? -1 : 0;
+          
+          /* invalid rays fill up the last group */
+          if (i >= N) {
+            ray.org.x[k] = ray.org.y[k] = ray.org.z[k] = 0.0f;
+            ray.dir.x[k] = ray.dir.y[k] = ray.dir.z[k] = 1.0f;
+            ray.tnear[k] = pos_inf; ray.tfar[k] = neg_inf;
+            ray.time[k] = 0.0f; ray.mask[k] = 0;
+            ray.geomID[k] = ray.primID[k] = ray.instID[k] = -1;
+            continue;
+          }
+          ray.org.x[k] = rays.orgx[i]; ray.org.y[k] = rays.orgy[i]; ray.org.z[k] = rays.orgz[i];
+          ray.dir.x[k] = rays.dirx[i]; ray.dir.y[k] = rays.diry[i]; ray.dir.z[k] = rays.dirz[i];
+          ray.tnear[k] = rays.tnear[i]; ray.tfar[k] = rays.tfar[i];
+          ray.time[k] = rays.time[i]; ray.mask[k] = rays.mask[i];
+          ray.Ng.x[k] = rays.Ngx[i]; ray.Ng.y[k] = rays.Ngy[i]; ray.Ng.z[k] = rays.Ngz[i];
+          ray.u[k] = rays.u[i]; ray.v[k] = rays.v[i];
+          ray.geomID[k] = rays.geomID[i]; ray.primID[k] = rays.primID[i]; ray.instID[k] = rays.instID[i];
+        }
+
+        /* classify rays by direction octant, invalid rays get no octant */
+        const avx3f rdir = rcp_safe(ray.dir);
+        packet.rdir[g] = rdir;
+        const avxi octant = select(rdir.x < 0.0f,avxi(1),avxi(zero)) | select(rdir.y < 0.0f,avxi(2),avxi(zero)) | select(rdir.z < 0.0f,avxi(4),avxi(zero));
+        packet.octant[g] = select(valid,octant,avxi(8));
+        for (size_t k=0; k<8; k++)
+          if (valid[k]) octants |= 1 << octant[k];
+      }
+      return octants;
+    }
+
+    template<typename PrimitiveIntersector8>
+    __forceinline bool BVH4Intersector8Packet<PrimitiveIntersector8>::computeFrustum(const Packet& packet, Frustum& frustum)
+    {
+      avx3f orgMin(pos_inf), orgMax(neg_inf);
+      avx3f rdirMin(pos_inf), rdirMax(neg_inf);
+      avxf tnear(pos_inf), tfar(neg_inf);
+      avxb any_valid(false);
+      for (size_t g=0; g<packet.numGroups; g++)
+      {
+        const avxb valid = packet.valid[g];
+        const Ray8& ray = packet.rays[g];
+        const avx3f& rdir = packet.rdir[g];
+        orgMin  = min(orgMin ,select(valid,ray.org,avx3f(pos_inf)));
+        orgMax  = max(orgMax ,select(valid,ray.org,avx3f(neg_inf)));
+        rdirMin = min(rdirMin,select(valid,rdir   ,avx3f(pos_inf)));
+        rdirMax = max(rdirMax,select(valid,rdir   ,avx3f(neg_inf)));
+        tnear = min(tnear,select(valid,ray.tnear,avxf(pos_inf)));
+        tfar  = max(tfar ,select(valid,ray.tfar ,avxf(neg_inf)));
+        any_valid |= valid;
+      }
+      if (none(any_valid)) return false;
+
+      /* choose the origin bound per axis that gives the smallest near and largest far distance */
+      const Vec3fa omin(reduce_min(orgMin.x),reduce_min(orgMin.y),reduce_min(orgMin.z));
+      const Vec3fa omax(reduce_max(orgMax.x),reduce_max(orgMax.y),reduce_max(orgMax.z));
+      frustum.rdirMin = Vec3fa(reduce_min(rdirMin.x),reduce_min(rdirMin.y),reduce_min(rdirMin.z));
+      frustum.rdirMax = Vec3fa(reduce_max(rdirMax.x),reduce_max(rdirMax.y),reduce_max(rdirMax.z));
+      const bool negX = frustum.rdirMax.x < 0.0f, negY = frustum.rdirMax.y < 0.0f, negZ = frustum.rdirMax.z < 0.0f;
+      frustum.orgNear = Vec3fa(negX ? omin.x : omax.x, negY ? omin.y : omax.y, negZ ? omin.z : omax.z);
+      frustum.orgFar  = Vec3fa(negX ? omax.x : omin.x, negY ? omax.y : omin.y, negZ ? omax.z : omin.z);
+      frustum.nearX = negX ? 1*sizeof(ssef) : 0*sizeof(ssef);
+      frustum.nearY = negY ? 3*sizeof(ssef) : 2*sizeof(ssef);
+      frustum.nearZ = negZ ? 5*sizeof(ssef) : 4*sizeof(ssef);
+      frustum.tnear = reduce_min(tnear);
+      frustum.tfar  = reduce_max(tfar);
+      return true;
+    }
+
+    template<typename PrimitiveIntersector8>
+    __forceinline avxb BVH4Intersector8Packet<PrimitiveIntersector8>::intersectBox(const Packet& packet, size_t group, const BBox3f& box)
+    {
+      const Ray8& ray = packet.rays[group];
+      const avx3f& rdir = packet.rdir[group];
+      const avxf clipMinX = (avxf(box.lower.x) - ray.org.x) * rdir.x;
+      const avxf clipMinY = (avxf(box.lower.y) - ray.org.y) * rdir.y;
+      const avxf clipMinZ = (avxf(box.lower.z) - ray.org.z) * rdir.z;
+      const avxf clipMaxX = (avxf(box.upper.x) - ray.org.x) * rdir.x;
+      const avxf clipMaxY = (avxf(box.upper.y) - ray.org.y) * rdir.y;
+      const avxf clipMaxZ = (avxf(box.upper.z) - ray.org.z) * rdir.z;
+      const avxf tNear = max(max(min(clipMinX,clipMaxX),min(clipMinY,clipMaxY)),max(min(clipMinZ,clipMaxZ),ray.tnear));
+      const avxf tFar  = min(min(max(clipMinX,clipMaxX),max(clipMinY,clipMaxY)),min(max(clipMinZ,clipMaxZ),ray.tfar));
+      return packet.valid[group] & (tNear <= tFar);
+    }
+
+    template<typename PrimitiveIntersector8>
+    void BVH4Intersector8Packet<PrimitiveIntersector8>::traverse(BVH4* bvh, Packet& packet, Frustum& frustum, bool occlusion)
+    {
+      /* runtime statistics */
+      SceneStat::Counters* stats = bvh->stat->thread();
+
+      /* number of rays that are not occluded yet */
+      size_t numActive = 0;
+      for (size_t g=0; g<packet.numGroups; g++)
+        numActive += popcnt(packet.valid[g]);
+
+      /* frustum in SIMD registers */
+      const size_t nearX = frustum.nearX, farX = nearX ^ sizeof(ssef);
+      const size_t nearY = frustum.nearY, farY = nearY ^ sizeof(ssef);
+      const size_t nearZ = frustum.nearZ, farZ = nearZ ^ sizeof(ssef);
+      const sse3f orgNear(frustum.orgNear.x,frustum.orgNear.y,frustum.orgNear.z);
+      const sse3f orgFar (frustum.orgFar .x,frustum.orgFar .y,frustum.orgFar .z);
+      const sse3f rdirMin(frustum.rdirMin.x,frustum.rdirMin.y,frustum.rdirMin.z);
+      const sse3f rdirMax(frustum.rdirMax.x,frustum.rdirMax.y,frustum.rdirMax.z);
+      const ssef tnear(frustum.tnear);
+      
+      /* push root node with infinite bounds */
+      StackItem stack[stackSize];
+      StackItem* stackPtr = stack;
+      stackPtr->bounds = BBox3f(Vec3fa(neg_inf),Vec3fa(pos_inf));
+      stackPtr->ref = bvh->getRoot();
+      stackPtr->first = 0;
+      stackPtr->last = packet.numGroups;
+      stackPtr->dist = frustum.tnear;
+      stackPtr++;
+
+      while (stackPtr != stack)
+      {
+        /* pop next node, cull it if behind the farthest ray */
+        stackPtr--;
+        if (unlikely(stackPtr->dist > frustum.tfar))
+          continue;
+
+        /* find first and last group that still hit the node */
+        size_t first = stackPtr->first, last = stackPtr->last; 
+        avxb hitFirst = false, hitLast = false;
+        for (; first<last; first++) {
+          hitFirst = intersectBox(packet,first,stackPtr->bounds);
+          if (any(hitFirst)) break;
+        }
+        if (unlikely(first == last))
+          continue;
+        hitLast = hitFirst;
+        for (; last-1>first; last--) {
+          hitLast = intersectBox(packet,last-1,stackPtr->bounds);
+          if (any(hitLast)) break;
+        }
+
+        /* intersect all groups between the first and the last one with the leaf */
+        const NodeRef cur = stackPtr->ref;
+        if (unlikely(cur.isLeaf()))
+        {
+          size_t items; const Primitive* prim = (const Primitive*) cur.leaf(items);
+          STAT_SCENE(stats,leaves++);
+          STAT_SCENE(stats,prims += items);
+          const BBox3f bounds = stackPtr->bounds;
+          bool terminated_any = false;
+          
+          for (size_t g=first; g<last; g++)
+          {
+            const avxb valid_leaf = g == first ? hitFirst : g == last-1 ? hitLast : intersectBox(packet,g,bounds);
+            if (none(valid_leaf)) continue;
+            Ray8& ray = packet.rays[g];
+            
+            if (occlusion) {
+              const avxb terminated = valid_leaf & PrimitiveIntersector8::occluded(valid_leaf,ray,prim,items,bvh->geometry);
+              if (none(terminated)) continue;
+              ray.geomID = select(terminated,avxi(zero),ray.geomID);
+              packet.valid[g] = packet.valid[g] & !terminated;
+              numActive -= popcnt(terminated);
+              terminated_any = true;
+            }
+            else
+              PrimitiveIntersector8::intersect(valid_leaf,ray,prim,items,bvh->geometry);
+          }
+
+          /* shrink the frustum to the remaining ray segments */
+          if (occlusion) {
+            if (numActive == 0) break;
+            if (terminated_any) frustum.tfar = farthest(packet);
+          }
+          else
+            frustum.tfar = farthest(packet);
+          continue;
+        }
+        
+        /* cull the 4 children against the frustum using interval arithmetic */
+        STAT_SCENE(stats,nodes++);
+        const Node* node = cur.node();
+        const ssef nX = node->plane(nearX) - orgNear.x, fX = node->plane(farX) - orgFar.x;
+        const ssef nY = node->plane(nearY) - orgNear.y, fY = node->plane(farY) - orgFar.y;
+        const ssef nZ = node->plane(nearZ) - orgNear.z, fZ = node->plane(farZ) - orgFar.z;
+        const ssef tNearX = min(nX*rdirMin.x,nX*rdirMax.x), tFarX = max(fX*rdirMin.x,fX*rdirMax.x);
+        const ssef tNearY = min(nY*rdirMin.y,nY*rdirMax.y), tFarY = max(fY*rdirMin.y,fY*rdirMax.y);
+        const ssef tNearZ = min(nZ*rdirMin.z,nZ*rdirMax.z), tFarZ = max(fZ*rdirMin.z,fZ*rdirMax.z);
+        const ssef tNear = max(max(tNearX,tNearY),max(tNearZ,tnear));
+        const ssef tFar  = min(min(tFarX ,tFarY ),min(tFarZ ,ssef(frustum.tfar)));
+        size_t mask = movemask(tNear <= tFar);
+
+        /* push hit children sorted such that the closest one gets popped first */
+        StackItem* begin = stackPtr;
+        for (size_t i=__bsf(mask); mask!=0; mask=__btc(mask,i), i=__bsf(mask)) 
+        {
+          const NodeRef child = node->children[i];
+          if (unlikely(child == BVH4::emptyNode)) continue;
+          assert(stackPtr < stack+stackSize);
+          StackItem item;
+          item.bounds = node->bounds(i);
+          item.ref = child;
+          item.first = first;
+          item.last = last;
+          item.dist = tNear[i];
+          StackItem* p = stackPtr++;
+          for (; p != begin && p[-1].dist < item.dist; p--) *p = p[-1];
+          *p = item;
+        }
+      }
+    }
+
+    template<typename PrimitiveIntersector8>
+    __forceinline float BVH4Intersector8Packet<PrimitiveIntersector8>::farthest(const Packet& packet)
+    {
+      avxf tfar(neg_inf);
+      for (size_t g=0; g<packet.numGroups; g++)
+        tfar = max(tfar,select(packet.valid[g],packet.rays[g].tfar,avxf(neg_inf)));
+      return reduce_max(tfar);
+    }
+
+    template<typename PrimitiveIntersector8>
+    void BVH4Intersector8Packet<PrimitiveIntersector8>::intersect(BVH4* bvh, const RTCRayNp& rays, size_t N)
+    {
+      assert(N <= RTC_MAX_PACKET_SIZE);
+      Packet packet;
+      const size_t octants = load(packet,rays,N);
+
+      /* traverse the rays of each direction octant together */
+      for (size_t o=0; o<8; o++)
+      {
+        if ((octants & (1 << o)) == 0) continue;
+        for (size_t g=0; g<packet.numGroups; g++)
+          packet.valid[g] = packet.octant[g] == avxi(o);
+        Frustum frustum; if (!computeFrustum(packet,frustum)) continue;
+        traverse(bvh,packet,frustum,false);
+      }
+
+      /* store hits */
+      for (size_t i=0; i<N; i++)
+      {
+        const Ray8& ray = packet.rays[i/8];
+        const size_t k = i%8;
+        rays.tfar[i] = ray.tfar[k];
+        rays.Ngx[i] = ray.Ng.x[k]; rays.Ngy[i] = ray.Ng.y[k]; rays.Ngz[i] = ray.Ng.z[k];
+        rays.u[i] = ray.u[k]; rays.v[i] = ray.v[k];
+        rays.geomID[i] = ray.geomID[k]; rays.primID[i] = ray.primID[k]; rays.instID[i] = ray.instID[k];
+      }
+      AVX_ZERO_UPPER();
+    }
+
+    template<typename PrimitiveIntersector8>
+    void BVH4Intersector8Packet<PrimitiveIntersector8>::occluded(BVH4* bvh, const RTCRayNp& rays, size_t N)
+    {
+      assert(N <= RTC_MAX_PACKET_SIZE);
+      Packet packet;
+      const size_t octants = load(packet,rays,N);
+
+      /* traverse the rays of each direction octant together */
+      for (size_t o=0; o<8; o++)
+      {
+        if ((octants & (1 << o)) == 0) continue;
+        for (size_t g=0; g<packet.numGroups; g++)
+          packet.valid[g] = packet.octant[g] == avxi(o);
+        Frustum frustum; if (!computeFrustum(packet,frustum)) continue;
+        traverse(bvh,packet,frustum,true);
+      }
+
+      /* store occlusion */
+      for (size_t i=0; i<N; i++)
+        rays.geomID[i] = packet.rays[i/8].geomID[i%8];
+      AVX_ZERO_UPPER();
+    }
+
+    DEFINE_INTERSECTOR_PACKET(BVH4Triangle1IntersectorPacketMoeller, BVH4Intersector8Packet<Triangle1Intersector8MoellerTrumbore>);
+    DEFINE_INTERSECTOR_PACKET(BVH4Triangle4IntersectorPacketMoeller, BVH4Intersector8Packet<Triangle4Intersector8MoellerTrumbore>);
+    DEFINE_INTERSECTOR_PACKET(BVH4Triangle8IntersectorPacketMoeller, BVH4Intersector8Packet<Triangle8Intersector8MoellerTrumbore>);
+    DEFINE_INTERSECTOR_PACKET(BVH4Triangle4wIntersectorPacketWoop, BVH4Intersector8Packet<Triangle4wIntersector8Woop>);
+    DEFINE_INTERSECTOR_PACKET(BVH4Triangle8wIntersectorPacketWoop, BVH4Intersector8Packet<Triangle8wIntersector8Woop>);
+    DEFINE_INTERSECTOR_PACKET(BVH4Triangle4vIntersectorPacketPluecker, BVH4Intersector8Packet<Triangle4vIntersector8Pluecker>);
+  }
+}
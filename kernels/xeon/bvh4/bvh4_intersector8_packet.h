@@ -0,0 +1,88 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef __EMBREE_BVH4_INTERSECTOR8_PACKET_H__
+#define __EMBREE_BVH4_INTERSECTOR8_PACKET_H__
+
+#include "bvh4.h"
+#include "common/ray8.h"
+#include "embree2/rtcore_ray.h"
+
+namespace embree
+{
+  namespace isa 
+  {
+    /*! BVH4 Traverser. Large packet traversal for coherent packets of
+     *  up to RTC_MAX_PACKET_SIZE rays. The rays are split into groups
+     *  of 8 and the rays of each direction octant are traversed
+     *  together. Inner nodes are culled against a frustum bounding
+     *  all rays using interval arithmetic, and each stack entry
+     *  remembers the range of groups from the first to the last one
+     *  that still hit the node, such that groups that left the node
+     *  are never tested again below it. */
+    template<typename PrimitiveIntersector8>
+      class BVH4Intersector8Packet
+    {
+      /* shortcuts for frequently used types */
+      typedef typename PrimitiveIntersector8::Primitive Primitive;
+      typedef typename BVH4::NodeRef NodeRef;
+      typedef typename BVH4::Node Node;
+      static const size_t maxGroups = RTC_MAX_PACKET_SIZE/8;
+      static const size_t stackSize = 1+3*BVH4::maxDepth;
+
+      /*! rays of the packet split into groups of 8 rays */
+      struct Packet
+      {
+        Ray8 rays[maxGroups];      //!< groups of 8 rays
+        avx3f rdir[maxGroups];     //!< reciprocal ray directions
+        avxb valid[maxGroups];     //!< active rays of the current octant
+        avxi octant[maxGroups];    //!< direction octant of each ray
+        size_t numGroups;          //!< number of groups
+      };
+
+      /*! bounds of the rays of the current octant */
+      struct Frustum
+      {
+        Vec3fa orgNear, orgFar;    //!< origin bounds that minimize the near and maximize the far distance
+        Vec3fa rdirMin, rdirMax;   //!< reciprocal direction bounds
+        size_t nearX, nearY, nearZ; //!< offsets of the near planes inside a node
+        float tnear, tfar;         //!< ray segment bounds
+      };
+
+      /*! stack entry that remembers the bounds of the node and the range of groups that may hit it */
+      struct StackItem
+      {
+        BBox3f bounds;
+        NodeRef ref;
+        unsigned first, last;
+        float dist;
+      };
+
+    private:
+      static size_t load(Packet& packet, const RTCRayNp& rays, size_t N);
+      static bool computeFrustum(const Packet& packet, Frustum& frustum);
+      static avxb intersectBox(const Packet& packet, size_t group, const BBox3f& box);
+      static float farthest(const Packet& packet);
+      static void traverse(BVH4* bvh, Packet& packet, Frustum& frustum, bool occlusion);
+
+    public:
+      static void intersect(BVH4* bvh, const RTCRayNp& rays, size_t N);
+      static void occluded (BVH4* bvh, const RTCRayNp& rays, size_t N);
+    };
+  }
+}
+
+#endif
@@ -17,6 +17,7 @@
 #include "bvh4_refit.h"
 #include "bvh4_builder.h"
 #include "bvh4_statistics.h"
+#include "bvh4_rotate.h"
 #include "builders/heuristics.h"
 #include "sys/tasklogger.h"
 
@@ -27,16 +28,18 @@ namespace embree
   namespace isa
   {
     static const size_t block_size = 1024;
+    static const size_t tasks_per_thread = 32;
+    static const size_t ROTATE_PASSES = 5;
     
     __forceinline bool compare(const BVH4::NodeRef* a, const BVH4::NodeRef* b)
     {
-      int sa = *(size_t*)a->node();
-      int sb = *(size_t*)b->node();
+      size_t sa = *(size_t*)a->node();
+      size_t sb = *(size_t*)b->node();
       return sa < sb;
     }
     
     BVH4Refit::BVH4Refit (BVH4* bvh, Builder* builder, TriangleMeshScene::TriangleMesh* mesh)
-    : builder(builder), mesh(mesh), primTy(bvh->primTy), bvh(bvh) 
+    : builder(builder), mesh(mesh), primTy(bvh->primTy), bvh(bvh), built(false), updateRoots(false), buildSAH(0.0f), refitSAH(0.0f)
     {
       needAllThreads = builder->needAllThreads;
     }
@@ -48,16 +51,19 @@ namespace embree
     void BVH4Refit::build(size_t threadIndex, size_t threadCount) 
     {
       /* build initial BVH */
-      if (builder) {
-        builder->build(threadIndex,threadCount);
-        if (false) { //bvh->numPrimitives > 50000) {
+      if (!built) {
+        rebuild(threadIndex,threadCount);
+        built = true;
+      }
+
+      /* select subtrees for the parallel refit after the topology changed */
+      if (updateRoots) {
+        roots.clear();
+        if (threadCount > 1 && bvh->numPrimitives > 50000) {
           annotate_tree_sizes(bvh->root);
-          calculate_refit_roots();
-          needAllThreads = false;
-        } else {
-          needAllThreads = false;
+          calculate_refit_roots(threadCount);
         }
-        delete builder; builder = NULL;
+        updateRoots = false;
       }
       
       /* refit BVH */
@@ -74,8 +80,11 @@ namespace embree
         refit_sequential(threadIndex,threadCount,NULL);
         TaskLogger::endTask(threadIndex,taskID);
       }
-      else
+      else {
+        threadSAH.clear();
+        threadSAH.resize(threadCount,0.0f);
         TaskScheduler::executeTask(threadIndex,threadCount,_task_refit_parallel,this,numRoots,_task_refit_complete,this,"BVH4Refit::parallel");
+      }
       
       if (g_verbose >= 2) {
         double t1 = getSeconds();
@@ -83,6 +92,54 @@ namespace embree
         std::cout << "  dt = " << 1000.0f*(t1-t0) << "ms, perf = " << 1E-6*double(mesh->numTriangles)/(t1-t0) << " Mprim/s" << std::endl;
         std::cout << BVH4Statistics(bvh).str();
       }
+
+      /* rotate or rebuild the BVH if refitting degraded it too much */
+      monitor_quality(threadIndex,threadCount);
+    }
+
+    void BVH4Refit::rebuild(size_t threadIndex, size_t threadCount)
+    {
+      builder->build(threadIndex,threadCount);
+      buildSAH = sah();
+      updateRoots = true;
+    }
+
+    float BVH4Refit::sah()
+    {
+      if (!bvh->root.isNode() || bvh->bounds.empty()) return 0.0f;
+      return BVH4Statistics(bvh).sah();
+    }
+
+    void BVH4Refit::monitor_quality(size_t threadIndex, size_t threadCount)
+    {
+      if (g_refit_rotate <= 0.0f && g_refit_rebuild <= 0.0f) return;
+      if (buildSAH <= 0.0f) return;
+
+      /* compare against the SAH cost after the last full build */
+      const float ratio = refitSAH/buildSAH;
+
+      if (g_refit_rebuild > 0.0f && ratio > g_refit_rebuild) 
+      {
+        double t0 = getSeconds();
+        rebuild(threadIndex,threadCount);
+        double t1 = getSeconds();
+        if (g_verbose >= 1) 
+          std::cout << "BVH4Refit: sah = " << refitSAH << " is " << ratio << " times the build sah, rebuild took " 
+                    << 1000.0f*(t1-t0) << "ms, sah = " << buildSAH << std::endl;
+      }
+      else if (g_refit_rotate > 0.0f && ratio > g_refit_rotate) 
+      {
+        double t0 = getSeconds();
+        for (size_t i=0; i<ROTATE_PASSES; i++) 
+          BVH4Rotate::rotate(bvh,bvh->root);
+        updateRoots = true;
+        double t1 = getSeconds();
+        if (g_verbose >= 1) 
+          std::cout << "BVH4Refit: sah = " << refitSAH << " is " << ratio << " times the build sah, rotation took " 
+                    << 1000.0f*(t1-t0) << "ms, sah = " << sah() << std::endl;
+      }
+      else if (g_verbose >= 2) 
+        std::cout << "  refit sah = " << refitSAH << ", build sah = " << buildSAH << ", ratio = " << ratio << std::endl;
     }
     
     size_t BVH4Refit::annotate_tree_sizes(BVH4::NodeRef& ref)
@@ -107,21 +164,26 @@ namespace embree
       }
     }
     
-    void BVH4Refit::calculate_refit_roots ()
+    void BVH4Refit::calculate_refit_roots (size_t threadCount)
     {
       if (!bvh->root.isNode()) return;
+
+      /* split subtrees until each holds a small fraction of all primitives */
+      const size_t numPrimitives = *(size_t*)bvh->root.node();
+      const size_t maxPrimitives = max(size_t(block_size),numPrimitives/(tasks_per_thread*threadCount));
       
       roots.push_back(&bvh->root);
       std::make_heap (roots.begin(), roots.end(), compare);
       
-      while (true)
+      while (!roots.empty())
       {
         std::pop_heap(roots.begin(), roots.end(), compare);
         BVH4::NodeRef* node = roots.back();
-        roots.pop_back();
-        if (*(size_t*)node->node() < block_size) 
+        if (*(size_t*)node->node() <= maxPrimitives) 
           break;
+        roots.pop_back();
         
+        /* leaves of the opened node get refit in the toplevel pass */
         for (size_t i=0; i<BVH4::N; i++) {
           BVH4::NodeRef* child = &node->node()->child(i);
           if (child->isNode()) {
@@ -147,7 +209,24 @@ namespace embree
         return leaf_bounds(ref);
     }
     
-    BBox3f BVH4Refit::recurse_bottom(NodeRef& ref)
+    __forceinline float BVH4Refit::node_sah(Node* node, const BBox<sse3f>& bounds)
+    {
+      /* weight the surface area of each child with its cost, the same way as BVH4Statistics does */
+      ssef cost = zero;
+      for (size_t i=0; i<BVH4::N; i++) {
+        const NodeRef child = node->child(i);
+        size_t num = 0; 
+        if (child.isNode()) cost[i] = BVH4::travCost;
+        else { child.leaf(num); cost[i] = bvh->primTy.intCost*float(num); }
+      }
+      const ssef dx = bounds.upper.x-bounds.lower.x;
+      const ssef dy = bounds.upper.y-bounds.lower.y;
+      const ssef dz = bounds.upper.z-bounds.lower.z;
+      const ssef A = 2.0f*(dx*(dy+dz)+dy*dz);
+      return reduce_add(select(cost != ssef(zero),A*cost,ssef(zero)));
+    }
+    
+    BBox3f BVH4Refit::recurse_bottom(NodeRef& ref, float& sah)
     {
       /* this is a leaf node */
       if (unlikely(ref.isLeaf()))
@@ -155,10 +234,10 @@ namespace embree
       
       /* recurse if this is an internal node */
       Node* node = ref.node();
-      const BBox3f bounds0 = recurse_bottom(node->child(0));
-      const BBox3f bounds1 = recurse_bottom(node->child(1));
-      const BBox3f bounds2 = recurse_bottom(node->child(2));
-      const BBox3f bounds3 = recurse_bottom(node->child(3));
+      const BBox3f bounds0 = recurse_bottom(node->child(0),sah);
+      const BBox3f bounds1 = recurse_bottom(node->child(1),sah);
+      const BBox3f bounds2 = recurse_bottom(node->child(2),sah);
+      const BBox3f bounds3 = recurse_bottom(node->child(3),sah);
       
       /* AOS to SOA transform */
       BBox<sse3f> bounds;
@@ -172,6 +251,7 @@ namespace embree
       node->upper_x = bounds.upper.x;
       node->upper_y = bounds.upper.y;
       node->upper_z = bounds.upper.z;
+      sah += node_sah(node,bounds);
       
       /* return merged bounds */
       const float lower_x = reduce_min(bounds.lower.x);
@@ -184,7 +264,7 @@ namespace embree
                     Vec3fa(upper_x,upper_y,upper_z));
     }
     
-    BBox3f BVH4Refit::recurse_top(NodeRef& ref)
+    BBox3f BVH4Refit::recurse_top(NodeRef& ref, float& sah)
     {
       /* stop here if we encounter a barrier */
       if (unlikely(ref.isBarrier())) {
@@ -198,10 +278,10 @@ namespace embree
       
       /* recurse if this is an internal node */
       Node* node = ref.node();
-      const BBox3f bounds0 = recurse_top(node->child(0));
-      const BBox3f bounds1 = recurse_top(node->child(1));
-      const BBox3f bounds2 = recurse_top(node->child(2));
-      const BBox3f bounds3 = recurse_top(node->child(3));
+      const BBox3f bounds0 = recurse_top(node->child(0),sah);
+      const BBox3f bounds1 = recurse_top(node->child(1),sah);
+      const BBox3f bounds2 = recurse_top(node->child(2),sah);
+      const BBox3f bounds3 = recurse_top(node->child(3),sah);
       
       /* AOS to SOA transform */
       BBox<sse3f> bounds;
@@ -215,6 +295,7 @@ namespace embree
       node->upper_x = bounds.upper.x;
       node->upper_y = bounds.upper.y;
       node->upper_z = bounds.upper.z;
+      sah += node_sah(node,bounds);
       
       /* return merged bounds */
       const float lower_x = reduce_min(bounds.lower.x);
@@ -230,16 +311,33 @@ namespace embree
     void BVH4Refit::task_refit_parallel(size_t threadIndex, size_t threadCount, size_t taskIndex, size_t taskCount, TaskScheduler::Event* event) 
     {
       NodeRef& ref = *roots[taskIndex];
-      recurse_bottom(ref);
+      recurse_bottom(ref,threadSAH[threadIndex]);
       ref.setBarrier();
     }
     
-    void BVH4Refit::task_refit_complete(size_t threadIndex, size_t threadCount, TaskScheduler::Event* event) {
-      bvh->bounds = recurse_top(bvh->root);
+    void BVH4Refit::task_refit_complete(size_t threadIndex, size_t threadCount, TaskScheduler::Event* event) 
+    {
+      float sah = 0.0f;
+      bvh->bounds = recurse_top(bvh->root,sah);
+      for (size_t i=0; i<threadSAH.size(); i++) sah += threadSAH[i];
+      refitSAH = root_sah(sah);
     }
     
-    void BVH4Refit::refit_sequential(size_t threadIndex, size_t threadCount, TaskScheduler::Event* event) {
-      bvh->bounds = recurse_bottom(bvh->root);
+    void BVH4Refit::refit_sequential(size_t threadIndex, size_t threadCount, TaskScheduler::Event* event) 
+    {
+      float sah = 0.0f;
+      bvh->bounds = recurse_bottom(bvh->root,sah);
+      refitSAH = root_sah(sah);
+    }
+
+    float BVH4Refit::root_sah(float sah)
+    {
+      /* add the cost of the root and normalize by its surface area */
+      if (bvh->bounds.empty()) return 0.0f;
+      const float A = area(bvh->bounds);
+      if (bvh->root.isNode()) sah += A*BVH4::travCost;
+      else { size_t num; bvh->root.leaf(num); sah += A*bvh->primTy.intCost*float(num); }
+      return sah/A;
     }
 
     Builder* BVH4BuilderObjectSplit4TriangleMeshFast (void* bvh, TriangleMeshScene::TriangleMesh* mesh, const size_t minLeafSize, const size_t maxLeafSize);
@@ -47,13 +47,27 @@ namespace embree
       TASK_COMPLETE_FUNCTION(BVH4Refit,task_refit_complete);
       
     private:
+      /*! full rebuild of the BVH using the wrapped builder */
+      void rebuild(size_t threadIndex, size_t threadCount);
+
+      /*! SAH cost of the current BVH as computed by BVH4Statistics */
+      float sah();
+
+      /*! rotates or rebuilds the BVH if the SAH cost grew too much since the last build */
+      void monitor_quality(size_t threadIndex, size_t threadCount);
+
+      /*! stores the number of primitives of each subtree in its root node */
       size_t annotate_tree_sizes(NodeRef& ref);
-      void calculate_refit_roots ();
+
+      /*! selects subtrees of similar primitive count to get refit in parallel */
+      void calculate_refit_roots (size_t threadCount);
       
       BBox3f leaf_bounds(NodeRef& ref);
       BBox3f node_bounds(NodeRef& ref);
-      BBox3f recurse_bottom(NodeRef& ref);
-      BBox3f recurse_top(NodeRef& ref);
+      float node_sah(Node* node, const BBox<sse3f>& bounds);
+      float root_sah(float sah);
+      BBox3f recurse_bottom(NodeRef& ref, float& sah);
+      BBox3f recurse_top(NodeRef& ref, float& sah);
       
     private:
       //BuildSource* source;           //!< input geometry
@@ -68,6 +82,11 @@ namespace embree
       Builder* builder;
       BVH4* bvh;                      //!< BVH to refit
       std::vector<NodeRef*> roots;    //!< List of equal sized subtrees for bvh refit
+      bool built;                     //!< true after the initial build
+      bool updateRoots;               //!< true if the subtrees have to get selected again
+      float buildSAH;                 //!< SAH cost after the last full build
+      float refitSAH;                 //!< SAH cost after the last refit
+      std::vector<float> threadSAH;   //!< SAH cost of the subtrees refit by each thread
     };
   }
 }
@@ -0,0 +1,210 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "bvh4_restructure.h"
+
+namespace embree
+{
+  /*! Computes the height of a subtree. */
+  static size_t subtreeHeight(BVH4::NodeRef ref)
+  {
+    ref.clearBarrier();
+    if (ref.isLeaf()) return 0;
+    BVH4::Node* node = ref.node();
+    size_t height = 0;
+    for (size_t c=0; c<4; c++)
+      height = max(height,subtreeHeight(node->child(c)));
+    return 1+height;
+  }
+
+  size_t BVH4Restructure::restructure(BVH4* bvh, NodeRef& ref, size_t depth)
+  {
+    /*! barrier nodes are handled by someone else */
+    if (ref.isBarrier()) return subtreeHeight(ref);
+    if (ref.isLeaf()) return 0;
+    Node* node = ref.node();
+
+    /*! restructure all children first */
+    size_t height[4];
+    for (size_t c=0; c<4; c++)
+      height[c] = restructure(bvh,node->child(c),depth+1);
+
+    return restructure_treelet(bvh,node,depth,height);
+  }
+
+  size_t BVH4Restructure::restructure_treelet(BVH4* bvh, Node* root, size_t depth, const size_t height[4])
+  {
+    /*! the children of the root are the initial treelet leaves */
+    BBox3f bounds[MAX_TREELET_LEAVES];
+    NodeRef leaves[MAX_TREELET_LEAVES];
+    size_t heights[MAX_TREELET_LEAVES];
+    size_t numLeaves = 0, rootHeight = 0;
+    for (size_t c=0; c<4; c++) 
+    {
+      if (root->child(c) == BVH4::emptyNode) continue;
+      bounds[numLeaves] = root->bounds(c);
+      leaves[numLeaves] = root->child(c);
+      heights[numLeaves] = height[c];
+      rootHeight = max(rootHeight,1+height[c]);
+      numLeaves++;
+    }
+
+    /*! grow the treelet by expanding the inner node with largest surface area */
+    Node* nodes[MAX_TREELET_NODES]; nodes[0] = root;
+    size_t numNodes = 1;
+    float oldCost = 0.0f;
+    while (numNodes < MAX_TREELET_NODES)
+    {
+      ssize_t best = -1;
+      float bestArea = neg_inf;
+      for (size_t i=0; i<numLeaves; i++) 
+      {
+        /*! leaves and barriers cannot get expanded */
+        if (leaves[i].isLeaf()) continue;
+        const Node* node = leaves[i].node();
+        size_t numChildren = 0;
+        for (size_t c=0; c<4; c++) numChildren += node->child(c) != BVH4::emptyNode;
+        if (numLeaves-1+numChildren > MAX_TREELET_LEAVES) continue;
+
+        const float A = halfArea(bounds[i]);
+        if (A > bestArea) { bestArea = A; best = i; }
+      }
+      if (best == -1) break;
+
+      /*! replace the node by its children, these are at most as high as the node minus one */
+      Node* node = leaves[best].node();
+      const size_t h = heights[best]-1;
+      nodes[numNodes++] = node;
+      oldCost += bestArea;
+      bool first = true;
+      for (size_t c=0; c<4; c++) 
+      {
+        if (node->child(c) == BVH4::emptyNode) continue;
+        const size_t i = first ? best : numLeaves++;
+        bounds[i] = node->bounds(c);
+        leaves[i] = node->child(c);
+        heights[i] = h;
+        first = false;
+      }
+    }
+    
+    /*! nothing to optimize if the treelet consists of a single node */
+    if (numNodes == 1) return rootHeight;
+
+    /*! calculate bounds, surface area, size, and height of each subset of treelet leaves */
+    const unsigned int all = (1 << numLeaves)-1;
+    BBox3f box[1 << MAX_TREELET_LEAVES];
+    float area[1 << MAX_TREELET_LEAVES];
+    unsigned char count[1 << MAX_TREELET_LEAVES];
+    unsigned char maxHeight[1 << MAX_TREELET_LEAVES];
+    box[0] = empty; count[0] = 0; maxHeight[0] = 0;
+    for (unsigned int m=1; m<=all; m++) 
+    {
+      const size_t i = __bsf(m);
+      const unsigned int r = m & (m-1);
+      box[m] = merge(box[r],bounds[i]);
+      area[m] = halfArea(box[m]);
+      count[m] = count[r]+1;
+      maxHeight[m] = (unsigned char) max(size_t(maxHeight[r]),heights[i]);
+    }
+
+    /*! Find the arrangement with lowest cost. Each inner node of the
+     *  treelet costs its surface area, the cost of the treelet
+     *  leaves does not change. We test a single inner node G1, or two
+     *  sibling nodes G1 and G2, or G2 being a child of G1. */
+    const size_t n = numLeaves;
+    const size_t maxLevel = BVH4::maxBuildDepth-depth;
+    float bestCost = oldCost;
+    unsigned int bestG1 = 0, bestG2 = 0;
+    bool bestNested = false;
+    for (unsigned int G1=all; G1; G1=(G1-1)&all)
+    {
+      const size_t k1 = count[G1];
+      if (k1 < 2 || k1 == n) continue;
+      const float A1 = area[G1];
+      if (A1 >= bestCost) continue;
+
+      /*! single node G1, only tested for treelets with two nodes to not leave a node unused */
+      const bool fitsRoot = n-k1+1 <= 4;
+      if (numNodes == 2) {
+        if (k1 <= 4 && fitsRoot && 2+maxHeight[G1] <= maxLevel) { bestCost = A1; bestG1 = G1; }
+        continue;
+      }
+
+      /*! node G2 as child of node G1 */
+      if (fitsRoot) 
+      {
+        for (unsigned int G2=(G1-1)&G1; G2; G2=(G2-1)&G1) 
+        {
+          const size_t k2 = count[G2];
+          if (k2 < 2 || k2 > 4 || k1-k2+1 > 4) continue;
+          const float A = A1+area[G2];
+          if (A >= bestCost) continue;
+          if (2+maxHeight[G1&~G2] > maxLevel || 3+maxHeight[G2] > maxLevel) continue;
+          bestCost = A; bestG1 = G1; bestG2 = G2; bestNested = true;
+        }
+      }
+
+      /*! sibling nodes G1 and G2, G2 contains only leaves above the lowest one of G1 to test each pair once */
+      if (k1 <= 4 && 2+maxHeight[G1] <= maxLevel)
+      {
+        const unsigned int rest = all & ~G1 & ~(((G1 & (0-G1)) << 1)-1);
+        for (unsigned int G2=rest; G2; G2=(G2-1)&rest) 
+        {
+          const size_t k2 = count[G2];
+          if (k2 < 2 || k2 > 4 || n-k1-k2+2 > 4) continue;
+          const float A = A1+area[G2];
+          if (A >= bestCost) continue;
+          if (2+maxHeight[G2] > maxLevel) continue;
+          bestCost = A; bestG1 = G1; bestG2 = G2; bestNested = false;
+        }
+      }
+    }
+
+    /*! keep the treelet if no arrangement reduces the cost */
+    if (bestG1 == 0) return rootHeight;
+
+    /*! rebuild the treelet using the nodes of the old one */
+    Node* node1 = nodes[1];
+    Node* node2 = numNodes > 2 ? nodes[2] : NULL;
+    size_t num0 = 0, num1 = 0, num2 = 0, newHeight = 0;
+    root->clear();
+    node1->clear();
+    if (bestG2) node2->clear();
+    for (size_t i=0; i<n; i++) 
+    {
+      if ((bestG2 >> i) & 1) {
+        node2->set(num2++,bounds[i],leaves[i]);
+        newHeight = max(newHeight,(bestNested ? 3 : 2)+heights[i]);
+      }
+      else if ((bestG1 >> i) & 1) {
+        node1->set(num1++,bounds[i],leaves[i]);
+        newHeight = max(newHeight,2+heights[i]);
+      }
+      else {
+        root->set(num0++,bounds[i],leaves[i]);
+        newHeight = max(newHeight,1+heights[i]);
+      }
+    }
+    root->set(num0++,box[bestG1],bvh->encodeNode(node1));
+    if (bestG2) {
+      if (bestNested) node1->set(num1++,box[bestG2],bvh->encodeNode(node2));
+      else            root ->set(num0++,box[bestG2],bvh->encodeNode(node2));
+    }
+    assert(num0 <= 4 && num1 <= 4 && num2 <= 4);
+    return newHeight;
+  }
+}
@@ -0,0 +1,50 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef __EMBREE_BVH4_RESTRUCTURE_H__
+#define __EMBREE_BVH4_RESTRUCTURE_H__
+
+#include "bvh4.h"
+
+namespace embree
+{
+  /* BVH4 Treelet Restructuring. A treelet is a node together with up
+   * to two of its descendants. The treelet is rebuilt with the same
+   * nodes into the arrangement of its up to 7 leaves with lowest SAH
+   * cost. */
+  class BVH4Restructure
+  {
+  public:
+    typedef BVH4::Node Node;
+    typedef BVH4::NodeRef NodeRef;
+
+    static const size_t MAX_TREELET_NODES = 3;  //!< maximal number of inner nodes of a treelet
+    static const size_t MAX_TREELET_LEAVES = 7; //!< maximal number of leaves of a treelet
+
+  public:
+
+    /*! Restructures all treelets of a subtree bottom up. Barrier nodes
+     *  are treated as leaves. Returns the height of the subtree. */
+    static size_t restructure(BVH4* bvh, NodeRef& ref, size_t depth = 1);
+
+  private:
+
+    /*! Restructures the treelet rooted at the specified node, returns the new height of the node. */
+    static size_t restructure_treelet(BVH4* bvh, Node* root, size_t depth, const size_t height[4]);
+  };
+}
+
+#endif
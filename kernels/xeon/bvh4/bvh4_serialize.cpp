@@ -0,0 +1,334 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "bvh4.h"
+
+namespace embree
+{
+  /*! Header of a BVH4 stored to a file. All node references in the
+   *  file are offsets relative to the begin of the file. */
+  struct BVH4FileHeader
+  {
+    char primTy[32];          //!< name of the primitive type stored in the leaves
+    size_t compressed;        //!< 1 if nodes are of type CompressedNode
+    size_t root;              //!< offset of root node
+    BBox3f bounds;            //!< bounds of the BVH
+    size_t numPrimitives;
+    size_t numVertices;
+    size_t ofsNodes;          //!< file offset of node array
+    size_t bytesNodes;        //!< size of node array
+    size_t ofsLeaves;         //!< file offset of leaf array
+    size_t bytesLeaves;       //!< size of leaf array
+  };
+
+  /*! alignment of the node and leaf arrays inside the file */
+  static const size_t fileAlignment = 64;
+
+  __forceinline size_t alignFile(size_t ofs) { 
+    return (ofs+fileAlignment-1) & ~(fileAlignment-1); 
+  }
+
+  /*! Computes the size of a single leaf. Leaves are 16 byte aligned
+   *  to keep the lower bits of the node reference free. */
+  __forceinline size_t leafBytes(const BVH4* bvh, size_t num) {
+    return (num*bvh->primTy.bytes+BVH4::align_mask) & ~BVH4::align_mask;
+  }
+
+  template<typename NodeTy>
+  static void countSubtreeBytes(const BVH4* bvh, BVH4::NodeRef ref, size_t& bytesNodes, size_t& bytesLeaves)
+  {
+    if (ref == BVH4::emptyNode) 
+      return;
+
+    if (ref.isLeaf()) {
+      size_t num; ref.leaf(num);
+      bytesLeaves += leafBytes(bvh,num);
+      return;
+    }
+
+    const NodeTy* node = (const NodeTy*) ref.node();
+    bytesNodes += sizeof(NodeTy);
+    for (size_t i=0; i<BVH4::N; i++)
+      countSubtreeBytes<NodeTy>(bvh,node->child(i),bytesNodes,bytesLeaves);
+  }
+
+  /*! Returns the order in which to lay out the children of a node.
+   *  The child with the largest surface area is the one most likely
+   *  traversed, thus it is placed directly behind its parent. */
+  template<typename NodeTy>
+  __forceinline void hotChildOrder(const NodeTy* node, size_t order[BVH4::N])
+  {
+    float areas[BVH4::N];
+    for (size_t i=0; i<BVH4::N; i++) {
+      order[i] = i;
+      areas[i] = node->child(i) == BVH4::emptyNode ? neg_inf : halfArea(node->bounds(i));
+    }
+    for (size_t i=1; i<BVH4::N; i++)
+      for (size_t j=i; j>0 && areas[order[j]] > areas[order[j-1]]; j--)
+        std::swap(order[j],order[j-1]);
+  }
+
+  /*! Copies a subtree into the file buffer and returns the reference
+   *  to the subtree relative to the begin of the file. */
+  template<typename NodeTy>
+  static BVH4::NodeRef storeSubtree(const BVH4* bvh, BVH4::NodeRef ref, char* buffer, size_t ofs, char*& nodes, char*& leaves)
+  {
+    if (ref == BVH4::emptyNode) 
+      return ref;
+
+    if (ref.isLeaf()) {
+      size_t num; char* prims = ref.leaf(num);
+      memcpy(leaves,prims,num*bvh->primTy.bytes);
+      const size_t leaf = ofs + (leaves-buffer);
+      leaves += leafBytes(bvh,num);
+      return BVH4::NodeRef(leaf | (1+num));
+    }
+
+    const NodeTy* node = (const NodeTy*) ref.node();
+    NodeTy* dst = (NodeTy*) nodes;
+    nodes += sizeof(NodeTy);
+    memcpy(dst,node,sizeof(NodeTy));
+    size_t order[BVH4::N]; hotChildOrder(node,order);
+    for (size_t i=0; i<BVH4::N; i++)
+      dst->child(order[i]) = storeSubtree<NodeTy>(bvh,node->child(order[i]),buffer,ofs,nodes,leaves);
+    return BVH4::NodeRef(ofs + ((char*)dst-buffer));
+  }
+
+  /*! Translates a node reference from a file offset to a pointer into
+   *  the mapped file. Only the nodes get modified, thus the pages
+   *  containing the leaves stay shared with the page cache. */
+  template<typename NodeTy>
+  static bool relocate(const BVH4* bvh, BVH4::NodeRef& ref, char* file, const BVH4FileHeader& header, size_t depth)
+  {
+    if (ref == BVH4::emptyNode) 
+      return true;
+
+    if (depth > BVH4::maxDepth)
+      return false;
+
+    if (ref.isLeaf()) 
+    {
+      size_t num; const size_t leaf = (size_t) ref.leaf(num);
+      if (leaf < header.ofsLeaves || leaf+num*bvh->primTy.bytes > header.ofsLeaves+header.bytesLeaves) return false;
+      ref = BVH4::NodeRef((size_t)(file+leaf) | (1+num));
+      return true;
+    }
+
+    const size_t ofs = (size_t) ref.node();
+    if (ofs < header.ofsNodes || ofs+sizeof(NodeTy) > header.ofsNodes+header.bytesNodes) return false;
+    NodeTy* node = (NodeTy*) (file+ofs);
+    ref = BVH4::NodeRef((size_t)node);
+    for (size_t i=0; i<BVH4::N; i++)
+      if (!relocate<NodeTy>(bvh,node->child(i),file,header,depth+1)) return false;
+    return true;
+  }
+
+  template<typename NodeTy>
+  static void collectNodes(BVH4::NodeRef ref, std::vector<NodeTy*>& nodes)
+  {
+    if (!ref.isNode()) 
+      return;
+
+    NodeTy* node = (NodeTy*) ref.node();
+    nodes.push_back(node);
+    for (size_t i=0; i<BVH4::N; i++)
+      collectNodes<NodeTy>(node->child(i),nodes);
+  }
+
+  /*! Copies the nodes of a subtree in depth first order into the
+   *  buffer. Child references get translated to the node slots the
+   *  copies are moved to later. */
+  template<typename NodeTy>
+  static void layoutSubtree(const NodeTy* node, NodeTy* const* slots, NodeTy* buffer, size_t& next)
+  {
+    NodeTy* dst = &buffer[next++];
+    memcpy(dst,node,sizeof(NodeTy));
+    size_t order[BVH4::N]; hotChildOrder(node,order);
+    for (size_t i=0; i<BVH4::N; i++) 
+    {
+      const BVH4::NodeRef child = node->child(order[i]);
+      if (!child.isNode()) continue;
+      const size_t slot = next;
+      layoutSubtree<NodeTy>((const NodeTy*)child.node(),slots,buffer,next);
+      dst->child(order[i]) = BVH4::NodeRef((size_t)slots[slot]);
+    }
+  }
+
+  /*! Reorders the nodes of a tree in depth first order over the memory
+   *  locations the nodes already occupy, the leaves stay in place. */
+  template<typename NodeTy>
+  static void layoutTree(BVH4::NodeRef& root)
+  {
+    std::vector<NodeTy*> slots;
+    collectNodes<NodeTy>(root,slots);
+    std::sort(slots.begin(),slots.end());
+
+    const size_t bytes = slots.size()*sizeof(NodeTy);
+    NodeTy* buffer = (NodeTy*) os_malloc(bytes);
+    size_t next = 0;
+    layoutSubtree<NodeTy>((const NodeTy*)root.node(),&slots[0],buffer,next);
+    for (size_t i=0; i<slots.size(); i++)
+      memcpy(slots[i],&buffer[i],sizeof(NodeTy));
+    os_free(buffer,bytes);
+    root = BVH4::NodeRef((size_t)slots[0]);
+  }
+
+  void BVH4::layout()
+  {
+    /* the toplevel tree of a two level BVH links the nodes of the object trees */
+    if (!root.isNode() || mappedFile || replicas.size() || objects.size()) 
+      return;
+
+    if (compressed) layoutTree<CompressedNode>(root);
+    else            layoutTree<Node>          (root);
+  }
+
+  void BVH4::countBytes(size_t& bytesNodes, size_t& bytesLeaves) const
+  {
+    if (compressed) countSubtreeBytes<CompressedNode>(this,root,bytesNodes,bytesLeaves);
+    else            countSubtreeBytes<Node>          (this,root,bytesNodes,bytesLeaves);
+  }
+
+  bool BVH4::store(std::ostream& out)
+  {
+    /* only leaves that do not reference the scene vertices can get stored */
+    if (primTy.needVertices || primTy.name.size() >= sizeof(((BVH4FileHeader*)NULL)->primTy))
+      return false;
+
+    /* compute file layout */
+    const size_t ofs = (size_t) out.tellp();
+    BVH4FileHeader header;
+    memset(&header,0,sizeof(header));
+    strcpy(header.primTy,primTy.name.c_str());
+    header.compressed = compressed;
+    header.bounds = bounds;
+    header.numPrimitives = numPrimitives;
+    header.numVertices = numVertices;
+    countBytes(header.bytesNodes,header.bytesLeaves);
+    header.ofsNodes  = alignFile(ofs+sizeof(BVH4FileHeader));
+    header.ofsLeaves = alignFile(header.ofsNodes+header.bytesNodes);
+    const size_t bytes = header.ofsLeaves+header.bytesLeaves-ofs;
+
+    /* copy tree into file buffer */
+    char* buffer = (char*) alignedMalloc(bytes);
+    memset(buffer,0,bytes);
+    char* nodes  = buffer+header.ofsNodes-ofs;
+    char* leaves = buffer+header.ofsLeaves-ofs;
+    if (compressed) header.root = storeSubtree<CompressedNode>(this,root,buffer,ofs,nodes,leaves);
+    else            header.root = storeSubtree<Node>          (this,root,buffer,ofs,nodes,leaves);
+    memcpy(buffer,&header,sizeof(header));
+
+    out.write(buffer,bytes);
+    alignedFree(buffer);
+    return out.good();
+  }
+
+  bool BVH4::load(void* file, size_t bytes, size_t ofs)
+  {
+    /* validate header */
+    if (ofs+sizeof(BVH4FileHeader) > bytes) return false;
+    BVH4FileHeader& header = *(BVH4FileHeader*)((char*)file+ofs);
+    if (strncmp(header.primTy,primTy.name.c_str(),sizeof(header.primTy)) != 0) return false;
+    if (header.compressed != (size_t)compressed) return false;
+    if (header.ofsNodes  < ofs+sizeof(BVH4FileHeader) || header.ofsNodes  % fileAlignment) return false;
+    if (header.ofsLeaves < header.ofsNodes+header.bytesNodes || header.ofsLeaves % fileAlignment) return false;
+    if (header.ofsLeaves+header.bytesLeaves > bytes) return false;
+
+    /* translate all node references into pointers */
+    NodeRef ref = header.root;
+    bool valid = compressed 
+      ? relocate<CompressedNode>(this,ref,(char*)file,header,0)
+      : relocate<Node>          (this,ref,(char*)file,header,0);
+    if (!valid) return false;
+
+    root = ref;
+    bounds = header.bounds;
+    numPrimitives = header.numPrimitives;
+    numVertices = header.numVertices;
+    mappedFile = file;
+    bytesMappedFile = bytes;
+    return true;
+  }
+
+  void BVH4::replicate()
+  {
+    const size_t numNodes = getNumberOfNumaNodes();
+    if (numNodes <= 1 || replicas.size() || root == emptyNode) 
+      return;
+
+    size_t bytesNodes = 0, bytesLeaves = 0;
+    countBytes(bytesNodes,bytesLeaves);
+    const size_t bytes = alignFile(bytesNodes)+bytesLeaves;
+
+    /* copy the tree into memory bound to each node that has processors */
+    replicas.resize(numNodes);
+    for (size_t node=0; node<numNodes; node++) 
+    {
+      replicas[node].root = root;
+      bool hasThreads = false;
+      for (size_t i=0; i<getNumberOfLogicalThreads(); i++)
+        hasThreads |= getNumaNodeOfLogicalThread(i) == node;
+      if (!hasThreads) continue;
+
+      char* buffer = (char*) os_malloc(bytes);
+      os_numa_bind(buffer,bytes,node);
+      char* nodes  = buffer;
+      char* leaves = buffer+alignFile(bytesNodes);
+      if (compressed) replicas[node].root = storeSubtree<CompressedNode>(this,root,buffer,(size_t)buffer,nodes,leaves);
+      else            replicas[node].root = storeSubtree<Node>          (this,root,buffer,(size_t)buffer,nodes,leaves);
+      replicas[node].ptr = buffer;
+      replicas[node].bytes = bytes;
+    }
+  }
+
+  void BVH4::compact()
+  {
+    /* the toplevel tree of a two level BVH links the nodes of the object trees */
+    if (root == emptyNode || mappedFile || compactedTree || replicas.size() || objects.size()) 
+      return;
+
+    size_t bytesTreeNodes = 0, bytesTreeLeaves = 0;
+    countBytes(bytesTreeNodes,bytesTreeLeaves);
+    const size_t bytes = alignFile(bytesTreeNodes)+bytesTreeLeaves;
+
+    /* the copy temporarily needs additional memory */
+    if (!memoryMonitor(bytes)) 
+      return;
+
+    /* copy nodes and leaves in depth first order */
+    char* buffer = (char*) numa_reserve(bytes);
+    numa_commit(buffer,bytes);
+    char* nodes  = buffer;
+    char* leaves = buffer+alignFile(bytesTreeNodes);
+    if (compressed) root = storeSubtree<CompressedNode>(this,root,buffer,(size_t)buffer,nodes,leaves);
+    else            root = storeSubtree<Node>          (this,root,buffer,(size_t)buffer,nodes,leaves);
+    compactedTree = buffer;
+    bytesCompactedTree = bytes;
+
+    /* release the build memory */
+    const size_t bytesBefore = (this->nodes || primitives) ? bytesCommitted : alloc->bytes();
+    if (this->nodes) os_free(this->nodes,bytesNodes);
+    if (primitives) os_free(primitives,bytesPrimitives);
+    this->nodes = primitives = NULL;
+    bytesNodes = bytesPrimitives = bytesCommitted = 0;
+    alloc->reset();
+    memoryMonitor(-ssize_t(bytesMonitored));
+    bytesMonitored = bytes;
+
+    if (g_verbose >= 2) 
+      std::cout << "compacted " << primTy.name << " BVH from " << bytesBefore/1E6 << " MB to " << bytes/1E6 << " MB" << std::endl;
+  }
+}
@@ -64,4 +64,8 @@ namespace embree
     bounds = accel->bounds;
     intersectors = accel->intersectors;
   }
+
+  void TwoLevelAccel::memoryStatistics(RTCMemoryStatistics& stats) {
+    accel->memoryStatistics(stats);
+  }
 }
@@ -33,6 +33,7 @@ namespace embree
   public:
     void build(size_t threadIndex, size_t threadCount);
     void buildUserGeometryAccels(size_t threadIndex, size_t threadCount);
+    void memoryStatistics(RTCMemoryStatistics& stats);
 
   public:
     Scene* scene;
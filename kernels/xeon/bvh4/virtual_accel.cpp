@@ -61,4 +61,8 @@ namespace embree
     builder->build(threadIndex,threadCount);
     bounds = accel->bounds;
   }
+
+  void VirtualAccel::memoryStatistics(RTCMemoryStatistics& stats) {
+    accel->memoryStatistics(stats);
+  }
 }
@@ -86,6 +86,7 @@ namespace embree
     
   public:
     void build (size_t threadIndex, size_t threadCount);
+    void memoryStatistics(RTCMemoryStatistics& stats);
     
   public:
     Bounded* accel;
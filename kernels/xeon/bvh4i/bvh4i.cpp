@@ -21,6 +21,8 @@
 #include "geometry/triangle1v.h"
 #include "geometry/triangle4v.h"
 #include "geometry/triangle8.h"
+#include "geometry/triangle4w.h"
+#include "geometry/triangle8w.h"
 
 #include "common/accelinstance.h"
 
@@ -64,6 +66,13 @@ namespace embree
   DECLARE_SYMBOL(Accel::Intersector4,BVH4iTriangle8Intersector4ChunkMoeller);
   DECLARE_SYMBOL(Accel::Intersector8,BVH4iTriangle8Intersector8ChunkMoeller);
 
+  DECLARE_SYMBOL(Accel::Intersector1,BVH4iTriangle4wIntersector1Woop);
+  DECLARE_SYMBOL(Accel::Intersector4,BVH4iTriangle4wIntersector4ChunkWoop);
+  DECLARE_SYMBOL(Accel::Intersector8,BVH4iTriangle4wIntersector8HybridWoop);
+  DECLARE_SYMBOL(Accel::Intersector1,BVH4iTriangle8wIntersector1Woop);
+  DECLARE_SYMBOL(Accel::Intersector4,BVH4iTriangle8wIntersector4ChunkWoop);
+  DECLARE_SYMBOL(Accel::Intersector8,BVH4iTriangle8wIntersector8HybridWoop);
+
 
 #if defined(__TARGET_AVX2__)
   extern Accel::Intersector8 BVH4iTriangle1Intersector8ChunkAVX2;
@@ -120,6 +129,13 @@ namespace embree
     SELECT_SYMBOL_AVX_AVX2(features,BVH4iTriangle8Intersector4ChunkMoeller);
     SELECT_SYMBOL_AVX_AVX2(features,BVH4iTriangle8Intersector8ChunkMoeller);
 
+    SELECT_SYMBOL_DEFAULT_AVX_AVX2(features,BVH4iTriangle4wIntersector1Woop);
+    SELECT_SYMBOL_DEFAULT_AVX_AVX2(features,BVH4iTriangle4wIntersector4ChunkWoop);
+    SELECT_SYMBOL_AVX_AVX2(features,BVH4iTriangle4wIntersector8HybridWoop);
+    SELECT_SYMBOL_AVX_AVX2(features,BVH4iTriangle8wIntersector1Woop);
+    SELECT_SYMBOL_AVX_AVX2(features,BVH4iTriangle8wIntersector4ChunkWoop);
+    SELECT_SYMBOL_AVX_AVX2(features,BVH4iTriangle8wIntersector8HybridWoop);
+
   }
 
 
@@ -181,6 +197,28 @@ namespace embree
     return intersectors;
   }
 
+  Accel::Intersectors BVH4iTriangle4wIntersectors(BVH4i* bvh)
+  {
+    Accel::Intersectors intersectors;
+    intersectors.ptr = bvh;
+    intersectors.intersector1 = BVH4iTriangle4wIntersector1Woop;
+    intersectors.intersector4 = BVH4iTriangle4wIntersector4ChunkWoop;
+    intersectors.intersector8 = BVH4iTriangle4wIntersector8HybridWoop;
+    intersectors.intersector16 = NULL;
+    return intersectors;
+  }
+
+  Accel::Intersectors BVH4iTriangle8wIntersectors(BVH4i* bvh)
+  {
+    Accel::Intersectors intersectors;
+    intersectors.ptr = bvh;
+    intersectors.intersector1 = BVH4iTriangle8wIntersector1Woop;
+    intersectors.intersector4 = BVH4iTriangle8wIntersector4ChunkWoop;
+    intersectors.intersector8 = BVH4iTriangle8wIntersector8HybridWoop;
+    intersectors.intersector16 = NULL;
+    return intersectors;
+  }
+
 #if defined (__TARGET_AVX__)
 
   Accel* BVH4i::BVH4iTriangle8(Scene* scene)
@@ -200,6 +238,20 @@ namespace embree
 
     return new AccelInstance(accel,builder,intersectors);
   }
+
+  Accel* BVH4i::BVH4iTriangle8w(Scene* scene)
+  { 
+    BVH4i* accel = new BVH4i(SceneTriangle8w::type,scene);
+
+    Builder* builder = NULL;
+    if      (g_builder == "default"     ) builder = BVH4iBuilderObjectSplit8(accel,&scene->flat_triangle_source_1,scene,1,inf);
+    else if (g_builder == "spatialsplit") builder = BVH4iBuilderSpatialSplit8(accel,&scene->flat_triangle_source_1,scene,1,inf);
+    else if (g_builder == "objectsplit" ) builder = BVH4iBuilderObjectSplit8(accel,&scene->flat_triangle_source_1,scene,1,inf);
+    else throw std::runtime_error("unknown builder "+g_builder+" for BVH4i<Triangle8w>");
+
+    Accel::Intersectors intersectors = BVH4iTriangle8wIntersectors(accel);
+    return new AccelInstance(accel,builder,intersectors);
+  }
 #endif
 
 
@@ -233,6 +285,20 @@ namespace embree
     Accel::Intersectors intersectors = BVH4iTriangle4Intersectors(accel);
     return new AccelInstance(accel,builder,intersectors);
   }
+
+  Accel* BVH4i::BVH4iTriangle4w(Scene* scene)
+  { 
+    BVH4i* accel = new BVH4i(SceneTriangle4w::type);
+    
+    Builder* builder = NULL;
+    if      (g_builder == "default"     ) builder = BVH4iBuilderObjectSplit4(accel,&scene->flat_triangle_source_1,scene,1,inf);
+    else if (g_builder == "spatialsplit") builder = BVH4iBuilderSpatialSplit4(accel,&scene->flat_triangle_source_1,scene,1,inf);
+    else if (g_builder == "objectsplit" ) builder = BVH4iBuilderObjectSplit4(accel,&scene->flat_triangle_source_1,scene,1,inf);
+    else throw std::runtime_error("unknown builder "+g_builder+" for BVH4i<Triangle4w>");
+    
+    Accel::Intersectors intersectors = BVH4iTriangle4wIntersectors(accel);
+    return new AccelInstance(accel,builder,intersectors);
+  }
   
   Accel* BVH4i::BVH4iTriangle1_v1(Scene* scene)
   { 
@@ -345,6 +411,73 @@ namespace embree
     }
   }
 
+  /*! Returns the order in which to lay out the children of a node,
+   *  the child with the largest surface area goes directly behind its
+   *  parent. */
+  __forceinline void hotChildOrder(const BVH4i::Node* node, size_t order[BVH4i::N])
+  {
+    float areas[BVH4i::N];
+    for (size_t i=0; i<BVH4i::N; i++) {
+      order[i] = i;
+      areas[i] = node->child(i) == BVH4i::emptyNode ? neg_inf : halfArea(node->bounds(i));
+    }
+    for (size_t i=1; i<BVH4i::N; i++)
+      for (size_t j=i; j>0 && areas[order[j]] > areas[order[j-1]]; j--)
+        std::swap(order[j],order[j-1]);
+  }
+
+  static void collectNodes(const void* base, BVH4i::NodeRef ref, std::vector<unsigned>& nodes)
+  {
+    if (!ref.isNode()) 
+      return;
+
+    nodes.push_back(ref);
+    const BVH4i::Node* node = ref.node(base);
+    for (size_t i=0; i<BVH4i::N; i++)
+      collectNodes(base,node->child(i),nodes);
+  }
+
+  static void layoutSubtree(const void* base, const BVH4i::Node* node, const unsigned* slots, BVH4i::Node* buffer, size_t& next)
+  {
+    BVH4i::Node* dst = &buffer[next++];
+    memcpy(dst,node,sizeof(BVH4i::Node));
+    size_t order[BVH4i::N]; hotChildOrder(node,order);
+    for (size_t i=0; i<BVH4i::N; i++) 
+    {
+      const BVH4i::NodeRef child = node->child(order[i]);
+      if (!child.isNode()) continue;
+      const size_t slot = next;
+      layoutSubtree(base,child.node(base),slots,buffer,next);
+      dst->child(order[i]) = slots[slot];
+    }
+  }
+
+  void BVH4i::layout()
+  {
+    if (!root.isNode()) 
+      return;
+
+    /* reorder the nodes in depth first order over the offsets they already occupy */
+    std::vector<unsigned> slots;
+    collectNodes(nodePtr(),root,slots);
+    std::sort(slots.begin(),slots.end());
+
+    /* the fast builders keep a copy of the root in the unused node at offset 0 */
+    Node* first = (Node*) nodePtr();
+    const bool rootCopy = slots[0] != 0 && first->child(0) == root;
+
+    const size_t bytes = slots.size()*sizeof(Node);
+    Node* buffer = (Node*) os_malloc(bytes);
+    size_t next = 0;
+    layoutSubtree(nodePtr(),root.node(nodePtr()),&slots[0],buffer,next);
+    for (size_t i=0; i<slots.size(); i++)
+      memcpy(NodeRef(slots[i]).node(nodePtr()),&buffer[i],sizeof(Node));
+    os_free(buffer,bytes);
+
+    root = slots[0];
+    if (rootCopy) first->child(0) = root;
+  }
+
   float BVH4i::sah () {
     return sah(root,bounds)/area(bounds);
   }
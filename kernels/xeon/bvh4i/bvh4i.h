@@ -216,12 +216,14 @@ namespace embree
     static Accel* BVH4iTriangle1(Scene* scene);
     static Accel* BVH4iTriangle4(Scene* scene);
     static Accel* BVH4iTriangle4i(Scene* scene);
+    static Accel* BVH4iTriangle4w(Scene* scene);
     static Accel* BVH4iTriangle1_v1(Scene* scene);
     static Accel* BVH4iTriangle1_v2(Scene* scene);
     static Accel* BVH4iTriangle1_morton(Scene* scene);
     static Accel* BVH4iTriangle1_morton_enhanced(Scene* scene);
 
     static Accel* BVH4iTriangle8(Scene* scene);
+    static Accel* BVH4iTriangle8w(Scene* scene);
 
     static Accel* BVH4iTriangle1(TriangleMeshScene::TriangleMesh* mesh);
     static Accel* BVH4iTriangle4(TriangleMeshScene::TriangleMesh* mesh);
@@ -238,6 +240,9 @@ namespace embree
     /*! Calculates the SAH of the BVH */
     float sah ();
 
+    /*! reorders the nodes in depth first order for cache efficient traversal */
+    void layout();
+
   public:
 
     /*! encodes a node */
@@ -294,6 +299,13 @@ namespace embree
       return alloc_nodes->bytes() + alloc_tris->bytes();
     }
 
+    /*! adds the memory consumption of the BVH to the statistics */
+    void memoryStatistics(RTCMemoryStatistics& stats) {
+      stats.nodes += alloc_nodes->bytes();
+      stats.primitives += alloc_tris->bytes();
+      stats.allocated += bytes();
+    }
+
     // temporaery hack
     void *qbvh;
     void *accel;
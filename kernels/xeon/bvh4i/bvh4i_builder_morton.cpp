@@ -37,7 +37,7 @@ namespace embree
     
     BVH4iBuilderMorton::BVH4iBuilderMorton (BVH4i* bvh, BuildSource* source, void* geometry, const size_t minLeafSize, const size_t maxLeafSize)
     : bvh(bvh), source(source), scene((Scene*)geometry), topLevelItemThreshold(0), encodeShift(0), encodeMask(0), numBuildRecords(0), 
-      morton(NULL), node(NULL), accel(NULL), numGroups(0), numPrimitives(0), numNodes(0), numAllocatedNodes(0)
+      morton(NULL), bytesMorton(0), useMorton64(false), node(NULL), accel(NULL), numGroups(0), numPrimitives(0), numNodes(0), numAllocatedNodes(0)
     {
     }
     
@@ -126,25 +126,30 @@ namespace embree
         FATAL("ENCODING ERROR");
       }
       
+      /* switch to 64 bit morton codes for large scenes */
+      const bool useMorton64Old = useMorton64;
+      useMorton64 = numPrimitives > g_morton64_threshold;
+
       /* preallocate arrays */
       const size_t additional_size = 16 * CACHELINE_SIZE;
       
-      if (numPrimitivesOld != numPrimitives)
+      if (numPrimitivesOld != numPrimitives || useMorton64Old != useMorton64)
       {
         /* free previously allocated memory */
-        const size_t old_size_morton = numPrimitivesOld * sizeof(MortonID32Bit) + additional_size;
         const size_t old_size_node  = numAllocatedNodes * sizeof(BVHNode) + additional_size;
         const size_t old_size_accel = numPrimitivesOld * sizeof(Triangle1) + additional_size;
-        if (morton) os_free(morton,old_size_morton);
+        if (morton) os_free(morton,bytesMorton);
         if (node  ) os_free(node  ,old_size_node);
         if (accel ) os_free(accel ,old_size_accel);
         
         /* allocated memory for primrefs,nodes, and accel */
+        const size_t bytesMortonID = useMorton64 ? sizeof(MortonID64Bit) : sizeof(MortonID32Bit);
         numAllocatedNodes = numPrimitives * BVH_NODE_PREALLOC_FACTOR;
-        const size_t size_morton = numPrimitives * sizeof(MortonID32Bit) + additional_size;
+        const size_t size_morton = numPrimitives * bytesMortonID + additional_size;
         const size_t size_node   = numAllocatedNodes * sizeof(BVHNode) + additional_size;
         const size_t size_accel  = numPrimitives * sizeof(Triangle1) + additional_size;
         
+        bytesMorton = size_morton;
         morton = (MortonID32Bit* ) os_malloc(size_morton); memset(morton,0,size_morton);
         node   = (BVHNode*)        os_malloc(size_node  ); memset(node  ,0,size_node);
         accel  = (Triangle1*)  os_malloc(size_accel ); memset(accel ,0,size_accel);	
@@ -209,6 +214,11 @@ namespace embree
     
     void BVH4iBuilderMorton::computeMortonCodes(const size_t threadID, const size_t numThreads)
     {
+      if (useMorton64) {
+        computeMortonCodes64(threadID,numThreads);
+        return;
+      }
+
       const size_t startID = (threadID+0)*numPrimitives/numThreads;
       const size_t endID   = (threadID+1)*numPrimitives/numThreads;
       
@@ -273,7 +283,47 @@ namespace embree
       }
     }
     
-    void BVH4iBuilderMorton::recreateMortonCodes(SmallBuildRecord& current) const
+    void BVH4iBuilderMorton::computeMortonCodes64(const size_t threadID, const size_t numThreads)
+    {
+      const size_t startID = (threadID+0)*numPrimitives/numThreads;
+      const size_t endID   = (threadID+1)*numPrimitives/numThreads;
+      
+      /* store the morton codes temporarily in 'node' memory */
+      MortonID64Bit* __restrict__ const dest = (MortonID64Bit*)node; 
+      
+      /* compute mapping from world space into 3D grid */
+      const ssef base     = (ssef)global_bounds.centroid2.lower;
+      const ssef diagonal = (ssef)global_bounds.centroid2.upper - (ssef)global_bounds.centroid2.lower;
+      const ssef scale    = select(diagonal != 0, rcp(diagonal) * ssef(LATTICE_SIZE_PER_DIM_64 * 0.99f),ssef(0.0f));
+      
+      size_t currentID = startID;
+      size_t offset = thread_startGroupOffset[threadID];
+      
+      for (size_t group = thread_startGroup[threadID]; group<numGroups; group++) 
+      {       
+        Geometry* geom = scene->get(group);
+        if (geom == NULL || geom->type != TRIANGLE_MESH) continue;
+        TriangleMeshScene::TriangleMesh* mesh = (TriangleMeshScene::TriangleMesh*) geom;
+	if (unlikely(!mesh->isEnabled())) continue;
+
+        const size_t numTriangles = min(mesh->numTriangles-offset,endID-currentID);
+        
+        for (size_t i=0; i<numTriangles; i++, currentID++)	  
+        {
+          const BBox3f b = mesh->bounds(offset+i);
+          const ssef lower = (ssef)b.lower;
+          const ssef upper = (ssef)b.upper;
+          const ssef centroid2 = lower+upper;
+          const ssei binID = ssei((centroid2-base)*scale);
+          dest[currentID].code  = bitInterleave64(extract<0>(binID),extract<1>(binID),extract<2>(binID));
+          dest[currentID].index = (group << encodeShift) | (offset+i);
+        }
+        offset = 0;
+        if (currentID == endID) break;
+      }
+    }
+    
+    void BVH4iBuilderMorton::recreateMortonCodes(MortonID32Bit* __restrict__ const morton, SmallBuildRecord& current) const
     {
       Centroid_Scene_AABB global_bounds;
       global_bounds.reset();
@@ -317,27 +367,77 @@ namespace embree
       
     }
     
+    void BVH4iBuilderMorton::recreateMortonCodes(MortonID64Bit* __restrict__ const morton, SmallBuildRecord& current) const
+    {
+      Centroid_Scene_AABB global_bounds;
+      global_bounds.reset();
+      
+      for (size_t i=current.begin; i<current.end; i++)
+      {
+        const size_t index  = morton[i].index;
+        const size_t primID = index & encodeMask; 
+        const size_t geomID = index >> encodeShift; 
+        global_bounds.extend(scene->getTriangleMesh(geomID)->bounds(primID));
+      }
+      
+      /* compute mapping from world space into 3D grid */
+      const ssef base     = (ssef)global_bounds.centroid2.lower;
+      const ssef diagonal = (ssef)global_bounds.centroid2.upper - (ssef)global_bounds.centroid2.lower;
+      const ssef scale    = select(diagonal != 0,rcp(diagonal) * ssef(LATTICE_SIZE_PER_DIM_64 * 0.99f),ssef(0.0f));
+      
+      for (size_t i=current.begin; i<current.end; i++)
+      {
+        const size_t index  = morton[i].index;
+        const size_t primID = index & encodeMask; 
+        const size_t geomID = index >> encodeShift; 
+        const BBox3f b = scene->getTriangleMesh(geomID)->bounds(primID);
+        const ssef lower = (ssef)b.lower;
+        const ssef upper = (ssef)b.upper;
+        const ssef centroid2 = lower+upper;
+        const ssei binID = ssei((centroid2-base)*scale);
+        morton[i].code = bitInterleave64(extract<0>(binID),extract<1>(binID),extract<2>(binID));
+      }
+      
+      quicksort_insertionsort_ascending<MortonID64Bit,512>(morton,current.begin,current.end-1); 
+      
+#if defined(DEBUG)
+      for (size_t i=current.begin; i<current.end-1; i++)
+        assert(morton[i].code <= morton[i+1].code);
+#endif	    
+    }
+    
+    void BVH4iBuilderMorton::radixsort(const size_t threadID, const size_t numThreads)
+    {
+      if (useMorton64) radixsort<MortonID64Bit>(threadID,numThreads);
+      else             radixsort<MortonID32Bit>(threadID,numThreads);
+    }
+
+    template<typename MortonID>
     void BVH4iBuilderMorton::radixsort(const size_t threadID, const size_t numThreads)
     {
       const size_t startID = (threadID+0)*numPrimitives/numThreads;
       const size_t endID   = (threadID+1)*numPrimitives/numThreads;
       
-      MortonID32Bit* __restrict__ mortonID[2];
-      mortonID[0] = (MortonID32Bit*) morton; 
-      mortonID[1] = (MortonID32Bit*) node;
+      MortonID* __restrict__ mortonID[2];
+      mortonID[0] = (MortonID*) morton; 
+      mortonID[1] = (MortonID*) node;
+
+      /* an odd number of passes leaves the sorted codes in the morton array */
+      assert(MortonID::RADIX_PASSES % 2 == 1);
+      assert(MortonID::RADIX_BITS <= RADIX_BITS);
       
-      /* we need 3 iterations to process all 32 bits */
-      for (size_t b=0; b<3; b++)
+      for (size_t b=0; b<MortonID::RADIX_PASSES; b++)
       {
-        const MortonID32Bit* __restrict src = (MortonID32Bit*) &mortonID[((b+1)%2)][0];
-        MortonID32Bit*       __restrict dst = (MortonID32Bit*) &mortonID[((b+0)%2)][0];
+        const MortonID* __restrict src = (MortonID*) &mortonID[((b+1)%2)][0];
+        MortonID*       __restrict dst = (MortonID*) &mortonID[((b+0)%2)][0];
         
         /* shift and mask to extract some number of bits */
-        const unsigned int mask = RADIX_BUCKETS_MASK;
-        const unsigned int shift = b * RADIX_BITS;
+        const size_t buckets = (size_t)1 << MortonID::RADIX_BITS;
+        const unsigned int mask = buckets-1;
+        const unsigned int shift = b * MortonID::RADIX_BITS;
         
         /* count how many items go into the buckets */
-        for (size_t i=0; i<RADIX_BUCKETS; i++)
+        for (size_t i=0; i<buckets; i++)
           radixCount[threadID][i] = 0;
         
         for (size_t i=startID; i<endID; i++) {
@@ -352,11 +452,11 @@ namespace embree
         
 #if 0
         __align(64) unsigned int total[RADIX_BUCKETS];
-        for (size_t i=0; i<RADIX_BUCKETS; i++)
+        for (size_t i=0; i<buckets; i++)
           total[i] = 0;
         
         for (size_t i=0; i<numThreads; i++)
-          for (size_t j=0; j<RADIX_BUCKETS; j++)
+          for (size_t j=0; j<buckets; j++)
             total[j] += radixCount[i][j];
 #else
         __align(64) unsigned int inner_offset[RADIX_BUCKETS];
@@ -364,10 +464,10 @@ namespace embree
 #define CHUNK 64
         
 #pragma unroll(CHUNK)
-        for (size_t i=0; i<RADIX_BUCKETS; i++)
+        for (size_t i=0; i<buckets; i++)
           inner_offset[i] = 0;
         
-        for (size_t j=0; j<RADIX_BUCKETS; j+=CHUNK)
+        for (size_t j=0; j<buckets; j+=CHUNK)
           for (size_t i=0; i<threadID; i++)
 #pragma unroll(CHUNK)
             for (size_t k=0;k<CHUNK;k++)
@@ -376,10 +476,10 @@ namespace embree
         __align(64) unsigned int total[RADIX_BUCKETS];
         
 #pragma unroll(CHUNK)      
-        for (size_t i=0; i<RADIX_BUCKETS; i++)
+        for (size_t i=0; i<buckets; i++)
           total[i] = inner_offset[i];
         
-        for (size_t j=0; j<RADIX_BUCKETS; j+=CHUNK)
+        for (size_t j=0; j<buckets; j+=CHUNK)
           for (size_t i=threadID; i<numThreads; i++)
 #pragma unroll(CHUNK)
             for (size_t k=0;k<CHUNK;k++)
@@ -390,18 +490,18 @@ namespace embree
         /* calculate start offset of each bucket */
         __align(64) unsigned int offset[RADIX_BUCKETS];
         offset[0] = 0;
-        for (size_t i=1; i<RADIX_BUCKETS; i++)    
+        for (size_t i=1; i<buckets; i++)    
           offset[i] = offset[i-1] + total[i-1];
         
         /* calculate start offset of each bucket for this thread */
 #if 0
-        for (size_t j=0; j<RADIX_BUCKETS; j++)
+        for (size_t j=0; j<buckets; j++)
           for (size_t i=0; i<threadID; i++)
             offset[j] += radixCount[i][j];
 #else
         
 #pragma unroll(32) 
-        for (size_t j=0; j<RADIX_BUCKETS; j++)
+        for (size_t j=0; j<buckets; j++)
           offset[j] += inner_offset[j];
 #endif
         
@@ -410,7 +510,7 @@ namespace embree
           const unsigned int index = src[i].get(shift, mask);
           dst[offset[index]++] = src[i];
         }
-        if (b < 2) LockStepTaskScheduler::syncThreads(threadID,numThreads);
+        if (b < MortonID::RADIX_PASSES-1) LockStepTaskScheduler::syncThreads(threadID,numThreads);
       }
     }
     
@@ -479,7 +579,7 @@ namespace embree
       
       for (size_t i=0; i<items; i++) 
       {	
-        const size_t index = morton[start+i].index;
+        const size_t index = mortonIndex(start+i);
         const size_t primID = index & encodeMask; 
         const size_t geomID = index >> encodeShift; 
         const TriangleMeshScene::TriangleMesh* __restrict__ const mesh = scene->getTriangleMesh(geomID);
@@ -569,39 +669,41 @@ namespace embree
         return false;
       }
       
-      const unsigned int code_start = morton[current.begin].code;
-      const unsigned int code_end   = morton[current.end-1].code;
-      unsigned int bitpos = clz(code_start^code_end);
-      
+      if (useMorton64) split((MortonID64Bit*)morton,current,left,right);
+      else             split(morton,current,left,right);
+      return true;
+    }
+
+    template<typename MortonID>
+    __forceinline void BVH4iBuilderMorton::split(MortonID* __restrict__ const morton,
+                                                 SmallBuildRecord& current,
+                                                 SmallBuildRecord& left,
+                                                 SmallBuildRecord& right) const
+    {
       /* if all items mapped to same morton code, then create new morton codes for the items */
-      if (unlikely(bitpos == 32)) 
+      if (unlikely(morton[current.begin].code == morton[current.end-1].code)) 
       {
-        recreateMortonCodes(current);
-        const unsigned int code_start = morton[current.begin].code;
-        const unsigned int code_end   = morton[current.end-1].code;
-        bitpos = clz(code_start^code_end);
+        recreateMortonCodes(morton,current);
         
         /* if the morton code is still the same, goto fall back split */
-        if (unlikely(bitpos == 32)) 
+        if (unlikely(morton[current.begin].code == morton[current.end-1].code)) 
         {
           size_t center = (current.begin + current.end)/2; 
           left.init(current.begin,center);
           right.init(center,current.end);
-          return true;
+          return;
         }
       }
       
       /* split the items at the topmost different morton code bit */
-      const unsigned int bitpos_diff = 31-bitpos;
-      const unsigned int bitmask = 1 << bitpos_diff;
+      const typename MortonID::Code bitmask = highestBit(morton[current.begin].code ^ morton[current.end-1].code);
       
       /* find location where bit differs using binary search */
       size_t begin = current.begin;
       size_t end   = current.end;
       while (begin + 1 != end) {
         const size_t mid = (begin+end)/2;
-        const unsigned bit = morton[mid].code & bitmask;
-        if (bit == 0) begin = mid; else end = mid;
+        if ((morton[mid].code & bitmask) == 0) begin = mid; else end = mid;
       }
       size_t center = end;
 #if defined(DEBUG)      
@@ -611,7 +713,6 @@ namespace embree
       
       left.init(current.begin,center);
       right.init(center,current.end);
-      return true;
     }
     
     BBox3f BVH4iBuilderMorton::recurse(SmallBuildRecord& current, 
@@ -780,10 +881,16 @@ namespace embree
       LockStepTaskScheduler::dispatchTask( task_computeMortonCodes, this, threadIndex, threadCount );   
       
       /* padding */
-      MortonID32Bit* __restrict__ const dest = (MortonID32Bit*)node;
       for (size_t i=numPrimitives; i<( (numPrimitives+7)&(-8) ); i++) {
-        dest[i].code  = 0xffffffff; 
-        dest[i].index = 0;
+        if (useMorton64) {
+          MortonID64Bit* __restrict__ const dest = (MortonID64Bit*)node;
+          dest[i].code  = 0xffffffffffffffffull; 
+          dest[i].index = 0;
+        } else {
+          MortonID32Bit* __restrict__ const dest = (MortonID32Bit*)node;
+          dest[i].code  = 0xffffffff; 
+          dest[i].index = 0;
+        }
       }
       
       /* sort morton codes */
@@ -791,7 +898,9 @@ namespace embree
       
 #if defined(DEBUG)
       for (size_t i=1; i<numPrimitives; i++)
-        assert(morton[i-1].code <= morton[i].code);
+        assert(useMorton64 || morton[i-1].code <= morton[i].code);
+      for (size_t i=1; i<numPrimitives; i++)
+        assert(!useMorton64 || ((MortonID64Bit*)morton)[i-1].code <= ((MortonID64Bit*)morton)[i].code);
 #endif	    
       
       /* build and extract top-level tree */
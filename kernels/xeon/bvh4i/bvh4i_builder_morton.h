@@ -35,6 +35,8 @@ namespace embree
       static const size_t MORTON_LEAF_THRESHOLD = 4;
       static const size_t LATTICE_BITS_PER_DIM = 10;
       static const size_t LATTICE_SIZE_PER_DIM = size_t(1) << LATTICE_BITS_PER_DIM;
+      static const size_t LATTICE_BITS_PER_DIM_64 = 21;
+      static const size_t LATTICE_SIZE_PER_DIM_64 = size_t(1) << LATTICE_BITS_PER_DIM_64;
       typedef AtomicIDBlock<NODE_BLOCK_SIZE> NodeAllocator;
       
     public:
@@ -65,6 +67,11 @@ namespace embree
       
       struct __align(8) MortonID32Bit
       {
+        /*! the 30 bit codes get sorted in 3 passes of 11 bits */
+        static const size_t RADIX_BITS = 11;
+        static const size_t RADIX_PASSES = 3;
+        typedef unsigned int Code;
+
         unsigned int code;
         unsigned int index;
         
@@ -84,6 +91,34 @@ namespace embree
         __forceinline bool operator<(const MortonID32Bit &m) const { return code < m.code; } 
         __forceinline bool operator>(const MortonID32Bit &m) const { return code > m.code; } 
       };
+
+      /*! Morton code with 21 bits per dimension, used for large scenes
+       *  where 10 bits per dimension map too many primitives to the
+       *  same code. */
+      struct __align(16) MortonID64Bit
+      {
+        /*! the 63 bit codes get sorted in 7 passes of 9 bits, narrow
+         *  enough to reuse the per thread bucket counters */
+        static const size_t RADIX_BITS = 9;
+        static const size_t RADIX_PASSES = 7;
+        typedef uint64 Code;
+
+        uint64 code;
+        unsigned int index;
+        unsigned int pad;
+        
+        __forceinline unsigned int get(const unsigned int shift, const unsigned and_mask) const {
+          return (unsigned int)(code >> shift) & and_mask;
+        }
+        
+        __forceinline friend std::ostream &operator<<(std::ostream &o, const MortonID64Bit& mc) {
+          o << "index " << mc.index << " code = " << mc.code;
+          return o;
+        }
+        
+        __forceinline bool operator<(const MortonID64Bit &m) const { return code < m.code; } 
+        __forceinline bool operator>(const MortonID64Bit &m) const { return code > m.code; } 
+      };
       
       /*! Constructor. */
       BVH4iBuilderMorton (BVH4i* bvh, BuildSource* source, void* geometry, const size_t minLeafSize = 1, const size_t maxLeafSize = inf);
@@ -106,9 +141,11 @@ namespace embree
       
       /*! task that calculates the morton codes for each primitive in the scene */
       TASK_FUNCTION(BVH4iBuilderMorton,computeMortonCodes);
+      void computeMortonCodes64(const size_t threadID, const size_t numThreads);
       
       /*! parallel sort of the morton codes */
       TASK_FUNCTION(BVH4iBuilderMorton,radixsort);
+      template<typename MortonID> void radixsort(const size_t threadID, const size_t numThreads);
       
       /*! task that builds a list of sub-trees */
       TASK_FUNCTION(BVH4iBuilderMorton,recurseSubMortonTrees);
@@ -130,6 +167,9 @@ namespace embree
       
       /*! split a build record into two */
       bool split(SmallBuildRecord& current, SmallBuildRecord& left, SmallBuildRecord& right) const;
+
+      template<typename MortonID>
+        void split(MortonID* __restrict__ const morton, SmallBuildRecord& current, SmallBuildRecord& left, SmallBuildRecord& right) const;
       
       /*! main recursive build function */
       BBox3f recurse(SmallBuildRecord& current, 
@@ -144,7 +184,14 @@ namespace embree
       void refit(const size_t index) const;
       
       /*! recreates morton codes when reaching a region where all codes are identical */
-      void recreateMortonCodes(SmallBuildRecord& current) const;
+      void recreateMortonCodes(MortonID32Bit* __restrict__ const morton, SmallBuildRecord& current) const;
+      void recreateMortonCodes(MortonID64Bit* __restrict__ const morton, SmallBuildRecord& current) const;
+
+      /*! returns the primitive index of the i'th sorted morton code */
+      __forceinline unsigned int mortonIndex(const size_t i) const {
+        if (useMorton64) return ((MortonID64Bit*)morton)[i].index;
+        else             return morton[i].index;
+      }
       
     public:
       BVH4i* bvh;               //!< Output BVH
@@ -169,7 +216,9 @@ namespace embree
       __align(64) unsigned int radixCount[MAX_MIC_THREADS][RADIX_BUCKETS];
       
     protected:
-      MortonID32Bit* __restrict__ morton;
+      MortonID32Bit* __restrict__ morton;  //!< morton codes, MortonID64Bit array if useMorton64 is set
+      size_t bytesMorton;
+      bool useMorton64;                    //!< large scenes use 64 bit morton codes
       BVHNode* __restrict__ node;
       Triangle1* __restrict__ accel;
       
@@ -19,12 +19,14 @@
 
 #include "geometry/triangle1_intersector1_moeller.h"
 #include "geometry/triangle4_intersector1_moeller.h"
+#include "geometry/triangle4w_intersector1_woop.h"
 #include "geometry/triangle1v_intersector1_pluecker.h"
 #include "geometry/triangle4v_intersector1_pluecker.h"
 #include "geometry/virtual_accel_intersector1.h"
 
 #if defined(__AVX__)
 #include "geometry/triangle8_intersector1_moeller.h"
+#include "geometry/triangle8w_intersector1_woop.h"
 #endif
 
 namespace embree
@@ -275,11 +277,13 @@ namespace embree
     
     DEFINE_INTERSECTOR1(BVH4iTriangle1Intersector1Moeller,BVH4iIntersector1<Triangle1Intersector1MoellerTrumbore>);
     DEFINE_INTERSECTOR1(BVH4iTriangle4Intersector1Moeller,BVH4iIntersector1<Triangle4Intersector1MoellerTrumbore>);
+    DEFINE_INTERSECTOR1(BVH4iTriangle4wIntersector1Woop,BVH4iIntersector1<Triangle4wIntersector1Woop>);
     DEFINE_INTERSECTOR1(BVH4iTriangle1vIntersector1Pluecker,BVH4iIntersector1<Triangle1vIntersector1Pluecker>);
     DEFINE_INTERSECTOR1(BVH4iTriangle4vIntersector1Pluecker,BVH4iIntersector1<Triangle4vIntersector1Pluecker>);
     DEFINE_INTERSECTOR1(BVH4iVirtualIntersector1,BVH4iIntersector1<VirtualAccelIntersector1>);
 #if defined(__AVX__)
     DEFINE_INTERSECTOR1(BVH4iTriangle8Intersector1Moeller,BVH4iIntersector1<Triangle8Intersector1MoellerTrumbore>);
+    DEFINE_INTERSECTOR1(BVH4iTriangle8wIntersector1Woop,BVH4iIntersector1<Triangle8wIntersector1Woop>);
 #endif
   }
 }
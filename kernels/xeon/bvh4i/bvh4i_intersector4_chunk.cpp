@@ -18,11 +18,13 @@
 
 #include "geometry/triangle1_intersector4_moeller.h"
 #include "geometry/triangle4_intersector4_moeller.h"
+#include "geometry/triangle4w_intersector4_woop.h"
 #include "geometry/triangle1v_intersector4_pluecker.h"
 #include "geometry/triangle4v_intersector4_pluecker.h"
 #include "geometry/virtual_accel_intersector4.h"
 #if defined (__AVX__)
 #include "geometry/triangle8_intersector4_moeller.h"
+#include "geometry/triangle8w_intersector4_woop.h"
 #endif
 
 namespace embree
@@ -282,11 +284,13 @@ namespace embree
     
     DEFINE_INTERSECTOR4(BVH4iTriangle1Intersector4ChunkMoeller, BVH4iIntersector4Chunk<Triangle1Intersector4MoellerTrumbore>);
     DEFINE_INTERSECTOR4(BVH4iTriangle4Intersector4ChunkMoeller, BVH4iIntersector4Chunk<Triangle4Intersector4MoellerTrumbore>);
+    DEFINE_INTERSECTOR4(BVH4iTriangle4wIntersector4ChunkWoop, BVH4iIntersector4Chunk<Triangle4wIntersector4Woop>);
     DEFINE_INTERSECTOR4(BVH4iTriangle1vIntersector4ChunkPluecker, BVH4iIntersector4Chunk<Triangle1vIntersector4Pluecker>);
     DEFINE_INTERSECTOR4(BVH4iTriangle4vIntersector4ChunkPluecker, BVH4iIntersector4Chunk<Triangle4vIntersector4Pluecker>);
     DEFINE_INTERSECTOR4(BVH4iVirtualIntersector4Chunk, BVH4iIntersector4Chunk<VirtualAccelIntersector4>);
 #if defined (__AVX__)
     DEFINE_INTERSECTOR4(BVH4iTriangle8Intersector4ChunkMoeller, BVH4iIntersector4Chunk<Triangle8Intersector4MoellerTrumbore>);
+    DEFINE_INTERSECTOR4(BVH4iTriangle8wIntersector4ChunkWoop, BVH4iIntersector4Chunk<Triangle8wIntersector4Woop>);
 #endif
 
   }
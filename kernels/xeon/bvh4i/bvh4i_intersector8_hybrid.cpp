@@ -18,6 +18,8 @@
 
 #include "geometry/triangle4_intersector8_moeller.h"
 #include "geometry/triangle8_intersector8_moeller.h"
+#include "geometry/triangle4w_intersector8_woop.h"
+#include "geometry/triangle8w_intersector8_woop.h"
 #include "geometry/triangle4v_intersector8_pluecker.h"
 
 #define SWITCH_THRESHOLD 6
@@ -604,6 +606,8 @@ namespace embree
 
     DEFINE_INTERSECTOR8(BVH4iTriangle4Intersector8HybridMoeller, BVH4iIntersector8Hybrid<Triangle4Intersector8MoellerTrumbore>);
     DEFINE_INTERSECTOR8(BVH4iTriangle8Intersector8HybridMoeller, BVH4iIntersector8Hybrid<Triangle8Intersector8MoellerTrumbore>);
+    DEFINE_INTERSECTOR8(BVH4iTriangle4wIntersector8HybridWoop, BVH4iIntersector8Hybrid<Triangle4wIntersector8Woop>);
+    DEFINE_INTERSECTOR8(BVH4iTriangle8wIntersector8HybridWoop, BVH4iIntersector8Hybrid<Triangle8wIntersector8Woop>);
 
   }
 }
@@ -231,6 +231,12 @@ namespace embree
     /*! prints statistics */
     void print();
 
+    /*! adds the memory consumption of the BVH to the statistics, nodes
+     *  and triangles share one allocator and are only counted as allocated */
+    void memoryStatistics(RTCMemoryStatistics& stats) {
+      stats.allocated += alloc.bytes();
+    }
+
     /*! Rotates tree to improve SAH cost. */
     size_t rotate(Base* node, size_t depth);
 
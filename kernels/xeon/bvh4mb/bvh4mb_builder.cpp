@@ -32,6 +32,11 @@ namespace embree
     if (source->isEmpty())
       return;
 
+    /* grow the pool at once for the primitive references the builder does not hold yet */
+    const size_t bytesPrimRefs = source->size()*sizeof(PrimRef);
+    if (bytesPrimRefs > alloc.bytes()) 
+      Alloc::global.reserve(bytesPrimRefs-alloc.bytes());
+
     if (g_verbose >= 2) 
       std::cout << "building BVH4MB<" << bvh->primTy.name << "> with " << Heuristic::name() << " SAH builder ... " << std::flush;
 
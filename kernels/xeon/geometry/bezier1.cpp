@@ -0,0 +1,67 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#include "bezier1.h"
+#include "common/scene.h"
+
+namespace embree
+{
+  SceneBezier1 SceneBezier1::type("bezier1",1);
+  SceneBezier1 SceneBezier1::type_subdiv("bezier1.subdiv",4);
+
+  Bezier1Type::Bezier1Type (const char* name, size_t numSegments) 
+    : PrimitiveType(name,sizeof(Bezier1),1,false,2), numSegments(numSegments) {} 
+  
+  size_t Bezier1Type::blocks(size_t x) const {
+    return x;
+  }
+    
+  size_t Bezier1Type::size(const char* This) const {
+    return 1;
+  }
+
+  void SceneBezier1::pack(char* dst, atomic_set<PrimRefBlock>::block_iterator_unsafe& prims, void* geom) const 
+  {
+    Scene* scene = (Scene*) geom;
+    const PrimRef& prim = *prims;
+    const unsigned geomID = prim.geomID();
+    const unsigned curveID = prim.primID()/numSegments;
+    const unsigned segment = prim.primID()%numSegments;
+    const Scene::QuadraticBezierCurves* curves = scene->getQuadraticBezierCurves(geomID);
+    const float t0 = float(segment+0)/float(numSegments);
+    const float t1 = float(segment+1)/float(numSegments);
+    Vec3fa p0,p1,p2,p3; curves->segment(curveID,t0,t1,p0,p1,p2,p3);
+    new (dst) Bezier1(p0,p1,p2,p3,t0,t1,geomID,curveID,curves->mask);
+    prims++;
+  }
+  
+  BBox3f SceneBezier1::update(char* prim, size_t num, void* geom) const 
+  {
+    BBox3f bounds = empty;
+    Scene* scene = (Scene*) geom;
+    
+    for (size_t j=0; j<num; j++) 
+    {
+      Bezier1& dst = ((Bezier1*) prim)[j];
+      const Scene::QuadraticBezierCurves* curves = scene->getQuadraticBezierCurves(dst.geomID);
+      Vec3fa p0,p1,p2,p3; curves->segment(dst.primID,dst.t0,dst.t1,p0,p1,p2,p3);
+      new (&dst) Bezier1(p0,p1,p2,p3,dst.t0,dst.t1,dst.geomID,dst.primID,curves->mask);
+      bounds.extend(dst.bounds());
+    }
+    return bounds; 
+  }
+}
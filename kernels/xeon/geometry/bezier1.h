@@ -0,0 +1,78 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#ifndef __EMBREE_ACCEL_BEZIER1_H__
+#define __EMBREE_ACCEL_BEZIER1_H__
+
+#include "primitive.h"
+
+namespace embree
+{
+  /*! Cubic bezier curve with varying radius. The primitive covers the
+   *  part [t0,t1] of the original curve. */
+  struct Bezier1
+  {
+  public:
+
+    /*! Default constructor. */
+    __forceinline Bezier1 () {}
+
+    /*! Construction from control points and IDs. */
+    __forceinline Bezier1 (const Vec3fa& p0, const Vec3fa& p1, const Vec3fa& p2, const Vec3fa& p3, 
+                           const float t0, const float t1, const unsigned int geomID, const unsigned int primID, const unsigned int mask)
+      : p0(p0), p1(p1), p2(p2), p3(p3), t0(t0), t1(t1), geomID(geomID), primID(primID), mask(mask) {}
+
+    /*! calculate the bounds of the curve */
+    __forceinline BBox3f bounds() const {
+      const BBox3f b = merge(BBox3f(p0),BBox3f(p1),BBox3f(p2),BBox3f(p3));
+      return enlarge(b,Vec3fa(max(p0.w,p1.w,p2.w,p3.w)));
+    }
+    
+  public:
+    Vec3fa p0;            //!< 1st control point (x,y,z,r)
+    Vec3fa p1;            //!< 2nd control point (x,y,z,r)
+    Vec3fa p2;            //!< 3rd control point (x,y,z,r)
+    Vec3fa p3;            //!< 4th control point (x,y,z,r)
+    float t0,t1;          //!< range of the original curve covered by this primitive
+    unsigned int geomID;  //!< geometry ID
+    unsigned int primID;  //!< primitive ID
+    unsigned int mask;    //!< geometry mask
+  };
+
+  struct Bezier1Type : public PrimitiveType 
+  {
+    Bezier1Type (const char* name, size_t numSegments);
+    size_t blocks(size_t x) const;
+    size_t size(const char* This) const;
+
+  public:
+    size_t numSegments;   //!< number of primitives each curve got subdivided into
+  };
+
+  struct SceneBezier1 : public Bezier1Type
+  {
+    SceneBezier1 (const char* name, size_t numSegments) 
+      : Bezier1Type(name,numSegments) {}
+
+    static SceneBezier1 type;
+    static SceneBezier1 type_subdiv;
+    void pack(char* dst, atomic_set<PrimRefBlock>::block_iterator_unsafe& prims, void* geom) const; 
+    BBox3f update(char* prim, size_t num, void* geom) const;
+  };
+}
+
+#endif
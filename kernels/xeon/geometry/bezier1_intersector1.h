@@ -0,0 +1,223 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#ifndef __EMBREE_BEZIER1_INTERSECTOR1_H__
+#define __EMBREE_BEZIER1_INTERSECTOR1_H__
+
+#include "bezier1.h"
+#include "common/ray.h"
+#include "geometry/filter.h"
+
+namespace embree
+{
+  /*! Intersector for a single ray with a bezier curve. The curve is
+   *  transformed into a coordinate frame where the ray runs along the
+   *  z axis and is approximated by line segments with linearly
+   *  varying radius. A segment is hit if the distance of the ray to
+   *  the segment is smaller than the radius at the closest point. The
+   *  segments are processed in parallel using SSE or AVX. */
+  struct Bezier1Intersector1
+  {
+    typedef Bezier1 Primitive;
+
+    /*! number of line segments a curve gets approximated with */
+    static const size_t numSegments = 8;
+
+    /*! potential hits with the segments of a curve */
+    struct Hits
+    {
+      __align(32) float t[numSegments];  //!< hit distances
+      __align(32) float u[numSegments];  //!< curve parameters of hits
+    };
+
+    /*! transforms a control point into the coordinate frame of the ray */
+    static __forceinline Vec3fa toRaySpace(const Vec3fa& p, const Vec3fa& org, const Vec3fa& dx, const Vec3fa& dy, const Vec3fa& dz)
+    {
+      const Vec3fa d = p-org;
+      Vec3fa q(dot(d,dx),dot(d,dy),dot(d,dz)); 
+      q.w = p.w;
+      return q;
+    }
+
+    /*! evaluates the curve at multiple locations */
+    template<typename vfloat>
+    static __forceinline void eval(const vfloat& t, const Vec3fa& q0, const Vec3fa& q1, const Vec3fa& q2, const Vec3fa& q3, 
+                                   vfloat& x, vfloat& y, vfloat& z, vfloat& r)
+    {
+      const vfloat s = vfloat(one)-t;
+      const vfloat b0 = s*s*s;
+      const vfloat b1 = vfloat(3.0f)*t*s*s;
+      const vfloat b2 = vfloat(3.0f)*t*t*s;
+      const vfloat b3 = t*t*t;
+      x = b0*vfloat(q0.x) + b1*vfloat(q1.x) + b2*vfloat(q2.x) + b3*vfloat(q3.x);
+      y = b0*vfloat(q0.y) + b1*vfloat(q1.y) + b2*vfloat(q2.y) + b3*vfloat(q3.y);
+      z = b0*vfloat(q0.z) + b1*vfloat(q1.z) + b2*vfloat(q2.z) + b3*vfloat(q3.z);
+      r = b0*vfloat(q0.w) + b1*vfloat(q1.w) + b2*vfloat(q2.w) + b3*vfloat(q3.w);
+    }
+
+    /*! intersects the ray with the line segments between the curve points at ta and tb */
+    template<typename vfloat>
+    static __forceinline size_t intersectSegments(const vfloat& ta, const vfloat& tb, 
+                                                  const Vec3fa& q0, const Vec3fa& q1, const Vec3fa& q2, const Vec3fa& q3, 
+                                                  const float tnear, const float tfar, float* t_o, float* u_o)
+    {
+      vfloat ax,ay,az,ar; eval(ta,q0,q1,q2,q3,ax,ay,az,ar);
+      vfloat bx,by,bz,br; eval(tb,q0,q1,q2,q3,bx,by,bz,br);
+
+      /* find point on segment closest to the ray */
+      const vfloat dx = bx-ax, dy = by-ay;
+      const vfloat s = min(max(-(ax*dx+ay*dy)/(dx*dx+dy*dy),vfloat(zero)),vfloat(one));
+      const vfloat px = ax+s*dx, py = ay+s*dy;
+      const vfloat r = ar+s*(br-ar);
+      const vfloat z = az+s*(bz-az);
+
+      /* perform distance and depth test */
+      const size_t mask = movemask((px*px+py*py <= r*r) & (z > vfloat(tnear)) & (z < vfloat(tfar)));
+      *(vfloat*)t_o = z;
+      *(vfloat*)u_o = ta+s*(tb-ta);
+      return mask;
+    }
+
+    /*! Intersects the ray with all segments of the curve. Returns a
+     *  bitmask of the segments hit. */
+    static __forceinline size_t intersect(const Vec3fa& org, const Vec3fa& dir, const float tnear, const float tfar, const Bezier1& curve, Hits& hits)
+    {
+      /* calculate coordinate frame of the ray, z is measured in units of the ray parameter */
+      const Vec3fa dx0 = cross(Vec3fa(1.0f,0.0f,0.0f),dir);
+      const Vec3fa dx1 = cross(Vec3fa(0.0f,1.0f,0.0f),dir);
+      const Vec3fa dx = normalize(dot(dx0,dx0) > dot(dx1,dx1) ? dx0 : dx1);
+      const Vec3fa dy = normalize(cross(dir,dx));
+      const Vec3fa dz = dir*(1.0f/dot(dir,dir));
+
+      /* transform control points into ray space */
+      const Vec3fa q0 = toRaySpace(curve.p0,org,dx,dy,dz);
+      const Vec3fa q1 = toRaySpace(curve.p1,org,dx,dy,dz);
+      const Vec3fa q2 = toRaySpace(curve.p2,org,dx,dy,dz);
+      const Vec3fa q3 = toRaySpace(curve.p3,org,dx,dy,dz);
+
+      /* intersect all line segments */
+      const float dt = 1.0f/float(numSegments);
+#if defined(__AVX__)
+      const avxf ta = avxf(step)*avxf(dt);
+      return intersectSegments(ta,ta+avxf(dt),q0,q1,q2,q3,tnear,tfar,hits.t,hits.u);
+#else
+      const ssef ta0 = ssef(step)*ssef(dt);
+      const ssef ta1 = ta0+ssef(4.0f*dt);
+      const size_t mask0 = intersectSegments(ta0,ta0+ssef(dt),q0,q1,q2,q3,tnear,tfar,hits.t+0,hits.u+0);
+      const size_t mask1 = intersectSegments(ta1,ta1+ssef(dt),q0,q1,q2,q3,tnear,tfar,hits.t+4,hits.u+4);
+      return mask0 | (mask1 << 4);
+#endif
+    }
+
+    /*! returns the closest of the hits */
+    static __forceinline size_t closest(size_t mask, const Hits& hits)
+    {
+      size_t i = __bsf(mask);
+      for (size_t m=__btc(mask,i); m; m=__btc(m,__bsf(m))) 
+        if (hits.t[__bsf(m)] < hits.t[i]) i = __bsf(m);
+      return i;
+    }
+
+    /*! calculates the tangent of the curve, which is used as geometry normal */
+    static __forceinline Vec3fa tangent(const Bezier1& curve, const float t)
+    {
+      const float s = 1.0f-t;
+      return 3.0f*(s*s*(curve.p1-curve.p0) + 2.0f*s*t*(curve.p2-curve.p1) + t*t*(curve.p3-curve.p2));
+    }
+
+    /*! Intersect a ray with the curve and updates the hit. */
+    static __forceinline void intersect(Ray& ray, const Bezier1& curve, const void* geom)
+    {
+      /* ray masking test */
+      STAT3(normal.trav_prims,1,1,1);
+#if defined(__USE_RAY_MASK__)
+      if (unlikely((curve.mask & ray.mask) == 0)) return;
+#endif
+
+      Hits hits;
+      size_t mask = intersect(ray.org,ray.dir,ray.tnear,ray.tfar,curve,hits);
+      if (likely(mask == 0)) return;
+
+      /* intersection filter test */
+#if defined(__INTERSECTION_FILTER__)
+      Geometry* geometry = ((Scene*)geom)->get(curve.geomID);
+      while (unlikely(geometry->hasIntersectionFilter1()))
+      {
+        const size_t i = closest(mask,hits);
+        const float u = curve.t0 + hits.u[i]*(curve.t1-curve.t0);
+        if (runIntersectionFilter1(geometry,ray,u,0.0f,hits.t[i],tangent(curve,hits.u[i]),curve.geomID,curve.primID)) return;
+        mask = __btc(mask,i);
+        if (mask == 0) return;
+      }
+#endif
+
+      /* update hit information */
+      const size_t i = closest(mask,hits);
+      ray.u = curve.t0 + hits.u[i]*(curve.t1-curve.t0);
+      ray.v = 0.0f;
+      ray.tfar = hits.t[i];
+      ray.Ng = tangent(curve,hits.u[i]);
+      ray.geomID = curve.geomID;
+      ray.primID = curve.primID;
+    }
+
+    static __forceinline void intersect(Ray& ray, const Bezier1* curves, size_t num, void* geom)
+    {
+      for (size_t i=0; i<num; i++)
+        intersect(ray,curves[i],geom);
+    }
+
+    /*! Test if the ray is occluded by the curve. */
+    static __forceinline bool occluded(Ray& ray, const Bezier1& curve, const void* geom)
+    {
+      /* ray masking test */
+      STAT3(shadow.trav_prims,1,1,1);
+#if defined(__USE_RAY_MASK__)
+      if (unlikely((curve.mask & ray.mask) == 0)) return false;
+#endif
+
+      Hits hits;
+      size_t mask = intersect(ray.org,ray.dir,ray.tnear,ray.tfar,curve,hits);
+      if (likely(mask == 0)) return false;
+
+      /* intersection filter test */
+#if defined(__INTERSECTION_FILTER__)
+      Geometry* geometry = ((Scene*)geom)->get(curve.geomID);
+      while (unlikely(geometry->hasOcclusionFilter1()))
+      {
+        const size_t i = closest(mask,hits);
+        const float u = curve.t0 + hits.u[i]*(curve.t1-curve.t0);
+        if (runOcclusionFilter1(geometry,ray,u,0.0f,hits.t[i],tangent(curve,hits.u[i]),curve.geomID,curve.primID)) return true;
+        mask = __btc(mask,i);
+        if (mask == 0) return false;
+      }
+#endif
+      return true;
+    }
+
+    static __forceinline bool occluded(Ray& ray, const Bezier1* curves, size_t num, void* geom) 
+    {
+      for (size_t i=0; i<num; i++) 
+        if (occluded(ray,curves[i],geom))
+          return true;
+
+      return false;
+    }
+  };
+}
+
+#endif
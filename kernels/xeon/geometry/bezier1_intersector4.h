@@ -0,0 +1,141 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#ifndef __EMBREE_BEZIER1_INTERSECTOR4_H__
+#define __EMBREE_BEZIER1_INTERSECTOR4_H__
+
+#include "bezier1_intersector1.h"
+#include "common/ray4.h"
+#include "geometry/filter.h"
+
+namespace embree
+{
+  /*! Intersector for bezier curves with 4 rays. The rays are
+   *  processed one by one using the SIMD segment intersector of
+   *  Bezier1Intersector1. */
+  struct Bezier1Intersector4
+  {
+    typedef Bezier1 Primitive;
+    typedef Bezier1Intersector1::Hits Hits;
+
+    /*! Intersect ray k of the packet with the curve and updates the hit. */
+    static __forceinline void intersect(Ray4& ray, size_t k, const Bezier1& curve, void* geom)
+    {
+      /* ray masking test */
+      STAT3(normal.trav_prims,1,1,1);
+#if defined(__USE_RAY_MASK__)
+      if (unlikely((curve.mask & ray.mask[k]) == 0)) return;
+#endif
+
+      const Vec3fa org(ray.org.x[k],ray.org.y[k],ray.org.z[k]);
+      const Vec3fa dir(ray.dir.x[k],ray.dir.y[k],ray.dir.z[k]);
+      Hits hits;
+      size_t mask = Bezier1Intersector1::intersect(org,dir,ray.tnear[k],ray.tfar[k],curve,hits);
+      if (likely(mask == 0)) return;
+
+      /* intersection filter test */
+#if defined(__INTERSECTION_FILTER__)
+      Geometry* geometry = ((Scene*)geom)->get(curve.geomID);
+      while (unlikely(geometry->hasIntersectionFilter4()))
+      {
+        const size_t i = Bezier1Intersector1::closest(mask,hits);
+        const float u = curve.t0 + hits.u[i]*(curve.t1-curve.t0);
+        const Vec3fa Ng = Bezier1Intersector1::tangent(curve,hits.u[i]);
+        if (runIntersectionFilter4(geometry,ray,k,u,0.0f,hits.t[i],Ng,curve.geomID,curve.primID)) return;
+        mask = __btc(mask,i);
+        if (mask == 0) return;
+      }
+#endif
+
+      /* update hit information */
+      const size_t i = Bezier1Intersector1::closest(mask,hits);
+      const Vec3fa Ng = Bezier1Intersector1::tangent(curve,hits.u[i]);
+      ray.u[k] = curve.t0 + hits.u[i]*(curve.t1-curve.t0);
+      ray.v[k] = 0.0f;
+      ray.tfar[k] = hits.t[i];
+      ray.Ng.x[k] = Ng.x;
+      ray.Ng.y[k] = Ng.y;
+      ray.Ng.z[k] = Ng.z;
+      ray.geomID[k] = curve.geomID;
+      ray.primID[k] = curve.primID;
+    }
+
+    static __forceinline void intersect(Ray4& ray, size_t k, const Bezier1* curves, size_t num, void* geom)
+    {
+      for (size_t i=0; i<num; i++)
+        intersect(ray,k,curves[i],geom);
+    }
+
+    static __forceinline void intersect(const sseb& valid, Ray4& ray, const Bezier1* curves, size_t num, void* geom)
+    {
+      for (size_t m=movemask(valid), k=__bsf(m); m!=0; m=__btc(m,k), k=__bsf(m))
+        intersect(ray,k,curves,num,geom);
+    }
+
+    /*! Test if ray k of the packet is occluded by the curve. */
+    static __forceinline bool occluded(Ray4& ray, size_t k, const Bezier1& curve, void* geom)
+    {
+      /* ray masking test */
+      STAT3(shadow.trav_prims,1,1,1);
+#if defined(__USE_RAY_MASK__)
+      if (unlikely((curve.mask & ray.mask[k]) == 0)) return false;
+#endif
+
+      const Vec3fa org(ray.org.x[k],ray.org.y[k],ray.org.z[k]);
+      const Vec3fa dir(ray.dir.x[k],ray.dir.y[k],ray.dir.z[k]);
+      Hits hits;
+      size_t mask = Bezier1Intersector1::intersect(org,dir,ray.tnear[k],ray.tfar[k],curve,hits);
+      if (likely(mask == 0)) return false;
+
+      /* intersection filter test */
+#if defined(__INTERSECTION_FILTER__)
+      Geometry* geometry = ((Scene*)geom)->get(curve.geomID);
+      while (unlikely(geometry->hasOcclusionFilter4()))
+      {
+        const size_t i = Bezier1Intersector1::closest(mask,hits);
+        const float u = curve.t0 + hits.u[i]*(curve.t1-curve.t0);
+        const Vec3fa Ng = Bezier1Intersector1::tangent(curve,hits.u[i]);
+        if (runOcclusionFilter4(geometry,ray,k,u,0.0f,hits.t[i],Ng,curve.geomID,curve.primID)) return true;
+        mask = __btc(mask,i);
+        if (mask == 0) return false;
+      }
+#endif
+      return true;
+    }
+
+    static __forceinline bool occluded(Ray4& ray, size_t k, const Bezier1* curves, size_t num, void* geom) 
+    {
+      for (size_t i=0; i<num; i++) 
+        if (occluded(ray,k,curves[i],geom))
+          return true;
+
+      return false;
+    }
+
+    static __forceinline sseb occluded(const sseb& valid, Ray4& ray, const Bezier1* curves, size_t num, void* geom)
+    {
+      sseb terminated = !valid;
+      for (size_t m=movemask(valid), k=__bsf(m); m!=0; m=__btc(m,k), k=__bsf(m)) {
+        if (!occluded(ray,k,curves,num,geom)) continue;
+        terminated[k] = -1;
+      }
+      return terminated;
+    }
+  };
+}
+
+#endif
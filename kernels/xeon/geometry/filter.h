@@ -18,6 +18,7 @@
 #define __EMBREE_FILTER_H__
 
 #include "common/geometry.h"
+#include "common/scene.h"
 
 #include "common/ray.h"
 
@@ -35,6 +36,13 @@
 
 namespace embree
 {
+  /*! counts the invocation of a filter function in the statistics of the scene */
+  __forceinline void countFilterCall(const Geometry* const geometry)
+  {
+    SceneStat::Counters* stats = geometry->parent->statistics.thread();
+    STAT_SCENE(stats,filters++);
+  }
+
   __forceinline bool runIntersectionFilter1(const Geometry* const geometry, Ray& ray, 
                                             const float& u, const float& v, const float& t, const Vec3fa& Ng, const int geomID, const int primID)
   {
@@ -50,6 +58,7 @@ namespace embree
     ray.Ng = Ng;
 
     /* invoke filter function */
+    countFilterCall(geometry);
     AVX_ZERO_UPPER();
     geometry->intersectionFilter1(geometry->userPtr,(RTCRay&)ray);
     
@@ -78,6 +87,7 @@ namespace embree
     ray.Ng = Ng;
 
     /* invoke filter function */
+    countFilterCall(geometry);
     AVX_ZERO_UPPER();
     geometry->occlusionFilter1(geometry->userPtr,(RTCRay&)ray);
     
@@ -105,6 +115,7 @@ namespace embree
     const ssef ray_Ng_z = ray.Ng.z;     store4f(valid,&ray.Ng.z,Ng.z);
 
     /* invoke filter function */
+    countFilterCall(geometry);
     RTCFilterFunc4  filter4     = (RTCFilterFunc4)  geometry->intersectionFilter4;
     ISPCFilterFunc4 ispcFilter4 = (ISPCFilterFunc4) geometry->ispcIntersectionFilter4;
     AVX_ZERO_UPPER();
@@ -144,6 +155,7 @@ namespace embree
     store4f(valid,&ray.Ng.z,Ng.z);
 
     /* invoke filter function */
+    countFilterCall(geometry);
     RTCFilterFunc4  filter4     = (RTCFilterFunc4)  geometry->occlusionFilter4;
     ISPCFilterFunc4 ispcFilter4 = (ISPCFilterFunc4) geometry->ispcOcclusionFilter4;
     AVX_ZERO_UPPER();
@@ -172,6 +184,7 @@ namespace embree
     const ssef ray_Ng_z = ray.Ng.z;     ray.Ng.z[k] = Ng.z;
 
     /* invoke filter function */
+    countFilterCall(geometry);
     const sseb valid(1 << k);
     RTCFilterFunc4  filter4     = (RTCFilterFunc4)  geometry->intersectionFilter4;
     ISPCFilterFunc4 ispcFilter4 = (ISPCFilterFunc4) geometry->ispcIntersectionFilter4;
@@ -210,6 +223,7 @@ namespace embree
     ray.Ng.z[k] = Ng.z;
 
     /* invoke filter function */
+    countFilterCall(geometry);
     const sseb valid(1 << k);
     RTCFilterFunc4  filter4     = (RTCFilterFunc4)  geometry->occlusionFilter4;
     ISPCFilterFunc4 ispcFilter4 = (ISPCFilterFunc4) geometry->ispcOcclusionFilter4;
@@ -241,6 +255,7 @@ namespace embree
     const avxf ray_Ng_z = ray.Ng.z;     store8f(valid,&ray.Ng.z,Ng.z);
 
     /* invoke filter function */
+    countFilterCall(geometry);
     RTCFilterFunc8  filter8     = (RTCFilterFunc8)  geometry->intersectionFilter8;
     ISPCFilterFunc8 ispcFilter8 = (ISPCFilterFunc8) geometry->ispcIntersectionFilter8;
     AVX_ZERO_UPPER();
@@ -280,6 +295,7 @@ namespace embree
     store8f(valid,&ray.Ng.z,Ng.z);
 
     /* invoke filter function */
+    countFilterCall(geometry);
     RTCFilterFunc8  filter8     = (RTCFilterFunc8)  geometry->occlusionFilter8;
     ISPCFilterFunc8 ispcFilter8 = (ISPCFilterFunc8) geometry->ispcOcclusionFilter8;
     AVX_ZERO_UPPER();
@@ -308,6 +324,7 @@ namespace embree
     const avxf ray_Ng_z = ray.Ng.z;     ray.Ng.z[k] = Ng.z;
 
     /* invoke filter function */
+    countFilterCall(geometry);
     const avxb valid(1 << k);
     RTCFilterFunc8  filter8     = (RTCFilterFunc8)  geometry->intersectionFilter8;
     ISPCFilterFunc8 ispcFilter8 = (ISPCFilterFunc8) geometry->ispcIntersectionFilter8;
@@ -346,6 +363,7 @@ namespace embree
     ray.Ng.z[k] = Ng.z;
 
     /* invoke filter function */
+    countFilterCall(geometry);
     const avxb valid(1 << k);
     RTCFilterFunc8  filter8     = (RTCFilterFunc8)  geometry->occlusionFilter8;
     ISPCFilterFunc8 ispcFilter8 = (ISPCFilterFunc8) geometry->ispcOcclusionFilter8;
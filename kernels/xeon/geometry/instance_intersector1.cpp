@@ -15,6 +15,7 @@
 // ======================================================================== //
 
 #include "instance_intersector1.h"
+#include "common/scene.h"
 
 namespace embree
 {
@@ -49,7 +50,11 @@ namespace embree
       ray.dir = xfmVector(instance->world2local,ray_dir);
       ray.geomID = -1;
       ray.instID = instance->id;
+      SceneStat::Counters* stats = instance->parent->statistics.thread();
+      STAT_SCENE(stats,instances += 1);
+      SceneStat::Counters* objectStats = ((Scene*)instance->object)->statistics.begin();
       instance->object->intersect((RTCRay&)ray);
+      STAT_SCENE(objectStats,count(ray.geomID));
       ray.org = ray_org;
       ray.dir = ray_dir;
       if (ray.geomID == -1) {
@@ -65,7 +70,11 @@ namespace embree
       ray.org = xfmPoint (instance->world2local,ray_org);
       ray.dir = xfmVector(instance->world2local,ray_dir);
       ray.instID = instance->id;
+      SceneStat::Counters* stats = instance->parent->statistics.thread();
+      STAT_SCENE(stats,instances += 1);
+      SceneStat::Counters* objectStats = ((Scene*)instance->object)->statistics.begin();
       instance->object->occluded((RTCRay&)ray);
+      STAT_SCENE(objectStats,count(ray.geomID));
       ray.org = ray_org;
       ray.dir = ray_dir;
     }
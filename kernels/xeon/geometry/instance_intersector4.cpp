@@ -15,6 +15,7 @@
 // ======================================================================== //
 
 #include "instance_intersector4.h"
+#include "common/scene.h"
 
 namespace embree
 {
@@ -33,7 +34,11 @@ namespace embree
       ray.dir = xfmVector(world2local,ray_dir);
       ray.geomID = -1;
       ray.instID = instance->id;
+      SceneStat::Counters* stats = instance->parent->statistics.thread();
+      STAT_SCENE(stats,instances += popcnt(*valid));
+      SceneStat::Counters* objectStats = ((Scene*)instance->object)->statistics.begin();
       instance->object->intersect4(valid,(RTCRay4&)ray);
+      STAT_SCENE(objectStats,count(valid,(int*)&ray.geomID,4));
       ray.org = ray_org;
       ray.dir = ray_dir;
       sseb nohit = ray.geomID == ssei(-1);
@@ -50,7 +55,11 @@ namespace embree
       ray.org = xfmPoint (world2local,ray_org);
       ray.dir = xfmVector(world2local,ray_dir);
       ray.instID = instance->id;
+      SceneStat::Counters* stats = instance->parent->statistics.thread();
+      STAT_SCENE(stats,instances += popcnt(*valid));
+      SceneStat::Counters* objectStats = ((Scene*)instance->object)->statistics.begin();
       instance->object->occluded4(valid,(RTCRay4&)ray);
+      STAT_SCENE(objectStats,count(valid,(int*)&ray.geomID,4));
       ray.org = ray_org;
       ray.dir = ray_dir;
     }
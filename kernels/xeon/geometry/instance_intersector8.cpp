@@ -15,6 +15,7 @@
 // ======================================================================== //
 
 #include "instance_intersector8.h"
+#include "common/scene.h"
 
 namespace embree
 {
@@ -33,7 +34,11 @@ namespace embree
       ray.dir = xfmVector(world2local,ray_dir);
       ray.geomID = -1;
       ray.instID = instance->id;
+      SceneStat::Counters* stats = instance->parent->statistics.thread();
+      STAT_SCENE(stats,instances += popcnt(*valid));
+      SceneStat::Counters* objectStats = ((Scene*)instance->object)->statistics.begin();
       instance->object->intersect8(valid,(RTCRay8&)ray);
+      STAT_SCENE(objectStats,count(valid,(int*)&ray.geomID,8));
       ray.org = ray_org;
       ray.dir = ray_dir;
       avxb nohit = ray.geomID == avxi(-1);
@@ -50,7 +55,11 @@ namespace embree
       ray.org = xfmPoint (world2local,ray_org);
       ray.dir = xfmVector(world2local,ray_dir);
       ray.instID = instance->id;
+      SceneStat::Counters* stats = instance->parent->statistics.thread();
+      STAT_SCENE(stats,instances += popcnt(*valid));
+      SceneStat::Counters* objectStats = ((Scene*)instance->object)->statistics.begin();
       instance->object->occluded8(valid,(RTCRay8&)ray);
+      STAT_SCENE(objectStats,count(valid,(int*)&ray.geomID,8));
       ray.org = ray_org;
       ray.dir = ray_dir;
     }
@@ -0,0 +1,80 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef __EMBREE_ACCEL_QUAD4_H__
+#define __EMBREE_ACCEL_QUAD4_H__
+
+#include "primitive.h"
+
+namespace embree
+{
+  /*! Stores 4 quads with their 4 shared vertices. Each quad
+      (v0,v1,v2,v3) gets intersected as the two triangles (v0,v1,v3)
+      and (v2,v3,v1), thus 4 quads need half the memory of the 8
+      triangles of two Triangle4 blocks. The reported hit coordinates
+      u and v are the coordinates of the hit inside the quad, with u
+      running from v0 to v1 and v running from v0 to v3. */
+  struct Quad4
+  {
+  public:
+
+    /*! Default constructor. */
+    __forceinline Quad4 () {}
+
+    /*! Construction from vertices and IDs. */
+    __forceinline Quad4 (const sse3f& v0, const sse3f& v1, const sse3f& v2, const sse3f& v3, const ssei& geomID, const ssei& primID, const ssei& mask)
+      : v0(v0), v1(v1), v2(v2), v3(v3), geomID(geomID), primID(primID)
+    {
+#if defined(__USE_RAY_MASK__)
+      this->mask = mask;
+#endif
+    }
+
+    /*! Returns a mask that tells which quads are valid. */
+    __forceinline sseb valid() const { return geomID != ssei(-1); }
+
+    /*! Returns the number of stored quads. */
+    __forceinline size_t size() const {
+      return bitscan(~movemask(valid()));
+    }
+
+  public:
+    sse3f v0;      //!< 1st vertex of the quads.
+    sse3f v1;      //!< 2nd vertex of the quads.
+    sse3f v2;      //!< 3rd vertex of the quads.
+    sse3f v3;      //!< 4th vertex of the quads.
+    ssei geomID;   //!< user geometry ID
+    ssei primID;   //!< primitive ID
+#if defined(__USE_RAY_MASK__)
+    ssei mask;     //!< geometry mask
+#endif
+  };
+
+  struct Quad4Type : public PrimitiveType {
+    Quad4Type ();
+    size_t blocks(size_t x) const;
+    size_t size(const char* This) const;
+  };
+
+  struct SceneQuad4 : public Quad4Type
+  {
+    static SceneQuad4 type;
+    void pack(char* This, atomic_set<PrimRefBlock>::block_iterator_unsafe& prims, void* geom) const;
+    BBox3f update(char* prim, size_t num, void* geom) const;
+  };
+}
+
+#endif
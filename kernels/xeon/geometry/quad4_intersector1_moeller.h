@@ -0,0 +1,214 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef __EMBREE_ACCEL_QUAD4_INTERSECTOR1_MOELLER_H__
+#define __EMBREE_ACCEL_QUAD4_INTERSECTOR1_MOELLER_H__
+
+#include "quad4.h"
+#include "common/ray.h"
+#include "geometry/filter.h"
+
+namespace embree
+{
+  /*! Intersector for a single ray with 4 quads. Each quad gets
+   *  tested as two triangles using the same Moeller Trumbore test as
+   *  the Triangle4 intersector, with the edges and the geometry
+   *  normal calculated on the fly from the shared vertices. The
+   *  second triangle (v2,v3,v1) reports the mirrored coordinates
+   *  1-u and 1-v, which makes u and v continuous across the quad. */
+  struct Quad4Intersector1MoellerTrumbore
+  {
+    typedef Quad4 Primitive;
+
+    /*! Intersect a ray with one triangle of each of the 4 quads and updates the hit. */
+    template<bool flip>
+    static __forceinline void intersect(Ray& ray, const sse3f& p0, const sse3f& e1, const sse3f& e2, const Quad4& quad, void* geom)
+    {
+      /* calculate denominator */
+      const sse3f O = sse3f(ray.org);
+      const sse3f D = sse3f(ray.dir);
+      const sse3f C = p0 - O;
+      const sse3f R = cross(D,C);
+      const sse3f Ng = cross(e1,e2);
+      const ssef den = dot(Ng,D);
+      const ssef absDen = abs(den);
+      const ssef sgnDen = signmsk(den);
+
+      /* perform edge tests */
+      const ssef U = dot(R,e2) ^ sgnDen;
+      const ssef V = dot(R,e1) ^ sgnDen;
+
+      /* perform backface culling */
+#if defined(__BACKFACE_CULLING__)
+      sseb valid = (den > ssef(zero)) & (U >= 0.0f) & (V >= 0.0f) & (U+V<=absDen);
+#else
+      sseb valid = (den != ssef(zero)) & (U >= 0.0f) & (V >= 0.0f) & (U+V<=absDen);
+#endif
+      if (likely(none(valid))) return;
+      
+      /* perform depth test */
+      const ssef T = dot(Ng,C) ^ sgnDen;
+      valid &= (T > absDen*ssef(ray.tnear)) & (T < absDen*ssef(ray.tfar));
+      if (likely(none(valid))) return;
+
+      /* ray masking test */
+#if defined(__USE_RAY_MASK__)
+      valid &= (quad.mask & ray.mask) != 0;
+      if (unlikely(none(valid))) return;
+#endif
+
+      /* calculate hit information */
+      const ssef rcpAbsDen = rcp(absDen);
+      const ssef u = flip ? ssef(one) - U * rcpAbsDen : U * rcpAbsDen;
+      const ssef v = flip ? ssef(one) - V * rcpAbsDen : V * rcpAbsDen;
+      const ssef t = T * rcpAbsDen;
+      size_t i = select_min(valid,t);
+      int geomID = quad.geomID[i];
+      
+      /* intersection filter test */
+#if defined(__INTERSECTION_FILTER__)
+      while (true) 
+      {
+        Geometry* geometry = ((Scene*)geom)->get(geomID);
+        if (likely(!geometry->hasIntersectionFilter1())) 
+        {
+#endif
+          /* update hit information */
+          ray.u = u[i];
+          ray.v = v[i];
+          ray.tfar = t[i];
+          ray.Ng.x = Ng.x[i];
+          ray.Ng.y = Ng.y[i];
+          ray.Ng.z = Ng.z[i];
+          ray.geomID = geomID;
+          ray.primID = quad.primID[i];
+
+#if defined(__INTERSECTION_FILTER__)
+          return;
+        }
+
+        const Vec3fa Ng1 = Vec3fa(Ng.x[i],Ng.y[i],Ng.z[i]);
+        if (runIntersectionFilter1(geometry,ray,u[i],v[i],t[i],Ng1,geomID,quad.primID[i])) return;
+        valid[i] = 0;
+        if (none(valid)) return;
+        i = select_min(valid,t);
+        geomID = quad.geomID[i];
+      }
+#endif
+    }
+
+    /*! Intersect a ray with the 4 quads and updates the hit. */
+    static __forceinline void intersect(Ray& ray, const Quad4& quad, void* geom)
+    {
+      STAT3(normal.trav_prims,1,1,1);
+      intersect<false>(ray,quad.v0,quad.v0-quad.v1,quad.v3-quad.v0,quad,geom);
+      intersect<true >(ray,quad.v2,quad.v2-quad.v3,quad.v1-quad.v2,quad,geom);
+    }
+
+    static __forceinline void intersect(Ray& ray, const Quad4* quad, size_t num, void* geom)
+    {
+      for (size_t i=0; i<num; i++)
+        intersect(ray,quad[i],geom);
+    }
+
+    /*! Test if the ray is occluded by one triangle of each of the 4 quads. */
+    template<bool flip>
+    static __forceinline bool occluded(Ray& ray, const sse3f& p0, const sse3f& e1, const sse3f& e2, const Quad4& quad, void* geom)
+    {
+      /* calculate denominator */
+      const sse3f O = sse3f(ray.org);
+      const sse3f D = sse3f(ray.dir);
+      const sse3f C = p0 - O;
+      const sse3f R = cross(D,C);
+      const sse3f Ng = cross(e1,e2);
+      const ssef den = dot(Ng,D);
+      const ssef absDen = abs(den);
+      const ssef sgnDen = signmsk(den);
+
+      /* perform edge tests */
+      const ssef U = dot(R,e2) ^ sgnDen;
+      const ssef V = dot(R,e1) ^ sgnDen;
+      const ssef W = absDen-U-V;
+      sseb valid = (U >= 0.0f) & (V >= 0.0f) & (W >= 0.0f);
+      if (unlikely(none(valid))) return false;
+      
+      /* perform depth test */
+      const ssef T = dot(Ng,C) ^ sgnDen;
+      valid &= (den != ssef(zero)) & (T >= absDen*ssef(ray.tnear)) & (absDen*ssef(ray.tfar) >= T);
+      if (unlikely(none(valid))) return false;
+
+      /* perform backface culling */
+#if defined(__BACKFACE_CULLING__)
+      valid &= den > ssef(zero);
+      if (unlikely(none(valid))) return false;
+#endif
+
+      /* ray masking test */
+#if defined(__USE_RAY_MASK__)
+      valid &= (quad.mask & ray.mask) != 0;
+      if (unlikely(none(valid))) return false;
+#endif
+
+      /* intersection filter test */
+#if defined(__INTERSECTION_FILTER__)
+      size_t m=movemask(valid), i=__bsf(m);
+      while (true)
+      {  
+        const int geomID = quad.geomID[i];
+        Geometry* geometry = ((Scene*)geom)->get(geomID);
+
+        /* if we have no filter then the test passes */
+        if (likely(!geometry->hasOcclusionFilter1()))
+          break;
+
+        /* calculate hit information */
+        const ssef rcpAbsDen = rcp(absDen);
+        const ssef u = flip ? ssef(one) - U * rcpAbsDen : U * rcpAbsDen;
+        const ssef v = flip ? ssef(one) - V * rcpAbsDen : V * rcpAbsDen;
+        const ssef t = T * rcpAbsDen;
+        const Vec3fa Ng1 = Vec3fa(Ng.x[i],Ng.y[i],Ng.z[i]);
+        if (runOcclusionFilter1(geometry,ray,u[i],v[i],t[i],Ng1,geomID,quad.primID[i])) 
+          break;
+
+        /* test if one more triangle hit */
+        m=__btc(m,i); i=__bsf(m);
+        if (m == 0) return false;
+      }
+#endif
+
+      return true;
+    }
+
+    /*! Test if the ray is occluded by one of the quads. */
+    static __forceinline bool occluded(Ray& ray, const Quad4& quad, void* geom)
+    {
+      STAT3(shadow.trav_prims,1,1,1);
+      if (occluded<false>(ray,quad.v0,quad.v0-quad.v1,quad.v3-quad.v0,quad,geom)) return true;
+      return occluded<true>(ray,quad.v2,quad.v2-quad.v3,quad.v1-quad.v2,quad,geom);
+    }
+
+    static __forceinline bool occluded(Ray& ray, const Quad4* quad, size_t num, void* geom) 
+    {
+      for (size_t i=0; i<num; i++) 
+        if (occluded(ray,quad[i],geom))
+          return true;
+
+      return false;
+    }
+  };
+}
+
+#endif
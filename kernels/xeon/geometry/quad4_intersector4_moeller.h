@@ -0,0 +1,419 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef __EMBREE_ACCEL_QUAD4_INTERSECTOR4_MOELLER_H__
+#define __EMBREE_ACCEL_QUAD4_INTERSECTOR4_MOELLER_H__
+
+#include "quad4.h"
+#include "quad4_intersector1_moeller.h"
+
+#include "../common/ray4.h"
+
+namespace embree
+{
+  /*! Intersector for 4 quads with 4 rays. Each quad gets tested as
+   *  the two triangles (v0,v1,v3) and (v2,v3,v1) using the Moeller
+   *  Trumbore test of the Triangle4 intersector. */
+  struct Quad4Intersector4MoellerTrumbore
+  {
+    typedef Quad4 Primitive;
+
+    /*! Intersects 4 rays with one triangle of a quad. */
+    template<bool flip>
+    static __forceinline void intersect(const sseb& valid_i, Ray4& ray, const sse3f& p0, const sse3f& e1, const sse3f& e2, const int geomID, const int primID, const int mask, void* geom)
+    {
+      /* calculate denominator */
+      sseb valid = valid_i;
+      const sse3f Ng = cross(e1,e2);
+      const sse3f C = p0 - ray.org;
+      const sse3f R = cross(ray.dir,C);
+      const ssef den = dot(Ng,ray.dir);
+      const ssef absDen = abs(den);
+      const ssef sgnDen = signmsk(den);
+      
+      /* test against edge p2 p0 */
+      const ssef U = dot(R,e2) ^ sgnDen;
+      valid &= U >= 0.0f;
+      if (likely(none(valid))) return;
+      
+      /* test against edge p0 p1 */
+      const ssef V = dot(R,e1) ^ sgnDen;
+      valid &= V >= 0.0f;
+      if (likely(none(valid))) return;
+      
+      /* test against edge p1 p2 */
+      const ssef W = absDen-U-V;
+      valid &= W >= 0.0f;
+      if (likely(none(valid))) return;
+      
+      /* perform depth test */
+      const ssef T = dot(Ng,C) ^ sgnDen;
+      valid &= (T >= absDen*ray.tnear) & (absDen*ray.tfar >= T);
+      if (unlikely(none(valid))) return;
+
+      /* perform backface culling */
+#if defined(__BACKFACE_CULLING__)
+      valid &= den > ssef(zero);
+      if (unlikely(none(valid))) return;
+#else
+      valid &= den != ssef(zero);
+      if (unlikely(none(valid))) return;
+#endif
+
+      /* ray masking test */
+#if defined(__USE_RAY_MASK__)
+      valid &= (mask & ray.mask) != 0;
+      if (unlikely(none(valid))) return;
+#endif
+      
+      /* calculate hit information */
+      const ssef rcpAbsDen = rcp(absDen);
+      const ssef u = flip ? ssef(one) - U*rcpAbsDen : U*rcpAbsDen;
+      const ssef v = flip ? ssef(one) - V*rcpAbsDen : V*rcpAbsDen;
+      const ssef t = T*rcpAbsDen;
+
+      /* intersection filter test */
+#if defined(__INTERSECTION_FILTER__)
+      Geometry* geometry = ((Scene*)geom)->get(geomID);
+      if (unlikely(geometry->hasIntersectionFilter4())) {
+        runIntersectionFilter4(valid,geometry,ray,u,v,t,Ng,geomID,primID);
+        return;
+      }
+#endif
+
+      /* update hit information */
+      store4f(valid,&ray.u,u);
+      store4f(valid,&ray.v,v);
+      store4f(valid,&ray.tfar,t);
+      store4i(valid,&ray.geomID,geomID);
+      store4i(valid,&ray.primID,primID);
+      store4f(valid,&ray.Ng.x,Ng.x);
+      store4f(valid,&ray.Ng.y,Ng.y);
+      store4f(valid,&ray.Ng.z,Ng.z);
+    }
+
+    /*! Intersects 4 rays with 4 quads. */
+    static __forceinline void intersect(const sseb& valid_i, Ray4& ray, const Quad4& quad, void* geom)
+    {
+      for (size_t i=0; i<quad.size(); i++)
+      {
+        STAT3(normal.trav_prims,1,popcnt(valid_i),4);
+
+        /* load vertices */
+        const sse3f v0 = broadcast4f(quad.v0,i);
+        const sse3f v1 = broadcast4f(quad.v1,i);
+        const sse3f v2 = broadcast4f(quad.v2,i);
+        const sse3f v3 = broadcast4f(quad.v3,i);
+#if defined(__USE_RAY_MASK__)
+        const int mask = quad.mask[i];
+#else
+        const int mask = -1;
+#endif
+        intersect<false>(valid_i,ray,v0,v0-v1,v3-v0,quad.geomID[i],quad.primID[i],mask,geom);
+        intersect<true >(valid_i,ray,v2,v2-v3,v1-v2,quad.geomID[i],quad.primID[i],mask,geom);
+      }
+    }
+
+    static __forceinline void intersect(const sseb& valid, Ray4& ray, const Quad4* quad, size_t num, void* geom)
+    {
+      for (size_t i=0; i<num; i++) {
+        intersect(valid,ray,quad[i],geom);
+      }
+    }
+
+    /*! Test for 4 rays if they are occluded by one triangle of a quad. */
+    template<bool flip>
+    static __forceinline sseb occluded(const sseb& valid_i, Ray4& ray, const sse3f& p0, const sse3f& e1, const sse3f& e2, const int geomID, const int primID, const int mask, void* geom)
+    {
+      /* calculate denominator */
+      sseb valid = valid_i;
+      const sse3f Ng = cross(e1,e2);
+      const sse3f C = p0 - ray.org;
+      const sse3f R = cross(ray.dir,C);
+      const ssef den = dot(Ng,ray.dir);
+      const ssef absDen = abs(den);
+      const ssef sgnDen = signmsk(den);
+      
+      /* test against edge p2 p0 */
+      const ssef U = dot(R,e2) ^ sgnDen;
+      valid &= U >= 0.0f;
+      if (likely(none(valid))) return valid;
+      
+      /* test against edge p0 p1 */
+      const ssef V = dot(R,e1) ^ sgnDen;
+      valid &= V >= 0.0f;
+      if (likely(none(valid))) return valid;
+      
+      /* test against edge p1 p2 */
+      const ssef W = absDen-U-V;
+      valid &= W >= 0.0f;
+      if (likely(none(valid))) return valid;
+      
+      /* perform depth test */
+      const ssef T = dot(Ng,C) ^ sgnDen;
+      valid &= (T >= absDen*ray.tnear) & (absDen*ray.tfar >= T);
+      if (unlikely(none(valid))) return valid;
+
+      /* perform backface culling */
+#if defined(__BACKFACE_CULLING__)
+      valid &= den > ssef(zero);
+      if (unlikely(none(valid))) return valid;
+#else
+      valid &= den != ssef(zero);
+      if (unlikely(none(valid))) return valid;
+#endif
+
+      /* ray masking test */
+#if defined(__USE_RAY_MASK__)
+      valid &= (mask & ray.mask) != 0;
+      if (unlikely(none(valid))) return valid;
+#endif
+
+      /* intersection filter test */
+#if defined(__INTERSECTION_FILTER__)
+      Geometry* geometry = ((Scene*)geom)->get(geomID);
+      if (unlikely(geometry->hasOcclusionFilter4()))
+      {
+        /* calculate hit information */
+        const ssef rcpAbsDen = rcp(absDen);
+        const ssef u = flip ? ssef(one) - U*rcpAbsDen : U*rcpAbsDen;
+        const ssef v = flip ? ssef(one) - V*rcpAbsDen : V*rcpAbsDen;
+        const ssef t = T*rcpAbsDen;
+        valid = runOcclusionFilter4(valid,geometry,ray,u,v,t,Ng,geomID,primID);
+      }
+#endif
+      return valid;
+    }
+
+    /*! Test for 4 rays if they are occluded by any of the 4 quads. */
+    static __forceinline sseb occluded(const sseb& valid_i, Ray4& ray, const Quad4& quad, void* geom)
+    {
+      sseb valid0 = valid_i;
+
+      for (size_t i=0; i<quad.size(); i++)
+      {
+        STAT3(shadow.trav_prims,1,popcnt(valid0),4);
+
+        /* load vertices */
+        const sse3f v0 = broadcast4f(quad.v0,i);
+        const sse3f v1 = broadcast4f(quad.v1,i);
+        const sse3f v2 = broadcast4f(quad.v2,i);
+        const sse3f v3 = broadcast4f(quad.v3,i);
+#if defined(__USE_RAY_MASK__)
+        const int mask = quad.mask[i];
+#else
+        const int mask = -1;
+#endif
+
+        /* update occlusion */
+        valid0 &= !occluded<false>(valid0,ray,v0,v0-v1,v3-v0,quad.geomID[i],quad.primID[i],mask,geom);
+        if (none(valid0)) break;
+        valid0 &= !occluded<true >(valid0,ray,v2,v2-v3,v1-v2,quad.geomID[i],quad.primID[i],mask,geom);
+        if (none(valid0)) break;
+      }
+      return !valid0;
+    }
+
+    static __forceinline sseb occluded(const sseb& valid, Ray4& ray, const Quad4* quad, size_t num, void* geom)
+    {
+      sseb valid0 = valid;
+      for (size_t i=0; i<num; i++) {
+        valid0 &= !occluded(valid0,ray,quad[i],geom);
+        if (none(valid0)) break;
+      }
+      return !valid0;
+    }
+
+    /*! Intersect ray k with one triangle of each of the 4 quads and updates the hit. */
+    template<bool flip>
+    static __forceinline void intersect(Ray4& ray, size_t k, const sse3f& p0, const sse3f& e1, const sse3f& e2, const Quad4& quad, void* geom)
+    {
+      /* calculate denominator */
+      const sse3f O = broadcast4f(ray.org,k);
+      const sse3f D = broadcast4f(ray.dir,k);
+      const sse3f C = p0 - O;
+      const sse3f R = cross(D,C);
+      const sse3f Ng = cross(e1,e2);
+      const ssef den = dot(Ng,D);
+      const ssef absDen = abs(den);
+      const ssef sgnDen = signmsk(den);
+
+      /* perform edge tests */
+      const ssef U = dot(R,e2) ^ sgnDen;
+      const ssef V = dot(R,e1) ^ sgnDen;
+
+      /* perform backface culling */
+#if defined(__BACKFACE_CULLING__)
+      sseb valid = (den > ssef(zero)) & (U >= 0.0f) & (V >= 0.0f) & (U+V<=absDen);
+#else
+      sseb valid = (den != ssef(zero)) & (U >= 0.0f) & (V >= 0.0f) & (U+V<=absDen);
+#endif
+      if (likely(none(valid))) return;
+      
+      /* perform depth test */
+      const ssef T = dot(Ng,C) ^ sgnDen;
+      valid &= (T > absDen*ssef(ray.tnear[k])) & (T < absDen*ssef(ray.tfar[k]));
+      if (likely(none(valid))) return;
+
+      /* ray masking test */
+#if defined(__USE_RAY_MASK__)
+      valid &= (quad.mask & ray.mask[k]) != 0;
+      if (unlikely(none(valid))) return;
+#endif
+
+      /* calculate hit information */
+      const ssef rcpAbsDen = rcp(absDen);
+      const ssef u = flip ? ssef(one) - U * rcpAbsDen : U * rcpAbsDen;
+      const ssef v = flip ? ssef(one) - V * rcpAbsDen : V * rcpAbsDen;
+      const ssef t = T * rcpAbsDen;
+      size_t i = select_min(valid,t);
+      int geomID = quad.geomID[i];
+      
+      /* intersection filter test */
+#if defined(__INTERSECTION_FILTER__)
+      while (true) 
+      {
+        Geometry* geometry = ((Scene*)geom)->get(geomID);
+        if (likely(!geometry->hasIntersectionFilter4())) 
+        {
+#endif
+          /* update hit information */
+          ray.u[k] = u[i];
+          ray.v[k] = v[i];
+          ray.tfar[k] = t[i];
+          ray.Ng.x[k] = Ng.x[i];
+          ray.Ng.y[k] = Ng.y[i];
+          ray.Ng.z[k] = Ng.z[i];
+          ray.geomID[k] = geomID;
+          ray.primID[k] = quad.primID[i];
+
+#if defined(__INTERSECTION_FILTER__)
+          return;
+        }
+
+        const Vec3fa Ng1(Ng.x[i],Ng.y[i],Ng.z[i]);
+        if (runIntersectionFilter4(geometry,ray,k,u[i],v[i],t[i],Ng1,geomID,quad.primID[i])) return;
+        valid[i] = 0;
+        if (unlikely(none(valid))) return;
+        i = select_min(valid,t);
+        geomID = quad.geomID[i];
+      }
+#endif
+    }
+
+    /*! Intersect ray k with the 4 quads and updates the hit. */
+    static __forceinline void intersect(Ray4& ray, size_t k, const Quad4& quad, void* geom)
+    {
+      STAT3(normal.trav_prims,1,1,1);
+      intersect<false>(ray,k,quad.v0,quad.v0-quad.v1,quad.v3-quad.v0,quad,geom);
+      intersect<true >(ray,k,quad.v2,quad.v2-quad.v3,quad.v1-quad.v2,quad,geom);
+    }
+
+    static __forceinline void intersect(Ray4& ray, size_t k, const Quad4* quad, size_t num, void* geom)
+    {
+      for (size_t i=0; i<num; i++)
+        intersect(ray,k,quad[i],geom);
+    }
+
+    /*! Test if ray k is occluded by one triangle of each of the 4 quads. */
+    template<bool flip>
+    static __forceinline bool occluded(Ray4& ray, size_t k, const sse3f& p0, const sse3f& e1, const sse3f& e2, const Quad4& quad, void* geom)
+    {
+      /* calculate denominator */
+      const sse3f O = broadcast4f(ray.org,k);
+      const sse3f D = broadcast4f(ray.dir,k);
+      const sse3f C = p0 - O;
+      const sse3f R = cross(D,C);
+      const sse3f Ng = cross(e1,e2);
+      const ssef den = dot(Ng,D);
+      const ssef absDen = abs(den);
+      const ssef sgnDen = signmsk(den);
+
+      /* perform edge tests */
+      const ssef U = dot(R,e2) ^ sgnDen;
+      const ssef V = dot(R,e1) ^ sgnDen;
+      const ssef W = absDen-U-V;
+      sseb valid = (U >= 0.0f) & (V >= 0.0f) & (W >= 0.0f);
+      if (unlikely(none(valid))) return false;
+      
+      /* perform depth test */
+      const ssef T = dot(Ng,C) ^ sgnDen;
+      valid &= (T >= absDen*ssef(ray.tnear[k])) & (absDen*ssef(ray.tfar[k]) >= T);
+      if (unlikely(none(valid))) return false;
+
+      /* perform backface culling */
+#if defined(__BACKFACE_CULLING__)
+      valid &= den > ssef(zero);
+      if (unlikely(none(valid))) return false;
+#else
+      valid &= den != ssef(zero);
+      if (unlikely(none(valid))) return false;
+#endif
+
+      /* ray masking test */
+#if defined(__USE_RAY_MASK__)
+      valid &= (quad.mask & ray.mask[k]) != 0;
+      if (unlikely(none(valid))) return false;
+#endif
+
+      /* intersection filter test */
+#if defined(__INTERSECTION_FILTER__)
+
+      size_t i = select_min(valid,T);
+      int geomID = quad.geomID[i];
+
+      while (true) 
+      {
+        Geometry* geometry = ((Scene*)geom)->get(geomID);
+        if (likely(!geometry->hasOcclusionFilter4())) break;
+
+        /* calculate hit information */
+        const ssef rcpAbsDen = rcp(absDen);
+        const ssef u = flip ? ssef(one) - U * rcpAbsDen : U * rcpAbsDen;
+        const ssef v = flip ? ssef(one) - V * rcpAbsDen : V * rcpAbsDen;
+        const ssef t = T * rcpAbsDen;
+        const Vec3fa Ng1(Ng.x[i],Ng.y[i],Ng.z[i]);
+        if (runOcclusionFilter4(geometry,ray,k,u[i],v[i],t[i],Ng1,geomID,quad.primID[i])) break;
+        valid[i] = 0;
+        if (unlikely(none(valid))) return false;
+        i = select_min(valid,T);
+        geomID = quad.geomID[i];
+      }
+#endif
+
+      return true;
+    }
+
+    /*! Test if ray k is occluded by one of the 4 quads. */
+    static __forceinline bool occluded(Ray4& ray, size_t k, const Quad4& quad, void* geom)
+    {
+      STAT3(shadow.trav_prims,1,1,1);
+      if (occluded<false>(ray,k,quad.v0,quad.v0-quad.v1,quad.v3-quad.v0,quad,geom)) return true;
+      return occluded<true>(ray,k,quad.v2,quad.v2-quad.v3,quad.v1-quad.v2,quad,geom);
+    }
+
+    static __forceinline bool occluded(Ray4& ray, size_t k, const Quad4* quad, size_t num, void* geom) 
+    {
+      for (size_t i=0; i<num; i++) 
+        if (occluded(ray,k,quad[i],geom))
+          return true;
+
+      return false;
+    }
+  };
+}
+
+#endif
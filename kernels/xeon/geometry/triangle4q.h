@@ -0,0 +1,144 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef __EMBREE_ACCEL_TRIANGLE4Q_H__
+#define __EMBREE_ACCEL_TRIANGLE4Q_H__
+
+#include "primitive.h"
+
+namespace embree
+{
+  /*! Stores 4 triangles with their vertex coordinates quantized to 16
+      bits relative to the bounds of the 4 triangles. As neighboring
+      leaves quantize shared vertices differently, the intersectors
+      move each edge of a triangle outwards by a distance in world
+      space that covers the quantization error of its own and of the
+      neighboring leaves, to avoid cracks at shared edges. The leaf
+      needs 128 bytes (144 with ray masks), less than a Triangle4 leaf
+      and without requiring the vertex arrays after the build, but
+      more than a Triangle4i leaf, which references the vertex arrays
+      of the application. */
+  struct Triangle4q
+  {
+  public:
+
+    /*! Default constructor. */
+    __forceinline Triangle4q () {}
+
+    /*! Construction from vertices and IDs. */
+    __forceinline Triangle4q (const sse3f& v0, const sse3f& v1, const sse3f& v2, const ssei& geomID, const ssei& primID, const ssei& mask)
+      : geomID(geomID), primID(primID)
+    {
+#if defined(__USE_RAY_MASK__)
+      this->mask = mask;
+#endif
+      /* calculate bounds of the valid triangles */
+      const sseb valid = geomID != ssei(-1);
+      const sse3f p[3] = { v0, v1, v2 };
+      for (size_t d=0; d<3; d++)
+      {
+        const float lo = reduce_min(select(valid,min(min(v0[d],v1[d]),v2[d]),ssef(pos_inf)));
+        const float hi = reduce_max(select(valid,max(max(v0[d],v1[d]),v2[d]),ssef(neg_inf)));
+        lower[d] = lo;
+        scale[d] = hi > lo ? (hi-lo)*(1.0f/65535.0f) : 0.0f;
+      }
+
+      /* quantize vertices by rounding to the closest grid point */
+      for (size_t k=0; k<3; k++) {
+        for (size_t d=0; d<3; d++) {
+          const ssef rcpScale = scale[d] > 0.0f ? ssef(1.0f/scale[d]) : ssef(zero);
+          const ssef q = min(max((p[k][d]-ssef(lower[d]))*rcpScale,ssef(zero)),ssef(65535.0f));
+          for (size_t i=0; i<4; i++) v[k][d][i] = valid[i] ? (unsigned short) (q[i]+0.5f) : 0;
+        }
+      }
+    }
+
+    /*! Returns a mask that tells which triangles are valid. */
+    __forceinline sseb valid() const { return geomID != ssei(-1); }
+
+    /*! Returns the number of stored triangles. */
+    __forceinline size_t size() const {
+      return bitscan(~movemask(valid()));
+    }
+
+    /*! Distance in world space by which the edges of the triangles
+        get moved outwards. Rounding moves a vertex by at most half the
+        grid diagonal. Of two neighboring leaves, the one with the
+        larger grid moves its edges outwards by the full diagonal,
+        which covers the rounding of both leaves. The distance is
+        doubled to also cover the rounding of the intersection test. */
+    __forceinline float delta() const {
+      return 2.0f*sqrtf(scale.x*scale.x+scale.y*scale.y+scale.z*scale.z);
+    }
+
+    /*! Calculates the epsilons of the edge tests against the edges
+        p2 p0, p0 p1, and p1 p2 in barycentric space. Moving an edge by
+        delta in world space corresponds to delta divided by the height
+        of the triangle over that edge, thus thin triangles get large
+        epsilons only across their short extent. Degenerated triangles
+        get NaN epsilons that fail all edge tests. */
+    __forceinline void epsilon(const sse3f& e1, const sse3f& e2, const sse3f& Ng, ssef& epsU, ssef& epsV, ssef& epsW) const
+    {
+      const ssef rcpArea2 = ssef(delta())*rsqrt(dot(Ng,Ng));
+      epsU = rcpArea2*length(e2);
+      epsV = rcpArea2*length(e1);
+      epsW = rcpArea2*length(e1+e2);
+    }
+
+    /*! Decodes one coordinate of one vertex of the 4 triangles. */
+    __forceinline ssef vertex(size_t k, size_t d) const 
+    {
+      const __m128i q = _mm_loadl_epi64((const __m128i*)v[k][d]);
+      return ssef(lower[d]) + ssef(scale[d])*ssef(_mm_unpacklo_epi16(q,_mm_setzero_si128()));
+    }
+
+    /*! Decodes the base vertex, edges, and geometry normal in the layout of Triangle4. */
+    __forceinline void decode(sse3f& p0, sse3f& e1, sse3f& e2, sse3f& Ng) const
+    {
+      p0 = sse3f(vertex(0,0),vertex(0,1),vertex(0,2));
+      const sse3f p1(vertex(1,0),vertex(1,1),vertex(1,2));
+      const sse3f p2(vertex(2,0),vertex(2,1),vertex(2,2));
+      e1 = p0-p1;
+      e2 = p2-p0;
+      Ng = cross(e1,e2);
+    }
+
+  public:
+    ssei geomID;                  //!< user geometry ID
+    ssei primID;                  //!< primitive ID
+#if defined(__USE_RAY_MASK__)
+    ssei mask;                    //!< geometry mask
+#endif
+    Vec3f lower;                  //!< lower bounds of the quantization grid
+    Vec3f scale;                  //!< size of a grid cell
+    unsigned short v[3][3][4];    //!< quantized coordinates of the vertices
+  };
+
+  struct Triangle4qType : public PrimitiveType {
+    Triangle4qType ();
+    size_t blocks(size_t x) const;
+    size_t size(const char* This) const;
+  };
+
+  struct SceneTriangle4q : public Triangle4qType
+  {
+    static SceneTriangle4q type;
+    void pack(char* This, atomic_set<PrimRefBlock>::block_iterator_unsafe& prims, void* geom) const;
+    BBox3f update(char* prim, size_t num, void* geom) const;
+  };
+}
+
+#endif
@@ -0,0 +1,202 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef __EMBREE_ACCEL_TRIANGLE4Q_INTERSECTOR1_MOELLER_H__
+#define __EMBREE_ACCEL_TRIANGLE4Q_INTERSECTOR1_MOELLER_H__
+
+#include "triangle4q.h"
+#include "common/ray.h"
+#include "geometry/filter.h"
+
+namespace embree
+{
+  /*! Intersector for a single ray with 4 quantized triangles. The
+   *  triangles get decoded and intersected with the Moeller Trumbore
+   *  test of the Triangle4 intersector, with the edges moved
+   *  outwards by the epsilons of the triangles to close the cracks
+   *  between neighboring leaves. Hits inside this band get their
+   *  barycentric coordinates clamped onto the triangle. */
+  struct Triangle4qIntersector1MoellerTrumbore
+  {
+    typedef Triangle4q Primitive;
+
+    /*! Intersect a ray with the 4 triangles and updates the hit. */
+    static __forceinline void intersect(Ray& ray, const Triangle4q& tri, void* geom)
+    {
+      /* calculate denominator */
+      STAT3(normal.trav_prims,1,1,1);
+      sse3f p0,e1,e2,Ng; tri.decode(p0,e1,e2,Ng);
+      const sse3f O = sse3f(ray.org);
+      const sse3f D = sse3f(ray.dir);
+      const sse3f C = p0 - O;
+      const sse3f R = cross(D,C);
+      const ssef den = dot(Ng,D);
+      const ssef absDen = abs(den);
+      const ssef sgnDen = signmsk(den);
+      ssef epsU,epsV,epsW; tri.epsilon(e1,e2,Ng,epsU,epsV,epsW);
+
+      /* perform edge tests */
+      const ssef U = dot(R,e2) ^ sgnDen;
+      const ssef V = dot(R,e1) ^ sgnDen;
+
+      /* perform backface culling */
+#if defined(__BACKFACE_CULLING__)
+      sseb valid = (den > ssef(zero)) & (U >= -epsU*absDen) & (V >= -epsV*absDen) & (U+V <= absDen+epsW*absDen);
+#else
+      sseb valid = (den != ssef(zero)) & (U >= -epsU*absDen) & (V >= -epsV*absDen) & (U+V <= absDen+epsW*absDen);
+#endif
+      if (likely(none(valid))) return;
+      
+      /* perform depth test */
+      const ssef T = dot(Ng,C) ^ sgnDen;
+      valid &= (T > absDen*ssef(ray.tnear)) & (T < absDen*ssef(ray.tfar));
+      if (likely(none(valid))) return;
+
+      /* ray masking test */
+#if defined(__USE_RAY_MASK__)
+      valid &= (tri.mask & ray.mask) != 0;
+      if (unlikely(none(valid))) return;
+#endif
+
+      /* calculate hit information */
+      const ssef rcpAbsDen = rcp(absDen);
+      const ssef u = min(max(U,ssef(zero))*rcpAbsDen,ssef(one));
+      const ssef v = min(max(V,ssef(zero))*rcpAbsDen,ssef(one)-u);
+      const ssef t = T * rcpAbsDen;
+      size_t i = select_min(valid,t);
+      int geomID = tri.geomID[i];
+      
+      /* intersection filter test */
+#if defined(__INTERSECTION_FILTER__)
+      while (true) 
+      {
+        Geometry* geometry = ((Scene*)geom)->get(geomID);
+        if (likely(!geometry->hasIntersectionFilter1())) 
+        {
+#endif
+          /* update hit information */
+          ray.u = u[i];
+          ray.v = v[i];
+          ray.tfar = t[i];
+          ray.Ng.x = Ng.x[i];
+          ray.Ng.y = Ng.y[i];
+          ray.Ng.z = Ng.z[i];
+          ray.geomID = geomID;
+          ray.primID = tri.primID[i];
+
+#if defined(__INTERSECTION_FILTER__)
+          return;
+        }
+
+        Vec3fa Ng = Vec3fa(Ng.x[i],Ng.y[i],Ng.z[i]);
+        if (runIntersectionFilter1(geometry,ray,u[i],v[i],t[i],Ng,geomID,tri.primID[i])) return;
+        valid[i] = 0;
+        if (none(valid)) return;
+        i = select_min(valid,t);
+        geomID = tri.geomID[i];
+      }
+#endif
+    }
+
+    static __forceinline void intersect(Ray& ray, const Triangle4q* tri, size_t num, void* geom)
+    {
+      for (size_t i=0; i<num; i++)
+        intersect(ray,tri[i],geom);
+    }
+
+    /*! Test if the ray is occluded by one of the triangles. */
+    static __forceinline bool occluded(Ray& ray, const Triangle4q& tri, void* geom)
+    {
+      /* calculate denominator */
+      STAT3(shadow.trav_prims,1,1,1);
+      sse3f p0,e1,e2,Ng; tri.decode(p0,e1,e2,Ng);
+      const sse3f O = sse3f(ray.org);
+      const sse3f D = sse3f(ray.dir);
+      const sse3f C = p0 - O;
+      const sse3f R = cross(D,C);
+      const ssef den = dot(Ng,D);
+      const ssef absDen = abs(den);
+      const ssef sgnDen = signmsk(den);
+      ssef epsU,epsV,epsW; tri.epsilon(e1,e2,Ng,epsU,epsV,epsW);
+
+      /* perform edge tests */
+      const ssef U = dot(R,e2) ^ sgnDen;
+      const ssef V = dot(R,e1) ^ sgnDen;
+      const ssef W = absDen-U-V;
+      sseb valid = (U >= -epsU*absDen) & (V >= -epsV*absDen) & (W >= -epsW*absDen);
+      if (unlikely(none(valid))) return false;
+      
+      /* perform depth test */
+      const ssef T = dot(Ng,C) ^ sgnDen;
+      valid &= (den != ssef(zero)) & (T >= absDen*ssef(ray.tnear)) & (absDen*ssef(ray.tfar) >= T);
+      if (unlikely(none(valid))) return false;
+
+      /* perform backface culling */
+#if defined(__BACKFACE_CULLING__)
+      valid &= den > ssef(zero);
+      if (unlikely(none(valid))) return false;
+#endif
+
+      /* ray masking test */
+#if defined(__USE_RAY_MASK__)
+      valid &= (tri.mask & ray.mask) != 0;
+      if (unlikely(none(valid))) return false;
+#endif
+
+      /* intersection filter test */
+#if defined(__INTERSECTION_FILTER__)
+      size_t m=movemask(valid), i=__bsf(m);
+      while (true)
+      {  
+        const int geomID = tri.geomID[i];
+        Geometry* geometry = ((Scene*)geom)->get(geomID);
+
+        /* if we have no filter then the test passes */
+        if (likely(!geometry->hasOcclusionFilter1()))
+          break;
+
+        /* calculate hit information */
+        const ssef rcpAbsDen = rcp(absDen);
+        const ssef u = min(max(U,ssef(zero))*rcpAbsDen,ssef(one));
+        const ssef v = min(max(V,ssef(zero))*rcpAbsDen,ssef(one)-u);
+        const ssef t = T * rcpAbsDen;
+        const Vec3fa Ng = Vec3fa(Ng.x[i],Ng.y[i],Ng.z[i]);
+        if (runOcclusionFilter1(geometry,ray,u[i],v[i],t[i],Ng,geomID,tri.primID[i])) 
+          break;
+
+        /* test if one more triangle hit */
+        m=__btc(m,i); i=__bsf(m);
+        if (m == 0) return false;
+      }
+#endif
+
+      return true;
+    }
+
+    static __forceinline bool occluded(Ray& ray, const Triangle4q* tri, size_t num, void* geom) 
+    {
+      for (size_t i=0; i<num; i++) 
+        if (occluded(ray,tri[i],geom))
+          return true;
+
+      return false;
+    }
+  };
+}
+
+#endif
+
+
@@ -0,0 +1,394 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef __EMBREE_ACCEL_TRIANGLE4Q_INTERSECTOR4_MOELLER_H__
+#define __EMBREE_ACCEL_TRIANGLE4Q_INTERSECTOR4_MOELLER_H__
+
+#include "triangle4q.h"
+#include "triangle4q_intersector1_moeller.h"
+
+#include "../common/ray4.h"
+
+namespace embree
+{
+  /*! Intersector for 4 rays with 4 quantized triangles. The
+   *  triangles get decoded and intersected with the Moeller Trumbore
+   *  test of the Triangle4 intersector, with the edges moved
+   *  outwards by the epsilons of the triangles to close the cracks
+   *  between neighboring leaves. Hits inside this band get their
+   *  barycentric coordinates clamped onto the triangle. */
+  struct Triangle4qIntersector4MoellerTrumbore
+  {
+    typedef Triangle4q Primitive;
+
+    /*! Intersects a 4 rays with 4 triangles. */
+    static __forceinline void intersect(const sseb& valid_i, Ray4& ray, const Triangle4q& tri, void* geom)
+    {
+      /* decode the triangles once for all rays */
+      sse3f tv0,te1,te2,tNg; tri.decode(tv0,te1,te2,tNg);
+      ssef tepsU,tepsV,tepsW; tri.epsilon(te1,te2,tNg,tepsU,tepsV,tepsW);
+
+      for (size_t i=0; i<tri.size(); i++)
+      {
+        STAT3(normal.trav_prims,1,popcnt(valid_i),4);
+
+        /* load edges and geometry normal */
+        sseb valid = valid_i;
+        const sse3f p0 = broadcast4f(tv0,i);
+        const sse3f e1 = broadcast4f(te1,i);
+        const sse3f e2 = broadcast4f(te2,i);
+        const sse3f Ng = broadcast4f(tNg,i);
+        
+        /* calculate denominator */
+        const sse3f C = p0 - ray.org;
+        const sse3f R = cross(ray.dir,C);
+        const ssef den = dot(Ng,ray.dir);
+        const ssef absDen = abs(den);
+        const ssef sgnDen = signmsk(den);
+        
+        /* test against edge p2 p0 */
+        const ssef U = dot(R,e2) ^ sgnDen;
+        valid &= U >= -ssef(tepsU[i])*absDen;
+        if (likely(none(valid))) continue;
+        
+        /* test against edge p0 p1 */
+        const ssef V = dot(R,e1) ^ sgnDen;
+        valid &= V >= -ssef(tepsV[i])*absDen;
+        if (likely(none(valid))) continue;
+        
+        /* test against edge p1 p2 */
+        const ssef W = absDen-U-V;
+        valid &= W >= -ssef(tepsW[i])*absDen;
+        if (likely(none(valid))) continue;
+        
+        /* perform depth test */
+        const ssef T = dot(Ng,C) ^ sgnDen;
+        valid &= (T >= absDen*ray.tnear) & (absDen*ray.tfar >= T);
+        if (unlikely(none(valid))) continue;
+
+        /* perform backface culling */
+#if defined(__BACKFACE_CULLING__)
+        valid &= den > ssef(zero);
+        if (unlikely(none(valid))) continue;
+#else
+        valid &= den != ssef(zero);
+        if (unlikely(none(valid))) continue;
+#endif
+
+        /* ray masking test */
+#if defined(__USE_RAY_MASK__)
+        valid &= (tri.mask[i] & ray.mask) != 0;
+        if (unlikely(none(valid))) continue;
+#endif
+        
+        /* calculate hit information */
+        const ssef rcpAbsDen = rcp(absDen);
+        const ssef u = min(max(U,ssef(zero))*rcpAbsDen,ssef(one));
+        const ssef v = min(max(V,ssef(zero))*rcpAbsDen,ssef(one)-u);
+        const ssef t = T*rcpAbsDen;
+        const int geomID = tri.geomID[i];
+        const int primID = tri.primID[i];
+
+        /* intersection filter test */
+#if defined(__INTERSECTION_FILTER__)
+        Geometry* geometry = ((Scene*)geom)->get(geomID);
+        if (unlikely(geometry->hasIntersectionFilter4())) {
+          runIntersectionFilter4(valid,geometry,ray,u,v,t,Ng,geomID,primID);
+          continue;
+        }
+#endif
+
+        /* update hit information */
+        store4f(valid,&ray.u,u);
+        store4f(valid,&ray.v,v);
+        store4f(valid,&ray.tfar,t);
+        store4i(valid,&ray.geomID,geomID);
+        store4i(valid,&ray.primID,primID);
+        store4f(valid,&ray.Ng.x,Ng.x);
+        store4f(valid,&ray.Ng.y,Ng.y);
+        store4f(valid,&ray.Ng.z,Ng.z);
+      }
+    }
+
+    static __forceinline void intersect(const sseb& valid, Ray4& ray, const Triangle4q* tri, size_t num, void* geom)
+    {
+      for (size_t i=0; i<num; i++) {
+        intersect(valid,ray,tri[i],geom);
+      }
+    }
+
+    /*! Test for 4 rays if they are occluded by any of the 4 triangle. */
+    static __forceinline sseb occluded(const sseb& valid_i, Ray4& ray, const Triangle4q& tri, void* geom)
+    {
+      sseb valid0 = valid_i;
+
+      /* decode the triangles once for all rays */
+      sse3f tv0,te1,te2,tNg; tri.decode(tv0,te1,te2,tNg);
+      ssef tepsU,tepsV,tepsW; tri.epsilon(te1,te2,tNg,tepsU,tepsV,tepsW);
+
+
+      for (size_t i=0; i<tri.size(); i++)
+      {
+        STAT3(shadow.trav_prims,1,popcnt(valid0),4);
+
+        /* load edges and geometry normal */
+        sseb valid = valid0;
+        const sse3f p0 = broadcast4f(tv0,i);
+        const sse3f e1 = broadcast4f(te1,i);
+        const sse3f e2 = broadcast4f(te2,i);
+        const sse3f Ng = broadcast4f(tNg,i);
+        
+        /* calculate denominator */
+        const sse3f C = p0 - ray.org;
+        const sse3f R = cross(ray.dir,C);
+        const ssef den = dot(Ng,ray.dir);
+        const ssef absDen = abs(den);
+        const ssef sgnDen = signmsk(den);
+        
+        /* test against edge p2 p0 */
+        const ssef U = dot(R,e2) ^ sgnDen;
+        valid &= U >= -ssef(tepsU[i])*absDen;
+        if (likely(none(valid))) continue;
+        
+        /* test against edge p0 p1 */
+        const ssef V = dot(R,e1) ^ sgnDen;
+        valid &= V >= -ssef(tepsV[i])*absDen;
+        if (likely(none(valid))) continue;
+        
+        /* test against edge p1 p2 */
+        const ssef W = absDen-U-V;
+        valid &= W >= -ssef(tepsW[i])*absDen;
+        if (likely(none(valid))) continue;
+        
+        /* perform depth test */
+        const ssef T = dot(Ng,C) ^ sgnDen;
+        valid &= (T >= absDen*ray.tnear) & (absDen*ray.tfar >= T);
+        if (unlikely(none(valid))) continue;
+
+        /* perform backface culling */
+#if defined(__BACKFACE_CULLING__)
+        valid &= den > ssef(zero);
+        if (unlikely(none(valid))) continue;
+#else
+        valid &= den != ssef(zero);
+        if (unlikely(none(valid))) continue;
+#endif
+
+        /* ray masking test */
+#if defined(__USE_RAY_MASK__)
+        valid &= (tri.mask[i] & ray.mask) != 0;
+        if (unlikely(none(valid))) continue;
+#endif
+
+        /* intersection filter test */
+#if defined(__INTERSECTION_FILTER__)
+        const int geomID = tri.geomID[i];
+        Geometry* geometry = ((Scene*)geom)->get(geomID);
+        if (unlikely(geometry->hasOcclusionFilter4()))
+        {
+          /* calculate hit information */
+          const ssef rcpAbsDen = rcp(absDen);
+          const ssef u = min(max(U,ssef(zero))*rcpAbsDen,ssef(one));
+          const ssef v = min(max(V,ssef(zero))*rcpAbsDen,ssef(one)-u);
+          const ssef t = T*rcpAbsDen;
+          const int primID = tri.primID[i];
+          valid = runOcclusionFilter4(valid,geometry,ray,u,v,t,Ng,geomID,primID);
+        }
+#endif
+
+        /* update occlusion */
+        valid0 &= !valid;
+        if (none(valid0)) break;
+      }
+      return !valid0;
+    }
+
+    static __forceinline sseb occluded(const sseb& valid, Ray4& ray, const Triangle4q* tri, size_t num, void* geom)
+    {
+      sseb valid0 = valid;
+      for (size_t i=0; i<num; i++) {
+        valid0 &= !occluded(valid0,ray,tri[i],geom);
+        if (none(valid0)) break;
+      }
+      return !valid0;
+    }
+
+    /*! Intersect a ray with the 4 triangles and updates the hit. */
+    static __forceinline void intersect(Ray4& ray, size_t k, const Triangle4q& tri, void* geom)
+    {
+      /* calculate denominator */
+      STAT3(normal.trav_prims,1,1,1);
+      sse3f p0,e1,e2,Ng; tri.decode(p0,e1,e2,Ng);
+      const sse3f O = broadcast4f(ray.org,k);
+      const sse3f D = broadcast4f(ray.dir,k);
+      const sse3f C = p0 - O;
+      const sse3f R = cross(D,C);
+      const ssef den = dot(Ng,D);
+      const ssef absDen = abs(den);
+      const ssef sgnDen = signmsk(den);
+      ssef epsU,epsV,epsW; tri.epsilon(e1,e2,Ng,epsU,epsV,epsW);
+
+      /* perform edge tests */
+      const ssef U = dot(R,e2) ^ sgnDen;
+      const ssef V = dot(R,e1) ^ sgnDen;
+
+      /* perform backface culling */
+#if defined(__BACKFACE_CULLING__)
+      sseb valid = (den > ssef(zero)) & (U >= -epsU*absDen) & (V >= -epsV*absDen) & (U+V <= absDen+epsW*absDen);
+#else
+      sseb valid = (den != ssef(zero)) & (U >= -epsU*absDen) & (V >= -epsV*absDen) & (U+V <= absDen+epsW*absDen);
+#endif
+      if (likely(none(valid))) return;
+      
+      /* perform depth test */
+      const ssef T = dot(Ng,C) ^ sgnDen;
+      valid &= (T > absDen*ssef(ray.tnear[k])) & (T < absDen*ssef(ray.tfar[k]));
+      if (likely(none(valid))) return;
+
+      /* ray masking test */
+#if defined(__USE_RAY_MASK__)
+      valid &= (tri.mask & ray.mask[k]) != 0;
+      if (unlikely(none(valid))) return;
+#endif
+
+      /* calculate hit information */
+      const ssef rcpAbsDen = rcp(absDen);
+      const ssef u = min(max(U,ssef(zero))*rcpAbsDen,ssef(one));
+      const ssef v = min(max(V,ssef(zero))*rcpAbsDen,ssef(one)-u);
+      const ssef t = T * rcpAbsDen;
+      size_t i = select_min(valid,t);
+      int geomID = tri.geomID[i];
+      
+      /* intersection filter test */
+#if defined(__INTERSECTION_FILTER__)
+      while (true) 
+      {
+        Geometry* geometry = ((Scene*)geom)->get(geomID);
+        if (likely(!geometry->hasIntersectionFilter4())) 
+        {
+#endif
+          /* update hit information */
+          ray.u[k] = u[i];
+          ray.v[k] = v[i];
+          ray.tfar[k] = t[i];
+          ray.Ng.x[k] = Ng.x[i];
+          ray.Ng.y[k] = Ng.y[i];
+          ray.Ng.z[k] = Ng.z[i];
+          ray.geomID[k] = geomID;
+          ray.primID[k] = tri.primID[i];
+
+#if defined(__INTERSECTION_FILTER__)
+          return;
+        }
+
+        const Vec3fa Ng(Ng.x[i],Ng.y[i],Ng.z[i]);
+        if (runIntersectionFilter4(geometry,ray,k,u[i],v[i],t[i],Ng,geomID,tri.primID[i])) return;
+        valid[i] = 0;
+        if (unlikely(none(valid))) return;
+        i = select_min(valid,t);
+        geomID = tri.geomID[i];
+      }
+#endif
+    }
+
+    static __forceinline void intersect(Ray4& ray, size_t k, const Triangle4q* tri, size_t num, void* geom)
+    {
+      for (size_t i=0; i<num; i++)
+        intersect(ray,k,tri[i],geom);
+    }
+
+    /*! Test if the ray is occluded by one of the triangles. */
+    static __forceinline bool occluded(Ray4& ray, size_t k, const Triangle4q& tri, void* geom)
+    {
+      /* calculate denominator */
+      STAT3(shadow.trav_prims,1,1,1);
+      sse3f p0,e1,e2,Ng; tri.decode(p0,e1,e2,Ng);
+      const sse3f O = broadcast4f(ray.org,k);
+      const sse3f D = broadcast4f(ray.dir,k);
+      const sse3f C = p0 - O;
+      const sse3f R = cross(D,C);
+      const ssef den = dot(Ng,D);
+      const ssef absDen = abs(den);
+      const ssef sgnDen = signmsk(den);
+      ssef epsU,epsV,epsW; tri.epsilon(e1,e2,Ng,epsU,epsV,epsW);
+
+      /* perform edge tests */
+      const ssef U = dot(R,e2) ^ sgnDen;
+      const ssef V = dot(R,e1) ^ sgnDen;
+      const ssef W = absDen-U-V;
+      sseb valid = (U >= -epsU*absDen) & (V >= -epsV*absDen) & (W >= -epsW*absDen);
+      if (unlikely(none(valid))) return false;
+      
+      /* perform depth test */
+      const ssef T = dot(Ng,C) ^ sgnDen;
+      valid &= (T >= absDen*ssef(ray.tnear[k])) & (absDen*ssef(ray.tfar[k]) >= T);
+      if (unlikely(none(valid))) return false;
+
+      /* perform backface culling */
+#if defined(__BACKFACE_CULLING__)
+      valid &= den > ssef(zero);
+      if (unlikely(none(valid))) return false;
+#else
+      valid &= den != ssef(zero);
+      if (unlikely(none(valid))) return false;
+#endif
+
+      /* ray masking test */
+#if defined(__USE_RAY_MASK__)
+      valid &= (tri.mask & ray.mask[k]) != 0;
+      if (unlikely(none(valid))) return false;
+#endif
+
+      /* intersection filter test */
+#if defined(__INTERSECTION_FILTER__)
+
+      size_t i = select_min(valid,T);
+      int geomID = tri.geomID[i];
+
+      while (true) 
+      {
+        Geometry* geometry = ((Scene*)geom)->get(geomID);
+        if (likely(!geometry->hasOcclusionFilter4())) break;
+
+        /* calculate hit information */
+        const ssef rcpAbsDen = rcp(absDen);
+        const ssef u = min(max(U,ssef(zero))*rcpAbsDen,ssef(one));
+        const ssef v = min(max(V,ssef(zero))*rcpAbsDen,ssef(one)-u);
+        const ssef t = T * rcpAbsDen;
+        const Vec3fa Ng(Ng.x[i],Ng.y[i],Ng.z[i]);
+        if (runOcclusionFilter4(geometry,ray,k,u[i],v[i],t[i],Ng,geomID,tri.primID[i])) break;
+        valid[i] = 0;
+        if (unlikely(none(valid))) return false;
+        i = select_min(valid,T);
+        geomID = tri.geomID[i];
+      }
+#endif
+
+      return true;
+    }
+
+    static __forceinline bool occluded(Ray4& ray, size_t k, const Triangle4q* tri, size_t num, void* geom) 
+    {
+      for (size_t i=0; i<num; i++) 
+        if (occluded(ray,k,tri[i],geom))
+          return true;
+
+      return false;
+    }
+  };
+}
+
+#endif
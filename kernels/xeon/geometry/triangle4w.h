@@ -0,0 +1,96 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef __EMBREE_ACCEL_TRIANGLE4W_H__
+#define __EMBREE_ACCEL_TRIANGLE4W_H__
+
+#include "primitive.h"
+
+namespace embree
+{
+  /*! Precalculated representation for 4 triangles. Stores for each
+      triangle the affine transformation from world space into the
+      space of the unit triangle (0,0,0), (1,0,0), (0,1,0) as proposed
+      by Woop in "Real-Time Ray Tracing of Dynamic Scenes on an FPGA
+      Chip". The rows of the transformation yield the hit distance
+      and the barycentric coordinates of a ray with few operations,
+      at the cost of storing more data than Triangle4. */
+  struct Triangle4w
+  {
+  public:
+
+    /*! Default constructor. */
+    __forceinline Triangle4w () {}
+
+    /*! Construction from vertices and IDs. */
+    __forceinline Triangle4w (const sse3f& v0, const sse3f& v1, const sse3f& v2, const ssei& geomID, const ssei& primID, const ssei& mask)
+      : geomID(geomID), primID(primID)
+    {
+      /* the unit triangle space is spanned by the edges and the normal */
+      const sse3f e1 = v1-v0;
+      const sse3f e2 = v2-v0;
+      const sse3f N  = cross(e1,e2);
+      const ssef det = dot(N,N);
+      const ssef rcpDet = select(det != ssef(zero), ssef(one)/det, ssef(zero));
+
+      /* calculate the rows of the inverse of the matrix (e1,e2,N) */
+      Tu = cross(e2,N)*rcpDet; ou = -dot(Tu,v0);
+      Tv = cross(N,e1)*rcpDet; ov = -dot(Tv,v0);
+      Tw = N*rcpDet;           ow = -dot(Tw,v0);
+      Ng = -N;
+#if defined(__USE_RAY_MASK__)
+      this->mask = mask;
+#endif
+    }
+
+    /*! Returns a mask that tells which triangles are valid. */
+    __forceinline sseb valid() const { return geomID != ssei(-1); }
+
+    /*! Returns the number of stored triangles. */
+    __forceinline size_t size() const {
+      return bitscan(~movemask(valid()));
+    }
+
+  public:
+    sse3f Tw;      //!< 3rd row of the transformation, maps to the distance from the triangle plane.
+    ssef  ow;      //!< Offset of the 3rd row.
+    sse3f Tu;      //!< 1st row of the transformation, maps to the 1st barycentric coordinate.
+    ssef  ou;      //!< Offset of the 1st row.
+    sse3f Tv;      //!< 2nd row of the transformation, maps to the 2nd barycentric coordinate.
+    ssef  ov;      //!< Offset of the 2nd row.
+    sse3f Ng;      //!< Geometry normal of the triangles.
+    ssei geomID;   //!< user geometry ID
+    ssei primID;   //!< primitive ID
+#if defined(__USE_RAY_MASK__)
+    ssei mask;     //!< geometry mask
+#endif
+  };
+
+  struct Triangle4wType : public PrimitiveType {
+    Triangle4wType ();
+    size_t blocks(size_t x) const;
+    size_t size(const char* This) const;
+  };
+
+  struct SceneTriangle4w : public Triangle4wType
+  {
+    static SceneTriangle4w type;
+    void pack(char* This, atomic_set<PrimRefBlock>::block_iterator_unsafe& prims, void* geom) const;
+    BBox3f update(char* prim, size_t num, void* geom) const;
+  };
+}
+
+#endif
@@ -0,0 +1,322 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef __EMBREE_ACCEL_TRIANGLE4W_INTERSECTOR4_WOOP_H__
+#define __EMBREE_ACCEL_TRIANGLE4W_INTERSECTOR4_WOOP_H__
+
+#include "triangle4w.h"
+#include "triangle4w_intersector1_woop.h"
+
+#include "../common/ray4.h"
+
+namespace embree
+{
+  /*! Intersector for 4 triangles with 4 rays. Transforms the rays
+   *  into the unit triangle space of each triangle, see
+   *  Triangle4wIntersector1Woop. */
+  struct Triangle4wIntersector4Woop
+  {
+    typedef Triangle4w Primitive;
+
+    /*! Intersects 4 rays with 4 triangles. */
+    static __forceinline void intersect(const sseb& valid_i, Ray4& ray, const Triangle4w& tri, void* geom)
+    {
+      for (size_t i=0; i<tri.size(); i++)
+      {
+        STAT3(normal.trav_prims,1,popcnt(valid_i),4);
+
+        /* calculate hit distance */
+        sseb valid = valid_i;
+        const sse3f Tw = broadcast4f(tri.Tw,i);
+        const ssef Ow = dot(Tw,ray.org) + ssef(tri.ow[i]);
+        const ssef Dw = dot(Tw,ray.dir);
+        const ssef t = -Ow*rcp(Dw);
+
+        /* perform depth test */
+        valid &= (t > ray.tnear) & (t < ray.tfar);
+        if (likely(none(valid))) continue;
+
+        /* perform backface culling */
+#if defined(__BACKFACE_CULLING__)
+        valid &= Dw < ssef(zero);
+        if (unlikely(none(valid))) continue;
+#endif
+
+        /* test against edge p2 p0 */
+        const sse3f Tu = broadcast4f(tri.Tu,i);
+        const ssef u = dot(Tu,ray.org) + ssef(tri.ou[i]) + t*dot(Tu,ray.dir);
+        valid &= u >= 0.0f;
+        if (likely(none(valid))) continue;
+
+        /* test against edge p0 p1 and p1 p2 */
+        const sse3f Tv = broadcast4f(tri.Tv,i);
+        const ssef v = dot(Tv,ray.org) + ssef(tri.ov[i]) + t*dot(Tv,ray.dir);
+        valid &= (v >= 0.0f) & (u+v <= 1.0f);
+        if (likely(none(valid))) continue;
+
+        /* ray masking test */
+#if defined(__USE_RAY_MASK__)
+        valid &= (tri.mask[i] & ray.mask) != 0;
+        if (unlikely(none(valid))) continue;
+#endif
+
+        /* calculate hit information */
+        const sse3f Ng = broadcast4f(tri.Ng,i);
+        const int geomID = tri.geomID[i];
+        const int primID = tri.primID[i];
+
+        /* intersection filter test */
+#if defined(__INTERSECTION_FILTER__)
+        Geometry* geometry = ((Scene*)geom)->get(geomID);
+        if (unlikely(geometry->hasIntersectionFilter4())) {
+          runIntersectionFilter4(valid,geometry,ray,u,v,t,Ng,geomID,primID);
+          continue;
+        }
+#endif
+
+        /* update hit information */
+        store4f(valid,&ray.u,u);
+        store4f(valid,&ray.v,v);
+        store4f(valid,&ray.tfar,t);
+        store4i(valid,&ray.geomID,geomID);
+        store4i(valid,&ray.primID,primID);
+        store4f(valid,&ray.Ng.x,Ng.x);
+        store4f(valid,&ray.Ng.y,Ng.y);
+        store4f(valid,&ray.Ng.z,Ng.z);
+      }
+    }
+
+    static __forceinline void intersect(const sseb& valid, Ray4& ray, const Triangle4w* tri, size_t num, void* geom)
+    {
+      for (size_t i=0; i<num; i++) {
+        intersect(valid,ray,tri[i],geom);
+      }
+    }
+
+    /*! Test for 4 rays if they are occluded by any of the 4 triangles. */
+    static __forceinline sseb occluded(const sseb& valid_i, Ray4& ray, const Triangle4w& tri, void* geom)
+    {
+      sseb valid0 = valid_i;
+
+      for (size_t i=0; i<tri.size(); i++)
+      {
+        STAT3(shadow.trav_prims,1,popcnt(valid0),4);
+
+        /* calculate hit distance */
+        sseb valid = valid0;
+        const sse3f Tw = broadcast4f(tri.Tw,i);
+        const ssef Ow = dot(Tw,ray.org) + ssef(tri.ow[i]);
+        const ssef Dw = dot(Tw,ray.dir);
+        const ssef t = -Ow*rcp(Dw);
+
+        /* perform depth test */
+        valid &= (t >= ray.tnear) & (t <= ray.tfar);
+        if (likely(none(valid))) continue;
+
+        /* perform backface culling */
+#if defined(__BACKFACE_CULLING__)
+        valid &= Dw < ssef(zero);
+        if (unlikely(none(valid))) continue;
+#endif
+
+        /* test against edge p2 p0 */
+        const sse3f Tu = broadcast4f(tri.Tu,i);
+        const ssef u = dot(Tu,ray.org) + ssef(tri.ou[i]) + t*dot(Tu,ray.dir);
+        valid &= u >= 0.0f;
+        if (likely(none(valid))) continue;
+
+        /* test against edge p0 p1 and p1 p2 */
+        const sse3f Tv = broadcast4f(tri.Tv,i);
+        const ssef v = dot(Tv,ray.org) + ssef(tri.ov[i]) + t*dot(Tv,ray.dir);
+        valid &= (v >= 0.0f) & (u+v <= 1.0f);
+        if (likely(none(valid))) continue;
+
+        /* ray masking test */
+#if defined(__USE_RAY_MASK__)
+        valid &= (tri.mask[i] & ray.mask) != 0;
+        if (unlikely(none(valid))) continue;
+#endif
+
+        /* intersection filter test */
+#if defined(__INTERSECTION_FILTER__)
+        const int geomID = tri.geomID[i];
+        Geometry* geometry = ((Scene*)geom)->get(geomID);
+        if (unlikely(geometry->hasOcclusionFilter4()))
+        {
+          /* calculate hit information */
+          const sse3f Ng = broadcast4f(tri.Ng,i);
+          const int primID = tri.primID[i];
+          valid = runOcclusionFilter4(valid,geometry,ray,u,v,t,Ng,geomID,primID);
+        }
+#endif
+
+        /* update occlusion */
+        valid0 &= !valid;
+        if (none(valid0)) break;
+      }
+      return !valid0;
+    }
+
+    static __forceinline sseb occluded(const sseb& valid, Ray4& ray, const Triangle4w* tri, size_t num, void* geom)
+    {
+      sseb valid0 = valid;
+      for (size_t i=0; i<num; i++) {
+        valid0 &= !occluded(valid0,ray,tri[i],geom);
+        if (none(valid0)) break;
+      }
+      return !valid0;
+    }
+
+    /*! Intersect a ray with the 4 triangles and updates the hit. */
+    static __forceinline void intersect(Ray4& ray, size_t k, const Triangle4w& tri, void* geom)
+    {
+      /* calculate hit distance */
+      STAT3(normal.trav_prims,1,1,1);
+      const sse3f O = broadcast4f(ray.org,k);
+      const sse3f D = broadcast4f(ray.dir,k);
+      const ssef Ow = dot(tri.Tw,O) + tri.ow;
+      const ssef Dw = dot(tri.Tw,D);
+      const ssef t = -Ow*rcp(Dw);
+
+      /* perform depth test and backface culling */
+#if defined(__BACKFACE_CULLING__)
+      sseb valid = (Dw < ssef(zero)) & (t > ssef(ray.tnear[k])) & (t < ssef(ray.tfar[k]));
+#else
+      sseb valid = (t > ssef(ray.tnear[k])) & (t < ssef(ray.tfar[k]));
+#endif
+      if (likely(none(valid))) return;
+
+      /* perform edge tests */
+      const ssef u = dot(tri.Tu,O) + tri.ou + t*dot(tri.Tu,D);
+      const ssef v = dot(tri.Tv,O) + tri.ov + t*dot(tri.Tv,D);
+      valid &= (u >= 0.0f) & (v >= 0.0f) & (u+v <= 1.0f);
+      if (likely(none(valid))) return;
+
+      /* ray masking test */
+#if defined(__USE_RAY_MASK__)
+      valid &= (tri.mask & ray.mask[k]) != 0;
+      if (unlikely(none(valid))) return;
+#endif
+
+      /* calculate hit information */
+      size_t i = select_min(valid,t);
+      int geomID = tri.geomID[i];
+
+      /* intersection filter test */
+#if defined(__INTERSECTION_FILTER__)
+      while (true)
+      {
+        Geometry* geometry = ((Scene*)geom)->get(geomID);
+        if (likely(!geometry->hasIntersectionFilter4()))
+        {
+#endif
+          /* update hit information */
+          ray.u[k] = u[i];
+          ray.v[k] = v[i];
+          ray.tfar[k] = t[i];
+          ray.Ng.x[k] = tri.Ng.x[i];
+          ray.Ng.y[k] = tri.Ng.y[i];
+          ray.Ng.z[k] = tri.Ng.z[i];
+          ray.geomID[k] = geomID;
+          ray.primID[k] = tri.primID[i];
+
+#if defined(__INTERSECTION_FILTER__)
+          return;
+        }
+
+        const Vec3fa Ng(tri.Ng.x[i],tri.Ng.y[i],tri.Ng.z[i]);
+        if (runIntersectionFilter4(geometry,ray,k,u[i],v[i],t[i],Ng,geomID,tri.primID[i])) return;
+        valid[i] = 0;
+        if (unlikely(none(valid))) return;
+        i = select_min(valid,t);
+        geomID = tri.geomID[i];
+      }
+#endif
+    }
+
+    static __forceinline void intersect(Ray4& ray, size_t k, const Triangle4w* tri, size_t num, void* geom)
+    {
+      for (size_t i=0; i<num; i++)
+        intersect(ray,k,tri[i],geom);
+    }
+
+    /*! Test if the ray is occluded by one of the triangles. */
+    static __forceinline bool occluded(Ray4& ray, size_t k, const Triangle4w& tri, void* geom)
+    {
+      /* calculate hit distance */
+      STAT3(shadow.trav_prims,1,1,1);
+      const sse3f O = broadcast4f(ray.org,k);
+      const sse3f D = broadcast4f(ray.dir,k);
+      const ssef Ow = dot(tri.Tw,O) + tri.ow;
+      const ssef Dw = dot(tri.Tw,D);
+      const ssef t = -Ow*rcp(Dw);
+
+      /* perform depth test and backface culling */
+#if defined(__BACKFACE_CULLING__)
+      sseb valid = (Dw < ssef(zero)) & (t >= ssef(ray.tnear[k])) & (t <= ssef(ray.tfar[k]));
+#else
+      sseb valid = (t >= ssef(ray.tnear[k])) & (t <= ssef(ray.tfar[k]));
+#endif
+      if (likely(none(valid))) return false;
+
+      /* perform edge tests */
+      const ssef u = dot(tri.Tu,O) + tri.ou + t*dot(tri.Tu,D);
+      const ssef v = dot(tri.Tv,O) + tri.ov + t*dot(tri.Tv,D);
+      valid &= (u >= 0.0f) & (v >= 0.0f) & (u+v <= 1.0f);
+      if (likely(none(valid))) return false;
+
+      /* ray masking test */
+#if defined(__USE_RAY_MASK__)
+      valid &= (tri.mask & ray.mask[k]) != 0;
+      if (unlikely(none(valid))) return false;
+#endif
+
+      /* intersection filter test */
+#if defined(__INTERSECTION_FILTER__)
+
+      size_t i = select_min(valid,t);
+      int geomID = tri.geomID[i];
+
+      while (true)
+      {
+        Geometry* geometry = ((Scene*)geom)->get(geomID);
+        if (likely(!geometry->hasOcclusionFilter4())) break;
+
+        /* calculate hit information */
+        const Vec3fa Ng(tri.Ng.x[i],tri.Ng.y[i],tri.Ng.z[i]);
+        if (runOcclusionFilter4(geometry,ray,k,u[i],v[i],t[i],Ng,geomID,tri.primID[i])) break;
+        valid[i] = 0;
+        if (unlikely(none(valid))) return false;
+        i = select_min(valid,t);
+        geomID = tri.geomID[i];
+      }
+#endif
+
+      return true;
+    }
+
+    static __forceinline bool occluded(Ray4& ray, size_t k, const Triangle4w* tri, size_t num, void* geom)
+    {
+      for (size_t i=0; i<num; i++)
+        if (occluded(ray,k,tri[i],geom))
+          return true;
+
+      return false;
+    }
+  };
+}
+
+#endif
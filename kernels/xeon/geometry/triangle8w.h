@@ -0,0 +1,97 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef __EMBREE_ACCEL_TRIANGLE8W_H__
+#define __EMBREE_ACCEL_TRIANGLE8W_H__
+
+#include "primitive.h"
+
+namespace embree
+{
+#if defined __AVX__
+
+  /*! Precalculated representation for 8 triangles. Stores for each
+      triangle the affine transformation from world space into the
+      space of the unit triangle, see Triangle4w. */
+  struct Triangle8w
+  {
+  public:
+
+    /*! Default constructor. */
+    __forceinline Triangle8w () {}
+
+    /*! Construction from vertices and IDs. */
+    __forceinline Triangle8w (const avx3f& v0, const avx3f& v1, const avx3f& v2, const avxi& geomID, const avxi& primID, const avxi& mask)
+      : geomID(geomID), primID(primID)
+    {
+      /* the unit triangle space is spanned by the edges and the normal */
+      const avx3f e1 = v1-v0;
+      const avx3f e2 = v2-v0;
+      const avx3f N  = cross(e1,e2);
+      const avxf det = dot(N,N);
+      const avxf rcpDet = select(det != avxf(zero), avxf(one)/det, avxf(zero));
+
+      /* calculate the rows of the inverse of the matrix (e1,e2,N) */
+      Tu = cross(e2,N)*rcpDet; ou = -dot(Tu,v0);
+      Tv = cross(N,e1)*rcpDet; ov = -dot(Tv,v0);
+      Tw = N*rcpDet;           ow = -dot(Tw,v0);
+      Ng = -N;
+#if defined(__USE_RAY_MASK__)
+      this->mask = mask;
+#endif
+    }
+
+    /*! Returns a mask that tells which triangles are valid. */
+    __forceinline avxb valid() const { return geomID != avxi(-1); }
+
+    /*! Returns the number of stored triangles. */
+    __forceinline unsigned int size() const {
+      return __bsf(~movemask(valid()));
+    }
+
+  public:
+    avx3f Tw;      //!< 3rd row of the transformation, maps to the distance from the triangle plane.
+    avxf  ow;      //!< Offset of the 3rd row.
+    avx3f Tu;      //!< 1st row of the transformation, maps to the 1st barycentric coordinate.
+    avxf  ou;      //!< Offset of the 1st row.
+    avx3f Tv;      //!< 2nd row of the transformation, maps to the 2nd barycentric coordinate.
+    avxf  ov;      //!< Offset of the 2nd row.
+    avx3f Ng;      //!< Geometry normal of the triangles.
+    avxi geomID;   //!< user geometry ID
+    avxi primID;   //!< primitive ID
+#if defined(__USE_RAY_MASK__)
+    avxi mask;     //!< geometry mask
+#endif
+  };
+#endif
+
+#if defined(__TARGET_AVX__)
+  struct Triangle8wType : public PrimitiveType {
+    Triangle8wType ();
+    size_t blocks(size_t x) const;
+    size_t size(const char* This) const;
+  };
+
+  struct SceneTriangle8w : public Triangle8wType
+  {
+    static SceneTriangle8w type;
+    void pack(char* This, atomic_set<PrimRefBlock>::block_iterator_unsafe& prims, void* geom) const;
+    BBox3f update(char* prim, size_t num, void* geom) const;
+  };
+#endif
+}
+
+#endif
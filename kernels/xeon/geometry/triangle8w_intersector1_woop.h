@@ -0,0 +1,178 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef __EMBREE_ACCEL_TRIANGLE8W_INTERSECTOR1_WOOP_H__
+#define __EMBREE_ACCEL_TRIANGLE8W_INTERSECTOR1_WOOP_H__
+
+#include "triangle8w.h"
+#include "common/ray.h"
+#include "geometry/filter.h"
+
+namespace embree
+{
+  /*! Intersector for a single ray with 8 triangles. The ray gets
+   *  transformed into the unit triangle space of each triangle,
+   *  where the hit distance is the zero crossing of the 3rd
+   *  coordinate and the barycentric coordinates are the first two
+   *  coordinates at that distance. This requires fewer operations
+   *  than the Moeller Trumbore test, but the triangles are not
+   *  watertight at shared edges. */
+  struct Triangle8wIntersector1Woop
+  {
+    typedef Triangle8w Primitive;
+
+    /*! Intersect a ray with the 8 triangles and updates the hit. */
+    static __forceinline void intersect(Ray& ray, const Triangle8w& tri, void* geom)
+    {
+      /* calculate hit distance */
+      STAT3(normal.trav_prims,1,1,1);
+      const avx3f O = avx3f(ray.org);
+      const avx3f D = avx3f(ray.dir);
+      const avxf Ow = dot(tri.Tw,O) + tri.ow;
+      const avxf Dw = dot(tri.Tw,D);
+      const avxf t = -Ow*rcp(Dw);
+
+      /* perform depth test and backface culling */
+#if defined(__BACKFACE_CULLING__)
+      avxb valid = (Dw < avxf(zero)) & (t > avxf(ray.tnear)) & (t < avxf(ray.tfar));
+#else
+      avxb valid = (t > avxf(ray.tnear)) & (t < avxf(ray.tfar));
+#endif
+      if (likely(none(valid))) return;
+
+      /* perform edge tests */
+      const avxf u = dot(tri.Tu,O) + tri.ou + t*dot(tri.Tu,D);
+      const avxf v = dot(tri.Tv,O) + tri.ov + t*dot(tri.Tv,D);
+      valid &= (u >= 0.0f) & (v >= 0.0f) & (u+v <= 1.0f);
+      if (likely(none(valid))) return;
+
+      /* ray masking test */
+#if defined(__USE_RAY_MASK__)
+      valid &= (tri.mask & ray.mask) != 0;
+      if (unlikely(none(valid))) return;
+#endif
+
+      /* calculate hit information */
+      size_t i = select_min(valid,t);
+      int geomID = tri.geomID[i];
+
+      /* intersection filter test */
+#if defined(__INTERSECTION_FILTER__)
+      while (true)
+      {
+        Geometry* geometry = ((Scene*)geom)->get(geomID);
+        if (likely(!geometry->hasIntersectionFilter1()))
+        {
+#endif
+          /* update hit information */
+          ray.u = u[i];
+          ray.v = v[i];
+          ray.tfar = t[i];
+          ray.Ng.x = tri.Ng.x[i];
+          ray.Ng.y = tri.Ng.y[i];
+          ray.Ng.z = tri.Ng.z[i];
+          ray.geomID = geomID;
+          ray.primID = tri.primID[i];
+
+#if defined(__INTERSECTION_FILTER__)
+          return;
+        }
+
+        Vec3fa Ng = Vec3fa(tri.Ng.x[i],tri.Ng.y[i],tri.Ng.z[i]);
+        if (runIntersectionFilter1(geometry,ray,u[i],v[i],t[i],Ng,geomID,tri.primID[i])) return;
+        valid[i] = 0;
+        if (none(valid)) return;
+        i = select_min(valid,t);
+        geomID = tri.geomID[i];
+      }
+#endif
+    }
+
+    static __forceinline void intersect(Ray& ray, const Triangle8w* tri, size_t num, void* geom)
+    {
+      for (size_t i=0; i<num; i++)
+        intersect(ray,tri[i],geom);
+    }
+
+    /*! Test if the ray is occluded by one of the triangles. */
+    static __forceinline bool occluded(Ray& ray, const Triangle8w& tri, void* geom)
+    {
+      /* calculate hit distance */
+      STAT3(shadow.trav_prims,1,1,1);
+      const avx3f O = avx3f(ray.org);
+      const avx3f D = avx3f(ray.dir);
+      const avxf Ow = dot(tri.Tw,O) + tri.ow;
+      const avxf Dw = dot(tri.Tw,D);
+      const avxf t = -Ow*rcp(Dw);
+
+      /* perform depth test and backface culling */
+#if defined(__BACKFACE_CULLING__)
+      avxb valid = (Dw < avxf(zero)) & (t >= avxf(ray.tnear)) & (t <= avxf(ray.tfar));
+#else
+      avxb valid = (t >= avxf(ray.tnear)) & (t <= avxf(ray.tfar));
+#endif
+      if (likely(none(valid))) return false;
+
+      /* perform edge tests */
+      const avxf u = dot(tri.Tu,O) + tri.ou + t*dot(tri.Tu,D);
+      const avxf v = dot(tri.Tv,O) + tri.ov + t*dot(tri.Tv,D);
+      valid &= (u >= 0.0f) & (v >= 0.0f) & (u+v <= 1.0f);
+      if (likely(none(valid))) return false;
+
+      /* ray masking test */
+#if defined(__USE_RAY_MASK__)
+      valid &= (tri.mask & ray.mask) != 0;
+      if (unlikely(none(valid))) return false;
+#endif
+
+      /* intersection filter test */
+#if defined(__INTERSECTION_FILTER__)
+      size_t m=movemask(valid), i=__bsf(m);
+      while (true)
+      {
+        const int geomID = tri.geomID[i];
+        Geometry* geometry = ((Scene*)geom)->get(geomID);
+
+        /* if we have no filter then the test passes */
+        if (likely(!geometry->hasOcclusionFilter1()))
+          break;
+
+        /* calculate hit information */
+        const Vec3fa Ng = Vec3fa(tri.Ng.x[i],tri.Ng.y[i],tri.Ng.z[i]);
+        if (runOcclusionFilter1(geometry,ray,u[i],v[i],t[i],Ng,geomID,tri.primID[i]))
+          break;
+
+        /* test if one more triangle hit */
+        m=__btc(m,i); i=__bsf(m);
+        if (m == 0) return false;
+      }
+#endif
+
+      return true;
+    }
+
+    static __forceinline bool occluded(Ray& ray, const Triangle8w* tri, size_t num, void* geom)
+    {
+      for (size_t i=0; i<num; i++)
+        if (occluded(ray,tri[i],geom))
+          return true;
+
+      return false;
+    }
+  };
+}
+
+#endif
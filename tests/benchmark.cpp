@@ -32,6 +32,7 @@ namespace embree
   /* vertex and triangle layout */
   struct Vertex   { float x,y,z,a; };
   struct Triangle { int v0, v1, v2; };
+  struct Quad     { int v0, v1, v2, v3; };
 
 #define AssertNoError() \
   if (rtcGetError() != RTC_NO_ERROR) return false;
@@ -324,6 +325,27 @@ namespace embree
     return geom;
   }
 
+  unsigned addQuadSphere (RTCScene scene, RTCGeometryFlags flag, const Vec3f pos, const float r, size_t numPhi)
+  {
+    /* the quads of the sphere split into the triangles of createSphereMesh */
+    Mesh mesh; createSphereMesh (pos, r, numPhi, mesh);
+    size_t numTheta = 2*numPhi;
+    unsigned geom = rtcNewQuadMesh (scene, flag, numTheta*numPhi, mesh.vertices.size());
+    memcpy(rtcMapBuffer(scene,geom,RTC_VERTEX_BUFFER), &mesh.vertices[0], mesh.vertices.size()*sizeof(Vertex));
+    Quad* quads = (Quad*) rtcMapBuffer(scene,geom,RTC_INDEX_BUFFER);
+    for (size_t phi=1, i=0; phi<=numPhi; phi++) {
+      for (size_t theta=1; theta<=numTheta; theta++, i++) {
+        quads[i].v0 = (phi-1)*numTheta+theta-1;
+        quads[i].v1 = (phi-1)*numTheta+theta%numTheta;
+        quads[i].v2 = phi*numTheta+theta%numTheta;
+        quads[i].v3 = phi*numTheta+theta-1;
+      }
+    }
+    rtcUnmapBuffer(scene,geom,RTC_VERTEX_BUFFER);
+    rtcUnmapBuffer(scene,geom,RTC_INDEX_BUFFER);
+    return geom;
+  }
+
   double rtcore_create_geometry(RTCSceneFlags sflags, RTCGeometryFlags gflags, size_t numPhi, size_t numMeshes)
   {
     Mesh mesh; createSphereMesh (Vec3f(0,0,0), 1, numPhi, mesh);
@@ -352,6 +374,37 @@ namespace embree
     return double(numTriangles)/(t1-t0);
   }
   
+  double rtcore_create_geometry_batch(RTCSceneFlags sflags, RTCGeometryFlags gflags, size_t numPhi, size_t numMeshes)
+  {
+    Mesh mesh; createSphereMesh (Vec3f(0,0,0), 1, numPhi, mesh);
+
+    /* the application stores all meshes in one index and one vertex array */
+    const size_t numVertices = mesh.vertices.size(), numTriangles = mesh.triangles.size();
+    std::vector<Vertex> vertices(numMeshes*numVertices);
+    std::vector<Triangle> triangles(numMeshes*numTriangles);
+    std::vector<RTCMeshRange> ranges(numMeshes);
+    std::vector<unsigned> geomIDs(numMeshes);
+    for (size_t i=0; i<numMeshes; i++) 
+    {
+      ranges[i].firstTriangle = i*numTriangles; ranges[i].numTriangles = numTriangles;
+      ranges[i].firstVertex   = i*numVertices;  ranges[i].numVertices  = numVertices;
+      memcpy(&triangles[i*numTriangles],&mesh.triangles[0],numTriangles*sizeof(Triangle));
+      for (size_t j=0; j<numVertices; j++) {
+        Vertex& v = vertices[i*numVertices+j]; v = mesh.vertices[j];
+        v.x += float(i); v.y += float(i); v.z += float(i);
+      }
+    }
+
+    double t0 = getSeconds();
+    RTCScene scene = rtcNewScene(sflags,aflags);
+    rtcNewTriangleMeshes (scene, gflags, numMeshes, &ranges[0], &triangles[0], &vertices[0], &geomIDs[0]);
+    rtcCommit (scene);
+    double t1 = getSeconds();
+    rtcDeleteScene(scene);
+
+    return double(numTriangles*numMeshes)/(t1-t0);
+  }
+
   double rtcore_update_geometry(RTCGeometryFlags flags, size_t numPhi, size_t numMeshes)
   {
     Mesh mesh; createSphereMesh (Vec3f(0,0,0), 1, numPhi, mesh);
@@ -382,6 +435,95 @@ namespace embree
     return double(numTriangles)/(t1-t0);
   }
 
+  double rtcore_update_few_geometries(RTCGeometryFlags flags, size_t numPhi, size_t numMeshes, size_t numUpdates)
+  {
+    Mesh mesh; createSphereMesh (Vec3f(0,0,0), 1, numPhi, mesh);
+    RTCScene scene = rtcNewScene(RTC_SCENE_DYNAMIC,aflags);
+
+    for (size_t i=0; i<numMeshes; i++) 
+    {
+      unsigned geom = rtcNewTriangleMesh (scene, flags, mesh.triangles.size(), mesh.vertices.size());
+      memcpy(rtcMapBuffer(scene,geom,RTC_VERTEX_BUFFER), &mesh.vertices[0], mesh.vertices.size()*sizeof(Vertex));
+      memcpy(rtcMapBuffer(scene,geom,RTC_INDEX_BUFFER ), &mesh.triangles[0], mesh.triangles.size()*sizeof(Triangle));
+      rtcUnmapBuffer(scene,geom,RTC_VERTEX_BUFFER);
+      rtcUnmapBuffer(scene,geom,RTC_INDEX_BUFFER);
+      for (size_t i=0; i<mesh.vertices.size(); i++) {
+        mesh.vertices[i].x += 1.0f;
+        mesh.vertices[i].y += 1.0f;
+        mesh.vertices[i].z += 1.0f;
+      }
+    }
+    rtcCommit (scene);
+
+    /* move few meshes per frame, the toplevel BVH gets updated incrementally */
+    const size_t numFrames = 16;
+    double t0 = getSeconds();
+    for (size_t f=0; f<numFrames; f++) 
+    {
+      for (size_t i=0; i<numUpdates; i++) 
+      {
+        unsigned geom = (f*numUpdates+i)*7919 % numMeshes;
+        Vertex* vertices = (Vertex*) rtcMapBuffer(scene,geom,RTC_VERTEX_BUFFER);
+        for (size_t j=0; j<mesh.vertices.size(); j++) vertices[j].y += 0.5f;
+        rtcUnmapBuffer(scene,geom,RTC_VERTEX_BUFFER);
+        rtcUpdate(scene,geom);
+      }
+      rtcCommit (scene);
+    }
+    double t1 = getSeconds();
+    rtcDeleteScene(scene);
+
+    size_t numTriangles = mesh.triangles.size() * numMeshes;
+    return double(numFrames*numTriangles)/(t1-t0);
+  }
+
+  void rtcore_create_geometry_scaling(const char* name, RTCSceneFlags sflags, RTCGeometryFlags gflags, size_t numPhi, size_t numMeshes)
+  {
+    size_t numThreads = getNumberOfLogicalThreads();
+    for (size_t threads=1; ; threads=min(2*threads,numThreads))
+    {
+      std::stringstream cfg; cfg << g_rtcore << ",threads=" << threads;
+      rtcExit();
+      rtcInit(cfg.str().c_str());
+      double perf = rtcore_create_geometry(sflags,gflags,numPhi,numMeshes);
+      printf("%30s ... %f Mtris/s (%d threads)\n",name,perf*1E-6,int(threads));
+      fflush(stdout);
+      if (threads == numThreads) break;
+    }
+    rtcExit();
+    rtcInit(g_rtcore.c_str());
+  }
+
+  void rtcore_update_geometry_scaling(const char* name, RTCGeometryFlags flags, size_t numPhi, size_t numMeshes)
+  {
+    size_t numThreads = getNumberOfLogicalThreads();
+    for (size_t threads=1; ; threads=min(2*threads,numThreads))
+    {
+      std::stringstream cfg; cfg << g_rtcore << ",threads=" << threads;
+      rtcExit();
+      rtcInit(cfg.str().c_str());
+      double perf = rtcore_update_geometry(flags,numPhi,numMeshes);
+      printf("%30s ... %f Mtris/s (%d threads)\n",name,perf*1E-6,int(threads));
+      fflush(stdout);
+      if (threads == numThreads) break;
+    }
+    rtcExit();
+    rtcInit(g_rtcore.c_str());
+  }
+
+  /* rebuilds a dynamic mesh with the Morton builder, run with verbose=2 to compare the SAH cost of 32 and 64 bit codes */
+  void rtcore_morton_benchmark(const char* name, const char* morton, size_t numPhi)
+  {
+    std::string cfg = g_rtcore == "" ? std::string(morton) : g_rtcore+","+morton;
+    rtcExit();
+    rtcInit(cfg.c_str());
+    double perf = rtcore_update_geometry(RTC_GEOMETRY_DYNAMIC,numPhi,1);
+    printf("%30s ... %f Mtris/s\n",name,perf*1E-6);
+    fflush(stdout);
+    rtcExit();
+    rtcInit(g_rtcore.c_str());
+  }
+
   void rtcore_coherent_intersect1(RTCScene scene)
   {
     size_t width = 1024;
@@ -540,12 +682,25 @@ namespace embree
 	fflush(stdout);
   }
 
-  void rtcore_intersect_benchmark(RTCSceneFlags flags, size_t numPhi)
+  void rtcore_incoherent_intersectN(RTCScene scene, Vec3f* numbers, size_t N)
   {
-    RTCScene scene = rtcNewScene(flags,aflags);
-    addSphere (scene, RTC_GEOMETRY_STATIC, zero, 1, numPhi);
-    rtcCommit (scene);
+    const size_t S = 4096;
+    RTCRay* rays = (RTCRay*) alignedMalloc(S*sizeof(RTCRay));
+    double t0 = getSeconds();
+    for (size_t i=0; i<N; i+=S) {
+      const size_t M = min(N-i,S);
+      for (size_t j=0; j<M; j++) rays[j] = makeRay(zero,numbers[i+j]);
+      rtcIntersectN(scene,rays,M);
+    }
+    double t1 = getSeconds();
+    alignedFree(rays);
+
+    printf("%30s ... %f Mrps\n","incoherent_intersectN",1E-6*(double)N/(t1-t0));
+	fflush(stdout);
+  }
 
+  void rtcore_intersect_benchmark(RTCScene scene)
+  {
     rtcore_coherent_intersect1(scene);
 #if !defined(__MIC__)
     rtcore_coherent_intersect4(scene);
@@ -584,8 +739,374 @@ namespace embree
 #if defined(__MIC__)
     rtcore_incoherent_intersect16(scene,numbers,N);
 #endif
+    rtcore_incoherent_intersectN(scene,numbers,N);
 
     delete numbers;
+  }
+
+  void rtcore_intersect_benchmark(RTCSceneFlags flags, size_t numPhi)
+  {
+    RTCScene scene = rtcNewScene(flags,aflags);
+    addSphere (scene, RTC_GEOMETRY_STATIC, zero, 1, numPhi);
+    rtcCommit (scene);
+    rtcore_intersect_benchmark(scene);
+    rtcDeleteScene(scene);
+  }
+
+  /* compares build performance, memory, and tracing performance of a sphere made of quads with the same sphere made of triangles */
+  void rtcore_quad_benchmark(const char* name, bool quads, size_t numPhi)
+  {
+    Mesh mesh; createSphereMesh (zero, 1, numPhi, mesh);
+    RTCScene scene = rtcNewScene(RTC_SCENE_STATIC,aflags);
+    if (quads) addQuadSphere (scene, RTC_GEOMETRY_STATIC, zero, 1, numPhi);
+    else       addSphere     (scene, RTC_GEOMETRY_STATIC, zero, 1, numPhi);
+
+    double t0 = getSeconds();
+    rtcCommit (scene);
+    double t1 = getSeconds();
+    RTCMemoryStatistics stats;
+    rtcGetMemoryStatistics(scene,&stats,1);
+    printf("%30s ... %f Mtris/s, %f MB\n",name,1E-6*double(mesh.triangles.size())/(t1-t0),1E-6*double(stats.nodes+stats.primitives));
+    fflush(stdout);
+
+    rtcore_intersect_benchmark(scene);
+    rtcDeleteScene(scene);
+  }
+
+  /* traces a static scene with the given triangle acceleration structure, run with verbose=2 to compare the leaf memory */
+  void rtcore_triangle_leaf_benchmark(const char* accel, size_t numPhi)
+  {
+    std::string cfg = g_rtcore == "" ? "accel="+std::string(accel) : g_rtcore+",accel="+accel;
+    rtcExit();
+    rtcInit(cfg.c_str());
+    printf("%30s ...\n",accel);
+    rtcore_intersect_benchmark(RTC_SCENE_STATIC, numPhi);
+    rtcExit();
+    rtcInit(g_rtcore.c_str());
+  }
+
+  /* compares memory and tracing performance of triangle leaves, the vertex buffers count only if the leaves need them after the build */
+  void rtcore_triangle_leaf_benchmark(const char* name, const char* config, size_t numPhi)
+  {
+    std::string cfg = g_rtcore == "" ? std::string(config) : g_rtcore+","+config;
+    rtcExit();
+    rtcInit(cfg.c_str());
+
+    Mesh mesh; createSphereMesh (zero, 1, numPhi, mesh);
+    RTCScene scene = rtcNewScene(RTC_SCENE_STATIC,aflags);
+    addSphere (scene, RTC_GEOMETRY_STATIC, zero, 1, numPhi);
+    rtcCommit (scene);
+    RTCMemoryStatistics stats;
+    rtcGetMemoryStatistics(scene,&stats,1);
+    const double numTriangles = double(mesh.triangles.size());
+    printf("%30s ... %f bytes/tri leaves, %f bytes/tri total\n",name,double(stats.primitives)/numTriangles,
+           double(stats.nodes+stats.primitives+stats.sharedBuffers+stats.copiedBuffers)/numTriangles);
+    fflush(stdout);
+
+    rtcore_intersect_benchmark(scene);
+    rtcDeleteScene(scene);
+    rtcExit();
+    rtcInit(g_rtcore.c_str());
+  }
+
+  void rtcore_statistics_benchmark(size_t numPhi)
+  {
+    RTCScene scene = rtcNewScene(RTC_SCENE_STATIC,aflags);
+    addSphere (scene, RTC_GEOMETRY_STATIC, zero, 1, numPhi);
+    rtcCommit (scene);
+
+    size_t N = 1024*1024;
+    Vec3f* numbers = new Vec3f[N];
+    for (size_t i=0; i<N; i++) {
+      float x = 2.0f*drand48()-1.0f;
+      float y = 2.0f*drand48()-1.0f;
+      float z = 2.0f*drand48()-1.0f;
+      numbers[i] = Vec3f(x,y,z);
+    }
+
+    /* compare the tracing performance for all statistics modes */
+    const char* names[3] = { "statistics_disabled", "statistics_enabled", "statistics_sampled" };
+    for (int mode=RTC_STATISTICS_DISABLED; mode<=RTC_STATISTICS_SAMPLED; mode++)
+    {
+      rtcSetStatisticsMode(scene,(RTCStatisticsMode)mode);
+      double t0 = getSeconds();
+      for (size_t i=0; i<N; i++) {
+        RTCRay ray = makeRay(zero,numbers[i]);
+        rtcIntersect(scene,ray);
+      }
+      double t1 = getSeconds();
+      printf("%30s ... %f Mrps\n",names[mode],1E-6*(double)N/(t1-t0));
+      fflush(stdout);
+    }
+
+    delete[] numbers;
+    rtcDeleteScene(scene);
+  }
+
+  RTCScene g_numa_scene = NULL;
+  Vec3f* g_numa_numbers = NULL;
+  size_t g_numa_numRays = 0;
+  size_t g_numa_numThreads = 0;
+  double g_numa_t0 = 0.0, g_numa_t1 = 0.0;
+
+  void rtcore_numa_intersect_thread(void* ptr)
+  {
+    size_t threadIndex = (size_t) ptr;
+    size_t begin = (threadIndex+0)*g_numa_numRays/g_numa_numThreads;
+    size_t end   = (threadIndex+1)*g_numa_numRays/g_numa_numThreads;
+
+    g_barrier.wait();
+    if (threadIndex == 0) g_numa_t0 = getSeconds();
+    for (size_t i=begin; i<end; i++) {
+      RTCRay ray = makeRay(zero,g_numa_numbers[i]);
+      rtcIntersect(g_numa_scene,ray);
+    }
+    g_barrier.wait();
+    if (threadIndex == 0) g_numa_t1 = getSeconds();
+  }
+
+  /* traces incoherent rays from all logical threads with some placement of the BVH memory */
+  void rtcore_numa_benchmark(const char* name, const char* numa, size_t numPhi)
+  {
+    std::string cfg = g_rtcore == "" ? std::string(numa) : g_rtcore+","+numa;
+    rtcExit();
+    rtcInit(cfg.c_str());
+
+    g_numa_scene = rtcNewScene(RTC_SCENE_STATIC,aflags);
+    addSphere (g_numa_scene, RTC_GEOMETRY_STATIC, zero, 1, numPhi);
+    rtcCommit (g_numa_scene);
+
+    g_numa_numRays = 4*1024*1024;
+    g_numa_numbers = new Vec3f[g_numa_numRays];
+    for (size_t i=0; i<g_numa_numRays; i++) {
+      float x = 2.0f*drand48()-1.0f;
+      float y = 2.0f*drand48()-1.0f;
+      float z = 2.0f*drand48()-1.0f;
+      g_numa_numbers[i] = Vec3f(x,y,z);
+    }
+
+    g_numa_numThreads = getNumberOfLogicalThreads();
+    g_barrier.init(g_numa_numThreads);
+    for (size_t i=1; i<g_numa_numThreads; i++)
+      g_threads.push_back(createThread(rtcore_numa_intersect_thread,(void*)i,1000000,i));
+    setAffinity(0);
+    rtcore_numa_intersect_thread((void*)0);
+
+    for (size_t i=0; i<g_threads.size(); i++)
+      join(g_threads[i]);
+    g_threads.clear();
+
+    printf("%30s ... %f Mrps (%d threads)\n",name,1E-6*(double)g_numa_numRays/(g_numa_t1-g_numa_t0),int(g_numa_numThreads));
+    fflush(stdout);
+
+    delete[] g_numa_numbers; g_numa_numbers = NULL;
+    rtcDeleteScene(g_numa_scene); g_numa_scene = NULL;
+    rtcExit();
+    rtcInit(g_rtcore.c_str());
+  }
+
+  /* traces packets whose rays diverge by some spread from a pinhole camera, with fixed or adaptive packet to single ray switch */
+  void rtcore_hybrid_benchmark(const char* name, const char* threshold, float spread, size_t numPhi)
+  {
+    std::string cfg = g_rtcore == "" ? std::string(threshold) : g_rtcore+","+threshold;
+    rtcExit();
+    rtcInit(cfg.c_str());
+
+    RTCScene scene = rtcNewScene(RTC_SCENE_STATIC,aflags);
+    addSphere (scene, RTC_GEOMETRY_STATIC, zero, 1, numPhi);
+    rtcCommit (scene);
+
+    size_t width = 1024;
+    size_t height = 1024;
+    float rcpWidth = 1.0f/1024.0f;
+    float rcpHeight = 1.0f/1024.0f;
+    Vec3f* dirs = new Vec3f[width*height];
+    for (size_t i=0; i<width*height; i++)
+      dirs[i] = spread*Vec3f(2.0f*drand48()-1.0f,2.0f*drand48()-1.0f,2.0f*drand48()-1.0f);
+    const Vec3f org(0,0,-3);
+
+#if !defined(__MIC__)
+    double t0 = getSeconds();
+    for (size_t y=0; y<height; y+=2) {
+      for (size_t x=0; x<width; x+=2) {
+        RTCRay4 ray4; 
+        for (size_t dy=0; dy<2; dy++) {
+          for (size_t dx=0; dx<2; dx++) {
+            const Vec3f dir = Vec3f(float(x+dx)*rcpWidth-0.5f,float(y+dy)*rcpHeight-0.5f,1)+dirs[(y+dy)*width+x+dx];
+            setRay(ray4,2*dy+dx,makeRay(org,dir));
+          }
+        }
+        __align(16) int valid4[4] = { -1,-1,-1,-1 };
+        rtcIntersect4(valid4,scene,ray4);
+      }
+    }
+    double t1 = getSeconds();
+    printf("%30s ... %f Mrps (4 rays)\n",name,1E-6*(double)(width*height)/(t1-t0));
+    fflush(stdout);
+#endif
+
+#if defined(__TARGET_AVX__) || defined(__TARGET_AVX2__)
+    if (has_feature(AVX)) 
+    {
+      double t0 = getSeconds();
+      for (size_t y=0; y<height; y+=4) {
+        for (size_t x=0; x<width; x+=2) {
+          RTCRay8 ray8; 
+          for (size_t dy=0; dy<4; dy++) {
+            for (size_t dx=0; dx<2; dx++) {
+              const Vec3f dir = Vec3f(float(x+dx)*rcpWidth-0.5f,float(y+dy)*rcpHeight-0.5f,1)+dirs[(y+dy)*width+x+dx];
+              setRay(ray8,2*dy+dx,makeRay(org,dir));
+            }
+          }
+          __align(32) int valid8[8] = { -1,-1,-1,-1,-1,-1,-1,-1 };
+          rtcIntersect8(valid8,scene,ray8);
+        }
+      }
+      double t1 = getSeconds();
+      printf("%30s ... %f Mrps (8 rays)\n",name,1E-6*(double)(width*height)/(t1-t0));
+      fflush(stdout);
+    }
+#endif
+
+    delete[] dirs;
+    rtcDeleteScene(scene);
+    rtcExit();
+    rtcInit(g_rtcore.c_str());
+  }
+
+  /* traces the primary rays of a sphere and the shadow rays of its hit points towards a point light, in tiles of 8 rays or in large packets of K rays */
+  void rtcore_packet_benchmark(const char* name, size_t K, bool shadow, size_t numPhi)
+  {
+    RTCScene scene = rtcNewScene(RTC_SCENE_STATIC,aflags);
+    addSphere (scene, RTC_GEOMETRY_STATIC, zero, 1, numPhi);
+    rtcCommit (scene);
+
+    size_t width = 1024;
+    size_t height = 1024;
+    float rcpWidth = 1.0f/1024.0f;
+    float rcpHeight = 1.0f/1024.0f;
+    const Vec3f cam(0,0,-3), light(-2,2,-3);
+
+    /* primary rays start at the camera, shadow rays at the hit points */
+    Vec3f* orgs = new Vec3f[width*height];
+    Vec3f* dirs = new Vec3f[width*height];
+    for (size_t y=0; y<height; y++) {
+      for (size_t x=0; x<width; x++) {
+        const Vec3f dir(float(x)*rcpWidth-0.5f,float(y)*rcpHeight-0.5f,1);
+        orgs[y*width+x] = cam; dirs[y*width+x] = dir;
+        if (!shadow) continue;
+        RTCRay ray = makeRay(cam,dir);
+        rtcIntersect(scene,ray);
+        const Vec3f hit = cam + min(ray.tfar,4.0f)*dir;
+        orgs[y*width+x] = hit; dirs[y*width+x] = light-hit;
+      }
+    }
+    const float tnear = shadow ? 1E-3f : 0.0f;
+    const float tfar  = shadow ? 1.0f : float(inf);
+
+    /* square tiles of K rays, tiles of 2x4 rays for 8-wide packets */
+    const size_t tileX = K == 8 ? 2 : size_t(sqrtf(float(K)));
+    const size_t tileY = K/tileX;
+    std::vector<float> orgx(K), orgy(K), orgz(K), dirx(K), diry(K), dirz(K), tnears(K), tfars(K), time(K);
+    std::vector<float> Ngx(K), Ngy(K), Ngz(K), u(K), v(K);
+    std::vector<int> mask(K), geomID(K), primID(K), instID(K);
+    RTCRayNp rays = { &orgx[0], &orgy[0], &orgz[0], &dirx[0], &diry[0], &dirz[0], &tnears[0], &tfars[0], &time[0], &mask[0],
+                      &Ngx[0], &Ngy[0], &Ngz[0], &u[0], &v[0], &geomID[0], &primID[0], &instID[0] };
+
+    double t0 = getSeconds();
+    for (size_t y=0; y<height; y+=tileY) {
+      for (size_t x=0; x<width; x+=tileX) 
+      {
+        if (K == 8) 
+        {
+          RTCRay8 ray8; 
+          for (size_t dy=0; dy<tileY; dy++) {
+            for (size_t dx=0; dx<tileX; dx++) {
+              const size_t i = (y+dy)*width+x+dx;
+              setRay(ray8,tileX*dy+dx,makeRay(orgs[i],dirs[i],tnear,tfar));
+            }
+          }
+          __align(32) int valid8[8] = { -1,-1,-1,-1,-1,-1,-1,-1 };
+          if (shadow) rtcOccluded8(valid8,scene,ray8);
+          else        rtcIntersect8(valid8,scene,ray8);
+          continue;
+        }
+        for (size_t dy=0; dy<tileY; dy++) {
+          for (size_t dx=0; dx<tileX; dx++) {
+            const size_t i = (y+dy)*width+x+dx, k = tileX*dy+dx;
+            orgx[k] = orgs[i].x; orgy[k] = orgs[i].y; orgz[k] = orgs[i].z;
+            dirx[k] = dirs[i].x; diry[k] = dirs[i].y; dirz[k] = dirs[i].z;
+            tnears[k] = tnear; tfars[k] = tfar; time[k] = 0.0f; mask[k] = -1;
+            geomID[k] = primID[k] = instID[k] = -1;
+          }
+        }
+        if (shadow) rtcOccludedPacket(scene,rays,K);
+        else        rtcIntersectPacket(scene,rays,K);
+      }
+    }
+    double t1 = getSeconds();
+    printf("%30s ... %f Mrps (%d rays)\n",name,1E-6*(double)(width*height)/(t1-t0),int(K));
+    fflush(stdout);
+
+    delete[] orgs;
+    delete[] dirs;
+    rtcDeleteScene(scene);
+  }
+
+  unsigned addHair (RTCScene scene, RTCGeometryFlags flag, size_t numCurves)
+  {
+    /* randomly oriented curves inside the unit sphere */
+    unsigned geom = rtcNewQuadraticBezierCurves (scene, flag, numCurves, 4*numCurves);
+    Vec3fa* vertices = (Vec3fa*) rtcMapBuffer(scene,geom,RTC_VERTEX_BUFFER);
+    int* curves = (int*) rtcMapBuffer(scene,geom,RTC_INDEX_BUFFER);
+    for (size_t i=0; i<numCurves; i++) 
+    {
+      curves[i] = 4*i;
+      Vec3fa p(2.0f*drand48()-1.0f,2.0f*drand48()-1.0f,2.0f*drand48()-1.0f);
+      for (size_t j=0; j<4; j++) {
+        vertices[4*i+j] = 0.5f*p;
+        vertices[4*i+j].w = 0.002f;
+        p = p + Vec3fa(0.04f*drand48()-0.02f,0.04f*drand48()-0.02f,0.04f*drand48()-0.02f);
+      }
+    }
+    rtcUnmapBuffer(scene,geom,RTC_VERTEX_BUFFER);
+    rtcUnmapBuffer(scene,geom,RTC_INDEX_BUFFER);
+    return geom;
+  }
+
+  void rtcore_hair_benchmark(RTCSceneFlags flags, size_t numCurves)
+  {
+    RTCScene scene = rtcNewScene(flags,aflags);
+    addHair (scene, RTC_GEOMETRY_STATIC, numCurves);
+    double t0 = getSeconds();
+    rtcCommit (scene);
+    double t1 = getSeconds();
+    printf("%30s ... %f Mcurves/s\n","create_hair",1E-6*(double)numCurves/(t1-t0));
+    fflush(stdout);
+
+    const size_t N = 1024*1024;
+    double t2 = getSeconds();
+    for (size_t i=0; i<N; i++) {
+      RTCRay ray = makeRay(zero,Vec3f(2.0f*drand48()-1.0f,2.0f*drand48()-1.0f,2.0f*drand48()-1.0f));
+      rtcIntersect(scene,ray);
+    }
+    double t3 = getSeconds();
+    printf("%30s ... %f Mrps\n","hair_incoherent_intersect1",1E-6*(double)N/(t3-t2));
+    fflush(stdout);
+
+#if !defined(__MIC__)
+    double t4 = getSeconds();
+    for (size_t i=0; i<N; i+=4) {
+      RTCRay4 ray4;
+      for (size_t j=0; j<4; j++) 
+        setRay(ray4,j,makeRay(zero,Vec3f(2.0f*drand48()-1.0f,2.0f*drand48()-1.0f,2.0f*drand48()-1.0f)));
+      __align(16) int valid4[4] = { -1,-1,-1,-1 };
+      rtcIntersect4(valid4,scene,ray4);
+    }
+    double t5 = getSeconds();
+    printf("%30s ... %f Mrps\n","hair_incoherent_intersect4",1E-6*(double)N/(t5-t4));
+    fflush(stdout);
+#endif
 
     rtcDeleteScene(scene);
   }
@@ -605,6 +1126,75 @@ namespace embree
     
     rtcore_intersect_benchmark(RTC_SCENE_STATIC, 501);
 
+    /* compact scenes use compressed nodes, run with verbose=2 to get the memory consumption */
+    printf("%30s ...\n","compact_scene");
+    rtcore_intersect_benchmark(RTC_SCENE_STATIC | RTC_SCENE_COMPACT, 501);
+
+    /* compare the Moeller test on the vertices with the precomputed Woop transformations */
+#if !defined(__MIC__)
+    rtcore_triangle_leaf_benchmark("bvh4.triangle4",  501);
+    rtcore_triangle_leaf_benchmark("bvh4.triangle4w", 501);
+    rtcore_triangle_leaf_benchmark("bvh4i.triangle4", 501);
+    rtcore_triangle_leaf_benchmark("bvh4i.triangle4w",501);
+#endif
+#if defined(__TARGET_AVX__) || defined(__TARGET_AVX2__)
+    if (has_feature(AVX)) {
+      rtcore_triangle_leaf_benchmark("bvh4.triangle8",  501);
+      rtcore_triangle_leaf_benchmark("bvh4.triangle8w", 501);
+      rtcore_triangle_leaf_benchmark("bvh4i.triangle8", 501);
+      rtcore_triangle_leaf_benchmark("bvh4i.triangle8w",501);
+    }
+#endif
+
+    /* compare quads with the same geometry split into triangles */
+#if !defined(__MIC__)
+    rtcore_quad_benchmark("quad_mesh",     true,  501);
+    rtcore_quad_benchmark("triangle_mesh", false, 501);
+#endif
+
+    /* compare the leaves with indexed, quantized, and full precision vertices */
+#if !defined(__MIC__)
+    rtcore_triangle_leaf_benchmark("leaf_triangle4i", "accel=bvh4.triangle4i.compressed", 501);
+    rtcore_triangle_leaf_benchmark("leaf_triangle4q", "accel=bvh4.triangle4q.compressed", 501);
+    rtcore_triangle_leaf_benchmark("leaf_triangle4",  "accel=bvh4.triangle4",  501);
+    rtcore_triangle_leaf_benchmark("leaf_triangle1v", "accel=bvh4.triangle1v", 501);
+#endif
+
+    /* run on multi socket systems to compare the placements of the BVH memory */
+    rtcore_statistics_benchmark(501);
+
+    rtcore_numa_benchmark("numa_first_touch", "numa=first_touch", 501);
+    rtcore_numa_benchmark("numa_interleave",  "numa=interleave",  501);
+    rtcore_numa_benchmark("numa_replicate",   "numa_replicate=1", 501);
+
+    /* TLB misses dominate incoherent traversal of large scenes, compare normal with huge pages */
+    rtcore_numa_benchmark("huge_pages_off",         "huge_pages=off",         501);
+    rtcore_numa_benchmark("huge_pages_transparent", "huge_pages=transparent", 501);
+    rtcore_numa_benchmark("huge_pages_explicit",    "huge_pages=explicit",    501);
+#if !defined(__MIC__)
+    rtcore_hair_benchmark(RTC_SCENE_STATIC, 1000000);
+#endif
+
+    /* compare the fixed and the adaptive switch to single ray traversal for primary, glossy, and diffuse coherence */
+    rtcore_hybrid_benchmark("hybrid_fixed_coherent",       "hybrid_threshold=fixed",    0.0f,  501);
+    rtcore_hybrid_benchmark("hybrid_adaptive_coherent",    "hybrid_threshold=adaptive", 0.0f,  501);
+    rtcore_hybrid_benchmark("hybrid_fixed_semicoherent",   "hybrid_threshold=fixed",    0.05f, 501);
+    rtcore_hybrid_benchmark("hybrid_adaptive_semicoherent","hybrid_threshold=adaptive", 0.05f, 501);
+    rtcore_hybrid_benchmark("hybrid_fixed_incoherent",     "hybrid_threshold=fixed",    1.0f,  501);
+    rtcore_hybrid_benchmark("hybrid_adaptive_incoherent",  "hybrid_threshold=adaptive", 1.0f,  501);
+
+    /* compare 8-wide packets with large frustum packets for coherent primary and shadow rays */
+#if defined(__TARGET_AVX__) || defined(__TARGET_AVX2__)
+    if (has_feature(AVX)) {
+      rtcore_packet_benchmark("packet_primary",  8,  false, 501);
+      rtcore_packet_benchmark("packet_primary",  64, false, 501);
+      rtcore_packet_benchmark("packet_primary",  256,false, 501);
+      rtcore_packet_benchmark("packet_shadow",   8,  true,  501);
+      rtcore_packet_benchmark("packet_shadow",   64, true,  501);
+      rtcore_packet_benchmark("packet_shadow",   256,true,  501);
+    }
+#endif
+
     BUILD   ("create_static_geometry_120",       rtcore_create_geometry(RTC_SCENE_STATIC,RTC_GEOMETRY_STATIC,6,1));
     BUILD   ("create_static_geometry_1k",        rtcore_create_geometry(RTC_SCENE_STATIC,RTC_GEOMETRY_STATIC,17,1));
     BUILD   ("create_static_geometry_10k",       rtcore_create_geometry(RTC_SCENE_STATIC,RTC_GEOMETRY_STATIC,51,1));
@@ -615,6 +1205,15 @@ namespace embree
     BUILD   ("create_static_geometry_1k_1000",   rtcore_create_geometry(RTC_SCENE_STATIC,RTC_GEOMETRY_STATIC,17,1000));
 #if defined(__X86_64__)
     BUILD   ("create_static_geometry_120_10000", rtcore_create_geometry(RTC_SCENE_STATIC,RTC_GEOMETRY_STATIC,6,8334));
+    BUILD   ("create_static_batch_120_10000",    rtcore_create_geometry_batch(RTC_SCENE_STATIC,RTC_GEOMETRY_STATIC,6,8334));
+#endif
+
+#if !defined(__MIC__)
+    rtcore_create_geometry_scaling("scaling_static_geometry_1000k_1",  RTC_SCENE_STATIC,RTC_GEOMETRY_STATIC,501,1);
+    rtcore_create_geometry_scaling("scaling_static_geometry_1k_1000",  RTC_SCENE_STATIC,RTC_GEOMETRY_STATIC,17,1000);
+    rtcore_create_geometry_scaling("scaling_dynamic_geometry_1k_1000", RTC_SCENE_DYNAMIC,RTC_GEOMETRY_STATIC,17,1000);
+    rtcore_update_geometry_scaling("scaling_refit_geometry_1000k_1",   RTC_GEOMETRY_DEFORMABLE,501,1);
+    rtcore_update_geometry_scaling("scaling_refit_geometry_100k_10",   RTC_GEOMETRY_DEFORMABLE,159,10);
 #endif
 
     BUILD   ("create_dynamic_geometry_120",       rtcore_create_geometry(RTC_SCENE_DYNAMIC,RTC_GEOMETRY_STATIC,6,1));
@@ -627,8 +1226,14 @@ namespace embree
     BUILD   ("create_dynamic_geometry_1k_1000",   rtcore_create_geometry(RTC_SCENE_DYNAMIC,RTC_GEOMETRY_STATIC,17,1000));
 #if defined(__X86_64__)
     BUILD   ("create_dynamic_geometry_120_10000", rtcore_create_geometry(RTC_SCENE_DYNAMIC,RTC_GEOMETRY_STATIC,6,8334));
+    BUILD   ("create_dynamic_batch_120_10000",   rtcore_create_geometry_batch(RTC_SCENE_DYNAMIC,RTC_GEOMETRY_STATIC,6,8334));
 #endif
 
+    BUILD   ("create_morton_geometry_100k",       rtcore_create_geometry(RTC_SCENE_DYNAMIC,RTC_GEOMETRY_DYNAMIC,159,1));
+    BUILD   ("create_morton_geometry_1000k_1",    rtcore_create_geometry(RTC_SCENE_DYNAMIC,RTC_GEOMETRY_DYNAMIC,501,1));
+    BUILD   ("create_treelet_geometry_100k",      rtcore_create_geometry(RTCSceneFlags(RTC_SCENE_DYNAMIC | RTC_SCENE_HIGH_QUALITY),RTC_GEOMETRY_DYNAMIC,159,1));
+    BUILD   ("create_treelet_geometry_1000k_1",   rtcore_create_geometry(RTCSceneFlags(RTC_SCENE_DYNAMIC | RTC_SCENE_HIGH_QUALITY),RTC_GEOMETRY_DYNAMIC,501,1));
+
     BUILD   ("refit_geometry_120",        rtcore_update_geometry(RTC_GEOMETRY_DEFORMABLE,6,1));
     BUILD   ("refit_geometry_1k",         rtcore_update_geometry(RTC_GEOMETRY_DEFORMABLE,17,1));
     BUILD   ("refit_geometry_10k",        rtcore_update_geometry(RTC_GEOMETRY_DEFORMABLE,51,1));
@@ -653,6 +1258,17 @@ namespace embree
     BUILD   ("update_geometry_120_10000",  rtcore_update_geometry(RTC_GEOMETRY_DYNAMIC,6,8334));
 #endif
 
+    rtcore_morton_benchmark("morton32_geometry_1000k_1", "morton64_threshold=1000000000", 501);
+    rtcore_morton_benchmark("morton64_geometry_1000k_1", "morton64_threshold=0", 501);
+#if defined(__X86_64__)
+    rtcore_morton_benchmark("morton32_geometry_10M_1",   "morton64_threshold=1000000000", 1583);
+    rtcore_morton_benchmark("morton64_geometry_10M_1",   "morton64_threshold=0", 1583);
+#endif
+
+#if defined(__X86_64__)
+    BUILD   ("update_few_geometries_120_10000", rtcore_update_few_geometries(RTC_GEOMETRY_DYNAMIC,6,8334,16));
+#endif
+
     rtcExit();
 
     return 0;
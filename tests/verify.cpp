@@ -42,6 +42,7 @@ namespace embree
   /* vertex and triangle layout */
   struct Vertex   { float x,y,z,a; };
   struct Triangle { int v0, v1, v2; };
+  struct Quad     { int v0, v1, v2, v3; };
 
   std::vector<thread_t> g_threads;
 
@@ -442,6 +443,65 @@ namespace embree
     return mesh;
   }
 
+  unsigned addQuadSphere (RTCScene scene, RTCGeometryFlags flag, const Vec3fa& pos, const float r, size_t numPhi)
+  {
+    /* create a sphere of quads, which split into the triangles of addSphere */
+    size_t numTheta = 2*numPhi;
+    unsigned mesh = rtcNewQuadMesh (scene, flag, numTheta*numPhi, numTheta*(numPhi+1));
+    Vertex* vertices = (Vertex*) rtcMapBuffer(scene,mesh,RTC_VERTEX_BUFFER); 
+    Quad*   quads    = (Quad*  ) rtcMapBuffer(scene,mesh,RTC_INDEX_BUFFER);
+
+    size_t quad = 0;
+    const float rcpNumTheta = 1.0f/float(numTheta);
+    const float rcpNumPhi   = 1.0f/float(numPhi);
+    for (size_t phi=0; phi<=numPhi; phi++)
+    {
+      for (size_t theta=0; theta<numTheta; theta++)
+      {
+        const float phif   = phi*float(pi)*rcpNumPhi;
+        const float thetaf = theta*2.0f*float(pi)*rcpNumTheta;
+        Vertex* v = &vertices[phi*numTheta+theta];
+        v->x = pos.x + r*sin(phif)*sin(thetaf);
+        v->y = pos.y + r*cos(phif);
+        v->z = pos.z + r*sin(phif)*cos(thetaf);
+      }
+      if (phi == 0) continue;
+
+      /* the quads at the poles degenerate to triangles */
+      for (size_t theta=1; theta<=numTheta; theta++) 
+      {
+        quads[quad].v0 = (phi-1)*numTheta+theta-1;
+        quads[quad].v1 = (phi-1)*numTheta+theta%numTheta;
+        quads[quad].v2 = phi*numTheta+theta%numTheta;
+        quads[quad].v3 = phi*numTheta+theta-1;
+        quad++;
+      }
+    }
+
+    rtcUnmapBuffer(scene,mesh,RTC_VERTEX_BUFFER); 
+    rtcUnmapBuffer(scene,mesh,RTC_INDEX_BUFFER);
+    return mesh;
+  }
+
+  unsigned addHair (RTCScene scene, RTCGeometryFlags flag, const Vec3fa& pos, const float length, const float r, size_t numCurves)
+  {
+    /* straight curves along the x axis, stacked in y direction */
+    unsigned hair = rtcNewQuadraticBezierCurves (scene, flag, numCurves, 4*numCurves);
+    Vec3fa* vertices = (Vec3fa*) rtcMapBuffer(scene,hair,RTC_VERTEX_BUFFER); 
+    int* curves = (int*) rtcMapBuffer(scene,hair,RTC_INDEX_BUFFER);
+    for (size_t i=0; i<numCurves; i++) 
+    {
+      curves[i] = 4*i;
+      for (size_t j=0; j<4; j++) {
+        vertices[4*i+j] = pos + Vec3fa(length*(float(j)/3.0f-0.5f),4.0f*r*float(i),0.0f);
+        vertices[4*i+j].w = r;
+      }
+    }
+    rtcUnmapBuffer(scene,hair,RTC_VERTEX_BUFFER); 
+    rtcUnmapBuffer(scene,hair,RTC_INDEX_BUFFER);
+    return hair;
+  }
+
   struct Sphere
   {
     ALIGNED_CLASS;
@@ -968,6 +1028,279 @@ namespace embree
     return true;
   }
 
+  bool rtcore_refit_mesh(size_t numPhi, size_t numSwaps)
+  {
+    RTCScene scene = rtcNewScene(RTC_SCENE_DYNAMIC,aflags);
+    AssertNoError();
+    size_t numVertices = 2*numPhi*(numPhi+1);
+    size_t numTriangles = 2*2*numPhi*(numPhi-1);
+    unsigned geom = addSphere(scene,RTC_GEOMETRY_DEFORMABLE,zero,1.0f,numPhi);
+    rtcCommit (scene);
+    AssertNoError();
+
+    bool passed = true;
+    for (size_t i=0; i<4; i++) 
+    {
+      /* deform the mesh non uniformly, such that all bounds change */
+      Vec3fa* vertices = (Vec3fa*) rtcMapBuffer(scene,geom,RTC_VERTEX_BUFFER); 
+      for (size_t j=0; j<numVertices; j++) {
+        vertices[j].x *= 1.0f+0.5f*vertices[j].y;
+        vertices[j].z += 0.2f*float(i);
+      }
+
+      /* swapping vertices degrades the quality of the refitted BVH */
+      for (size_t j=0; j<numSwaps; j++) 
+        std::swap(vertices[rand()%numVertices],vertices[rand()%numVertices]);
+      rtcUnmapBuffer(scene,geom,RTC_VERTEX_BUFFER);
+      rtcUpdate(scene,geom);
+      rtcCommit (scene);
+      AssertNoError();
+
+      /* compare against a scene built from scratch */
+      RTCScene reference = rtcNewScene(RTC_SCENE_STATIC,aflags);
+      unsigned mesh = rtcNewTriangleMesh (reference, RTC_GEOMETRY_STATIC, numTriangles, numVertices);
+      memcpy(rtcMapBuffer(reference,mesh,RTC_VERTEX_BUFFER), rtcMapBuffer(scene,geom,RTC_VERTEX_BUFFER), numVertices*sizeof(Vertex));
+      memcpy(rtcMapBuffer(reference,mesh,RTC_INDEX_BUFFER ), rtcMapBuffer(scene,geom,RTC_INDEX_BUFFER ), numTriangles*sizeof(Triangle));
+      rtcUnmapBuffer(reference,mesh,RTC_VERTEX_BUFFER);
+      rtcUnmapBuffer(reference,mesh,RTC_INDEX_BUFFER);
+      rtcUnmapBuffer(scene,geom,RTC_VERTEX_BUFFER);
+      rtcUnmapBuffer(scene,geom,RTC_INDEX_BUFFER);
+      rtcCommit (reference);
+      AssertNoError();
+
+      for (size_t j=0; j<1000; j++) 
+      {
+        Vec3fa org(4.0f*drand48()-2.0f,4.0f*drand48()-2.0f,4.0f*drand48()-2.0f);
+        Vec3fa dir(2.0f*drand48()-1.0f,2.0f*drand48()-1.0f,2.0f*drand48()-1.0f);
+        RTCRay ray0 = makeRay(org,dir); rtcIntersect(scene,ray0);
+        RTCRay ray1 = makeRay(org,dir); rtcIntersect(reference,ray1);
+        passed &= ray0.geomID == ray1.geomID;
+        passed &= ray0.geomID == -1 || ray0.tfar == ray1.tfar;
+      }
+      rtcDeleteScene (reference);
+    }
+    AssertNoError();
+
+    rtcDeleteScene (scene);
+    return passed;
+  }
+
+  bool rtcore_morton_clustered_mesh(RTCSceneFlags sflags, size_t num)
+  {
+    RTCScene scene = rtcNewScene(sflags,aflags);
+    RTCScene reference = rtcNewScene(RTC_SCENE_STATIC,aflags);
+    AssertNoError();
+    unsigned geom = addPlane(scene,RTC_GEOMETRY_DYNAMIC,num,Vec3fa(0,0,0),Vec3fa(1,0,0),Vec3fa(0,0,1));
+    unsigned mesh = addPlane(reference,RTC_GEOMETRY_STATIC,num,Vec3fa(0,0,0),Vec3fa(1,0,0),Vec3fa(0,0,1));
+
+    /* squeeze most vertices into a small corner, such that many triangles map to the same coarse morton code */
+    size_t numVertices = (num+1)*(num+1);
+    Vertex* vertices0 = (Vertex*) rtcMapBuffer(scene,geom,RTC_VERTEX_BUFFER);
+    Vertex* vertices1 = (Vertex*) rtcMapBuffer(reference,mesh,RTC_VERTEX_BUFFER);
+    for (size_t i=0; i<numVertices; i++) {
+      vertices0[i].x = powf(vertices0[i].x,6.0f);
+      vertices0[i].z = powf(vertices0[i].z,6.0f);
+      vertices0[i].y = 0.01f*sinf(1000.0f*vertices0[i].x)*cosf(1000.0f*vertices0[i].z);
+      vertices1[i] = vertices0[i];
+    }
+    rtcUnmapBuffer(scene,geom,RTC_VERTEX_BUFFER);
+    rtcUnmapBuffer(reference,mesh,RTC_VERTEX_BUFFER);
+    rtcCommit (scene);
+    rtcCommit (reference);
+    AssertNoError();
+
+    bool passed = true;
+    for (size_t i=0; i<1000; i++)
+    {
+      Vec3fa org(powf(drand48(),6.0f),1.0f,powf(drand48(),6.0f));
+      Vec3fa dir(0.01f*drand48(),-1.0f,0.01f*drand48());
+      RTCRay ray0 = makeRay(org,dir); rtcIntersect(scene,ray0);
+      RTCRay ray1 = makeRay(org,dir); rtcIntersect(reference,ray1);
+      passed &= ray0.geomID == ray1.geomID;
+      passed &= ray0.geomID == -1 || ray0.tfar == ray1.tfar;
+    }
+    AssertNoError();
+
+    rtcDeleteScene (scene);
+    rtcDeleteScene (reference);
+    return passed;
+  }
+
+  bool rtcore_commit_async(RTCGeometryFlags flags)
+  {
+    RTCScene scene = rtcNewScene(RTC_SCENE_DYNAMIC,aflags);
+    AssertNoError();
+    size_t numPhi = 50;
+    size_t numVertices = 2*numPhi*(numPhi+1);
+    Vec3fa offset[4] = { Vec3fa(-1,10,-1), Vec3fa(-1,10,+1), Vec3fa(+1,10,-1), Vec3fa(+1,10,+1) };
+    unsigned geom[4];
+    Vec3fa pos[4];
+    for (size_t j=0; j<4; j++) {
+      geom[j] = addSphere(scene,flags,offset[j]-Vec3fa(0,10,0),1.0f,numPhi);
+      pos[j] = Vec3fa(zero);
+    }
+    rtcCommit (scene);
+    AssertNoError();
+
+    for (size_t i=0; i<16; i++) 
+    {
+      Vec3fa ds(20,0,20);
+      Vec3fa newpos[4];
+      for (size_t j=0; j<4; j++) {
+        newpos[j] = pos[j];
+        if (i & (1 << j)) { move_mesh(scene,geom[j],numVertices,ds); newpos[j] += ds; }
+      }
+      rtcCommitAsync (scene);
+      AssertNoError();
+
+      /* previous version of the scene is traced until the commit finished */
+      for (size_t j=0; j<4; j++) {
+        RTCRay ray = makeRay(pos[j]+offset[j],Vec3fa(0,-1,0)); 
+        rtcIntersect(scene,ray);
+        if (ray.geomID != geom[j]) return false;
+      }
+
+      if (i%2) rtcCommitWait(scene);
+      else while (!rtcCommitPoll(scene));
+      AssertNoError();
+
+      for (size_t j=0; j<4; j++) {
+        RTCRay ray0 = makeRay(newpos[j]+offset[j],Vec3fa(0,-1,0)); 
+        rtcIntersect(scene,ray0);
+        if (ray0.geomID != geom[j]) return false;
+        if (newpos[j] == pos[j]) continue;
+        RTCRay ray1 = makeRay(pos[j]+offset[j],Vec3fa(0,-1,0)); 
+        rtcIntersect(scene,ray1);
+        if (ray1.geomID != -1) return false;
+      }
+      for (size_t j=0; j<4; j++) pos[j] = newpos[j];
+    }
+
+    /* create and delete geometries between asynchronous commits */
+    int sphere[64];
+    for (size_t i=0; i<64; i++) sphere[i] = -1;
+    for (size_t i=0; i<50; i++) 
+    {
+      for (size_t j=0; j<8; j++) {
+        int index = rand()%64;
+        if (sphere[index] == -1) sphere[index] = addSphere(scene,flags,Vec3fa(4.0f*index,-20,0),1.0f,10);
+        else { rtcDeleteGeometry(scene,sphere[index]); sphere[index] = -1; }
+      }
+      rtcCommitAsync (scene);
+      rtcCommitWait (scene);
+      AssertNoError();
+
+      for (size_t j=0; j<64; j++) {
+        RTCRay ray = makeRay(Vec3fa(4.0f*j,-10,0),Vec3fa(0,-1,0)); 
+        rtcIntersect(scene,ray);
+        if (ray.geomID != sphere[j]) return false;
+      }
+    }
+
+    rtcDeleteScene (scene);
+    AssertNoError();
+    return true;
+  }
+
+  bool rtcore_commit_async_scenes(size_t numScenes)
+  {
+    /* the first round builds each scene alone */
+    std::vector<size_t> builderPeak(numScenes);
+    for (size_t i=0; i<21; i++)
+    {
+      std::vector<RTCScene> scenes(numScenes);
+      for (size_t j=0; j<numScenes; j++) {
+        scenes[j] = rtcNewScene(RTC_SCENE_STATIC,aflags);
+        addSphere(scenes[j],RTC_GEOMETRY_STATIC,Vec3fa(float(j),0,0),1.0f,50*(numScenes-j));
+        if (i) { rtcCommitAsync (scenes[j]); continue; }
+        rtcCommit (scenes[j]);
+        RTCMemoryStatistics stats;
+        rtcGetMemoryStatistics(scenes[j],&stats,1);
+        builderPeak[j] = stats.builderPeak;
+        rtcDeleteScene (scenes[j]);
+      }
+      AssertNoError();
+      if (i == 0) continue;
+
+      /* each build clears the block pool while the other builds allocate from it */
+      for (size_t j=0; j<numScenes; j++) 
+      {
+        rtcCommitWait (scenes[j]);
+        AssertNoError();
+        RTCRay ray = makeRay(Vec3fa(float(j),10,0),Vec3fa(0,-1,0)); 
+        rtcIntersect(scenes[j],ray);
+        if (ray.geomID != 0) return false;
+
+        /* a scene must not count the temporary memory of the other
+         * builds, the distribution over the threads may vary */
+        RTCMemoryStatistics stats;
+        rtcGetMemoryStatistics(scenes[j],&stats,1);
+        if (stats.builderPeak == 0 || stats.builderPeak > 2*builderPeak[j]) return false;
+        rtcDeleteScene (scenes[j]);
+      }
+      AssertNoError();
+    }
+    return true;
+  }
+
+  RTCScene g_commit_scene = NULL;
+  size_t g_commit_threads = 0;
+
+  void commit_thread(void* ptr) {
+    rtcCommitThread(g_commit_scene,(unsigned int)(size_t)ptr,(unsigned int)g_commit_threads);
+  }
+
+  void commit_with_threads(RTCScene scene, size_t numThreads)
+  {
+    g_commit_scene = scene;
+    g_commit_threads = numThreads;
+    for (size_t i=1; i<numThreads; i++)
+      g_threads.push_back(createThread(commit_thread,(void*)i,1000000,i));
+    commit_thread((void*)0);
+    for (size_t i=0; i<g_threads.size(); i++)
+      join(g_threads[i]);
+    g_threads.clear();
+  }
+
+  bool rtcore_commit_thread(RTCSceneFlags sflags, size_t numThreads)
+  {
+    RTCScene scene = rtcNewScene(sflags,aflags);
+    AssertNoError();
+    rtcCommit (scene);
+    AssertError(RTC_INVALID_OPERATION); // only rtcCommitThread can be used
+    rtcCommitThread (scene,0,numThreads+1);
+    AssertError(RTC_INVALID_ARGUMENT);
+
+    size_t numPhi = 50;
+    size_t numVertices = 2*numPhi*(numPhi+1);
+    RTCGeometryFlags gflags = sflags & RTC_SCENE_DYNAMIC ? RTC_GEOMETRY_DEFORMABLE : RTC_GEOMETRY_STATIC;
+    unsigned geom0 = addSphere(scene,gflags,Vec3fa(-1,0,-1),1.0f,numPhi);
+    unsigned geom1 = addSphere(scene,gflags,Vec3fa(+1,0,+1),1.0f,numPhi);
+    Vec3fa pos0 = Vec3fa(zero);
+    commit_with_threads(scene,numThreads);
+    AssertNoError();
+
+    size_t numCommits = sflags & RTC_SCENE_DYNAMIC ? 10 : 1;
+    for (size_t i=0; i<numCommits; i++) 
+    {
+      if (i) {
+        Vec3fa ds(20,0,20);
+        move_mesh(scene,geom0,numVertices,ds); pos0 += ds;
+        commit_with_threads(scene,numThreads);
+        AssertNoError();
+      }
+      RTCRay ray0 = makeRay(pos0+Vec3fa(-1,10,-1),Vec3fa(0,-1,0)); 
+      RTCRay ray1 = makeRay(Vec3fa(+1,10,+1),Vec3fa(0,-1,0)); 
+      rtcIntersect(scene,ray0);
+      rtcIntersect(scene,ray1);
+      if (ray0.geomID != geom0 || ray1.geomID != geom1) return false;
+    }
+
+    rtcDeleteScene (scene);
+    AssertNoError();
+    return true;
+  }
+
   bool rtcore_ray_masks_intersect(RTCSceneFlags sflags, RTCGeometryFlags gflags)
   {
     bool passed = true;
@@ -1499,77 +1832,944 @@ namespace embree
 	  fflush(stdout);
   }
 
-  void rtcore_watertight_sphere1(float pos)
+  bool rtcore_ray_stream(RTCSceneFlags sflags, RTCGeometryFlags gflags)
   {
-    RTCScene scene = rtcNewScene(RTC_SCENE_STATIC | RTC_SCENE_ROBUST,aflags);
-    unsigned geom = addSphere(scene,RTC_GEOMETRY_STATIC,Vec3fa(pos,0.0f,0.0f),2.0f,1000);
+    bool passed = true;
+    RTCScene scene = rtcNewScene(sflags,aflags);
+    addSphere(scene,gflags,Vec3fa(-1,0,-1),1.0f,50,-1,0.0f);
+    addSphere(scene,gflags,Vec3fa(+1,0,+1),1.0f,50,-1,0.0f);
+    addSphere(scene,gflags,Vec3fa(0,+2,0),0.5f,20,-1,0.0f);
     rtcCommit (scene);
-    size_t numFailures = 0;
-    for (size_t i=0; i<testN; i++) {
-      Vec3fa org(2.0f*drand48()-1.0f,2.0f*drand48()-1.0f,2.0f*drand48()-1.0f);
+    AssertNoError();
+
+    /* incoherent rays starting everywhere inside the scene */
+    const size_t N = 2345;
+    RTCRay* rays = (RTCRay*) alignedMalloc(N*sizeof(RTCRay));
+    RTCRay* rays0 = (RTCRay*) alignedMalloc(N*sizeof(RTCRay));
+    for (size_t i=0; i<N; i++) {
+      Vec3fa org(4.0f*drand48()-2.0f,4.0f*drand48()-2.0f,4.0f*drand48()-2.0f);
       Vec3fa dir(2.0f*drand48()-1.0f,2.0f*drand48()-1.0f,2.0f*drand48()-1.0f);
-      RTCRay ray = makeRay(Vec3fa(pos,0.0f,0.0f)+org,dir); 
-      rtcIntersect(scene,ray);
-      numFailures += ray.primID == -1;
+      rays[i] = rays0[i] = makeRay(org,dir);
+    }
+
+    /* structure of arrays copy of the rays */
+    std::vector<float> orgx(N), orgy(N), orgz(N), dirx(N), diry(N), dirz(N), tnear(N), tfar(N), time(N);
+    std::vector<float> Ngx(N), Ngy(N), Ngz(N), u(N), v(N);
+    std::vector<int> mask(N), geomID(N), primID(N), instID(N);
+    RTCRayNp raysNp = { &orgx[0], &orgy[0], &orgz[0], &dirx[0], &diry[0], &dirz[0], &tnear[0], &tfar[0], &time[0], &mask[0],
+                        &Ngx[0], &Ngy[0], &Ngz[0], &u[0], &v[0], &geomID[0], &primID[0], &instID[0] };
+    for (size_t i=0; i<N; i++) {
+      orgx[i] = rays[i].org[0]; orgy[i] = rays[i].org[1]; orgz[i] = rays[i].org[2];
+      dirx[i] = rays[i].dir[0]; diry[i] = rays[i].dir[1]; dirz[i] = rays[i].dir[2];
+      tnear[i] = rays[i].tnear; tfar[i] = rays[i].tfar; time[i] = rays[i].time; mask[i] = rays[i].mask;
+      geomID[i] = primID[i] = instID[i] = -1;
     }
+
+    /* streams have to give the same hits as single rays */
+    ::rtcIntersectN(scene,rays,N);
+    ::rtcIntersectNp(scene,raysNp,N);
+    AssertNoError();
+    for (size_t i=0; i<N; i++) {
+      rtcIntersect(scene,rays0[i]);
+      passed &= rays[i].geomID == rays0[i].geomID && geomID[i] == rays0[i].geomID;
+      passed &= rays[i].primID == rays0[i].primID && primID[i] == rays0[i].primID;
+      if (rays0[i].geomID == -1) continue;
+      passed &= fabs(rays[i].tfar-rays0[i].tfar) < 1E-3f && fabs(tfar[i]-rays0[i].tfar) < 1E-3f;
+    }
+
+    /* rays ending before the hit point are not occluded, the others are */
+    for (size_t i=0; i<N; i++) {
+      rays[i].tfar = (i%2) ? float(inf) : 0.99f*rays0[i].tfar; 
+      rays[i].geomID = -1;
+    }
+    ::rtcOccludedN(scene,rays,N);
+    AssertNoError();
+    for (size_t i=0; i<N; i++) 
+      passed &= (rays[i].geomID == -1) == ((i%2) == 0 || rays0[i].geomID == -1);
+
+    alignedFree(rays0);
+    alignedFree(rays);
     rtcDeleteScene (scene);
+    return passed;
+  }
 
-    printf("%30s ... %s (%f%%)\n","watertight_sphere1",
-           numFailures ? "\033[31m[FAILED]\033[0m" : "\033[32m[PASSED]\033[0m", 100.0f*(double)numFailures/(double)testN);
+  void rtcore_ray_stream_all()
+  {
+    printf("%30s ... ","ray_stream");
+    bool passed = true;
+    for (int i=0; i<numSceneFlags; i++) 
+    {
+      RTCSceneFlags flag = getSceneFlag(i);
+      bool ok0 = rtcore_ray_stream(flag,RTC_GEOMETRY_STATIC);
+      if (ok0) printf("\033[32m+\033[0m"); else printf("\033[31m-\033[0m");
+      passed &= ok0;
+    }
+    printf(" %s\n",passed ? "\033[32m[PASSED]\033[0m" : "\033[31m[FAILED]\033[0m");
 	  fflush(stdout);
   }
-  
-  void rtcore_watertight_sphere4(float pos)
+
+  bool rtcore_ray_stream_no_intersector()
   {
-    RTCScene scene = rtcNewScene(RTCSceneFlags(RTC_SCENE_STATIC | RTC_SCENE_ROBUST),aflags);
-    unsigned geom = addSphere(scene,RTC_GEOMETRY_STATIC,Vec3fa(pos,0.0f,0.0f),2.0f,1000);
+    /* streams cannot be traced without a single ray or packet intersector */
+    RTCScene scene = rtcNewScene(RTC_SCENE_STATIC,RTC_INTERSECT16);
+    addSphere(scene,RTC_GEOMETRY_STATIC,Vec3fa(0,0,0),1.0f,50,-1,0.0f);
     rtcCommit (scene);
-    size_t numFailures = 0;
-    for (size_t i=0; i<testN; i+=4) {
-      RTCRay4 ray4;
-      for (size_t j=0; j<4; j++) {
-        Vec3fa org(2.0f*drand48()-1.0f,2.0f*drand48()-1.0f,2.0f*drand48()-1.0f);
-        Vec3fa dir(2.0f*drand48()-1.0f,2.0f*drand48()-1.0f,2.0f*drand48()-1.0f);
-        RTCRay ray = makeRay(Vec3fa(pos,0.0f,0.0f)+org,dir); 
-        setRay(ray4,j,ray);
-      }
-      __align(16) int valid[4] = { -1,-1,-1,-1 };
-      rtcIntersect4(valid,scene,ray4);
-      for (size_t j=0; j<4; j++)
-        numFailures += ray4.primID[j] == -1;
-    }
+    AssertNoError();
+
+    RTCRay rays[4];
+    for (size_t i=0; i<4; i++) rays[i] = makeRay(Vec3fa(0,0,-4),Vec3fa(0,0,1));
+    rtcIntersectN(scene,rays,4);
+    AssertError(RTC_INVALID_OPERATION);
+    rtcOccludedN(scene,rays,4);
+    AssertError(RTC_INVALID_OPERATION);
+
     rtcDeleteScene (scene);
-    printf("%30s ... %s (%f%%)\n","watertight_sphere4",
-           numFailures ? "\033[31m[FAILED]\033[0m" : "\033[32m[PASSED]\033[0m", 100.0f*(double)numFailures/(double)testN);
-	  fflush(stdout);
+    return rays[0].geomID == -1;
   }
 
-  void rtcore_watertight_sphere8(float pos)
+  /* traces packets of different sizes and compares them with single rays */
+  bool rtcore_ray_packet(RTCScene scene)
   {
-    RTCScene scene = rtcNewScene(RTC_SCENE_STATIC | RTC_SCENE_ROBUST,aflags);
-    unsigned geom = addSphere(scene,RTC_GEOMETRY_STATIC,Vec3fa(pos,0.0f,0.0f),2.0f,1000);
-    rtcCommit (scene);
-    size_t numFailures = 0;
-    for (size_t i=0; i<testN; i+=8) {
-      RTCRay8 ray8;
-      for (size_t j=0; j<8; j++) {
-        Vec3fa org(2.0f*drand48()-1.0f,2.0f*drand48()-1.0f,2.0f*drand48()-1.0f);
-        Vec3fa dir(2.0f*drand48()-1.0f,2.0f*drand48()-1.0f,2.0f*drand48()-1.0f);
-        RTCRay ray = makeRay(Vec3fa(pos,0.0f,0.0f)+org,dir); 
-        setRay(ray8,j,ray);
+    bool passed = true;
+    const size_t maxN = RTC_MAX_PACKET_SIZE+44;
+    std::vector<float> orgx(maxN), orgy(maxN), orgz(maxN), dirx(maxN), diry(maxN), dirz(maxN), tnear(maxN), tfar(maxN), time(maxN);
+    std::vector<float> Ngx(maxN), Ngy(maxN), Ngz(maxN), u(maxN), v(maxN);
+    std::vector<int> mask(maxN), geomID(maxN), primID(maxN), instID(maxN);
+    RTCRayNp raysNp = { &orgx[0], &orgy[0], &orgz[0], &dirx[0], &diry[0], &dirz[0], &tnear[0], &tfar[0], &time[0], &mask[0],
+                        &Ngx[0], &Ngy[0], &Ngz[0], &u[0], &v[0], &geomID[0], &primID[0], &instID[0] };
+    std::vector<RTCRay> rays0(maxN);
+
+    const size_t sizes[] = { 1, 7, 64, 100, RTC_MAX_PACKET_SIZE, maxN };
+    for (size_t p=0; p<6*sizeof(sizes)/sizeof(size_t); p++)
+    {
+      /* coherent camera tiles, tiles with rays of all octants, and random rays */
+      const size_t N = sizes[p%(sizeof(sizes)/sizeof(size_t))];
+      const int kind = p/(sizeof(sizes)/sizeof(size_t)) % 3;
+      const Vec3fa cam(4.0f*drand48()-2.0f,4.0f*drand48()-2.0f,-4.0f);
+      const Vec3fa dir0(0.2f*drand48()-0.1f,0.2f*drand48()-0.1f,1.0f);
+      for (size_t i=0; i<N; i++) 
+      {
+        const float x = float(i%16)/16.0f-0.5f, y = float(i/16)/16.0f-0.5f;
+        Vec3fa org = cam, dir = dir0 + Vec3fa(0.2f*x,0.2f*y,0.0f);
+        if (kind == 1) dir = Vec3fa(x,y,(i%2) ? 0.2f : -0.2f);
+        if (kind == 2) {
+          org = Vec3fa(4.0f*drand48()-2.0f,4.0f*drand48()-2.0f,4.0f*drand48()-2.0f);
+          dir = Vec3fa(2.0f*drand48()-1.0f,2.0f*drand48()-1.0f,2.0f*drand48()-1.0f);
+        }
+        rays0[i] = makeRay(org,dir);
+        orgx[i] = org.x; orgy[i] = org.y; orgz[i] = org.z;
+        dirx[i] = dir.x; diry[i] = dir.y; dirz[i] = dir.z;
+        tnear[i] = 0.0f; tfar[i] = inf; time[i] = 0.0f; mask[i] = -1;
+        geomID[i] = primID[i] = instID[i] = -1;
+      }
+
+      /* packets have to give the same hits as single rays */
+      rtcIntersectPacket(scene,raysNp,N);
+      AssertNoError();
+      for (size_t i=0; i<N; i++) {
+        rtcIntersect(scene,rays0[i]);
+        passed &= geomID[i] == rays0[i].geomID;
+        passed &= primID[i] == rays0[i].primID;
+        if (rays0[i].geomID == -1) continue;
+        passed &= fabs(tfar[i]-rays0[i].tfar) < 1E-3f;
+      }
+
+      /* shadow rays from the hit points towards a point light are occluded like single rays */
+      const Vec3fa light(0.0f,4.0f,-4.0f);
+      for (size_t i=0; i<N; i++) {
+        const Vec3fa org = Vec3fa(orgx[i],orgy[i],orgz[i]) + min(tfar[i],8.0f)*Vec3fa(dirx[i],diry[i],dirz[i]);
+        rays0[i] = makeRay(org,light-org,1E-3f,1.0f);
+        orgx[i] = org.x; orgy[i] = org.y; orgz[i] = org.z;
+        dirx[i] = light.x-org.x; diry[i] = light.y-org.y; dirz[i] = light.z-org.z;
+        tnear[i] = 1E-3f; tfar[i] = 1.0f; geomID[i] = -1;
+      }
+      rtcOccludedPacket(scene,raysNp,N);
+      AssertNoError();
+      for (size_t i=0; i<N; i++) {
+        rtcOccluded(scene,rays0[i]);
+        passed &= (geomID[i] == -1) == (rays0[i].geomID == -1);
       }
-      __align(32) int valid[8] = { -1,-1,-1,-1,-1,-1,-1,-1 };
-      rtcIntersect8(valid,scene,ray8);
-      for (size_t j=0; j<8; j++)
-        numFailures += ray8.primID[j] == -1;
     }
-    rtcDeleteScene (scene);
-    printf("%30s ... %s (%f%%)\n","watertight_sphere8",
-           numFailures ? "\033[31m[FAILED]\033[0m" : "\033[32m[PASSED]\033[0m", 100.0f*(double)numFailures/(double)testN);
-	  fflush(stdout);
+    return passed;
   }
 
-  void rtcore_watertight_sphere16(float pos)
+  bool rtcore_ray_packet(RTCSceneFlags sflags, RTCGeometryFlags gflags)
+  {
+    RTCScene scene = rtcNewScene(sflags,aflags);
+    addSphere(scene,gflags,Vec3fa(-1,0,-1),1.0f,50,-1,0.0f);
+    addSphere(scene,gflags,Vec3fa(+1,0,+1),1.0f,50,-1,0.0f);
+    addSphere(scene,gflags,Vec3fa(0,+2,0),0.5f,20,-1,0.0f);
+    rtcCommit (scene);
+    AssertNoError();
+
+    bool passed = rtcore_ray_packet(scene);
+    rtcDeleteScene (scene);
+    return passed;
+  }
+
+  bool rtcore_ray_packet_new_geometry_type()
+  {
+    /* packets traced while the scene has a single acceleration structure */
+    RTCScene scene = rtcNewScene(RTC_SCENE_DYNAMIC,aflags);
+    addSphere(scene,RTC_GEOMETRY_STATIC,Vec3fa(-1,0,-1),1.0f,50,-1,0.0f);
+    rtcCommit (scene);
+    AssertNoError();
+    bool passed = rtcore_ray_packet(scene);
+
+    /* a geometry of another type adds a second acceleration structure */
+    addQuadSphere(scene,RTC_GEOMETRY_STATIC,Vec3fa(+1,0,+1),1.0f,50);
+    rtcCommit (scene);
+    AssertNoError();
+    passed &= rtcore_ray_packet(scene);
+
+    rtcDeleteScene (scene);
+    return passed;
+  }
+
+  void rtcore_ray_packet_all()
+  {
+    printf("%30s ... ","ray_packet");
+    bool passed = true;
+    for (int i=0; i<numSceneFlags; i++) 
+    {
+      RTCSceneFlags flag = getSceneFlag(i);
+      bool ok0 = rtcore_ray_packet(flag,RTC_GEOMETRY_STATIC);
+      if (ok0) printf("\033[32m+\033[0m"); else printf("\033[31m-\033[0m");
+      passed &= ok0;
+    }
+    printf(" %s\n",passed ? "\033[32m[PASSED]\033[0m" : "\033[31m[FAILED]\033[0m");
+	  fflush(stdout);
+  }
+
+  bool rtcore_compact_scene(int N)
+  {
+    /* the same geometry once in a default and once in a compact scene */
+    RTCScene scene0 = rtcNewScene(RTC_SCENE_STATIC,aflags);
+    RTCScene scene1 = rtcNewScene(RTC_SCENE_STATIC | RTC_SCENE_COMPACT,aflags);
+    for (size_t i=0; i<2; i++) {
+      RTCScene scene = i ? scene1 : scene0;
+      addSphere(scene,RTC_GEOMETRY_STATIC,Vec3fa(-1,0,-1),1.0f,50,-1,0.0f);
+      addSphere(scene,RTC_GEOMETRY_STATIC,Vec3fa(+1,0,+1),1.0f,50,-1,0.0f);
+      addSphere(scene,RTC_GEOMETRY_STATIC,Vec3fa(0,+2,0),0.5f,20,-1,0.0f);
+      rtcCommit (scene);
+    }
+    AssertNoError();
+
+    /* both scenes have to report the same hits */
+    bool passed = true;
+    for (size_t i=0; i<10000; i++) 
+    {
+      Vec3fa org(4.0f*drand48()-2.0f,4.0f*drand48()-2.0f,4.0f*drand48()-2.0f);
+      Vec3fa dir(2.0f*drand48()-1.0f,2.0f*drand48()-1.0f,2.0f*drand48()-1.0f);
+      RTCRay ray0 = makeRay(org,dir); rtcIntersectN(scene0,ray0,N);
+      RTCRay ray1 = makeRay(org,dir); rtcIntersectN(scene1,ray1,N);
+      passed &= ray0.geomID == ray1.geomID;
+      if (ray0.geomID == -1) continue;
+      passed &= fabs(ray0.tfar-ray1.tfar) < 1E-3f*ray0.tfar;
+    }
+    AssertNoError();
+
+    rtcDeleteScene (scene0);
+    rtcDeleteScene (scene1);
+    return passed;
+  }
+
+  bool rtcore_quantized_scene(int N)
+  {
+    /* the same rays once through the default and once through quantized leaves */
+    const size_t numRays = 10000;
+    std::vector<Vec3fa> org(numRays), dir(numRays);
+    std::vector<float> tfar(numRays);
+    std::vector<int> geomID(numRays);
+    for (size_t i=0; i<numRays; i++) {
+      org[i] = Vec3fa(4.0f*drand48()-2.0f,4.0f*drand48()-2.0f,4.0f*drand48()-2.0f);
+      dir[i] = Vec3fa(2.0f*drand48()-1.0f,2.0f*drand48()-1.0f,2.0f*drand48()-1.0f);
+    }
+
+    bool passed = true;
+    const float eps = 1E-3f;
+    for (size_t j=0; j<2; j++)
+    {
+      std::string cfg = j ? "accel=bvh4.triangle4q.compressed" : "";
+      if (g_rtcore != "") cfg = j ? g_rtcore+","+cfg : g_rtcore;
+      rtcInit(cfg.c_str());
+      RTCScene scene = rtcNewScene(RTC_SCENE_STATIC,aflags);
+      addSphere(scene,RTC_GEOMETRY_STATIC,Vec3fa(-1,0,-1),1.0f,50,-1,0.0f);
+      addSphere(scene,RTC_GEOMETRY_STATIC,Vec3fa(+1,0,+1),1.0f,50,-1,0.0f);
+      addSphere(scene,RTC_GEOMETRY_STATIC,Vec3fa(0,+2,0),0.5f,20,-1,0.0f);
+      rtcCommit (scene);
+
+      for (size_t i=0; i<numRays; i++) 
+      {
+        RTCRay ray = makeRay(org[i],dir[i]); rtcIntersectN(scene,ray,N);
+        if (j == 0) { tfar[i] = ray.tfar; geomID[i] = ray.geomID; continue; }
+        if (min(tfar[i],ray.tfar) < eps) continue; /* origin closer to the surface than the tolerance */
+        bool equal = ray.geomID == geomID[i];
+        if (geomID[i] != -1) equal &= fabs(tfar[i]-ray.tfar) < 1E-3f*tfar[i] + eps;
+
+        /* the slightly enlarged quantized triangles may only add closer hits */
+        if (!equal) equal = ray.tfar < tfar[i];
+        passed &= equal;
+      }
+      passed &= rtcGetError() == RTC_NO_ERROR;
+      rtcDeleteScene (scene);
+      rtcExit();
+    }
+    return passed;
+  }
+
+  bool rtcore_quantized_thin_triangles(int N)
+  {
+    std::string cfg = "accel=bvh4.triangle4q.compressed";
+    if (g_rtcore != "") cfg = g_rtcore+","+cfg;
+    rtcInit(cfg.c_str());
+
+    /* a long tilted cylinder of very thin triangles, whose quantization errors exceed their width noticeably */
+    const size_t numTheta = 1000;
+    const float length = 100.0f;
+    const Vec3fa axis = normalize(Vec3fa(1,1,1));
+    const Vec3fa dx = normalize(cross(axis,Vec3fa(0,0,1)));
+    const Vec3fa dy = cross(axis,dx);
+    RTCScene scene = rtcNewScene(RTC_SCENE_STATIC,aflags);
+    unsigned mesh = rtcNewTriangleMesh (scene, RTC_GEOMETRY_STATIC, 2*numTheta, 2*numTheta);
+    Vertex* vertices = (Vertex*) rtcMapBuffer(scene,mesh,RTC_VERTEX_BUFFER); 
+    Triangle* triangles = (Triangle*) rtcMapBuffer(scene,mesh,RTC_INDEX_BUFFER);
+    for (size_t i=0; i<numTheta; i++) 
+    {
+      const float theta = 2.0f*float(pi)*float(i)/float(numTheta);
+      for (size_t j=0; j<2; j++) {
+        const Vec3fa p = float(j)*length*axis + cosf(theta)*dx + sinf(theta)*dy;
+        Vertex& v = vertices[2*i+j]; v.x = p.x; v.y = p.y; v.z = p.z; 
+      }
+      const int i0 = 2*i, i1 = 2*((i+1)%numTheta);
+      triangles[2*i+0].v0 = i0; triangles[2*i+0].v1 = i0+1; triangles[2*i+0].v2 = i1;
+      triangles[2*i+1].v0 = i1; triangles[2*i+1].v1 = i0+1; triangles[2*i+1].v2 = i1+1;
+    }
+    rtcUnmapBuffer(scene,mesh,RTC_VERTEX_BUFFER); 
+    rtcUnmapBuffer(scene,mesh,RTC_INDEX_BUFFER);
+    rtcCommit (scene);
+
+    /* shoot at the axis from outside of the cylinder */
+    bool passed = true;
+    for (size_t i=0; i<10000; i++) 
+    {
+      const float theta = 2.0f*float(pi)*drand48();
+      const Vec3fa radial = cosf(theta)*dx + sinf(theta)*dy;
+      const Vec3fa org = (0.1f+0.8f*drand48())*length*axis + 2.0f*radial;
+      RTCRay ray = makeRay(org,-radial); rtcIntersectN(scene,ray,N);
+      passed &= ray.geomID == mesh && fabs(ray.tfar-1.0f) < 0.05f;
+    }
+    passed &= rtcGetError() == RTC_NO_ERROR;
+    rtcDeleteScene (scene);
+    rtcExit();
+    return passed;
+  }
+
+  bool rtcore_store_load_scene(int N)
+  {
+    /* build and store a scene */
+    const char* fileName = "verify_scene.bin";
+    RTCScene scene0 = rtcNewScene(RTC_SCENE_STATIC,aflags);
+    addSphere(scene0,RTC_GEOMETRY_STATIC,Vec3fa(-1,0,-1),1.0f,50,-1,0.0f);
+    addSphere(scene0,RTC_GEOMETRY_STATIC,Vec3fa(+1,0,+1),1.0f,50,-1,0.0f);
+    rtcCommit (scene0);
+    rtcStoreScene (scene0,fileName);
+    AssertNoError();
+
+    /* a scene with different geometry cannot load the file */
+    RTCScene scene1 = rtcNewScene(RTC_SCENE_STATIC,aflags);
+    addSphere(scene1,RTC_GEOMETRY_STATIC,Vec3fa(-1,0,-1),1.0f,50,-1,0.0f);
+    rtcLoadScene (scene1,fileName);
+    AssertError(RTC_INVALID_ARGUMENT);
+    rtcDeleteScene (scene1);
+
+    /* load file into a scene with the same geometry */
+    RTCScene scene2 = rtcNewScene(RTC_SCENE_STATIC,aflags);
+    addSphere(scene2,RTC_GEOMETRY_STATIC,Vec3fa(-1,0,-1),1.0f,50,-1,0.0f);
+    addSphere(scene2,RTC_GEOMETRY_STATIC,Vec3fa(+1,0,+1),1.0f,50,-1,0.0f);
+    rtcLoadScene (scene2,fileName);
+    AssertNoError();
+
+    /* both scenes have to report the same hits */
+    bool passed = true;
+    for (size_t i=0; i<10000; i++) 
+    {
+      Vec3fa org(4.0f*drand48()-2.0f,4.0f*drand48()-2.0f,4.0f*drand48()-2.0f);
+      Vec3fa dir(2.0f*drand48()-1.0f,2.0f*drand48()-1.0f,2.0f*drand48()-1.0f);
+      RTCRay ray0 = makeRay(org,dir); rtcIntersectN(scene0,ray0,N);
+      RTCRay ray2 = makeRay(org,dir); rtcIntersectN(scene2,ray2,N);
+      passed &= ray0.geomID == ray2.geomID && ray0.primID == ray2.primID && ray0.tfar == ray2.tfar;
+    }
+    AssertNoError();
+
+    rtcDeleteScene (scene0);
+    rtcDeleteScene (scene2);
+    remove(fileName);
+    return passed;
+  }
+
+  bool rtcore_triangle_leaves(int N)
+  {
+    /* three separated spheres */
+    RTCScene scene = rtcNewScene(RTC_SCENE_STATIC,aflags);
+    const Vec3fa pos[3] = { Vec3fa(-1,0,-1), Vec3fa(+1,0,+1), Vec3fa(0,+2,0) };
+    const float  rad[3] = { 1.0f, 1.0f, 0.5f };
+    for (size_t i=0; i<3; i++) addSphere(scene,RTC_GEOMETRY_STATIC,pos[i],rad[i],50);
+    rtcCommit (scene);
+    AssertNoError();
+
+    /* shoot at the center of each sphere from just outside of it */
+    bool passed = true;
+    for (size_t i=0; i<3000; i++) 
+    {
+      const unsigned geomID = i%3;
+      const float r = rad[geomID];
+      const Vec3fa dir = normalize(Vec3fa(2.0f*drand48()-1.0f,2.0f*drand48()-1.0f,2.0f*drand48()-1.0f));
+      const Vec3fa org = pos[geomID] - 1.2f*r*dir;
+
+      RTCRay ray = makeRay(org,dir); rtcIntersectN(scene,ray,N);
+      passed &= ray.geomID == geomID;
+      if (ray.geomID != geomID) continue;
+      passed &= ray.tfar >= 0.19f*r && ray.tfar <= 0.21f*r;
+      passed &= ray.u >= 0.0f && ray.v >= 0.0f && ray.u+ray.v <= 1.0f;
+      const Vec3fa Ng = normalize(Vec3fa(ray.Ng[0],ray.Ng[1],ray.Ng[2]));
+      passed &= fabs(dot(Ng,dir)) > 0.95f;
+
+      /* the sphere occludes only rays that reach it */
+      RTCRay shadow0 = makeRay(org,dir,0.0f,0.18f*r); rtcOccludedN(scene,shadow0,N);
+      RTCRay shadow1 = makeRay(org,dir,0.0f,0.22f*r); rtcOccludedN(scene,shadow1,N);
+      passed &= shadow0.geomID == -1 && shadow1.geomID == 0;
+    }
+    AssertNoError();
+
+    rtcDeleteScene (scene);
+    return passed;
+  }
+
+  void rtcore_triangle_leaves_all(const char* accel)
+  {
+    std::string cfg = "accel="+std::string(accel);
+    if (g_rtcore != "") cfg = g_rtcore+","+cfg;
+    rtcInit(cfg.c_str());
+
+    printf("%30s ... ",accel);
+    bool passed = true;
+    passed &= rtcore_triangle_leaves(1);
+    passed &= rtcore_triangle_leaves(4);
+#if defined(__TARGET_AVX__) || defined(__TARGET_AVX2__)
+    if (has_feature(AVX)) 
+      passed &= rtcore_triangle_leaves(8);
+#endif
+    printf("%s\n",passed ? "\033[32m[PASSED]\033[0m" : "\033[31m[FAILED]\033[0m");
+    fflush(stdout);
+    rtcExit();
+  }
+
+  bool rtcore_quad_mesh_motion_blur()
+  {
+    /* motion blurred quads are not supported yet */
+    RTCScene scene = rtcNewScene(RTC_SCENE_DYNAMIC,aflags);
+    rtcNewQuadMesh (scene, RTC_GEOMETRY_STATIC, 16, 16, 2);
+    AssertError(RTC_INVALID_OPERATION);
+    rtcNewQuadMesh (scene, RTC_GEOMETRY_STATIC, 16, 16, 1);
+    AssertNoError();
+    rtcDeleteScene (scene);
+    return true;
+  }
+
+  bool rtcore_quad_mesh(RTCSceneFlags sflags, int N)
+  {
+    /* the same spheres once as triangles and once as quads and triangles */
+    RTCScene scene0 = rtcNewScene(sflags,aflags);
+    addSphere(scene0,RTC_GEOMETRY_STATIC,Vec3fa(-1,0,-1),1.0f,50);
+    addSphere(scene0,RTC_GEOMETRY_STATIC,Vec3fa(+1,0,+1),1.0f,50);
+    rtcCommit (scene0);
+    RTCScene scene1 = rtcNewScene(sflags,aflags);
+    addQuadSphere(scene1,RTC_GEOMETRY_STATIC,Vec3fa(-1,0,-1),1.0f,50);
+    addSphere(scene1,RTC_GEOMETRY_STATIC,Vec3fa(+1,0,+1),1.0f,50);
+    rtcCommit (scene1);
+    AssertNoError();
+
+    /* both scenes have to report the same hits */
+    bool passed = true;
+    for (size_t i=0; i<10000; i++) 
+    {
+      Vec3fa org(4.0f*drand48()-2.0f,4.0f*drand48()-2.0f,4.0f*drand48()-2.0f);
+      Vec3fa dir(2.0f*drand48()-1.0f,2.0f*drand48()-1.0f,2.0f*drand48()-1.0f);
+      RTCRay ray0 = makeRay(org,dir); rtcIntersectN(scene0,ray0,N);
+      RTCRay ray1 = makeRay(org,dir); rtcIntersectN(scene1,ray1,N);
+      passed &= ray0.geomID == ray1.geomID;
+      RTCRay shadow0 = makeRay(org,dir); rtcOccludedN(scene0,shadow0,N);
+      RTCRay shadow1 = makeRay(org,dir); rtcOccludedN(scene1,shadow1,N);
+      passed &= shadow0.geomID == shadow1.geomID;
+      if (ray0.geomID != 0 || ray1.geomID != 0) continue;
+      passed &= fabs(ray0.tfar-ray1.tfar) < 1E-3f*ray0.tfar;
+      passed &= ray1.u >= 0.0f && ray1.u <= 1.0f && ray1.v >= 0.0f && ray1.v <= 1.0f;
+      passed &= dot(Vec3fa(ray0.Ng[0],ray0.Ng[1],ray0.Ng[2]),Vec3fa(ray1.Ng[0],ray1.Ng[1],ray1.Ng[2])) > 0.0f;
+    }
+    AssertNoError();
+
+    rtcDeleteScene (scene0);
+    rtcDeleteScene (scene1);
+    return passed;
+  }
+
+  bool rtcore_statistics(RTCSceneFlags sflags, int N)
+  {
+    RTCScene scene = rtcNewScene(sflags,aflags);
+    addSphere(scene,RTC_GEOMETRY_STATIC,Vec3fa(-1,0,-1),1.0f,50,-1,0.0f);
+    addSphere(scene,RTC_GEOMETRY_STATIC,Vec3fa(+1,0,+1),1.0f,50,-1,0.0f);
+    rtcCommit (scene);
+    AssertNoError();
+
+    bool passed = true;
+    for (int mode=RTC_STATISTICS_DISABLED; mode<=RTC_STATISTICS_SAMPLED; mode++)
+    {
+      rtcSetStatisticsMode(scene,(RTCStatisticsMode)mode);
+      rtcClearStatistics(scene);
+      AssertNoError();
+
+      /* trace some rays and count the hits */
+      size_t numRays = 0, numHits = 0;
+      for (size_t i=0; i<2000; i++) 
+      {
+        Vec3fa org(4.0f*drand48()-2.0f,4.0f*drand48()-2.0f,4.0f*drand48()-2.0f);
+        Vec3fa dir(2.0f*drand48()-1.0f,2.0f*drand48()-1.0f,2.0f*drand48()-1.0f);
+        RTCRay ray = makeRay(org,dir); 
+        if (i%2) rtcIntersectN(scene,ray,N);
+        else     rtcOccludedN (scene,ray,N);
+        numRays += N;
+        numHits += ray.geomID != -1 ? N : 0;
+      }
+
+      RTCStatistics stats;
+      rtcGetStatistics(scene,&stats);
+      AssertNoError();
+
+      switch (mode) {
+      case RTC_STATISTICS_DISABLED: 
+        passed &= stats.rays == 0 && stats.nodes == 0 && stats.leaves == 0 && stats.primitives == 0 && stats.hits == 0;
+        break;
+      case RTC_STATISTICS_ENABLED: 
+        passed &= stats.rays == numRays && stats.hits == numHits;
+        passed &= stats.nodes > 0 && stats.leaves > 0 && stats.primitives >= stats.leaves;
+        break;
+      case RTC_STATISTICS_SAMPLED: 
+        passed &= stats.rays % N == 0 && stats.rays > numRays/2 && stats.rays < 2*numRays;
+        passed &= stats.nodes > 0 && stats.hits <= stats.rays;
+        break;
+      }
+
+      /* clearing resets all counters */
+      rtcClearStatistics(scene);
+      rtcGetStatistics(scene,&stats);
+      passed &= stats.rays == 0 && stats.nodes == 0 && stats.hits == 0;
+    }
+    AssertNoError();
+
+    rtcDeleteScene (scene);
+    return passed;
+  }
+
+  struct StatisticsThreadData {
+    RTCScene scene;
+    size_t numRays;
+    size_t numHits;
+  };
+
+  void statistics_thread(void* ptr)
+  {
+    StatisticsThreadData* data = (StatisticsThreadData*) ptr;
+    for (size_t i=0; i<data->numRays; i++) {
+      RTCRay ray = makeRay(Vec3fa(float(i%7)*0.1f,0,-4),Vec3fa(0,float(i%5)*0.1f,1));
+      rtcIntersect(data->scene,ray);
+      data->numHits += ray.geomID != -1;
+    }
+  }
+
+  bool rtcore_statistics_many_threads()
+  {
+    RTCScene scene = rtcNewScene(RTC_SCENE_STATIC,aflags);
+    addSphere(scene,RTC_GEOMETRY_STATIC,Vec3fa(0,0,0),1.0f,50,-1,0.0f);
+    rtcCommit (scene);
+    rtcSetStatisticsMode(scene,RTC_STATISTICS_ENABLED);
+    AssertNoError();
+
+    /* more threads than slots of counters have to share the last slot */
+    const size_t numThreads = 300, numConcurrent = 8;
+    std::vector<StatisticsThreadData> data(numThreads);
+    for (size_t i=0; i<numThreads; i+=numConcurrent) 
+    {
+      std::vector<thread_t> threads;
+      for (size_t j=i; j<min(i+numConcurrent,numThreads); j++) {
+        data[j].scene = scene; data[j].numRays = 1000; data[j].numHits = 0;
+        threads.push_back(createThread(statistics_thread,&data[j]));
+      }
+      for (size_t j=0; j<threads.size(); j++) join(threads[j]);
+    }
+
+    /* no ray may get lost */
+    size_t numRays = 0, numHits = 0;
+    for (size_t i=0; i<numThreads; i++) {
+      numRays += data[i].numRays;
+      numHits += data[i].numHits;
+    }
+    RTCStatistics stats;
+    rtcGetStatistics(scene,&stats);
+    AssertNoError();
+    rtcDeleteScene (scene);
+    return stats.rays == numRays && stats.hits == numHits;
+  }
+
+  bool rtcore_memory_statistics(RTCSceneFlags sflags)
+  {
+    RTCScene scene = rtcNewScene(sflags,aflags);
+    addSphere(scene,RTC_GEOMETRY_STATIC,Vec3fa(-1,0,-1),1.0f,50);
+    
+    /* a quad sharing its buffers with the application */
+    Vec3fa vertices[4] = { Vec3fa(-1,-2,-1), Vec3fa(+1,-2,-1), Vec3fa(+1,-2,+1), Vec3fa(-1,-2,+1) };
+    int triangles[6] = { 0,1,2, 0,2,3 };
+    unsigned geom = rtcNewTriangleMesh (scene, RTC_GEOMETRY_STATIC, 2, 4);
+    rtcSetBuffer(scene,geom,RTC_INDEX_BUFFER,triangles,0,3*sizeof(int));
+    rtcSetBuffer(scene,geom,RTC_VERTEX_BUFFER,vertices,0,sizeof(Vec3fa));
+    rtcCommit (scene);
+    AssertNoError();
+
+    /* query number of entries first */
+    size_t numStats = rtcGetMemoryStatistics(scene,NULL,0);
+    AssertNoError();
+    if (numStats < 2) return false;
+    std::vector<RTCMemoryStatistics> stats(numStats);
+    bool passed = rtcGetMemoryStatistics(scene,&stats[0],numStats) == numStats;
+    AssertNoError();
+
+    /* the first entry sums over all acceleration structures */
+    RTCMemoryStatistics sum; memset(&sum,0,sizeof(sum));
+    for (size_t i=1; i<numStats; i++) {
+      sum.nodes += stats[i].nodes;
+      sum.primitives += stats[i].primitives;
+      passed &= stats[i].sharedBuffers == 0 && stats[i].copiedBuffers == 0;
+    }
+    passed &= stats[0].nodes > 0 && stats[0].primitives > 0;
+    passed &= stats[0].nodes == sum.nodes && stats[0].primitives == sum.primitives;
+    passed &= stats[0].allocated >= stats[0].nodes+stats[0].primitives;
+    passed &= stats[0].sharedBuffers >= sizeof(vertices)+sizeof(triangles);
+    
+    /* static scenes free the copied buffers after the build */
+    if (sflags & RTC_SCENE_DYNAMIC) 
+      passed &= stats[0].copiedBuffers > 0;
+
+    rtcDeleteScene (scene);
+    return passed;
+  }
+
+  static atomic_t g_bytesMonitored = 0;
+  static bool g_grantMemory = true;
+
+  bool monitorMemory(const ptrdiff_t bytes)
+  {
+    if (bytes > 0 && !g_grantMemory) return false;
+    atomic_add(&g_bytesMonitored,bytes);
+    return true;
+  }
+
+  bool rtcore_new_triangle_meshes(RTCSceneFlags sflags)
+  {
+    /* many small meshes created one by one */
+    const size_t numMeshes = 300;
+    RTCScene scene0 = rtcNewScene(sflags,aflags);
+    for (size_t i=0; i<numMeshes; i++) 
+      addSphere(scene0,RTC_GEOMETRY_STATIC,Vec3fa(4.0f*drand48()-2.0f,4.0f*drand48()-2.0f,4.0f*drand48()-2.0f),0.2f,5);
+    AssertNoError();
+
+    /* the same meshes inside shared arrays */
+    std::vector<Vertex> vertices;
+    std::vector<Triangle> triangles;
+    std::vector<RTCMeshRange> ranges(numMeshes);
+    for (size_t i=0; i<numMeshes; i++) 
+    {
+      Vertex*   v = (Vertex*  ) rtcMapBuffer(scene0,i,RTC_VERTEX_BUFFER);
+      Triangle* t = (Triangle*) rtcMapBuffer(scene0,i,RTC_INDEX_BUFFER);
+      ranges[i].firstTriangle = triangles.size(); ranges[i].numTriangles = 80;
+      ranges[i].firstVertex   = vertices.size();  ranges[i].numVertices  = 60;
+      triangles.insert(triangles.end(),t,t+80);
+      vertices.insert(vertices.end(),v,v+60);
+      rtcUnmapBuffer(scene0,i,RTC_VERTEX_BUFFER);
+      rtcUnmapBuffer(scene0,i,RTC_INDEX_BUFFER);
+    }
+    AssertNoError();
+
+    /* dynamic geometry cannot get added to static scenes */
+    std::vector<unsigned> geomIDs(numMeshes);
+    RTCScene scene1 = rtcNewScene(sflags,aflags);
+    if (sflags & RTC_SCENE_DYNAMIC) {
+      rtcNewTriangleMeshes(scene1,RTC_GEOMETRY_STATIC,numMeshes,&ranges[0],&triangles[0],&vertices[0],&geomIDs[0]);
+      AssertNoError();
+    } else {
+      rtcNewTriangleMeshes(scene1,RTC_GEOMETRY_DYNAMIC,numMeshes,&ranges[0],&triangles[0],&vertices[0],&geomIDs[0]);
+      AssertError(RTC_INVALID_OPERATION);
+      if (geomIDs[0] != RTC_INVALID_GEOMETRY_ID) return false;
+      rtcNewTriangleMeshes(scene1,RTC_GEOMETRY_STATIC,numMeshes,&ranges[0],&triangles[0],&vertices[0],&geomIDs[0]);
+      AssertNoError();
+    }
+    for (size_t i=0; i<numMeshes; i++)
+      if (geomIDs[i] != i) return false;
+
+    rtcCommit (scene0);
+    rtcCommit (scene1);
+    AssertNoError();
+
+    /* both scenes have to report the same hits */
+    bool passed = true;
+    for (size_t i=0; i<10000; i++) 
+    {
+      Vec3fa org(4.0f*drand48()-2.0f,4.0f*drand48()-2.0f,4.0f*drand48()-2.0f);
+      Vec3fa dir(2.0f*drand48()-1.0f,2.0f*drand48()-1.0f,2.0f*drand48()-1.0f);
+      RTCRay ray0 = makeRay(org,dir); rtcIntersect(scene0,ray0);
+      RTCRay ray1 = makeRay(org,dir); rtcIntersect(scene1,ray1);
+      passed &= ray0.geomID == ray1.geomID && ray0.primID == ray1.primID && ray0.tfar == ray1.tfar;
+    }
+    AssertNoError();
+
+    rtcDeleteScene (scene0);
+    rtcDeleteScene (scene1);
+    return passed;
+  }
+
+  bool rtcore_memory_monitor(RTCSceneFlags sflags)
+  {
+    rtcSetMemoryMonitorFunction(monitorMemory);
+    g_bytesMonitored = 0;
+    
+    /* granted builds report their memory */
+    g_grantMemory = true;
+    RTCScene scene0 = rtcNewScene(sflags,aflags);
+    addSphere(scene0,RTC_GEOMETRY_STATIC,Vec3fa(0,0,0),1.0f,50);
+    rtcCommit (scene0);
+    AssertNoError();
+    bool passed = g_bytesMonitored > 0;
+    
+    /* vetoed builds report an error and leave the scene empty */
+    g_grantMemory = false;
+    RTCScene scene1 = rtcNewScene(sflags,aflags);
+    addSphere(scene1,RTC_GEOMETRY_STATIC,Vec3fa(0,0,0),1.0f,50);
+    rtcCommit (scene1);
+    passed &= rtcGetError() == RTC_OUT_OF_MEMORY;
+    RTCRay ray = makeRay(Vec3fa(-2,0,0),Vec3fa(1,0,0)); 
+    rtcIntersect(scene1,ray);
+    passed &= ray.geomID == -1;
+    
+    /* all reported memory gets released again */
+    rtcDeleteScene (scene0);
+    rtcDeleteScene (scene1);
+    passed &= g_bytesMonitored == 0;
+    
+    rtcSetMemoryMonitorFunction(NULL);
+    AssertNoError();
+    return passed;
+  }
+
+  bool rtcore_update_many_objects(size_t numObjects)
+  {
+    RTCScene scene = rtcNewScene(RTC_SCENE_DYNAMIC,aflags);
+    AssertNoError();
+    const size_t numPhi = 4;
+    const size_t numVertices = 2*numPhi*(numPhi+1);
+    std::vector<Vec3fa> pos(numObjects);
+    std::vector<int> geom(numObjects);
+    std::vector<bool> enabled(numObjects);
+    for (size_t i=0; i<numObjects; i++) {
+      pos[i] = 100.0f*Vec3fa(drand48(),drand48(),drand48());
+      geom[i] = addSphere(scene,RTC_GEOMETRY_DEFORMABLE,pos[i],2.0f,numPhi);
+      enabled[i] = true;
+    }
+    AssertNoError();
+
+    bool passed = true;
+    for (size_t i=0; i<50 && passed; i++) 
+    {
+      /* move, enable, disable, and recreate some objects */
+      for (size_t j=0; j<20; j++) 
+      {
+        size_t index = rand()%numObjects;
+        Vec3fa delta = 10.0f*Vec3fa(drand48(),drand48(),drand48())-Vec3fa(5.0f);
+        switch (rand()%4) {
+        case 0: {
+          if (!enabled[index]) break;
+          Vertex* vertices = (Vertex*) rtcMapBuffer(scene,geom[index],RTC_VERTEX_BUFFER);
+          for (size_t k=0; k<numVertices; k++) {
+            vertices[k].x += delta.x; vertices[k].y += delta.y; vertices[k].z += delta.z;
+          }
+          rtcUnmapBuffer(scene,geom[index],RTC_VERTEX_BUFFER);
+          rtcUpdate(scene,geom[index]);
+          pos[index] = pos[index]+delta;
+          break;
+        }
+        case 1: if (!enabled[index]) { rtcEnable (scene,geom[index]); enabled[index] = true;  } break;
+        case 2: if ( enabled[index]) { rtcDisable(scene,geom[index]); enabled[index] = false; } break;
+        case 3: 
+          rtcDeleteGeometry(scene,geom[index]);
+          pos[index] = pos[index]+delta;
+          geom[index] = addSphere(scene,RTC_GEOMETRY_DEFORMABLE,pos[index],2.0f,numPhi);
+          enabled[index] = true;
+          break;
+        }
+      }
+      rtcCommit(scene);
+      AssertNoError();
+
+      /* compare against a scene built from scratch */
+      RTCScene reference = rtcNewScene(RTC_SCENE_STATIC,aflags);
+      for (size_t j=0; j<numObjects; j++) 
+        if (enabled[j]) addSphere(reference,RTC_GEOMETRY_STATIC,pos[j],2.0f,numPhi);
+      rtcCommit(reference);
+      AssertNoError();
+
+      for (size_t j=0; j<200; j++) 
+      {
+        Vec3fa org = 100.0f*Vec3fa(drand48(),drand48(),drand48());
+        Vec3fa dir(2.0f*drand48()-1.0f,2.0f*drand48()-1.0f,2.0f*drand48()-1.0f);
+        RTCRay ray0 = makeRay(org,dir); rtcIntersect(scene,ray0);
+        RTCRay ray1 = makeRay(org,dir); rtcIntersect(reference,ray1);
+        passed &= (ray0.geomID == -1) == (ray1.geomID == -1);
+        passed &= ray0.geomID == -1 || abs(ray0.tfar-ray1.tfar) < 1E-4f*ray1.tfar;
+      }
+      rtcDeleteScene (reference);
+    }
+    AssertNoError();
+
+    rtcDeleteScene (scene);
+    return passed;
+  }
+
+  bool rtcore_hair(RTCSceneFlags sflags, RTCGeometryFlags gflags, int N)
+  {
+    bool passed = true;
+    RTCScene scene = rtcNewScene(sflags,aflags);
+    const float r = 0.05f;
+    const size_t numCurves = 100;
+    unsigned hair = addHair(scene,gflags,Vec3fa(0,0,5),2.0f,r,numCurves);
+    rtcCommit (scene);
+    AssertNoError();
+
+    for (size_t i=0; i<1000; i++)
+    {
+      /* rays through the center of a curve hit it, rays between two curves miss */
+      const size_t primID = i%numCurves;
+      const bool between = (i/numCurves)%2;
+      const Vec3fa org(1.8f*drand48()-0.9f,4.0f*r*(float(primID)+(between ? 0.5f : 0.0f)),0.0f);
+      RTCRay ray0 = makeRay(org,Vec3fa(0,0,1)); 
+      rtcIntersectN(scene,ray0,N);
+      if (between) passed &= ray0.geomID == -1;
+      else passed &= ray0.geomID == hair && ray0.primID == primID && fabs(ray0.tfar-5.0f) < 1E-3f;
+
+      RTCRay ray1 = makeRay(org,Vec3fa(0,0,1)); 
+      rtcOccludedN(scene,ray1,N);
+      passed &= (ray1.geomID == -1) == between;
+    }
+
+    rtcDeleteScene (scene);
+    return passed;
+  }
+
+  void rtcore_hair_all()
+  {
+    printf("%30s ... ","hair");
+    bool passed = true;
+    for (int i=0; i<numSceneFlags; i++) 
+    {
+      RTCSceneFlags flag = getSceneFlag(i);
+      bool ok0 = rtcore_hair(flag,RTC_GEOMETRY_STATIC,1);
+      if (ok0) printf("\033[32m+\033[0m"); else printf("\033[31m-\033[0m");
+      passed &= ok0;
+#if !defined(__MIC__)
+      bool ok1 = rtcore_hair(flag,RTC_GEOMETRY_STATIC,4);
+      if (ok1) printf("\033[32m+\033[0m"); else printf("\033[31m-\033[0m");
+      passed &= ok1;
+#endif
+#if defined(__TARGET_AVX__) || defined(__TARGET_AVX2__)
+      if (has_feature(AVX)) {
+        bool ok2 = rtcore_hair(flag,RTC_GEOMETRY_STATIC,8);
+        if (ok2) printf("\033[32m+\033[0m"); else printf("\033[31m-\033[0m");
+        passed &= ok2;
+      }
+#endif
+    }
+    printf(" %s\n",passed ? "\033[32m[PASSED]\033[0m" : "\033[31m[FAILED]\033[0m");
+	  fflush(stdout);
+  }
+
+  void rtcore_watertight_sphere1(float pos)
+  {
+    RTCScene scene = rtcNewScene(RTC_SCENE_STATIC | RTC_SCENE_ROBUST,aflags);
+    unsigned geom = addSphere(scene,RTC_GEOMETRY_STATIC,Vec3fa(pos,0.0f,0.0f),2.0f,1000);
+    rtcCommit (scene);
+    size_t numFailures = 0;
+    for (size_t i=0; i<testN; i++) {
+      Vec3fa org(2.0f*drand48()-1.0f,2.0f*drand48()-1.0f,2.0f*drand48()-1.0f);
+      Vec3fa dir(2.0f*drand48()-1.0f,2.0f*drand48()-1.0f,2.0f*drand48()-1.0f);
+      RTCRay ray = makeRay(Vec3fa(pos,0.0f,0.0f)+org,dir); 
+      rtcIntersect(scene,ray);
+      numFailures += ray.primID == -1;
+    }
+    rtcDeleteScene (scene);
+
+    printf("%30s ... %s (%f%%)\n","watertight_sphere1",
+           numFailures ? "\033[31m[FAILED]\033[0m" : "\033[32m[PASSED]\033[0m", 100.0f*(double)numFailures/(double)testN);
+	  fflush(stdout);
+  }
+  
+  void rtcore_watertight_sphere4(float pos)
+  {
+    RTCScene scene = rtcNewScene(RTCSceneFlags(RTC_SCENE_STATIC | RTC_SCENE_ROBUST),aflags);
+    unsigned geom = addSphere(scene,RTC_GEOMETRY_STATIC,Vec3fa(pos,0.0f,0.0f),2.0f,1000);
+    rtcCommit (scene);
+    size_t numFailures = 0;
+    for (size_t i=0; i<testN; i+=4) {
+      RTCRay4 ray4;
+      for (size_t j=0; j<4; j++) {
+        Vec3fa org(2.0f*drand48()-1.0f,2.0f*drand48()-1.0f,2.0f*drand48()-1.0f);
+        Vec3fa dir(2.0f*drand48()-1.0f,2.0f*drand48()-1.0f,2.0f*drand48()-1.0f);
+        RTCRay ray = makeRay(Vec3fa(pos,0.0f,0.0f)+org,dir); 
+        setRay(ray4,j,ray);
+      }
+      __align(16) int valid[4] = { -1,-1,-1,-1 };
+      rtcIntersect4(valid,scene,ray4);
+      for (size_t j=0; j<4; j++)
+        numFailures += ray4.primID[j] == -1;
+    }
+    rtcDeleteScene (scene);
+    printf("%30s ... %s (%f%%)\n","watertight_sphere4",
+           numFailures ? "\033[31m[FAILED]\033[0m" : "\033[32m[PASSED]\033[0m", 100.0f*(double)numFailures/(double)testN);
+	  fflush(stdout);
+  }
+
+  void rtcore_watertight_sphere8(float pos)
+  {
+    RTCScene scene = rtcNewScene(RTC_SCENE_STATIC | RTC_SCENE_ROBUST,aflags);
+    unsigned geom = addSphere(scene,RTC_GEOMETRY_STATIC,Vec3fa(pos,0.0f,0.0f),2.0f,1000);
+    rtcCommit (scene);
+    size_t numFailures = 0;
+    for (size_t i=0; i<testN; i+=8) {
+      RTCRay8 ray8;
+      for (size_t j=0; j<8; j++) {
+        Vec3fa org(2.0f*drand48()-1.0f,2.0f*drand48()-1.0f,2.0f*drand48()-1.0f);
+        Vec3fa dir(2.0f*drand48()-1.0f,2.0f*drand48()-1.0f,2.0f*drand48()-1.0f);
+        RTCRay ray = makeRay(Vec3fa(pos,0.0f,0.0f)+org,dir); 
+        setRay(ray8,j,ray);
+      }
+      __align(32) int valid[8] = { -1,-1,-1,-1,-1,-1,-1,-1 };
+      rtcIntersect8(valid,scene,ray8);
+      for (size_t j=0; j<8; j++)
+        numFailures += ray8.primID[j] == -1;
+    }
+    rtcDeleteScene (scene);
+    printf("%30s ... %s (%f%%)\n","watertight_sphere8",
+           numFailures ? "\033[31m[FAILED]\033[0m" : "\033[32m[PASSED]\033[0m", 100.0f*(double)numFailures/(double)testN);
+	  fflush(stdout);
+  }
+
+  void rtcore_watertight_sphere16(float pos)
   {
     RTCScene scene = rtcNewScene(RTC_SCENE_STATIC | RTC_SCENE_ROBUST,aflags);
     unsigned geom = addSphere(scene,RTC_GEOMETRY_STATIC,Vec3fa(pos,0.0f,0.0f),2.0f,1000);
@@ -2162,8 +3362,15 @@ namespace embree
     POSITIVE("dynamic_enable_disable",    rtcore_dynamic_enable_disable());
     POSITIVE("update_deformable",         rtcore_update(RTC_GEOMETRY_DEFORMABLE));
     POSITIVE("update_dynamic",            rtcore_update(RTC_GEOMETRY_DYNAMIC));
+    POSITIVE("refit_large_mesh",          rtcore_refit_mesh(200,0));
+    POSITIVE("refit_degraded_mesh",       rtcore_refit_mesh(50,100));
+    POSITIVE("morton_clustered_mesh",     rtcore_morton_clustered_mesh(RTC_SCENE_DYNAMIC,500));
+    POSITIVE("commit_async_deformable",   rtcore_commit_async(RTC_GEOMETRY_DEFORMABLE));
+    POSITIVE("commit_async_dynamic",      rtcore_commit_async(RTC_GEOMETRY_DYNAMIC));
+    POSITIVE("commit_async_scenes",       rtcore_commit_async_scenes(4));
     POSITIVE("overlapping_geometry",      rtcore_overlapping(100000));
     POSITIVE("new_delete_geometry",       rtcore_new_delete_geometry());
+    POSITIVE("update_many_objects",       rtcore_update_many_objects(1200));
 
 #if defined(__USE_RAY_MASK__)
     rtcore_ray_masks_all();
@@ -2178,6 +3385,40 @@ namespace embree
 #endif
 
     rtcore_packet_write_test_all();
+    rtcore_ray_stream_all();
+#if !defined(__MIC__)
+    POSITIVE("ray_stream_no_intersector", rtcore_ray_stream_no_intersector());
+#endif
+    POSITIVE("compact_scene_1",           rtcore_compact_scene(1));
+#if !defined(__MIC__)
+    POSITIVE("compact_scene_4",           rtcore_compact_scene(4));
+#endif
+#if defined(__TARGET_AVX__) || defined(__TARGET_AVX2__)
+    if (has_feature(AVX)) {
+      POSITIVE("compact_scene_8",         rtcore_compact_scene(8));
+    }
+#endif
+    POSITIVE("store_load_scene_1",        rtcore_store_load_scene(1));
+#if !defined(__MIC__)
+    POSITIVE("store_load_scene_4",        rtcore_store_load_scene(4));
+#endif
+    POSITIVE("statistics_static_1",       rtcore_statistics(RTC_SCENE_STATIC,1));
+    POSITIVE("statistics_dynamic_1",      rtcore_statistics(RTC_SCENE_DYNAMIC,1));
+#if !defined(__MIC__)
+    POSITIVE("statistics_static_4",       rtcore_statistics(RTC_SCENE_STATIC,4));
+    POSITIVE("statistics_dynamic_4",      rtcore_statistics(RTC_SCENE_DYNAMIC,4));
+#endif
+#if defined(__TARGET_AVX__) || defined(__TARGET_AVX2__)
+    if (has_feature(AVX)) {
+      POSITIVE("statistics_static_8",     rtcore_statistics(RTC_SCENE_STATIC,8));
+    }
+#endif
+#if !defined(__MIC__)
+    POSITIVE("statistics_many_threads",   rtcore_statistics_many_threads());
+#endif
+#if !defined(__MIC__)
+    rtcore_hair_all();
+#endif
 
     rtcore_watertight_sphere1(100000);
     rtcore_watertight_plane1(100000);
@@ -2198,6 +3439,8 @@ namespace embree
     rtcore_watertight_plane16(100000);
 #endif
 
+    rtcore_ray_packet_all();
+
 #if defined(__FIX_RAYS__)
     rtcore_nan("nan_test_1",RTC_SCENE_STATIC,RTC_GEOMETRY_STATIC,1);
     rtcore_inf("inf_test_1",RTC_SCENE_STATIC,RTC_GEOMETRY_STATIC,1);
@@ -2222,9 +3465,91 @@ namespace embree
 
     POSITIVE("regression_static",         rtcore_regression_static());
     POSITIVE("regression_dynamic",        rtcore_regression_dynamic());
+    POSITIVE("morton_treelet_small_mesh", rtcore_morton_clustered_mesh(RTCSceneFlags(RTC_SCENE_DYNAMIC | RTC_SCENE_HIGH_QUALITY),100));
+    POSITIVE("morton_treelet_large_mesh", rtcore_morton_clustered_mesh(RTCSceneFlags(RTC_SCENE_DYNAMIC | RTC_SCENE_HIGH_QUALITY),500));
+    POSITIVE("memory_statistics_static",  rtcore_memory_statistics(RTC_SCENE_STATIC));
+    POSITIVE("memory_statistics_dynamic", rtcore_memory_statistics(RTC_SCENE_DYNAMIC));
+    POSITIVE("memory_monitor_static",     rtcore_memory_monitor(RTC_SCENE_STATIC));
+    POSITIVE("memory_monitor_dynamic",    rtcore_memory_monitor(RTC_SCENE_DYNAMIC));
+    POSITIVE("new_triangle_meshes_static",  rtcore_new_triangle_meshes(RTC_SCENE_STATIC));
+    POSITIVE("new_triangle_meshes_dynamic", rtcore_new_triangle_meshes(RTC_SCENE_DYNAMIC));
+#if !defined(__MIC__)
+    POSITIVE("quad_mesh_static_1",        rtcore_quad_mesh(RTC_SCENE_STATIC,1));
+    POSITIVE("quad_mesh_dynamic_1",       rtcore_quad_mesh(RTC_SCENE_DYNAMIC,1));
+    POSITIVE("quad_mesh_static_4",        rtcore_quad_mesh(RTC_SCENE_STATIC,4));
+    POSITIVE("quad_mesh_motion_blur",     rtcore_quad_mesh_motion_blur());
+    POSITIVE("ray_packet_new_geometry_type", rtcore_ray_packet_new_geometry_type());
+#endif
+#if defined(__TARGET_AVX__) || defined(__TARGET_AVX2__)
+    if (has_feature(AVX)) {
+      POSITIVE("quad_mesh_static_8",      rtcore_quad_mesh(RTC_SCENE_STATIC,8));
+    }
+#endif
 
     rtcExit();
 
+    /* builds with 64 bit morton codes */
+    std::string cfg64 = "morton64_threshold=0";
+    if (g_rtcore != "") cfg64 = g_rtcore+","+cfg64;
+    rtcInit(cfg64.c_str());
+    POSITIVE("morton64_clustered_mesh",   rtcore_morton_clustered_mesh(RTC_SCENE_DYNAMIC,500));
+    POSITIVE("morton64_regression_dynamic", rtcore_regression_dynamic());
+    rtcExit();
+
+    /* builders for triangles must not break the quad and curve accels */
+#if !defined(__MIC__)
+    const char* builders[] = { "spatialsplit", "morton", "fast" };
+    for (size_t i=0; i<3; i++) 
+    {
+      std::string builder = builders[i];
+      std::string cfgb = "accel=bvh4.triangle4,builder="+builder;
+      if (g_rtcore != "") cfgb = g_rtcore+","+cfgb;
+      rtcInit(cfgb.c_str());
+      POSITIVE(("builder_"+builder+"_quads").c_str(), rtcore_quad_mesh(RTC_SCENE_STATIC,1));
+      POSITIVE(("builder_"+builder+"_hair" ).c_str(), rtcore_hair(RTC_SCENE_STATIC,RTC_GEOMETRY_STATIC,1));
+      rtcExit();
+    }
+#endif
+
+    /* triangle leaves with precomputed Woop transformations */
+#if !defined(__MIC__)
+    rtcore_triangle_leaves_all("bvh4.triangle4w");
+    rtcore_triangle_leaves_all("bvh4i.triangle4w");
+#endif
+#if defined(__TARGET_AVX__) || defined(__TARGET_AVX2__)
+    if (has_feature(AVX)) {
+      rtcore_triangle_leaves_all("bvh4.triangle8w");
+      rtcore_triangle_leaves_all("bvh4i.triangle8w");
+    }
+#endif
+
+    /* triangle leaves with quantized vertices */
+#if !defined(__MIC__)
+    rtcore_triangle_leaves_all("bvh4.triangle4q");
+    rtcore_triangle_leaves_all("bvh4.triangle4q.compressed");
+    POSITIVE("quantized_scene_1", rtcore_quantized_scene(1));
+    POSITIVE("quantized_scene_4", rtcore_quantized_scene(4));
+    POSITIVE("quantized_thin_triangles_1", rtcore_quantized_thin_triangles(1));
+    POSITIVE("quantized_thin_triangles_4", rtcore_quantized_thin_triangles(4));
+#if defined(__TARGET_AVX__) || defined(__TARGET_AVX2__)
+    if (has_feature(AVX)) {
+      POSITIVE("quantized_scene_8", rtcore_quantized_scene(8));
+      POSITIVE("quantized_thin_triangles_8", rtcore_quantized_thin_triangles(8));
+    }
+#endif
+#endif
+
+    /* builds with threads of the application */
+#if !defined(__MIC__)
+    size_t numThreads = getNumberOfLogicalThreads();
+    std::string cfg = "user_threads="+std::stringOf(numThreads);
+    if (g_rtcore != "") cfg = g_rtcore+","+cfg;
+    rtcInit(cfg.c_str());
+    POSITIVE("commit_thread_static",      rtcore_commit_thread(RTC_SCENE_STATIC,numThreads));
+    POSITIVE("commit_thread_dynamic",     rtcore_commit_thread(RTC_SCENE_DYNAMIC,numThreads));
+    rtcExit();
+#endif
+
     return 0;
   }
 }